@@ -0,0 +1,140 @@
+"""
+BlockBlaster shape bitmask table generator.
+
+Reads the SHAPES[] table from src/blockblaster_shapes.h and writes
+src/blockblaster_shape_masks.h, a companion SHAPE_MASKS[] table holding for
+each entry (same order as SHAPES[]):
+
+  - per-row bitmasks    (bit sx of rows[sy] set when cells[sy][sx] is filled)
+  - per-column bitmasks (bit sy of cols[sx] set when cells[sy][sx] is filled)
+  - the filled-cell count (popcount)
+  - the bounding box of the filled cells
+  - the list of filled-cell (x, y) offsets
+
+Run it (or `make shape-masks`) after every edit of blockblaster_shapes.h.
+
+Usage: python3 gen_shape_masks.py [shapes_header] [output_header]
+"""
+
+import ast
+import re
+import sys
+
+SHAPE_MAX = 5
+
+SRC = sys.argv[1] if len(sys.argv) > 1 else "src/blockblaster_shapes.h"
+DST = sys.argv[2] if len(sys.argv) > 2 else "src/blockblaster_shape_masks.h"
+
+
+def strip_comments(text):
+    """Remove C block and line comments, leaving string literals intact."""
+    out, i, n = [], 0, len(text)
+    while i < n:
+        if text.startswith("/*", i):
+            i = text.index("*/", i) + 2
+        elif text.startswith("//", i):
+            i = text.index("\n", i)
+        elif text[i] == '"':
+            j = i + 1
+            while text[j] != '"':
+                j += 2 if text[j] == "\\" else 1
+            out.append(text[i:j + 1])
+            i = j + 1
+        else:
+            out.append(text[i])
+            i += 1
+    return "".join(out)
+
+
+def parse_shapes(path):
+    """Return the SHAPES[] initializer as a list of
+    (w, h, cells, name, weight, difficulty)."""
+    text = strip_comments(open(path, encoding="utf-8").read())
+    m = re.search(r"SHAPES\[\]\s*=\s*(\{.*?\n\});", text, re.S)
+    if not m:
+        sys.exit("error: SHAPES[] initializer not found in " + path)
+    body = m.group(1).replace("{", "[").replace("}", "]")
+    body = re.sub(r"\btrue\b", "True", body)
+    body = re.sub(r"\bfalse\b", "False", body)
+    body = re.sub(r"(\d)f\b", r"\1", body)
+    return ast.literal_eval(body)
+
+
+def emit(shapes, path):
+    lines = []
+    w = lines.append
+    w("/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */")
+    w("")
+    w("/**")
+    w(" * \\file blockblaster_shape_masks.h")
+    w(" * \\brief Precomputed bitmasks for every entry of SHAPES[].")
+    w(" *")
+    w(" * GENERATED by gen_shape_masks.py from blockblaster_shapes.h -- do not")
+    w(" * edit by hand.  Regenerate with `make shape-masks` after changing the")
+    w(" * shape table.")
+    w(" */")
+    w("")
+    w("#ifndef __BLOCKBLASTER_SHAPE_MASKS__")
+    w("#define __BLOCKBLASTER_SHAPE_MASKS__")
+    w("")
+    w("#ifdef __cplusplus")
+    w('extern "C" {')
+    w("#endif")
+    w("")
+    w("/**")
+    w(" * \\brief Bitmask companion of SHAPES[]; SHAPE_MASKS[i] describes SHAPES[i].")
+    w(" */")
+    w("static const ShapeMask SHAPE_MASKS[] = {")
+    names = [s[3] for s in shapes]
+    for idx, (sw, sh, cells, name, weight, _) in enumerate(shapes):
+        if names.count(name) > 1:
+            sys.exit("error: shape %s is listed more than once; raise its "
+                     "weight instead" % name)
+        if weight <= 0:
+            sys.exit("error: shape %d (%s) has no weight" % (idx, name))
+        grid = [[False] * SHAPE_MAX for _ in range(SHAPE_MAX)]
+        for y, row in enumerate(cells):
+            for x, v in enumerate(row):
+                grid[y][x] = bool(v)
+        filled = [(x, y) for y in range(sh) for x in range(sw) if grid[y][x]]
+        if not filled:
+            sys.exit("error: shape %d (%s) has no filled cell" % (idx, name))
+        rows = [sum(1 << x for x in range(SHAPE_MAX) if grid[y][x])
+                for y in range(SHAPE_MAX)]
+        cols = [sum(1 << y for y in range(SHAPE_MAX) if grid[y][x])
+                for x in range(SHAPE_MAX)]
+        xs = [c[0] for c in filled]
+        ys = [c[1] for c in filled]
+        if min(xs) != 0 or min(ys) != 0:
+            # The placement kernels only consider anchors with gx, gy >= 0.
+            sys.exit("error: shape %d (%s) is not top-left aligned"
+                     % (idx, name))
+        w("    /* [%d] %s */" % (idx, name))
+        w("    {%d, %d, %d, %d, %d, %d, %d," % (sw, sh, len(filled), min(xs),
+                                            min(ys), max(xs), max(ys)))
+        w("     {%s}," % ", ".join("0x%02x" % r for r in rows))
+        w("     {%s}," % ", ".join("0x%02x" % c for c in cols))
+        w("     {%s}}," % ", ".join("{%d, %d}" % c for c in filled))
+    w("};")
+    w("")
+    w("/* Fails to compile when SHAPE_MASKS[] and SHAPES[] differ in length;")
+    w("   BlockBlasterBench compares every entry. */")
+    w("typedef char shape_masks_match_shapes")
+    w("    [(sizeof(SHAPE_MASKS) / sizeof(SHAPE_MASKS[0]) ==")
+    w("      sizeof(SHAPES) / sizeof(SHAPES[0]))")
+    w("         ? 1")
+    w("         : -1];")
+    w("")
+    w("#ifdef __cplusplus")
+    w("}")
+    w("#endif")
+    w("")
+    w("#endif /* __BLOCKBLASTER_SHAPE_MASKS__ */")
+    with open(path, "w", encoding="utf-8") as f:
+        f.write("\n".join(lines) + "\n")
+
+
+if __name__ == "__main__":
+    shapes = parse_shapes(SRC)
+    emit(shapes, DST)
+    print("Wrote %s (%d shapes)" % (DST, len(shapes)))
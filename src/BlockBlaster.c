@@ -30,6 +30,7 @@
 #include "blockblaster_context.h"
 #include "blockblaster_game.h"
 #include "blockblaster_render.h"
+#include "blockblaster_simd.h"
 #include "blockblaster_ui.h"
 #include "nilorea/n_log.h"
 
@@ -54,12 +55,6 @@
 #include <emscripten/html5.h>
 #endif
 
-/* Runtime virtual canvas dimensions (declared extern in
-   blockblaster_context.h). These may change when switching between windowed and
-   fullscreen modes. */
-int WIN_W = WIN_W_DEFAULT;
-int WIN_H = WIN_H_DEFAULT;
-
 #if defined(ALLEGRO_ANDROID)
 /** \brief Path to the app's private internal storage on Android. */
 const char *android_internal_path = NULL;
@@ -82,8 +77,6 @@ int main(int argc, char *argv[])
     (void) argc;
     (void) argv;
 
-    srand((unsigned) time(NULL));
-
     set_log_level(LOG_INFO);
 #ifdef __EMSCRIPTEN__
     set_log_file_fd(stdout);
@@ -91,6 +84,17 @@ int main(int argc, char *argv[])
 #endif
     n_log(LOG_INFO, "Starting BlockBlaster...");
 
+    blockblaster_scan_init();
+    n_log(LOG_INFO, "Placement scan kernel: %s",
+          blockblaster_scan_path_name(blockblaster_scan_active_path()));
+    blockblaster_shape_sampler_init();
+
+    GameContext gm;
+    blockblaster_init_context(&gm);
+    gm.particles = blockblaster_particles_create(MAX_PARTICLES);
+    if (!gm.particles)
+        n_log(LOG_ERR, "Could not allocate the particle pool.");
+
     if (!al_init()) {
         n_log(LOG_ERR, "Failed to init Allegro.");
         return 1;
@@ -115,7 +119,7 @@ int main(int argc, char *argv[])
     }
     if (al_install_audio() && al_init_acodec_addon()) {
         if (al_reserve_samples(32))
-            audio_ok = true;
+            gm.audio.ok = true;
         else
             n_log(LOG_ERR, "Failed to reserve 32 audio samples");
     } else {
@@ -129,7 +133,7 @@ int main(int argc, char *argv[])
     al_set_new_display_flags(ALLEGRO_OPENGL | ALLEGRO_WINDOWED |
                              ALLEGRO_RESIZABLE);
 #endif
-    ALLEGRO_DISPLAY *display = al_create_display(WIN_W, WIN_H);
+    ALLEGRO_DISPLAY *display = al_create_display(gm.win_w, gm.win_h);
     if (!display) {
         n_log(LOG_ERR, "Failed to create display");
         return 1;
@@ -139,6 +143,9 @@ int main(int argc, char *argv[])
         n_log(LOG_ERR, "Failed to init primitives addon.");
         return 1;
     }
+    if (!blockblaster_particle_batch_create(&gm))
+        n_log(LOG_ERR, "Could not create the particle batch; particles are "
+                       "drawn one by one.");
 
     ALLEGRO_TIMER *timer = al_create_timer(1.0 / REFRESH_RATE);
     ALLEGRO_EVENT_QUEUE *queue = al_create_event_queue();
@@ -146,7 +153,7 @@ int main(int argc, char *argv[])
     char font_path[512];
     blockblaster_get_data_path(FONT_FILENAME, font_path, sizeof(font_path));
 
-    blockblaster_load_all_audio();
+    blockblaster_load_all_audio(&gm);
 
     al_register_event_source(queue, al_get_display_event_source(display));
     al_register_event_source(queue, al_get_keyboard_event_source());
@@ -158,7 +165,9 @@ int main(int argc, char *argv[])
 #endif
     al_register_event_source(queue, al_get_timer_event_source(timer));
 
-    GameContext gm = {0};
+    uint64_t seed = (uint64_t) time(NULL);
+    blockblaster_rng_seed(&gm.core.rng, seed, RNG_STREAM_GAMEPLAY);
+    blockblaster_rng_seed(&gm.fx_rng, seed, RNG_STREAM_COSMETIC);
     gm.display = display;
     gm.display_width = al_get_display_width(display);
     gm.display_height = al_get_display_height(display);
@@ -166,11 +175,14 @@ int main(int argc, char *argv[])
     gm.paused = false;
 #ifndef __EMSCRIPTEN__
     gm.sound_on = blockblaster_load_sound_state();
-    blockblaster_load_settings(&gm.setting_tray_count, &gm.setting_grid_size);
+    blockblaster_load_settings(&gm.setting_tray_count, &gm.setting_grid_size,
+                               &gm.setting_fair_tray, &gm.setting_undo);
 #else
     gm.sound_on = false;
     gm.setting_tray_count = 4;
     gm.setting_grid_size = 10;
+    gm.setting_fair_tray = false;
+    gm.setting_undo = false;
 #endif
 
     gm.font = blockblaster_reload_font(NULL, font_path,
@@ -184,7 +196,7 @@ int main(int argc, char *argv[])
     web_init_key_char_capture();
 #endif
 
-    al_set_mouse_xy(display, WIN_W / 2, WIN_H / 2);
+    al_set_mouse_xy(display, gm.win_w / 2, gm.win_h / 2);
     al_show_mouse_cursor(display);
 
     gm.state = STATE_MENU;
@@ -233,11 +245,12 @@ int main(int argc, char *argv[])
                     bool prev_sound = gm.sound_on;
                     gm.sound_on = blockblaster_load_sound_state();
                     if (prev_sound && !gm.sound_on) {
-                        blockblaster_stop_music();
-                        music_current_track = -1;
+                        blockblaster_stop_music(&gm);
+                        gm.audio.music_current_track = -1;
                     }
-                    blockblaster_load_settings(&gm.setting_tray_count,
-                                               &gm.setting_grid_size);
+                    blockblaster_load_settings(
+                        &gm.setting_tray_count, &gm.setting_grid_size,
+                        &gm.setting_fair_tray, &gm.setting_undo);
                     sound_state_loaded = true;
                 }
             }
@@ -254,26 +267,12 @@ int main(int argc, char *argv[])
                     gm.shake_t = 0.0f;
                 float t = gm.shake_t / SHAKE_TIME;
                 float s = gm.shake_strength * t;
-                gm.cam_x = blockblaster_frand(-s, s);
-                gm.cam_y = blockblaster_frand(-s, s);
+                gm.cam_x = blockblaster_frand(&gm.fx_rng, -s, s);
+                gm.cam_y = blockblaster_frand(&gm.fx_rng, -s, s);
             }
 
             /* Particles */
-            for (int i = 0; i < MAX_PARTICLES; i++) {
-                Particle *p = &gm.particles[i];
-                if (!p->alive)
-                    continue;
-                p->life -= dt;
-                if (p->life <= 0.0f) {
-                    p->alive = false;
-                    continue;
-                }
-                p->vy += 520.0f * dt;
-                p->vx *= (1.0f - 0.9f * dt);
-                p->vy *= (1.0f - 0.2f * dt);
-                p->x += p->vx * dt;
-                p->y += p->vy * dt;
-            }
+            blockblaster_particles_update(gm.particles, dt);
 
             /* Bonus popups */
             for (int i = 0; i < MAX_BONUS_POPUPS; i++) {
@@ -289,8 +288,8 @@ int main(int argc, char *argv[])
             }
 
             /* Pop timers */
-            for (int y = 0; y < GRID_H; y++)
-                for (int x = 0; x < GRID_W; x++)
+            for (int y = 0; y < gm.grid_h; y++)
+                for (int x = 0; x < gm.grid_w; x++)
                     if (gm.pop_t[y][x] > 0.0f) {
                         gm.pop_t[y][x] -= dt;
                         if (gm.pop_t[y][x] < 0.0f)
@@ -330,12 +329,20 @@ int main(int argc, char *argv[])
 
             if (gm.state == STATE_PLAY && gm.dragging && !gm.confirm_exit)
                 blockblaster_update_drop_preview(&gm);
+            if (gm.state == STATE_REPLAY)
+                blockblaster_update_replay_view(&gm, dt);
 
         } else if (ev.type == ALLEGRO_EVENT_MOUSE_AXES) {
             blockblaster_screen_to_virtual(&gm, ev.mouse.x, ev.mouse.y,
                                            &gm.mouse_x, &gm.mouse_y);
             if (gm.state == STATE_PLAY && gm.dragging && !gm.confirm_exit)
                 blockblaster_update_drop_preview(&gm);
+            if (gm.state == STATE_REPLAY && gm.replay_scrubbing) {
+                int move = blockblaster_replay_bar_move(&gm, gm.mouse_x);
+                if (move != gm.replay_move &&
+                    !blockblaster_show_replay_move(&gm, move))
+                    blockblaster_leave_replay_view(&gm);
+            }
 
         } else if (ev.type == ALLEGRO_EVENT_MOUSE_BUTTON_DOWN) {
             float mouse_x = 0.0f, mouse_y = 0.0f;
@@ -346,7 +353,7 @@ int main(int argc, char *argv[])
 
             if (ev.mouse.button == 1 && gm.state == STATE_MENU) {
                 MenuAction action =
-                    blockblaster_menu_action_from_click(mouse_x, mouse_y);
+                    blockblaster_menu_action_from_click(&gm, mouse_x, mouse_y);
                 if (action == MENU_ACTION_START_EMPTY)
                     blockblaster_start_game(&gm, 0);
                 if (action == MENU_ACTION_START_PARTIAL)
@@ -357,17 +364,32 @@ int main(int argc, char *argv[])
                     gm.sound_on = !gm.sound_on;
                     blockblaster_save_sound_state(gm.sound_on);
                     if (!gm.sound_on) {
-                        blockblaster_stop_music();
-                        music_current_track = -1;
+                        blockblaster_stop_music(&gm);
+                        gm.audio.music_current_track = -1;
                     }
                 }
+                if (action == MENU_ACTION_TOGGLE_FAIR) {
+                    gm.setting_fair_tray = !gm.setting_fair_tray;
+                    blockblaster_save_settings(
+                        gm.setting_tray_count, gm.setting_grid_size,
+                        gm.setting_fair_tray, gm.setting_undo);
+                    blockblaster_play_sfx(gm.audio.sfx_select, &gm);
+                }
+                if (action == MENU_ACTION_TOGGLE_UNDO) {
+                    gm.setting_undo = !gm.setting_undo;
+                    blockblaster_save_settings(
+                        gm.setting_tray_count, gm.setting_grid_size,
+                        gm.setting_fair_tray, gm.setting_undo);
+                    blockblaster_play_sfx(gm.audio.sfx_select, &gm);
+                }
                 if (action == MENU_ACTION_CYCLE_TRAY) {
                     gm.setting_tray_count++;
                     if (gm.setting_tray_count > 4)
                         gm.setting_tray_count = 1;
-                    blockblaster_save_settings(gm.setting_tray_count,
-                                               gm.setting_grid_size);
-                    blockblaster_play_sfx(sfx_select, &gm);
+                    blockblaster_save_settings(
+                        gm.setting_tray_count, gm.setting_grid_size,
+                        gm.setting_fair_tray, gm.setting_undo);
+                    blockblaster_play_sfx(gm.audio.sfx_select, &gm);
                 }
                 if (action == MENU_ACTION_CYCLE_GRID) {
                     if (gm.setting_grid_size == 10)
@@ -376,17 +398,19 @@ int main(int argc, char *argv[])
                         gm.setting_grid_size = 20;
                     else
                         gm.setting_grid_size = 10;
-                    blockblaster_save_settings(gm.setting_tray_count,
-                                               gm.setting_grid_size);
-                    blockblaster_play_sfx(sfx_select, &gm);
+                    blockblaster_save_settings(
+                        gm.setting_tray_count, gm.setting_grid_size,
+                        gm.setting_fair_tray, gm.setting_undo);
+                    blockblaster_play_sfx(gm.audio.sfx_select, &gm);
                 }
                 if (action == MENU_ACTION_START_EMPTY ||
                     action == MENU_ACTION_START_PARTIAL ||
                     action == MENU_ACTION_EXIT)
-                    blockblaster_play_sfx(sfx_select, &gm);
+                    blockblaster_play_sfx(gm.audio.sfx_select, &gm);
                 if (action == MENU_ACTION_START_EMPTY ||
                     action == MENU_ACTION_START_PARTIAL) {
-                    int rand_music = 2 + rand() % 3;
+                    int rand_music =
+                        2 + blockblaster_irand(&gm.fx_rng, 0, 2);
                     blockblaster_play_music_track(rand_music, &gm);
                 }
 
@@ -401,70 +425,92 @@ int main(int argc, char *argv[])
                         /* Re-insert score with possibly updated name */
                         blockblaster_load_high_scores(&gm);
                         blockblaster_insert_high_score(
-                            &gm, gm.score, gm.highest_combo, gm.player_name);
+                            &gm, gm.core.score, gm.core.highest_combo,
+                            gm.player_name);
                         blockblaster_save_high_scores(&gm);
                         snprintf(gm.last_player_name,
                                  sizeof(gm.last_player_name), "%s",
                                  gm.player_name);
                         blockblaster_save_player_name(gm.last_player_name);
                         gm.editing_name = false;
-                        blockblaster_play_sfx(sfx_select, &gm);
+                        blockblaster_play_sfx(gm.audio.sfx_select, &gm);
 #ifdef ALLEGRO_ANDROID
                         blockblaster_android_hide_keyboard();
 #endif
                     }
 #ifdef ALLEGRO_ANDROID
                     else if (blockblaster_gameover_name_field_clicked(
-                                 mouse_x, mouse_y)) {
+                                 &gm, mouse_x, mouse_y)) {
                         blockblaster_android_show_keyboard();
                     }
 #endif
                 } else {
-                    if (blockblaster_gameover_restart_clicked(mouse_x,
-                                                              mouse_y)) {
+                    if (blockblaster_gameover_replay_clicked(&gm, mouse_x,
+                                                             mouse_y)) {
+                        blockblaster_play_sfx(gm.audio.sfx_select, &gm);
+                        blockblaster_enter_replay_view(&gm);
+                    } else if (blockblaster_gameover_restart_clicked(
+                                   &gm, mouse_x, mouse_y)) {
                         gm.state = STATE_MENU;
-                        blockblaster_play_sfx(sfx_select, &gm);
+                        blockblaster_play_sfx(gm.audio.sfx_select, &gm);
                     }
-                    if (blockblaster_gameover_exit_clicked(mouse_x, mouse_y))
+                    if (blockblaster_gameover_exit_clicked(&gm, mouse_x,
+                                                           mouse_y))
                         running = false;
                 }
 
+            } else if (ev.mouse.button == 1 && gm.state == STATE_REPLAY) {
+                if (blockblaster_play_exit_clicked(&gm, mouse_x, mouse_y)) {
+                    blockblaster_leave_replay_view(&gm);
+                } else if (blockblaster_replay_bar_clicked(&gm, mouse_x,
+                                                           mouse_y)) {
+                    gm.replay_scrubbing = true;
+                    if (!blockblaster_show_replay_move(
+                            &gm, blockblaster_replay_bar_move(&gm, mouse_x)))
+                        blockblaster_leave_replay_view(&gm);
+                }
+
             } else if (gm.state == STATE_PLAY && ev.mouse.button == 1) {
                 if (gm.confirm_exit) {
-                    if (blockblaster_exit_confirm_yes_clicked(mouse_x, mouse_y))
+                    if (blockblaster_exit_confirm_yes_clicked(&gm, mouse_x,
+                                                              mouse_y))
                         running = false;
-                    else if (blockblaster_exit_confirm_no_clicked(mouse_x,
+                    else if (blockblaster_exit_confirm_no_clicked(&gm, mouse_x,
                                                                   mouse_y))
                         gm.confirm_exit = false;
                 } else if (!gm.clearing && !gm.returning) {
-                    if (blockblaster_play_exit_clicked(mouse_x, mouse_y))
+                    if (blockblaster_play_exit_clicked(&gm, mouse_x, mouse_y))
                         gm.confirm_exit = true;
-                    if (blockblaster_play_sound_clicked(mouse_x, mouse_y)) {
+                    if (blockblaster_play_sound_clicked(&gm, mouse_x,
+                                                        mouse_y)) {
                         gm.sound_on = !gm.sound_on;
                         blockblaster_save_sound_state(gm.sound_on);
                         if (!gm.sound_on) {
-                            blockblaster_stop_music();
-                            music_current_track = -1;
+                            blockblaster_stop_music(&gm);
+                            gm.audio.music_current_track = -1;
                         } else {
-                            int rand_music = 2 + rand() % 3;
+                            int rand_music =
+                                2 + blockblaster_irand(&gm.fx_rng, 0, 2);
                             blockblaster_play_music_track(rand_music, &gm);
                         }
                     }
-                    for (int i = 0; i < PIECES_PER_SET; i++) {
-                        if (gm.tray[i].used)
+                    for (int i = 0; i < gm.tray_count; i++) {
+                        if (gm.core.tray[i].used)
                             continue;
                         float x1, y1, x2, y2;
-                        blockblaster_tray_piece_rect(i, &x1, &y1, &x2, &y2);
+                        blockblaster_tray_piece_rect(&gm, i, &x1, &y1, &x2,
+                                                     &y2);
                         if (blockblaster_point_in_rect(mouse_x, mouse_y, x1, y1,
                                                        x2, y2)) {
-                            blockblaster_play_sfx(sfx_select, &gm);
+                            blockblaster_play_sfx(gm.audio.sfx_select, &gm);
                             gm.dragging = true;
                             gm.dragging_index = i;
                             float local_x = mouse_x - x1;
                             float local_y = mouse_y - y1;
                             blockblaster_compute_grab_cell(
-                                &gm.tray[i].shape, (x2 - x1), (y2 - y1),
-                                local_x, local_y, &gm.grab_sx, &gm.grab_sy);
+                                &gm, &gm.core.tray[i].shape, (x2 - x1),
+                                (y2 - y1), local_x, local_y, &gm.grab_sx,
+                                &gm.grab_sy);
                             blockblaster_update_drop_preview(&gm);
                             break;
                         }
@@ -476,6 +522,8 @@ int main(int argc, char *argv[])
             if (gm.state == STATE_PLAY && ev.mouse.button == 1 &&
                 !gm.confirm_exit)
                 blockblaster_try_drop(&gm);
+            if (ev.mouse.button == 1)
+                gm.replay_scrubbing = false;
 
         } else if (ev.type == ALLEGRO_EVENT_KEY_DOWN) {
             int kc = ev.keyboard.keycode;
@@ -483,10 +531,48 @@ int main(int argc, char *argv[])
             if (kc == ALLEGRO_KEY_ESCAPE) {
                 if (gm.state == STATE_PLAY) {
                     gm.confirm_exit = !gm.confirm_exit;
+                } else if (gm.state == STATE_REPLAY) {
+                    blockblaster_leave_replay_view(&gm);
                 } else {
                     running = false;
                 }
+            } else if (gm.state == STATE_REPLAY) {
+                /* Replay view: step, page, jump to either end, play/pause.
+                   Moving by hand pauses playback; the seek clamps. */
+                int move = gm.replay_move;
+                if (kc == ALLEGRO_KEY_LEFT)
+                    move -= 1;
+                else if (kc == ALLEGRO_KEY_RIGHT)
+                    move += 1;
+                else if (kc == ALLEGRO_KEY_PGUP)
+                    move -= REPLAY_PAGE_MOVES;
+                else if (kc == ALLEGRO_KEY_PGDN)
+                    move += REPLAY_PAGE_MOVES;
+                else if (kc == ALLEGRO_KEY_HOME)
+                    move = 0;
+                else if (kc == ALLEGRO_KEY_END)
+                    move = gm.replay.count;
+                if (kc == ALLEGRO_KEY_SPACE) {
+                    gm.replay_playing = !gm.replay_playing;
+                    gm.replay_t = REPLAY_STEP_TIME;
+                    if (gm.replay_playing && move >= gm.replay.count)
+                        move = 0;
+                } else if (move != gm.replay_move) {
+                    gm.replay_playing = false;
+                }
+                if (move != gm.replay_move &&
+                    !blockblaster_show_replay_move(&gm, move))
+                    blockblaster_leave_replay_view(&gm);
             }
+            if (kc == ALLEGRO_KEY_H && gm.state == STATE_PLAY &&
+                !gm.confirm_exit)
+                blockblaster_toggle_hint(&gm);
+            if (kc == ALLEGRO_KEY_Z && gm.state == STATE_PLAY &&
+                !gm.confirm_exit)
+                blockblaster_undo_move(&gm);
+            if (kc == ALLEGRO_KEY_Y && gm.state == STATE_PLAY &&
+                !gm.confirm_exit)
+                blockblaster_redo_move(&gm);
             if (kc == ALLEGRO_KEY_F11) {
                 blockblaster_toggle_fullscreen(&gm);
                 blockblaster_update_view_offset(&gm);
@@ -530,14 +616,15 @@ int main(int argc, char *argv[])
                         snprintf(gm.player_name, sizeof(gm.player_name),
                                  "PLAYR");
                     blockblaster_load_high_scores(&gm);
-                    blockblaster_insert_high_score(
-                        &gm, gm.score, gm.highest_combo, gm.player_name);
+                    blockblaster_insert_high_score(&gm, gm.core.score,
+                                                   gm.core.highest_combo,
+                                                   gm.player_name);
                     blockblaster_save_high_scores(&gm);
                     snprintf(gm.last_player_name, sizeof(gm.last_player_name),
                              "%s", gm.player_name);
                     blockblaster_save_player_name(gm.last_player_name);
                     gm.editing_name = false;
-                    blockblaster_play_sfx(sfx_select, &gm);
+                    blockblaster_play_sfx(gm.audio.sfx_select, &gm);
 #ifdef ALLEGRO_ANDROID
                     blockblaster_android_hide_keyboard();
 #endif
@@ -572,8 +659,8 @@ int main(int argc, char *argv[])
                 gm.returning = false;
                 gm.return_t = 0.0f;
             }
-            if (music_instance)
-                al_set_sample_instance_playing(music_instance, false);
+            if (gm.audio.music_instance)
+                al_set_sample_instance_playing(gm.audio.music_instance, false);
             al_stop_timer(timer);
 #endif
         } else if (ev.type == ALLEGRO_EVENT_DISPLAY_HALT_DRAWING) {
@@ -589,8 +676,8 @@ int main(int argc, char *argv[])
                 gm.returning = false;
                 gm.return_t = 0.0f;
             }
-            if (music_instance)
-                al_set_sample_instance_playing(music_instance, false);
+            if (gm.audio.music_instance)
+                al_set_sample_instance_playing(gm.audio.music_instance, false);
             al_stop_timer(timer);
             al_acknowledge_drawing_halt(display);
 
@@ -609,8 +696,8 @@ int main(int argc, char *argv[])
 #endif
             gm.font = blockblaster_reload_font(
                 gm.font, font_path, blockblaster_font_effective_scale(&gm));
-            if (music_instance)
-                al_set_sample_instance_playing(music_instance, true);
+            if (gm.audio.music_instance)
+                al_set_sample_instance_playing(gm.audio.music_instance, true);
             al_start_timer(timer);
 #ifdef ALLEGRO_ANDROID
         } else if (ev.type == ALLEGRO_EVENT_DISPLAY_SWITCH_IN) {
@@ -627,8 +714,9 @@ int main(int argc, char *argv[])
                 al_android_set_apk_file_interface();
                 gm.font = blockblaster_reload_font(
                     gm.font, font_path, blockblaster_font_effective_scale(&gm));
-                if (music_instance)
-                    al_set_sample_instance_playing(music_instance, true);
+                if (gm.audio.music_instance)
+                    al_set_sample_instance_playing(gm.audio.music_instance,
+                                                   true);
                 al_start_timer(timer);
             }
 #endif
@@ -649,11 +737,14 @@ int main(int argc, char *argv[])
             } else if (gm.state == STATE_PLAY) {
                 blockblaster_draw_play_scene(&gm);
                 if (gm.confirm_exit)
-                    blockblaster_draw_exit_confirm(gm.font);
+                    blockblaster_draw_exit_confirm(&gm, gm.font);
             } else if (gm.state == STATE_GAMEOVER) {
                 blockblaster_play_music_track(1, &gm);
                 blockblaster_draw_play_scene(&gm);
                 blockblaster_draw_gameover_overlay(&gm, gm.font);
+            } else if (gm.state == STATE_REPLAY) {
+                blockblaster_draw_play_scene(&gm);
+                blockblaster_draw_replay_bar(&gm, gm.font);
             }
 
 #ifdef __EMSCRIPTEN__
@@ -680,7 +771,14 @@ int main(int argc, char *argv[])
 
     n_log(LOG_INFO, "Exiting...");
 
-    blockblaster_destroy_all_audio();
+    blockblaster_hint_destroy(gm.hint);
+    blockblaster_undo_destroy(gm.undo);
+    blockblaster_particles_destroy(gm.particles);
+    blockblaster_particle_batch_destroy(&gm);
+    blockblaster_tile_atlas_destroy(&gm);
+    blockblaster_background_destroy(&gm);
+    blockblaster_replay_free(&gm.replay);
+    blockblaster_destroy_all_audio(&gm);
     al_destroy_font(gm.font);
     al_destroy_event_queue(queue);
     al_destroy_timer(timer);
@@ -0,0 +1,1422 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_bench.c
+ * \brief Placement-scan, shape-sampler and tray-solver microbenchmark.
+ *
+ * Every generated SHAPE_MASKS[] entry is first rebuilt from SHAPES[] and
+ * compared, catching a table left stale by a shape edit.
+ *
+ * It then builds a fixed set of random grids for the 10x10, 15x15 and
+ * 20x20 modes and runs every shape through each available scan path
+ * (scalar, SSE2, AVX2, NEON), reporting anchors tested per second.  Every
+ * path is checked against the scalar result before it is timed.
+ *
+ * The alias-table shape sampler is then checked against the exact
+ * difficulty weights with a chi-square test at several scores and timed
+ * against the linear cumulative scan it replaced.
+ *
+ * Finally the tray-ordering solver is run on positions taken from greedy
+ * self-play with 4-piece trays: every returned sequence is replayed through
+ * blockblaster_core_drop() to check its legality and score, and the solve
+ * time is reported per grid size.
+ *
+ * Greedy games are then played with fair trays to time the feasibility
+ * check per deal and to check that every kept set can be placed in full.
+ *
+ * The batched environment (blockblaster_vecenv.h) is checked step by step
+ * against CoreGames playing the same actions, and its aggregate step rate
+ * is measured for several batch sizes on one thread and on one thread per
+ * online CPU.
+ *
+ * Greedy games are also recorded as replays: seeking through their
+ * keyframes is checked against playing the drops from the start and both
+ * are timed, along with the encoded size.
+ *
+ * Greedy games are recorded into an undo history (blockblaster_undo.h) and
+ * random undo / redo runs are checked against full copies of every state,
+ * timing each operation and measuring the history size per level.
+ *
+ * The board features (blockblaster_features.h) are followed through
+ * greedy games incrementally and checked against a full recompute and a
+ * per-cell reference after every drop; full evaluations per second and the
+ * cost of an incremental update are reported per grid size.
+ *
+ * Last, every particle update path (blockblaster_particles.h) is checked
+ * against a per-particle reference of the former array-of-structs loop,
+ * then timed on full pools of 1000 and 20000 (the in-game MAX_PARTICLES)
+ * particles.
+ *
+ * Usage: BlockBlasterBench [iterations]
+ */
+
+#include "blockblaster_features.h"
+#include "blockblaster_particles.h"
+#include "blockblaster_replay.h"
+#include "blockblaster_simd.h"
+#include "blockblaster_solver.h"
+#include "blockblaster_undo.h"
+#include "blockblaster_vecenv.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Number of random grids per grid size. */
+#define BENCH_GRIDS 64
+
+/* Default number of passes over all grids and shapes. */
+#define BENCH_DEFAULT_ITERATIONS 2000
+
+/* Shape draws per score in the sampler chi-square check. */
+#define BENCH_SAMPLER_DRAWS 2000000
+
+/* Shape draws timed per sampler, per score. */
+#define BENCH_SAMPLER_TIMED 4000000
+
+/* Positions solved per grid size in the solver check. */
+#define BENCH_SOLVER_POSITIONS 200
+
+/* Games played per grid size in the fair-tray check. */
+#define BENCH_FAIR_GAMES 40
+
+/* Move cap per game in the fair-tray check. */
+#define BENCH_FAIR_MAX_MOVES 3000
+
+/* Games and rounds of the batched environment check. */
+#define BENCH_VEC_CHECK_GAMES 64
+#define BENCH_VEC_CHECK_ROUNDS 300
+
+/* Steps timed per batch size and thread count. */
+#define BENCH_VEC_STEPS (1L << 20)
+
+/* Most threads used by the batched environment benchmark. */
+#define BENCH_VEC_MAX_THREADS 64
+
+/* Games recorded per grid size and positions sought per game in the
+   replay check. */
+#define BENCH_REPLAY_GAMES 20
+#define BENCH_REPLAY_SEEKS 50
+
+/* Games and drops per game of the undo check (every state is kept for the
+   comparison). */
+#define BENCH_UNDO_GAMES 10
+#define BENCH_UNDO_MOVES 1000
+
+/* Games per grid size of the board features check, and passes over the
+   positions they visit when timing full evaluations. */
+#define BENCH_FEATURE_GAMES 20
+#define BENCH_FEATURE_PASSES 10
+
+/* Timed repeats of each update and recount in the board features check. */
+#define BENCH_FEATURE_REPEATS 8
+
+/* Positions kept per grid size for the full evaluation timing. */
+#define BENCH_FEATURE_POSITIONS 4096
+
+/* Frames of the particle check, with a burst every BENCH_PARTICLE_BURST
+   frames, and frames timed per pool size and path. */
+#define BENCH_PARTICLE_FRAMES 600
+#define BENCH_PARTICLE_BURST 7
+#define BENCH_PARTICLE_TIMED 2000
+
+/* Small deterministic generator so every run scans the same grids. */
+static uint32_t bench_rng = 0x9e3779b9u;
+
+static uint32_t bench_rand(void)
+{
+    bench_rng ^= bench_rng << 13;
+    bench_rng ^= bench_rng >> 17;
+    bench_rng ^= bench_rng << 5;
+    return bench_rng;
+}
+
+/* Fill a grid of w x h cells, each occupied with probability fill / 100. */
+static void bench_make_grid(uint32_t rows[GRID_H_MAX + GRID_ROW_PAD], int w,
+                            int h, int fill)
+{
+    for (int y = 0; y < GRID_H_MAX + GRID_ROW_PAD; y++) {
+        rows[y] = 0;
+        if (y >= h)
+            continue;
+        for (int x = 0; x < w; x++)
+            if ((int) (bench_rand() % 100) < fill)
+                rows[y] |= 1u << x;
+    }
+}
+
+/* Wall-clock time in seconds. */
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/* Number of anchors a scan returning first_row actually covered: every
+   anchor of the rows up to and including the first row with a fit. */
+static long bench_anchors(const ShapeMask *m, int w, int h, int first_row)
+{
+    int n = h - m->max_y;
+    int cols = w - m->max_x;
+    if (n <= 0 || cols <= 0)
+        return 0;
+    return (long) ((first_row < 0) ? n : first_row + 1) * cols;
+}
+
+/* Check every generated SHAPE_MASKS[] entry against masks rebuilt from
+   SHAPES[] the way gen_shape_masks.py builds them.  The generated header
+   only checks the entry count at compile time, so an edited or reordered
+   shape with a stale table is caught here.  Returns 0 on success, 1 on the
+   first mismatch. */
+static int bench_shape_masks(void)
+{
+    for (int i = 0; i < SHAPES_COUNT; i++) {
+        const Shape *s = &SHAPES[i];
+        const ShapeMask *m = &SHAPE_MASKS[i];
+        ShapeMask e;
+        memset(&e, 0, sizeof(e));
+        e.w = s->w;
+        e.h = s->h;
+        e.min_x = e.min_y = SHAPE_MAX;
+        e.max_x = e.max_y = -1;
+        for (int y = 0; y < s->h; y++)
+            for (int x = 0; x < s->w; x++) {
+                if (!s->cells[y][x])
+                    continue;
+                e.rows[y] |= 1u << x;
+                e.cols[x] |= 1u << y;
+                e.cells[e.cell_count][0] = (signed char) x;
+                e.cells[e.cell_count][1] = (signed char) y;
+                e.cell_count++;
+                e.min_x = x < e.min_x ? x : e.min_x;
+                e.min_y = y < e.min_y ? y : e.min_y;
+                e.max_x = x > e.max_x ? x : e.max_x;
+                e.max_y = y > e.max_y ? y : e.max_y;
+            }
+        bool same = m->w == e.w && m->h == e.h &&
+                    m->cell_count == e.cell_count && m->min_x == e.min_x &&
+                    m->min_y == e.min_y && m->max_x == e.max_x &&
+                    m->max_y == e.max_y &&
+                    memcmp(m->rows, e.rows, sizeof(e.rows)) == 0 &&
+                    memcmp(m->cols, e.cols, sizeof(e.cols)) == 0 &&
+                    memcmp(m->cells, e.cells,
+                           (size_t) e.cell_count * sizeof(e.cells[0])) == 0;
+        if (!same) {
+            fprintf(stderr,
+                    "SHAPE_MASKS[%d] does not match SHAPES[%d] (%s): run "
+                    "make shape-masks\n",
+                    i, i, s->name);
+            return 1;
+        }
+    }
+    printf("Shape masks: %d entries match SHAPES[]\n", SHAPES_COUNT);
+    return 0;
+}
+
+/* The shape picker the alias sampler replaced: rebuild every weight and
+   walk the cumulative sum on each draw. */
+static int bench_linear_draw(Rng *r, long score)
+{
+    float t = (float) score / (float) DIFFICULTY_MAX_SCORE;
+    if (t < 0.0f)
+        t = 0.0f;
+    if (t > 1.0f)
+        t = 1.0f;
+
+    float weights[128];
+    float total = 0.0f;
+    for (int i = 0; i < SHAPES_COUNT; i++) {
+        weights[i] = blockblaster_shape_weight(i, t);
+        total += weights[i];
+    }
+    float pick = blockblaster_frand(r, 0.0f, total);
+    float acc = 0.0f;
+    for (int i = 0; i < SHAPES_COUNT; i++) {
+        acc += weights[i];
+        if (pick < acc)
+            return i;
+    }
+    return SHAPES_COUNT - 1;
+}
+
+/* Chi-square statistic of BENCH_SAMPLER_DRAWS alias draws at score against
+   the exact (unquantised) difficulty weights. */
+static double bench_sampler_chi2(Rng *r, long score)
+{
+    static long counts[128];
+    float t = (float) score / (float) DIFFICULTY_MAX_SCORE;
+    double total = 0.0;
+    for (int i = 0; i < SHAPES_COUNT; i++) {
+        counts[i] = 0;
+        total += blockblaster_shape_weight(i, t);
+    }
+    for (long n = 0; n < BENCH_SAMPLER_DRAWS; n++)
+        counts[blockblaster_shape_draw(r, score)]++;
+
+    double chi2 = 0.0;
+    for (int i = 0; i < SHAPES_COUNT; i++) {
+        double expect =
+            BENCH_SAMPLER_DRAWS * blockblaster_shape_weight(i, t) / total;
+        double diff = (double) counts[i] - expect;
+        chi2 += diff * diff / expect;
+    }
+    return chi2;
+}
+
+/* Upper 0.1% point of the chi-square distribution with df degrees of
+   freedom (Wilson-Hilferty approximation). */
+static double bench_chi2_limit(int df)
+{
+    double k = 2.0 / (9.0 * df);
+    double c = 1.0 - k + 3.09 * sqrt(k);
+    return df * c * c * c;
+}
+
+/* Check the alias sampler's distribution, then time it against the linear
+   scan.  Returns 0 on success, 1 if a chi-square check fails. */
+static int bench_sampler(void)
+{
+    static const long scores[] = {0, 10000, 37500, 60001,
+                                  DIFFICULTY_MAX_SCORE};
+    const int nscores = (int) (sizeof(scores) / sizeof(scores[0]));
+    Rng r;
+    blockblaster_rng_seed(&r, 1u, RNG_STREAM_GAMEPLAY);
+    blockblaster_shape_sampler_init();
+
+    double limit = bench_chi2_limit(SHAPES_COUNT - 1);
+    printf("\nShape sampler: %d shapes, %d difficulty levels\n", SHAPES_COUNT,
+           DIFFICULTY_LEVELS);
+    printf("%-7s %10s %10s\n", "score", "chi2", "limit");
+    for (int i = 0; i < nscores; i++) {
+        double chi2 = bench_sampler_chi2(&r, scores[i]);
+        printf("%-7ld %10.1f %10.1f\n", scores[i], chi2, limit);
+        if (chi2 > limit) {
+            fprintf(stderr, "alias sampler distribution differs at score %ld\n",
+                    scores[i]);
+            return 1;
+        }
+    }
+
+    volatile int sink = 0;
+    double t0 = bench_now();
+    for (int i = 0; i < nscores; i++)
+        for (long n = 0; n < BENCH_SAMPLER_TIMED; n++)
+            sink += bench_linear_draw(&r, scores[i]);
+    double linear_dt = bench_now() - t0;
+    t0 = bench_now();
+    for (int i = 0; i < nscores; i++)
+        for (long n = 0; n < BENCH_SAMPLER_TIMED; n++)
+            sink += blockblaster_shape_draw(&r, scores[i]);
+    double alias_dt = bench_now() - t0;
+    (void) sink;
+
+    double draws = (double) nscores * BENCH_SAMPLER_TIMED;
+    printf("%-7s %14s %12s %9s\n", "picker", "draws/s", "ns/draw",
+           "speedup");
+    printf("%-7s %14.4g %12.1f %8.2fx\n", "linear", draws / linear_dt,
+           linear_dt * 1e9 / draws, 1.0);
+    printf("%-7s %14.4g %12.1f %8.2fx\n", "alias", draws / alias_dt,
+           alias_dt * 1e9 / draws, linear_dt / alias_dt);
+    return 0;
+}
+
+/* Advance c with the greedy policy to a fresh 4-piece tray after about
+   `moves` placements.  Returns false if the game ended first. */
+static bool bench_solver_position(CoreGame *c, Rng *r, int moves)
+{
+    const Policy *greedy = blockblaster_policy_find("greedy");
+    for (int i = 0; !c->game_over; i++) {
+        if (i >= moves && blockblaster_policy_legal_moves(c) > 0) {
+            bool fresh = true;
+            for (int k = 0; k < c->tray_count; k++)
+                fresh = fresh && !c->tray[k].used;
+            if (fresh)
+                return true;
+        }
+        PolicyMove pm;
+        if (!greedy->choose(c, r, &pm) ||
+            !blockblaster_core_drop(c, pm.slot, pm.gx, pm.gy, NULL))
+            return false;
+    }
+    return false;
+}
+
+/* Solve positions from greedy self-play on 10x10, 15x15 and 20x20 grids
+   with 4-piece trays.  Each result is replayed with core_drop to check
+   that every move is legal and the reported gain matches the game score.
+   Returns 0 on success, 1 on a mismatch. */
+static int bench_solver(void)
+{
+    static const int sizes[] = {10, 15, 20};
+    static CoreGame c, replay;
+    Solver s;
+    if (!blockblaster_solver_init(&s, SOLVER_TT_BITS_DEFAULT)) {
+        fprintf(stderr, "cannot allocate the solver table\n");
+        return 1;
+    }
+
+    printf("\nTray solver: 4 pieces, beam %d/%d/%d/%d, %d positions per "
+           "grid\n",
+           s.beam[0], s.beam[1], s.beam[2], s.beam[3], BENCH_SOLVER_POSITIONS);
+    printf("%-7s %10s %10s %10s %10s %9s\n", "grid", "mean ms", "max ms",
+           "nodes", "tt hits", "complete");
+    for (size_t si = 0; si < sizeof(sizes) / sizeof(sizes[0]); si++) {
+        int size = sizes[si];
+        Rng r;
+        blockblaster_rng_seed(&r, 7u, (uint64_t) size);
+        double total = 0.0, worst = 0.0;
+        long nodes = 0, hits = 0;
+        int solved = 0, complete = 0;
+        for (int p = 0; solved < BENCH_SOLVER_POSITIONS; p++) {
+            memset(&c, 0, sizeof(c));
+            blockblaster_rng_seed(&c.rng, (uint64_t) p, RNG_STREAM_GAMEPLAY);
+            blockblaster_core_start(&c, size, size, 4, p & 1);
+            if (!bench_solver_position(&c, &r, p % (size * 8)))
+                continue;
+
+            SolverResult res;
+            double t0 = bench_now();
+            bool found = blockblaster_solver_solve(&s, &c, &res);
+            double dt = bench_now() - t0;
+
+            replay = c;
+            long score0 = replay.score;
+            for (int i = 0; found && i < res.count; i++) {
+                if (!blockblaster_core_drop(&replay, res.moves[i].slot,
+                                            res.moves[i].gx, res.moves[i].gy,
+                                            NULL)) {
+                    fprintf(stderr, "solver move %d is illegal on %dx%d "
+                            "position %d\n", i, size, size, p);
+                    blockblaster_solver_free(&s);
+                    return 1;
+                }
+            }
+            if (found && replay.score - score0 != res.gain) {
+                fprintf(stderr, "solver gain %ld != replayed %ld on %dx%d "
+                        "position %d\n", res.gain, replay.score - score0,
+                        size, size, p);
+                blockblaster_solver_free(&s);
+                return 1;
+            }
+
+            total += dt;
+            if (dt > worst)
+                worst = dt;
+            nodes += res.nodes;
+            hits += res.tt_hits;
+            complete += res.complete;
+            solved++;
+        }
+        char label[16];
+        snprintf(label, sizeof(label), "%dx%d", size, size);
+        printf("%-7s %10.3f %10.3f %10.1f %10.1f %8.1f%%\n", label,
+               total * 1e3 / solved, worst * 1e3, (double) nodes / solved,
+               (double) hits / solved, 100.0 * complete / solved);
+    }
+    blockblaster_solver_free(&s);
+    return 0;
+}
+
+/* Greedy self-play with fair trays on 10x10, 15x15 and 20x20 grids with
+   4-piece trays, node limit only so runs repeat exactly.  Every kept set that
+   did not exhaust the budget is re-checked as placeable in full.  Reports
+   the cost of each deal and the game length against blind dealing.
+   Returns 0 on success, 1 if a fair deal is not placeable. */
+static int bench_fair_tray(void)
+{
+    static const int sizes[] = {10, 15, 20};
+    static CoreGame c;
+    const Policy *greedy = blockblaster_policy_find("greedy");
+
+    printf("\nFair trays: 4 pieces, greedy play, %d games per grid\n",
+           BENCH_FAIR_GAMES);
+    printf("%-7s %10s %10s %9s %9s %9s %11s %11s\n", "grid", "mean us",
+           "max us", "nodes", "redraw", "budget", "moves fair",
+           "moves blind");
+    for (size_t si = 0; si < sizeof(sizes) / sizeof(sizes[0]); si++) {
+        int size = sizes[si];
+        FairTrayStats sum;
+        memset(&sum, 0, sizeof(sum));
+        long moves[2] = {0, 0};
+        for (int fair = 1; fair >= 0; fair--) {
+            for (int g = 0; g < BENCH_FAIR_GAMES; g++) {
+                Rng r;
+                blockblaster_rng_seed(&r, (uint64_t) g, 11u);
+                memset(&c, 0, sizeof(c));
+                blockblaster_rng_seed(&c.rng, (uint64_t) g,
+                                      RNG_STREAM_GAMEPLAY);
+                c.fair_tray = fair;
+                blockblaster_core_start(&c, size, size, 4, g & 1);
+                /* Check each set right after it is dealt, unless that
+                   deal ran out of budget. */
+                bool dealt = true;
+                long hits = 0;
+                for (int m = 0; !c.game_over && m < BENCH_FAIR_MAX_MOVES;
+                     m++) {
+                    if (fair && dealt && c.fair.budget_hits == hits &&
+                        blockblaster_tray_feasible(&c, FAIR_TRAY_DRAW_NODES,
+                                                   0, NULL) != 1) {
+                        fprintf(stderr, "fair deal not placeable on %dx%d "
+                                "game %d move %d\n", size, size, g, m);
+                        return 1;
+                    }
+                    hits = c.fair.budget_hits;
+                    PolicyMove pm;
+                    CoreMove mv;
+                    if (!greedy->choose(&c, &r, &pm) ||
+                        !blockblaster_core_drop(&c, pm.slot, pm.gx, pm.gy,
+                                                &mv))
+                        break;
+                    moves[fair]++;
+                    dealt = mv.refilled;
+                }
+                if (fair) {
+                    sum.deals += c.fair.deals;
+                    sum.redraws += c.fair.redraws;
+                    sum.budget_hits += c.fair.budget_hits;
+                    sum.nodes += c.fair.nodes;
+                    sum.total_us += c.fair.total_us;
+                    if (c.fair.max_us > sum.max_us)
+                        sum.max_us = c.fair.max_us;
+                }
+            }
+        }
+        char label[16];
+        snprintf(label, sizeof(label), "%dx%d", size, size);
+        printf("%-7s %10.2f %10.1f %9.1f %8.2f%% %9ld %11.1f %11.1f\n",
+               label, sum.total_us / sum.deals, sum.max_us,
+               (double) sum.nodes / sum.deals,
+               100.0 * sum.redraws / sum.deals, sum.budget_hits,
+               (double) moves[1] / BENCH_FAIR_GAMES,
+               (double) moves[0] / BENCH_FAIR_GAMES);
+    }
+    return 0;
+}
+
+/* Write a legal action for game i of v: the first anchor row of the first
+   unused slot that fits, and the leftmost column in that row. */
+static void bench_vec_first_fit(VecEnv *v, int i)
+{
+    const uint32_t *rows = v->rows + (size_t) i * VECENV_ROW_STRIDE;
+    const uint8_t *shape = v->tray_shape + (size_t) i * PIECES_PER_SET_MAX;
+    SCAN_PATHS path = blockblaster_scan_active_path();
+    v->act_slot[i] = 0;
+    v->act_gx[i] = 0;
+    v->act_gy[i] = 0;
+    for (int k = 0; k < v->tray; k++) {
+        if (shape[k] == VECENV_SLOT_USED)
+            continue;
+        const ShapeMask *m = &SHAPE_MASKS[shape[k]];
+        int y = blockblaster_scan_first_row(path, rows, v->grid, v->grid, m);
+        if (y < 0)
+            continue;
+        uint32_t ok = GRID_BITS(v->grid - m->max_x);
+        for (int sy = m->min_y; sy <= m->max_y; sy++)
+            for (uint32_t b = m->rows[sy]; b; b &= b - 1)
+                ok &= ~(rows[y + sy] >> __builtin_ctz(b));
+        v->act_slot[i] = (uint8_t) k;
+        v->act_gx[i] = (uint8_t) __builtin_ctz(ok);
+        v->act_gy[i] = (uint8_t) y;
+        return;
+    }
+}
+
+/* Start the next episode of mirror game i the way the VecEnv does. */
+static void bench_vec_mirror_reset(const VecEnv *v, CoreGame *c, int i,
+                                   uint32_t *episode)
+{
+    do {
+        memset(c, 0, sizeof(*c));
+        blockblaster_rng_seed(&c->rng, v->seed,
+                              (uint64_t) i << 32 | (*episode)++);
+        blockblaster_core_start(c, v->grid, v->grid, v->tray, v->mode);
+    } while (c->game_over);
+}
+
+/* Play the same actions on a VecEnv and on one CoreGame per game, mostly
+   first-fit moves with some random (often illegal) ones, and compare the
+   outcome and state after every step.  Returns false on a mismatch. */
+static bool bench_vec_check(int grid, int tray, int mode)
+{
+    const int n = BENCH_VEC_CHECK_GAMES;
+    VecEnv v;
+    CoreGame *mirror = calloc((size_t) n, sizeof(*mirror));
+    uint32_t episode[BENCH_VEC_CHECK_GAMES] = {0};
+    if (!mirror || !blockblaster_vecenv_init(&v, n, grid, tray, mode, 7)) {
+        free(mirror);
+        fprintf(stderr, "vecenv: out of memory\n");
+        return false;
+    }
+    for (int i = 0; i < n; i++)
+        bench_vec_mirror_reset(&v, &mirror[i], i, &episode[i]);
+
+    bool ok = true;
+    for (int round = 0; ok && round < BENCH_VEC_CHECK_ROUNDS; round++) {
+        for (int i = 0; i < n; i++) {
+            bench_vec_first_fit(&v, i);
+            if (bench_rand() % 5 == 0) {
+                v.act_slot[i] = (uint8_t) (bench_rand() % (tray + 1));
+                v.act_gx[i] = (uint8_t) (bench_rand() % grid);
+                v.act_gy[i] = (uint8_t) (bench_rand() % grid);
+            }
+        }
+        blockblaster_vecenv_step(&v, 0, n);
+
+        for (int i = 0; ok && i < n; i++) {
+            CoreGame *c = &mirror[i];
+            CoreMove mv;
+            bool placed = blockblaster_core_drop(c, v.act_slot[i],
+                                                 v.act_gx[i], v.act_gy[i],
+                                                 &mv);
+            ok = v.placed[i] == placed && v.reward[i] == (placed ? mv.gain
+                                                                 : 0) &&
+                 v.done[i] == c->game_over;
+            if (ok && c->game_over) {
+                ok = v.final_score[i] == c->score;
+                bench_vec_mirror_reset(&v, c, i, &episode[i]);
+            }
+            const uint32_t *rows = v.rows + (size_t) i * VECENV_ROW_STRIDE;
+            const uint8_t *shape =
+                v.tray_shape + (size_t) i * PIECES_PER_SET_MAX;
+            ok = ok && v.score[i] == c->score;
+            for (int y = 0; ok && y < grid; y++)
+                ok = rows[y] == c->grid.rows[y];
+            for (int k = 0; ok && k < tray; k++)
+                ok = shape[k] == (c->tray[k].used ? VECENV_SLOT_USED
+                                                  : c->tray[k].shape_id);
+            if (!ok)
+                fprintf(stderr,
+                        "vecenv %dx%d tray %d mode %d: game %d differs "
+                        "from CoreGame at round %d\n",
+                        grid, grid, tray, mode, i, round);
+        }
+    }
+    blockblaster_vecenv_free(&v);
+    free(mirror);
+    return ok;
+}
+
+/* One thread of the batched environment benchmark: steps games [i0, i1)
+   for `rounds` rounds and times the step calls only. */
+typedef struct {
+    VecEnv *v;
+    int i0, i1;
+    long rounds;
+    double seconds;
+} BenchVecThread;
+
+static void *bench_vec_thread(void *arg)
+{
+    BenchVecThread *t = arg;
+    double spent = 0.0;
+    for (long r = 0; r < t->rounds; r++) {
+        for (int i = t->i0; i < t->i1; i++)
+            bench_vec_first_fit(t->v, i);
+        double t0 = bench_now();
+        blockblaster_vecenv_step(t->v, t->i0, t->i1);
+        spent += bench_now() - t0;
+    }
+    t->seconds = spent;
+    return NULL;
+}
+
+/* Aggregate steps per second of n first-fit games on nthreads threads, or
+   a negative value on failure. */
+static double bench_vec_rate(int grid, int n, int nthreads)
+{
+    VecEnv v;
+    if (!blockblaster_vecenv_init(&v, n, grid, 4, 0, 1))
+        return -1.0;
+    if (nthreads > n)
+        nthreads = n;
+    long rounds = BENCH_VEC_STEPS / n > 0 ? BENCH_VEC_STEPS / n : 1;
+
+    BenchVecThread t[BENCH_VEC_MAX_THREADS];
+    pthread_t tid[BENCH_VEC_MAX_THREADS];
+    int started = 0;
+    for (int k = 0; k < nthreads; k++) {
+        t[k].v = &v;
+        t[k].i0 = (int) ((long) n * k / nthreads);
+        t[k].i1 = (int) ((long) n * (k + 1) / nthreads);
+        t[k].rounds = rounds;
+        t[k].seconds = 0.0;
+        if (pthread_create(&tid[k], NULL, bench_vec_thread, &t[k]) != 0)
+            break;
+        started++;
+    }
+    double rate = started == nthreads ? 0.0 : -1.0;
+    for (int k = 0; k < started; k++) {
+        pthread_join(tid[k], NULL);
+        if (rate >= 0.0 && t[k].seconds > 0.0)
+            rate += (double) (t[k].i1 - t[k].i0) * rounds / t[k].seconds;
+    }
+    blockblaster_vecenv_free(&v);
+    return rate;
+}
+
+/* Check the batched environment against CoreGame on several settings,
+   then report its step rate for N = 1, 64, 1024 and 16384 games on one
+   thread and on one thread per online CPU (each thread steps its own
+   range of games).  Returns 0 on success, 1 on a mismatch or failure. */
+static int bench_vecenv(void)
+{
+    static const int check[][3] = {{10, 4, 0}, {15, 3, 1}, {20, 2, 0}};
+    static const int batch[] = {1, 64, 1024, 16384};
+    static const int sizes[] = {10, 20};
+
+    for (size_t k = 0; k < sizeof(check) / sizeof(check[0]); k++)
+        if (!bench_vec_check(check[k][0], check[k][1], check[k][2]))
+            return 1;
+
+    int cpus = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    if (online > 0)
+        cpus = online > BENCH_VEC_MAX_THREADS ? BENCH_VEC_MAX_THREADS
+                                              : (int) online;
+#endif
+    printf("\nBatched environment: 4 pieces, first-fit actions, step time "
+           "only\n");
+    printf("%-7s %7s %15s %15s\n", "grid", "N", "steps/s 1 thr",
+           cpus > 1 ? "steps/s all" : "steps/s all (1)");
+    for (size_t si = 0; si < sizeof(sizes) / sizeof(sizes[0]); si++) {
+        for (size_t bi = 0; bi < sizeof(batch) / sizeof(batch[0]); bi++) {
+            double one = bench_vec_rate(sizes[si], batch[bi], 1);
+            double all = bench_vec_rate(sizes[si], batch[bi], cpus);
+            if (one < 0.0 || all < 0.0) {
+                fprintf(stderr, "vecenv: out of memory or no threads\n");
+                return 1;
+            }
+            char label[16];
+            snprintf(label, sizeof(label), "%dx%d", sizes[si], sizes[si]);
+            printf("%-7s %7d %15.4g %15.4g\n", label, batch[bi], one, all);
+        }
+    }
+    return 0;
+}
+
+/* True when a and b hold the same rules state (grid, tray, bag, stream and
+   counters). */
+static bool bench_same_state(const CoreGame *a, const CoreGame *b)
+{
+    if (memcmp(a->grid.rows, b->grid.rows, sizeof(a->grid.rows)) != 0 ||
+        memcmp(a->grid.cols, b->grid.cols, sizeof(a->grid.cols)) != 0 ||
+        memcmp(a->grid.has_theme, b->grid.has_theme,
+               sizeof(a->grid.has_theme)) != 0 ||
+        memcmp(a->place_map, b->place_map, sizeof(a->place_map)) != 0 ||
+        memcmp(a->bag, b->bag, sizeof(a->bag)) != 0 ||
+        a->rng.state != b->rng.state || a->score != b->score ||
+        a->combo != b->combo || a->highest_combo != b->highest_combo ||
+        a->combo_miss != b->combo_miss ||
+        a->last_move_mult != b->last_move_mult ||
+        a->bag_pos != b->bag_pos || a->game_over != b->game_over)
+        return false;
+    for (int y = 0; y < a->grid.h; y++)
+        for (int x = 0; x < a->grid.w; x++)
+            if (a->grid.has_theme[y][x] &&
+                a->grid.cell_theme[y][x] != b->grid.cell_theme[y][x])
+                return false;
+    for (int i = 0; i < a->tray_count; i++)
+        if (a->tray[i].shape_id != b->tray[i].shape_id ||
+            a->tray[i].used != b->tray[i].used ||
+            a->tray[i].theme != b->tray[i].theme)
+            return false;
+    return true;
+}
+
+/* Record greedy games with 4-piece trays on each grid size, index and
+   encode them, and check that they decode and verify.  Then seek to random
+   moves through the keyframes and by playing from the start, check both
+   give the same state and time them.  Returns 0 on success, 1 on a
+   mismatch. */
+static int bench_replay(void)
+{
+    static const int sizes[] = {10, 15, 20};
+    static CoreGame a, b;
+    const Policy *greedy = blockblaster_policy_find("greedy");
+    Replay rec = {0}, dec = {0}, bad = {0};
+    uint8_t *buf = NULL;
+    int ret = 0;
+
+    printf("\nReplays: 4 pieces, greedy play, %d games per grid, keyframe "
+           "every %d drops\n",
+           BENCH_REPLAY_GAMES, REPLAY_KEYFRAME_INTERVAL);
+    printf("%-7s %9s %11s %11s %12s %12s\n", "grid", "moves", "bytes/move",
+           "keys/move", "seek us", "from 0 us");
+    for (size_t si = 0; si < sizeof(sizes) / sizeof(sizes[0]) && !ret; si++) {
+        int size = sizes[si];
+        long moves = 0, seeks = 0;
+        size_t bytes = 0, key_bytes = 0;
+        double t_key = 0.0, t_start = 0.0;
+        for (int g = 0; g < BENCH_REPLAY_GAMES && !ret; g++) {
+            Rng r;
+            blockblaster_rng_seed(&r, (uint64_t) g, 13u);
+            blockblaster_replay_begin(&rec, (uint64_t) g + 1, size, 4, g & 1,
+                                      false);
+            blockblaster_replay_start(&rec, &a);
+            PolicyMove pm;
+            while (!a.game_over && greedy->choose(&a, &r, &pm) &&
+                   blockblaster_core_drop(&a, pm.slot, pm.gx, pm.gy, NULL))
+                blockblaster_replay_add(&rec, pm.slot, pm.gx, pm.gy);
+            blockblaster_replay_finish(&rec, &a);
+
+            size_t plain = blockblaster_replay_size(&rec);
+            uint8_t *nb = blockblaster_replay_index(&rec)
+                              ? realloc(buf, blockblaster_replay_size(&rec))
+                              : NULL;
+            if (!nb) {
+                fprintf(stderr, "replay: cannot index game %d\n", g);
+                ret = 1;
+                break;
+            }
+            buf = nb;
+            size_t len = blockblaster_replay_size(&rec);
+            blockblaster_replay_encode(&rec, buf);
+            if (!blockblaster_replay_decode(&dec, buf, len) ||
+                dec.key_count != rec.key_count ||
+                blockblaster_replay_verify(&dec, &b, NULL) != REPLAY_OK) {
+                fprintf(stderr, "replay: %dx%d game %d does not verify\n",
+                        size, size, g);
+                ret = 1;
+                break;
+            }
+            /* A damaged tray size must be refused by the header check
+               itself: with the keyframe count zeroed, no keyframe size
+               check stands in for it. */
+            uint8_t *keys = buf + REPLAY_HEADER_SIZE + 2 * (size_t) rec.count;
+            uint8_t saved[5] = {buf[6], keys[4], keys[5], keys[6], keys[7]};
+            buf[6] = PIECES_PER_SET_MAX + 1;
+            memset(keys + 4, 0, 4);
+            bool bad_ok = blockblaster_replay_decode(&bad, buf, len);
+            buf[6] = saved[0];
+            memcpy(keys + 4, saved + 1, 4);
+            if (bad_ok) {
+                fprintf(stderr, "replay: tray size %d decoded\n",
+                        PIECES_PER_SET_MAX + 1);
+                ret = 1;
+                break;
+            }
+            moves += rec.count;
+            bytes += len;
+            key_bytes += len - plain;
+
+            Replay flat = dec;
+            flat.key_count = 0;
+            for (int k = 0; k < BENCH_REPLAY_SEEKS; k++) {
+                int m = (int) (bench_rand() % (uint32_t) (dec.count + 1));
+                double t0 = bench_now();
+                bool ok = blockblaster_replay_seek(&dec, m, &a);
+                double t1 = bench_now();
+                ok = blockblaster_replay_seek(&flat, m, &b) && ok;
+                double t2 = bench_now();
+                if (!ok || !bench_same_state(&a, &b)) {
+                    fprintf(stderr, "replay: seek to %d differs on %dx%d "
+                            "game %d\n", m, size, size, g);
+                    ret = 1;
+                    break;
+                }
+                t_key += t1 - t0;
+                t_start += t2 - t1;
+                seeks++;
+            }
+        }
+        if (ret)
+            break;
+        char label[16];
+        snprintf(label, sizeof(label), "%dx%d", size, size);
+        printf("%-7s %9.1f %11.2f %11.2f %12.1f %12.1f\n", label,
+               (double) moves / BENCH_REPLAY_GAMES, (double) bytes / moves,
+               (double) key_bytes / moves, t_key * 1e6 / seeks,
+               t_start * 1e6 / seeks);
+    }
+    free(buf);
+    blockblaster_replay_free(&rec);
+    blockblaster_replay_free(&dec);
+    blockblaster_replay_free(&bad);
+    return ret;
+}
+
+/* Play greedy games with 4-piece trays on each grid size, recording every
+   state into an undo history.  Every few drops, undo a random number of
+   levels, redo some of them and sometimes play on from there, checking
+   each state against a full copy kept on the side.  Reports the time per
+   record and per undo or redo and the history memory per level.  Returns
+   0 on success, 1 on a mismatch. */
+static int bench_undo(void)
+{
+    static const int sizes[] = {10, 15, 20};
+    static CoreGame states[BENCH_UNDO_MOVES + 1];
+    const Policy *greedy = blockblaster_policy_find("greedy");
+    UndoHistory *h = blockblaster_undo_create();
+    if (!h) {
+        fprintf(stderr, "undo: out of memory\n");
+        return 1;
+    }
+    int ret = 0;
+
+    printf("\nUndo: 4 pieces, greedy play, %d games of up to %d drops per "
+           "grid, %d levels\n",
+           BENCH_UNDO_GAMES, BENCH_UNDO_MOVES, UNDO_DEPTH - 1);
+    printf("%-7s %10s %10s %10s %12s %12s\n", "grid", "record ns",
+           "undo ns", "redo ns", "bytes/level", "copy bytes");
+    for (size_t si = 0; si < sizeof(sizes) / sizeof(sizes[0]) && !ret; si++) {
+        int size = sizes[si];
+        long records = 0, undos = 0, redos = 0, samples = 0;
+        double t_rec = 0.0, t_undo = 0.0, t_redo = 0.0, per_level = 0.0;
+        for (int g = 0; g < BENCH_UNDO_GAMES && !ret; g++) {
+            CoreGame c = {0};
+            Rng r;
+            blockblaster_rng_seed(&r, (uint64_t) g, 17u);
+            blockblaster_rng_seed(&c.rng, (uint64_t) g + 1,
+                                  RNG_STREAM_GAMEPLAY);
+            blockblaster_core_start(&c, size, size, 4, g & 1);
+            blockblaster_undo_reset(h);
+            int n = 0; /* Drops in the current line of play. */
+            PolicyMove pm;
+            while (n < BENCH_UNDO_MOVES && !c.game_over &&
+                   greedy->choose(&c, &r, &pm)) {
+                states[n] = c;
+                double t0 = bench_now();
+                blockblaster_undo_record(h, &c, (uint16_t) n);
+                t_rec += bench_now() - t0;
+                records++;
+                if (!blockblaster_core_drop(&c, pm.slot, pm.gx, pm.gy, NULL))
+                    break;
+                n++;
+                int levels = blockblaster_undo_levels(h);
+                if (levels == UNDO_DEPTH - 1) {
+                    per_level +=
+                        (double) blockblaster_undo_bytes_used(h) / levels;
+                    samples++;
+                }
+                if (n % 37 != 0)
+                    continue;
+
+                /* Undo k levels, redo j of them, check each state. */
+                states[n] = c;
+                int k = 1 + (int) (bench_rand() % (uint32_t) levels);
+                int j = (int) (bench_rand() % (uint32_t) (k + 1));
+                for (int i = 1; i <= k && !ret; i++) {
+                    t0 = bench_now();
+                    bool ok = blockblaster_undo(h, &c);
+                    t_undo += bench_now() - t0;
+                    undos++;
+                    if (!ok || !bench_same_state(&c, &states[n - i]))
+                        ret = 1;
+                }
+                for (int i = 1; i <= j && !ret; i++) {
+                    uint16_t mv;
+                    t0 = bench_now();
+                    bool ok = blockblaster_redo(h, &c, &mv);
+                    t_redo += bench_now() - t0;
+                    redos++;
+                    if (!ok || mv != n - k + i - 1 ||
+                        !bench_same_state(&c, &states[n - k + i]))
+                        ret = 1;
+                }
+                if (ret) {
+                    fprintf(stderr, "undo: %dx%d game %d differs after "
+                            "drop %d\n", size, size, g, n);
+                    break;
+                }
+                /* Play on from there (half the time) or redo to the end. */
+                n = n - k + j;
+                if (bench_rand() % 2 == 0)
+                    continue;
+                while (blockblaster_redo(h, &c, NULL))
+                    n++;
+                if (!bench_same_state(&c, &states[n])) {
+                    fprintf(stderr, "undo: %dx%d game %d differs after "
+                            "redoing to drop %d\n", size, size, g, n);
+                    ret = 1;
+                }
+            }
+        }
+        if (ret)
+            break;
+        char label[16];
+        snprintf(label, sizeof(label), "%dx%d", size, size);
+        printf("%-7s %10.1f %10.1f %10.1f %12.1f %12zu\n", label,
+               t_rec * 1e9 / records, t_undo * 1e9 / undos,
+               t_redo * 1e9 / redos, samples ? per_level / samples : 0.0,
+               sizeof(CoreGame));
+    }
+    blockblaster_undo_destroy(h);
+    return ret;
+}
+
+/* Per-cell reference of the board features: plain loops over the cells,
+   a stack flood fill for the regions and the classic dynamic programme for
+   the largest square.  Only the totals and the square corner are filled
+   in; the regions go to *regions. */
+static void bench_features_ref(const Grid *g, BoardFeatures *f, int *regions)
+{
+    static uint8_t side[GRID_H_MAX + 1][GRID_W_MAX + 1];
+    bool seen[GRID_H_MAX][GRID_W_MAX] = {{false}};
+    int stack[GRID_H_MAX * GRID_W_MAX];
+    int w = g->w, h = g->h;
+
+    memset(f, 0, sizeof(*f));
+    *regions = 0;
+    for (int y = 0; y < h; y++) {
+        int gap = 0;
+        for (int x = 0; x < w; x++) {
+            bool occ = GRID_OCC(g, x, y);
+            f->transitions += (x + 1 < w && occ != GRID_OCC(g, x + 1, y)) +
+                              (y + 1 < h && occ != GRID_OCC(g, x, y + 1));
+            if (occ)
+                continue;
+            gap++;
+            f->empty++;
+            f->holes += (x == 0 || GRID_OCC(g, x - 1, y)) &&
+                        (x + 1 == w || GRID_OCC(g, x + 1, y)) &&
+                        (y == 0 || GRID_OCC(g, x, y - 1)) &&
+                        (y + 1 == h || GRID_OCC(g, x, y + 1));
+        }
+        f->near_rows += gap >= 1 && gap <= FEATURES_NEAR_GAP;
+    }
+    for (int x = 0; x < w; x++) {
+        int gap = 0;
+        for (int y = 0; y < h; y++)
+            gap += !GRID_OCC(g, x, y);
+        f->near_cols += gap >= 1 && gap <= FEATURES_NEAR_GAP;
+    }
+
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            if (GRID_OCC(g, x, y) || seen[y][x])
+                continue;
+            (*regions)++;
+            int top = 0;
+            stack[top++] = y * GRID_W_MAX + x;
+            seen[y][x] = true;
+            while (top > 0) {
+                int cx = stack[--top] % GRID_W_MAX;
+                int cy = stack[top] / GRID_W_MAX;
+                static const int dx[4] = {1, -1, 0, 0};
+                static const int dy[4] = {0, 0, 1, -1};
+                for (int d = 0; d < 4; d++) {
+                    int nx = cx + dx[d], ny = cy + dy[d];
+                    if (nx < 0 || ny < 0 || nx >= w || ny >= h ||
+                        GRID_OCC(g, nx, ny) || seen[ny][nx])
+                        continue;
+                    seen[ny][nx] = true;
+                    stack[top++] = ny * GRID_W_MAX + nx;
+                }
+            }
+        }
+    }
+
+    memset(side, 0, sizeof(side));
+    for (int y = h - 1; y >= 0; y--) {
+        for (int x = w - 1; x >= 0; x--) {
+            int k = 0;
+            if (!GRID_OCC(g, x, y)) {
+                k = side[y + 1][x];
+                if (side[y][x + 1] < k)
+                    k = side[y][x + 1];
+                if (side[y + 1][x + 1] < k)
+                    k = side[y + 1][x + 1];
+                k++;
+            }
+            side[y][x] = (uint8_t) k;
+            if (k > f->square) {
+                f->square = k;
+                f->square_x = x;
+                f->square_y = y;
+            }
+        }
+    }
+}
+
+/* True when the totals of a and b match and both square corners point at
+   an empty square of the reported side. */
+static bool bench_same_features(const Grid *g, const BoardFeatures *a,
+                                const BoardFeatures *b)
+{
+    if (a->empty != b->empty || a->holes != b->holes ||
+        a->transitions != b->transitions || a->near_rows != b->near_rows ||
+        a->near_cols != b->near_cols || a->square != b->square)
+        return false;
+    const BoardFeatures *fs[2] = {a, b};
+    for (int i = 0; i < 2; i++) {
+        if (fs[i]->square == 0)
+            continue;
+        if (fs[i]->square_x < 0 || fs[i]->square_y < 0 ||
+            fs[i]->square_x + fs[i]->square > g->w ||
+            fs[i]->square_y + fs[i]->square > g->h)
+            return false;
+        uint32_t span = GRID_BITS(fs[i]->square) << fs[i]->square_x;
+        for (int y = fs[i]->square_y; y < fs[i]->square_y + fs[i]->square;
+             y++)
+            if (g->rows[y] & span)
+                return false;
+    }
+    return true;
+}
+
+/* Follow greedy games with 4-piece trays on each grid size with the
+   incremental board features, checking them (and the region count) after
+   every drop against a full recount and the per-cell reference, and time
+   the updates of each drop against the recount.  Then time full
+   evaluations of the positions visited, regions included, against the
+   per-cell reference.  Returns 0 on success, 1 on a
+   mismatch. */
+static int bench_features(void)
+{
+    static const int sizes[] = {10, 15, 20};
+    static Grid pos[BENCH_FEATURE_POSITIONS];
+    const Policy *greedy = blockblaster_policy_find("greedy");
+
+    printf("\nBoard features: 4 pieces, greedy play, %d games per grid\n",
+           BENCH_FEATURE_GAMES);
+    printf("%-7s %12s %9s %12s %8s %11s %11s\n", "grid", "evals/s",
+           "ns/eval", "cell loop ns", "speedup", "recount ns", "update ns");
+    for (size_t si = 0; si < sizeof(sizes) / sizeof(sizes[0]); si++) {
+        int size = sizes[si];
+        int npos = 0;
+        long updates = 0;
+        double t_update = 0.0, t_recount = 0.0;
+        for (int g = 0; g < BENCH_FEATURE_GAMES; g++) {
+            CoreGame c = {0};
+            Rng r;
+            BoardFeatures inc, full, ref;
+            blockblaster_rng_seed(&r, (uint64_t) g, 23u);
+            blockblaster_rng_seed(&c.rng, (uint64_t) g + 1,
+                                  RNG_STREAM_GAMEPLAY);
+            blockblaster_core_start(&c, size, size, 4, g & 1);
+            blockblaster_features_compute(&inc, &c.grid);
+            PolicyMove pm;
+            for (int n = 0; !c.game_over && greedy->choose(&c, &r, &pm);
+                 n++) {
+                const ShapeMask *m = &SHAPE_MASKS[c.tray[pm.slot].shape_id];
+                CoreMove mv;
+                if (!blockblaster_core_place(&c, pm.slot, pm.gx, pm.gy, &mv))
+                    break;
+                /* Each update works on a copy, repeated to time it. */
+                BoardFeatures next = inc;
+                double t0 = bench_now();
+                for (int k = 0; k < BENCH_FEATURE_REPEATS; k++) {
+                    next = inc;
+                    blockblaster_features_after_place(&next, &c.grid, m,
+                                                      pm.gx, pm.gy);
+                }
+                t_update += bench_now() - t0;
+                inc = next;
+                if (mv.lines > 0) {
+                    blockblaster_core_clear(&c, mv.full_rows, mv.full_cols);
+                    t0 = bench_now();
+                    for (int k = 0; k < BENCH_FEATURE_REPEATS; k++) {
+                        next = inc;
+                        blockblaster_features_after_clear(
+                            &next, &c.grid, mv.full_rows, mv.full_cols);
+                    }
+                    t_update += bench_now() - t0;
+                    inc = next;
+                }
+                t0 = bench_now();
+                for (int k = 0; k < BENCH_FEATURE_REPEATS; k++)
+                    blockblaster_features_compute(&full, &c.grid);
+                t_recount += bench_now() - t0;
+                updates += BENCH_FEATURE_REPEATS;
+                int ref_regions;
+                bench_features_ref(&c.grid, &ref, &ref_regions);
+                if (!bench_same_features(&c.grid, &inc, &full) ||
+                    !bench_same_features(&c.grid, &full, &ref) ||
+                    blockblaster_board_regions(c.grid.rows, size, size) !=
+                        ref_regions) {
+                    fprintf(stderr, "features: %dx%d game %d differs after "
+                            "drop %d\n", size, size, g, n);
+                    return 1;
+                }
+                if (npos < BENCH_FEATURE_POSITIONS)
+                    pos[npos++] = c.grid;
+            }
+        }
+
+        volatile int sink = 0;
+        BoardFeatures f;
+        double t0 = bench_now();
+        for (int p = 0; p < BENCH_FEATURE_PASSES; p++)
+            for (int i = 0; i < npos; i++) {
+                blockblaster_features_compute(&f, &pos[i]);
+                sink += f.holes + blockblaster_board_regions(
+                                      pos[i].rows, pos[i].w, pos[i].h);
+            }
+        double dt = bench_now() - t0;
+        t0 = bench_now();
+        for (int p = 0; p < BENCH_FEATURE_PASSES; p++)
+            for (int i = 0; i < npos; i++) {
+                int regions;
+                bench_features_ref(&pos[i], &f, &regions);
+                sink += f.holes + regions;
+            }
+        double ref_dt = bench_now() - t0;
+        (void) sink;
+
+        double evals = (double) npos * BENCH_FEATURE_PASSES;
+        char label[16];
+        snprintf(label, sizeof(label), "%dx%d", size, size);
+        printf("%-7s %12.4g %9.1f %12.1f %7.2fx %11.1f %11.1f\n", label,
+               evals / dt, dt * 1e9 / evals, ref_dt * 1e9 / evals,
+               ref_dt / dt, t_recount * 1e9 / updates,
+               t_update * 1e9 / updates);
+    }
+    return 0;
+}
+
+/* One particle of the reference: the array-of-structs layout and update
+   loop the particle system replaced. */
+typedef struct {
+    float x, y, vx, vy, life, life0;
+} BenchParticle;
+
+/* Reference step: integrate each live particle, replacing an expired one
+   by the last live particle, which is then stepped in its slot. */
+static void bench_particles_ref(BenchParticle *p, int *count, float dt)
+{
+    for (int i = 0; i < *count;) {
+        BenchParticle *q = &p[i];
+        q->life -= dt;
+        if (q->life <= 0.0f) {
+            *q = p[--*count];
+            continue;
+        }
+        q->vy += PARTICLE_GRAVITY * dt;
+        q->vx *= (1.0f - PARTICLE_DRAG_X * dt);
+        q->vy *= (1.0f - PARTICLE_DRAG_Y * dt);
+        q->x += q->vx * dt;
+        q->y += q->vy * dt;
+        i++;
+    }
+}
+
+/* True if a and b agree to a relative 1e-4 (kernels may contract a
+   multiply-add where the reference does not). */
+static bool bench_close(float a, float b)
+{
+    return fabsf(a - b) <= 1e-4f * (1.0f + fabsf(a) + fabsf(b));
+}
+
+/* Emit bursts on one pool per path and on the reference, step them all
+   for BENCH_PARTICLE_FRAMES frames and compare every live particle.  Then
+   time each path on pools kept full.  Returns 0 on success, 1 on a
+   mismatch or allocation failure. */
+static int bench_particles(void)
+{
+    static const int caps[] = {1000, 20000};
+    static BenchParticle ref[20000];
+    const float dt = 1.0f / 60.0f;
+    const ParticleBurst burst = {.x = 300.0f,
+                                 .y = 400.0f,
+                                 .r = 1.0f,
+                                 .g = 0.5f,
+                                 .b = 0.25f,
+                                 .size_min = 3.5f,
+                                 .size_max = 7.0f,
+                                 .scale = 1.0f,
+                                 .speed_min = PARTICLE_SPEED_MIN,
+                                 .speed_max = PARTICLE_SPEED_MAX};
+
+    printf("\nParticles: %d frames checked against the array-of-structs "
+           "loop, then %d frames timed on full pools\n",
+           BENCH_PARTICLE_FRAMES, BENCH_PARTICLE_TIMED);
+    printf("%-7s %-7s %12s %12s %9s %10s\n", "pool", "path", "ns/frame",
+           "ns/particle", "speedup", "emit ns/p");
+
+    for (int p = 0; p < SCAN_PATH_COUNT; p++) {
+        if (!blockblaster_scan_path_available((SCAN_PATHS) p))
+            continue;
+        ParticleSystem *ps = blockblaster_particles_create(caps[0]);
+        if (!ps) {
+            fprintf(stderr, "particles: out of memory\n");
+            return 1;
+        }
+        Rng r;
+        blockblaster_rng_seed(&r, 5u, RNG_STREAM_COSMETIC);
+        int count = 0;
+        for (int f = 0; f < BENCH_PARTICLE_FRAMES; f++) {
+            if (f % BENCH_PARTICLE_BURST == 0) {
+                int first = ps->count;
+                int n = blockblaster_particles_emit(ps, &r, &burst,
+                                                    60 + f % 200);
+                for (int i = first; i < first + n; i++)
+                    ref[count++] = (BenchParticle){
+                        ps->x[i],    ps->y[i],    ps->vx[i],
+                        ps->vy[i],   ps->life[i], ps->life[i]};
+            }
+            blockblaster_particles_update_path(ps, (SCAN_PATHS) p, dt);
+            bench_particles_ref(ref, &count, dt);
+            bool same = ps->count == count;
+            for (int i = 0; same && i < count; i++) {
+                float a = ref[i].life / ref[i].life0;
+                a = a < 0.0f ? 0.0f : (a > 1.0f ? 1.0f : a);
+                same = bench_close(ps->x[i], ref[i].x) &&
+                       bench_close(ps->y[i], ref[i].y) &&
+                       bench_close(ps->vx[i], ref[i].vx) &&
+                       bench_close(ps->vy[i], ref[i].vy) &&
+                       bench_close(ps->life[i], ref[i].life) &&
+                       bench_close(ps->alpha[i], a);
+            }
+            if (!same) {
+                fprintf(stderr, "particles: %s differs from the reference "
+                        "at frame %d\n",
+                        blockblaster_scan_path_name((SCAN_PATHS) p), f);
+                blockblaster_particles_destroy(ps);
+                return 1;
+            }
+        }
+        blockblaster_particles_destroy(ps);
+    }
+
+    for (size_t ci = 0; ci < sizeof(caps) / sizeof(caps[0]); ci++) {
+        double scalar_ns = 0.0;
+        for (int p = 0; p < SCAN_PATH_COUNT; p++) {
+            if (!blockblaster_scan_path_available((SCAN_PATHS) p))
+                continue;
+            ParticleSystem *ps = blockblaster_particles_create(caps[ci]);
+            if (!ps) {
+                fprintf(stderr, "particles: out of memory\n");
+                return 1;
+            }
+            Rng r;
+            blockblaster_rng_seed(&r, 6u, RNG_STREAM_COSMETIC);
+            int64_t update_ns = 0, emit_ns = 0;
+            long updated = 0, emitted = 0;
+            for (int f = 0; f < BENCH_PARTICLE_TIMED; f++) {
+                blockblaster_particles_emit(ps, &r, &burst, ps->cap);
+                blockblaster_particles_update_path(ps, (SCAN_PATHS) p, dt);
+                update_ns += ps->frame.update_ns;
+                emit_ns += ps->frame.emit_ns;
+                updated += ps->frame.updated;
+                emitted += ps->frame.emitted;
+            }
+            blockblaster_particles_destroy(ps);
+
+            double frame_ns = (double) update_ns / BENCH_PARTICLE_TIMED;
+            if (p == SCAN_PATH_SCALAR)
+                scalar_ns = frame_ns;
+            printf("%-7d %-7s %12.0f %12.2f %8.2fx %10.1f\n", caps[ci],
+                   blockblaster_scan_path_name((SCAN_PATHS) p), frame_ns,
+                   (double) update_ns / (double) updated,
+                   frame_ns > 0.0 ? scalar_ns / frame_ns : 1.0,
+                   emitted ? (double) emit_ns / (double) emitted : 0.0);
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief Benchmark entry point.
+ *
+ * \param argc  Argument count.
+ * \param argv  argv[1]: optional number of iterations.
+ * \return      0 on success, 1 if a generated shape mask does not match
+ *              SHAPES[], a path disagrees with the scalar kernel,
+ *              the shape sampler fails its distribution check, a solver
+ *              sequence does not replay, a fair deal is not placeable,
+ *              the batched environment differs from CoreGame, a replay
+ *              seek differs from playing from the start, an undo or redo
+ *              does not restore the recorded state, the board features
+ *              disagree with their per-cell reference or a particle update
+ *              path differs from the reference loop.
+ */
+int main(int argc, char *argv[])
+{
+    int iterations = (argc > 1) ? atoi(argv[1]) : BENCH_DEFAULT_ITERATIONS;
+    if (iterations <= 0)
+        iterations = BENCH_DEFAULT_ITERATIONS;
+
+    static const int sizes[] = {10, 15, 20};
+    static uint32_t grids[BENCH_GRIDS][GRID_H_MAX + GRID_ROW_PAD];
+    static int expect[BENCH_GRIDS][sizeof(SHAPE_MASKS) /
+                                   sizeof(SHAPE_MASKS[0])];
+
+    if (bench_shape_masks() != 0)
+        return 1;
+
+    blockblaster_scan_init();
+    printf("Active scan path: %s\n",
+           blockblaster_scan_path_name(blockblaster_scan_active_path()));
+    printf("%-7s %-7s %14s %12s %9s\n", "grid", "path", "anchors/s",
+           "ns/scan", "speedup");
+
+    for (size_t si = 0; si < sizeof(sizes) / sizeof(sizes[0]); si++) {
+        int w = sizes[si], h = sizes[si];
+
+        /* Densities from 40% to 95% so both early exits and full scans
+           (no fit anywhere) are represented. */
+        long anchors_per_pass = 0;
+        for (int gi = 0; gi < BENCH_GRIDS; gi++) {
+            bench_make_grid(grids[gi], w, h, 40 + (gi * 55) / BENCH_GRIDS);
+            for (int k = 0; k < SHAPES_COUNT; k++) {
+                expect[gi][k] = blockblaster_scan_first_row(
+                    SCAN_PATH_SCALAR, grids[gi], w, h, &SHAPE_MASKS[k]);
+                anchors_per_pass +=
+                    bench_anchors(&SHAPE_MASKS[k], w, h, expect[gi][k]);
+            }
+        }
+        long scans_per_pass = (long) BENCH_GRIDS * SHAPES_COUNT;
+
+        double scalar_rate = 0.0;
+        for (int p = 0; p < SCAN_PATH_COUNT; p++) {
+            if (!blockblaster_scan_path_available((SCAN_PATHS) p))
+                continue;
+
+            for (int gi = 0; gi < BENCH_GRIDS; gi++)
+                for (int k = 0; k < SHAPES_COUNT; k++)
+                    if (blockblaster_scan_first_row((SCAN_PATHS) p, grids[gi],
+                                                    w, h, &SHAPE_MASKS[k]) !=
+                        expect[gi][k]) {
+                        fprintf(stderr,
+                                "%s disagrees with scalar on %dx%d grid %d "
+                                "shape %d\n",
+                                blockblaster_scan_path_name((SCAN_PATHS) p), w,
+                                h, gi, k);
+                        return 1;
+                    }
+
+            volatile int sink = 0;
+            double t0 = bench_now();
+            for (int it = 0; it < iterations; it++)
+                for (int gi = 0; gi < BENCH_GRIDS; gi++)
+                    for (int k = 0; k < SHAPES_COUNT; k++)
+                        sink += blockblaster_scan_first_row(
+                            (SCAN_PATHS) p, grids[gi], w, h, &SHAPE_MASKS[k]);
+            double dt = bench_now() - t0;
+            (void) sink;
+
+            double anchors = (double) anchors_per_pass * iterations;
+            double scans = (double) scans_per_pass * iterations;
+            double rate = (dt > 0.0) ? anchors / dt : 0.0;
+            if (p == SCAN_PATH_SCALAR)
+                scalar_rate = rate;
+            char label[16];
+            snprintf(label, sizeof(label), "%dx%d", w, h);
+            printf("%-7s %-7s %14.4g %12.1f %8.2fx\n", label,
+                   blockblaster_scan_path_name((SCAN_PATHS) p), rate,
+                   dt * 1e9 / scans,
+                   scalar_rate > 0.0 ? rate / scalar_rate : 1.0);
+        }
+    }
+    if (bench_sampler() != 0)
+        return 1;
+    if (bench_solver() != 0)
+        return 1;
+    if (bench_fair_tray() != 0)
+        return 1;
+    if (bench_vecenv() != 0)
+        return 1;
+    if (bench_replay() != 0)
+        return 1;
+    if (bench_undo() != 0)
+        return 1;
+    if (bench_features() != 0)
+        return 1;
+    return bench_particles();
+}
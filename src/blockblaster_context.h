@@ -32,30 +32,34 @@ extern "C" {
 #include <allegro5/allegro_acodec.h>
 #include <allegro5/allegro_audio.h>
 #include <allegro5/allegro_font.h>
+#include <allegro5/allegro_primitives.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "blockblaster_core.h"
+#include "blockblaster_hint.h"
+#include "blockblaster_particles.h"
+#include "blockblaster_replay.h"
+#include "blockblaster_undo.h"
+
 /**
  * \defgroup GRID Grid dimensions
  * \brief Constants that define the size of the play grid.
+ *
+ * The grid size of a running game lives in GameContext.grid_w / grid_h.
  * @{
  */
 
-/** \brief Maximum number of columns (compile-time, used for array sizes). */
-#define GRID_W_MAX 20
-
-/** \brief Maximum number of rows (compile-time, used for array sizes). */
-#define GRID_H_MAX 20
-
-/** \brief Current number of columns in the play grid (runtime). */
-extern int GRID_W;
-
-/** \brief Current number of rows in the play grid (runtime). */
-extern int GRID_H;
+/** \brief Grid side length used until the saved settings are applied. */
+#define GRID_SIZE_DEFAULT 10
 
 /** \brief color of the tray and grid bordes */
 #define GRID_LINE_COLOR al_map_rgb(180, 180, 190)
 
+/** \brief Outline colour of the hint overlay. */
+#define HINT_COLOR al_map_rgba(255, 215, 90, 220)
+
 /** \brief Base line width of the tray and grid border (scaled by UI_SCALE). */
 #define GRID_LINE_WIDTH_BASE 3.0f
 
@@ -68,11 +72,11 @@ extern int GRID_H;
  * \defgroup CANVAS Virtual canvas and display
  * \brief Constants governing the virtual canvas and refresh rate.
  *
- * WIN_W and WIN_H are the virtual-canvas dimensions.  In windowed mode they
- * remain at their defaults (600 x 900).  In fullscreen mode (Android always;
- * desktop and Emscripten when toggled) update_view_offset() sets them to the
- * native display dimensions so the whole screen is used with no letterboxing
- * and scale = 1.0.
+ * GameContext.win_w and win_h are the virtual-canvas dimensions.  In
+ * windowed mode they remain at their defaults (600 x 900).  In fullscreen
+ * mode (Android always; desktop and Emscripten when toggled)
+ * update_view_offset() sets them to the native display dimensions so the
+ * whole screen is used with no letterboxing and scale = 1.0.
  * @{
  */
 
@@ -85,14 +89,6 @@ extern int GRID_H;
 /** \brief Target frames per second for the game timer. */
 #define REFRESH_RATE 30.0f
 
-/** \brief Current virtual canvas width; updated at runtime by
- * update_view_offset(). */
-extern int WIN_W;
-
-/** \brief Current virtual canvas height; updated at runtime by
- * update_view_offset(). */
-extern int WIN_H;
-
 /** @} */
 
 /**
@@ -101,35 +97,28 @@ extern int WIN_H;
  * @{
  */
 
-/** \brief Maximum pieces per set (compile-time, used for array sizes). */
-#define PIECES_PER_SET_MAX 4
-
-/** \brief Current number of pieces offered to the player each turn (runtime).
- */
-extern int PIECES_PER_SET;
-
-/** \brief Current display scale factor (runtime).
- *
- * Set by blockblaster_update_view_offset() whenever the window is resized.
- * Used by the line-width macros to guarantee a minimum physical pixel width
- * so that grid lines remain visible even at very small window sizes.
- */
-extern float g_display_scale;
+/** \brief Pieces per set used until the saved settings are applied.  The
+ * count of a running game lives in GameContext.tray_count. */
+#define PIECES_PER_SET_DEFAULT 4
 
 /** @} */
 
 /**
  * \defgroup LAYOUT Layout macros
- * \brief Macros deriving all UI positions and sizes from WIN_W / WIN_H.
+ * \brief Macros deriving all UI positions and sizes from a GameContext.
+ *
+ * Every macro takes the context pointer gm and reads its canvas size
+ * (win_w, win_h), board size (grid_w, grid_h) and tray count, so each
+ * context lays itself out independently.
  *
  * CELL is constrained by both axes so the grid and tray always fit inside
  * the virtual canvas:
- *  - Width  constraint: CELL_W = (WIN_W - 2*GRID_MARGIN) / GRID_W
- *  - Height constraint: CELL_H = (WIN_H-171) / (GRID_H + TRAY_H_CELLS + 0.5)
- *    where TRAY_H_CELLS = min(GRID_W/PIECES_PER_SET, TRAY_BOX_MAX_CELLS)
+ *  - Width  constraint: CELL_W = (win_w - 2*GRID_MARGIN) / grid_w
+ *  - Height constraint: CELL_H = (win_h-171) / (grid_h + TRAY_H_CELLS + 0.5)
+ *    where TRAY_H_CELLS = min(grid_w/tray_count, TRAY_BOX_MAX_CELLS)
  *  - CELL = min(CELL_W, CELL_H)
  *
- * The exit button is pinned independently to WIN_H - btn_h - 5, so only the
+ * The exit button is pinned independently to win_h - btn_h - 5, so only the
  * grid and tray stack drives the height constraint.
  * @{
  */
@@ -139,33 +128,34 @@ extern float g_display_scale;
 #define GRID_MARGIN 5.0f
 
 /** \brief Cell size derived from the canvas width. */
-#define CELL_W ((WIN_W - 2.0f * GRID_MARGIN) / (float) GRID_W)
+#define CELL_W(gm)                                                             \
+    (((float) (gm)->win_w - 2.0f * GRID_MARGIN) / (float) (gm)->grid_w)
 
 /** \brief Maximum tray box size in cell units.
  *
  * Ensures tray boxes never grow larger than this many cells, keeping them
- * well under one quarter of the grid width regardless of PIECES_PER_SET. */
+ * well under one quarter of the grid width regardless of the tray count. */
 #define TRAY_BOX_MAX_CELLS 3.0f
 
-/** \brief Uncapped tray height in cell units (GRID_W / PIECES_PER_SET). */
-#define TRAY_H_CELLS_RAW ((float) GRID_W / (float) PIECES_PER_SET)
+/** \brief Uncapped tray height in cell units (grid_w / tray_count). */
+#define TRAY_H_CELLS_RAW(gm) ((float) (gm)->grid_w / (float) (gm)->tray_count)
 
 /** \brief Capped tray height in cell units used for the height constraint.
  *
  * min(TRAY_H_CELLS_RAW, TRAY_BOX_MAX_CELLS) so the grid is as large as
  * possible even when few pieces are offered per turn. */
-#define TRAY_H_CELLS                                                           \
-    (TRAY_H_CELLS_RAW < TRAY_BOX_MAX_CELLS ? TRAY_H_CELLS_RAW                \
-                                             : TRAY_BOX_MAX_CELLS)
+#define TRAY_H_CELLS(gm)                                                       \
+    (TRAY_H_CELLS_RAW(gm) < TRAY_BOX_MAX_CELLS ? TRAY_H_CELLS_RAW(gm)          \
+                                               : TRAY_BOX_MAX_CELLS)
 
 /** \brief Cell size derived from the canvas height.
  *
- * The divisor is GRID_H + TRAY_H_CELLS + 0.5 so the grid and tray always
+ * The divisor is grid_h + TRAY_H_CELLS + 0.5 so the grid and tray always
  * fit vertically.  TRAY_H_CELLS is capped at TRAY_BOX_MAX_CELLS so the
- * grid stays as large as possible regardless of PIECES_PER_SET. */
-#define CELL_H                                                                 \
-    (((float) WIN_H - 171.0f) /                                                \
-     ((float) GRID_H + TRAY_H_CELLS + 0.5f))
+ * grid stays as large as possible regardless of the tray count. */
+#define CELL_H(gm)                                                             \
+    (((float) (gm)->win_h - 171.0f) /                                          \
+     ((float) (gm)->grid_h + TRAY_H_CELLS(gm) + 0.5f))
 
 /**
  * \brief Actual cell size in pixels, the minimum of CELL_W and CELL_H.
@@ -173,7 +163,7 @@ extern float g_display_scale;
  * Using the minimum ensures both the grid and the tray remain fully visible
  * regardless of the canvas aspect ratio.
  */
-#define CELL (CELL_W < CELL_H ? CELL_W : CELL_H)
+#define CELL(gm) (CELL_W(gm) < CELL_H(gm) ? CELL_W(gm) : CELL_H(gm))
 
 /**
  * \brief CELL size at the default 600x900 virtual canvas.
@@ -189,27 +179,27 @@ extern float g_display_scale;
  * Equals 1.0 at the default 600x900 canvas and scales proportionally with
  * the actual cell size on high-DPI or fullscreen displays.
  */
-#define UI_SCALE (CELL / CELL_DEFAULT)
+#define UI_SCALE(gm) (CELL(gm) / CELL_DEFAULT)
 
 /** \brief Minimum line width in virtual pixels, ensuring at least 1 physical
  * pixel after the display transform.  When the window is shrunk the display
- * scale drops and this value rises to compensate, preventing sub-pixel lines
- * from becoming invisible. */
-#define LINE_WIDTH_MIN (1.0f / g_display_scale)
+ * scale (gm->scale) drops and this value rises to compensate, preventing
+ * sub-pixel lines from becoming invisible. */
+#define LINE_WIDTH_MIN(gm) (1.0f / (gm)->scale)
 
 /** \brief Scaled line width for grid and tray borders.
  * Clamped so the line never falls below 1 physical pixel. */
-#define GRID_LINE_WIDTH                                                        \
-    ((GRID_LINE_WIDTH_BASE * UI_SCALE) > LINE_WIDTH_MIN                        \
-         ? (GRID_LINE_WIDTH_BASE * UI_SCALE)                                   \
-         : LINE_WIDTH_MIN)
+#define GRID_LINE_WIDTH(gm)                                                    \
+    ((GRID_LINE_WIDTH_BASE * UI_SCALE(gm)) > LINE_WIDTH_MIN(gm)                \
+         ? (GRID_LINE_WIDTH_BASE * UI_SCALE(gm))                               \
+         : LINE_WIDTH_MIN(gm))
 
 /** \brief Scaled line width for rounded rectangles.
  * Clamped so the line never falls below 1 physical pixel. */
-#define ROUNDED_LINE_WIDTH                                                     \
-    ((ROUNDED_LINE_WIDTH_BASE * UI_SCALE) > LINE_WIDTH_MIN                     \
-         ? (ROUNDED_LINE_WIDTH_BASE * UI_SCALE)                                \
-         : LINE_WIDTH_MIN)
+#define ROUNDED_LINE_WIDTH(gm)                                                 \
+    ((ROUNDED_LINE_WIDTH_BASE * UI_SCALE(gm)) > LINE_WIDTH_MIN(gm)             \
+         ? (ROUNDED_LINE_WIDTH_BASE * UI_SCALE(gm))                            \
+         : LINE_WIDTH_MIN(gm))
 
 /**
  * \brief Horizontal position (px) of the left edge of the play grid.
@@ -217,7 +207,8 @@ extern float g_display_scale;
  * The grid is centred horizontally within the virtual canvas.  When
  * CELL == CELL_W the grid fills edge-to-edge with GRID_MARGIN padding.
  */
-#define GRID_X (((float) WIN_W - (float) GRID_W * CELL) * 0.5f)
+#define GRID_X(gm)                                                             \
+    (((float) (gm)->win_w - (float) (gm)->grid_w * CELL(gm)) * 0.5f)
 
 /** \brief Vertical position (px) of the top edge of the play grid. */
 #define GRID_Y 40.0f
@@ -227,24 +218,25 @@ extern float g_display_scale;
  *
  * The tray sits below the grid with a 60 px gap.
  */
-#define TRAY_Y (GRID_Y + (float) GRID_H * CELL + 60.0f)
+#define TRAY_Y(gm) (GRID_Y + (float) (gm)->grid_h * CELL(gm) + 60.0f)
 
 /**
  * \brief Fixed horizontal gap (px) between adjacent tray slots.
  *
- * A small constant gap so slots never touch regardless of PIECES_PER_SET.
+ * A small constant gap so slots never touch regardless of the tray count.
  */
 #define TRAY_BOX_GAP 4.0f
 
 /**
  * \brief Uncapped tray box size that would span the full grid width.
  *
- * This is the old formula: PIECES_PER_SET boxes plus gaps fill exactly
- * GRID_W * CELL.  Used as one input to the capped TRAY_BOX calculation.
+ * This is the old formula: tray_count boxes plus gaps fill exactly
+ * grid_w * CELL.  Used as one input to the capped TRAY_BOX calculation.
  */
-#define TRAY_BOX_UNCAPPED                                                      \
-    (((float) GRID_W * CELL - (float) (PIECES_PER_SET - 1) * TRAY_BOX_GAP) /  \
-     (float) PIECES_PER_SET)
+#define TRAY_BOX_UNCAPPED(gm)                                                  \
+    (((float) (gm)->grid_w * CELL(gm) -                                        \
+      (float) ((gm)->tray_count - 1) * TRAY_BOX_GAP) /                         \
+     (float) (gm)->tray_count)
 
 /**
  * \brief Width (and height, px) of each tray slot box.
@@ -252,16 +244,17 @@ extern float g_display_scale;
  * Capped at TRAY_BOX_MAX_CELLS * CELL so that tray boxes never approach
  * one quarter of the grid width, regardless of how few pieces are offered.
  */
-#define TRAY_BOX                                                               \
-    (TRAY_BOX_UNCAPPED < (TRAY_BOX_MAX_CELLS * CELL) ? TRAY_BOX_UNCAPPED      \
-                                                       : (TRAY_BOX_MAX_CELLS * CELL))
+#define TRAY_BOX(gm)                                                           \
+    (TRAY_BOX_UNCAPPED(gm) < (TRAY_BOX_MAX_CELLS * CELL(gm))                   \
+         ? TRAY_BOX_UNCAPPED(gm)                                               \
+         : (TRAY_BOX_MAX_CELLS * CELL(gm)))
 
 /**
  * \brief Total horizontal extent (px) of all tray slots including gaps.
  */
-#define TRAY_TOTAL_W                                                           \
-    ((float) PIECES_PER_SET * TRAY_BOX +                                       \
-     (float) (PIECES_PER_SET - 1) * TRAY_BOX_GAP)
+#define TRAY_TOTAL_W(gm)                                                       \
+    ((float) (gm)->tray_count * TRAY_BOX(gm) +                                 \
+     (float) ((gm)->tray_count - 1) * TRAY_BOX_GAP)
 
 /**
  * \brief Horizontal position (px) of the left edge of the first tray slot.
@@ -269,7 +262,8 @@ extern float g_display_scale;
  * The tray is centred horizontally within the grid area so that boxes are
  * always visually centred regardless of their number.
  */
-#define TRAY_X (GRID_X + ((float) GRID_W * CELL - TRAY_TOTAL_W) * 0.5f)
+#define TRAY_X(gm)                                                             \
+    (GRID_X(gm) + ((float) (gm)->grid_w * CELL(gm) - TRAY_TOTAL_W(gm)) * 0.5f)
 
 /** @} */
 
@@ -290,82 +284,6 @@ extern float g_display_scale;
 
 /** @} */
 
-/**
- * \defgroup DIFFICULTY Difficulty ramp
- * \brief Constants governing the score-based difficulty ramp.
- *
- * At score 0 the bag is filled with easy shapes.  At DIFFICULTY_MAX_SCORE
- * the bag favours the hardest shapes.  Easy shapes are never completely absent
- * even at maximum difficulty, and hard shapes always have some chance even at
- * score 0 (see MIN_DIFFICULTY_WEIGHT).
- *
- * The weight for each shape is:
- *   w(d,t) = MIN_DIFFICULTY_WEIGHT + (1 - MIN_DIFFICULTY_WEIGHT) * lerp(1-d, d,
- * t)
- *
- * where d = i / (SHAPES_COUNT - 1) is the normalised position of shape i in
- * the SHAPES[] array (0 = easiest, 1 = hardest) and
- * t = min(score, DIFFICULTY_MAX_SCORE) / DIFFICULTY_MAX_SCORE.
- * @{
- */
-
-/** \brief Score at which the shape picker reaches maximum difficulty. */
-#define DIFFICULTY_MAX_SCORE 75000
-
-/**
- * \brief Minimum probability weight assigned to any shape at any difficulty.
- *
- * Prevents any shape from having zero probability; both easy and hard shapes
- * are always reachable.  Value 0.01 means a 1% floor weight.
- */
-#define MIN_DIFFICULTY_WEIGHT 0.01f
-
-/** @} */
-
-/**
- * \defgroup SCORING Scoring constants
- * \brief Point values awarded for placement and line-clearing events.
- * @{
- */
-
-/** \brief Points awarded per occupied cell placed on the grid. */
-#define SCORE_PER_PLACED_CELL 1
-
-/** \brief Points awarded per cell cleared from the grid. */
-#define SCORE_PER_CLEARED_CELL 10
-
-/** \brief Bonus points awarded per complete line (row or column) cleared. */
-#define SCORE_PER_LINE_BONUS 25
-
-/** \brief Extra bonus points per additional line cleared beyond the first. */
-#define SCORE_MULTI_LINE_BONUS 50
-
-/**
- * \brief Multiplier increment per consecutive clearing move.
- *
- * Each move that clears at least one line increases the combo counter by 1,
- * raising the effective multiplier by this fraction.
- */
-#define COMBO_STEP_MULT 0.25f
-
-/** @} */
-
-/**
- * \defgroup PARTIAL_FILL Partial-fill starting mode
- * \brief Range of random cells pre-filled in the "partially filled" start mode.
- * @{
- */
-
-/** \brief Minimum number of cells pre-filled when starting with a partial grid.
- */
-#define FILL_MIN 16
-
-/** \brief Maximum number of cells pre-filled when starting with a partial grid.
- */
-#define FILL_MAX 28
-
-/** @} */
-
 /**
  * \defgroup ANIMATION Animation timings
  * \brief Durations (seconds) for in-game animations.
@@ -382,41 +300,22 @@ extern float g_display_scale;
 
 /** @} */
 
-/**
- * \defgroup BAG Bag randomizer
- * \brief Constants for the weighted bag-randomizer used to draw shapes.
- * @{
- */
-
-/**
- * \brief Number of shape draws in one bag cycle before the bag is reshuffled.
- *
- * Can be set to SHAPES_COUNT to draw each shape exactly once per cycle.
- */
-#define BAG_SIZE 24
-
-/** @} */
-
 /**
  * \defgroup PARTICLES Particle system
  * \brief Constants governing the particle burst effects.
+ *
+ * Lifetime, launch speed, gravity and drag are in blockblaster_particles.h.
  * @{
  */
 
-/** \brief Maximum number of particles alive at the same time. */
-#define MAX_PARTICLES 1000
-
-/** \brief Minimum lifetime (seconds) of a single particle. */
-#define PARTICLE_LIFE_MIN 0.30f
-
-/** \brief Maximum lifetime (seconds) of a single particle. */
-#define PARTICLE_LIFE_MAX 0.60f
-
-/** \brief Minimum launch speed (pixels/second) of a particle. */
-#define PARTICLE_SPEED_MIN 90.0f
+/** \brief Maximum number of particles alive at the same time.  The pool and
+ * the vertex array of the batched draw (6 vertices per particle) are sized
+ * from it. */
+#define MAX_PARTICLES 20000
 
-/** \brief Maximum launch speed (pixels/second) of a particle. */
-#define PARTICLE_SPEED_MAX 220.0f
+/** \brief Side (pixels) of the disc texture particles are drawn with; a
+ * power of two so OpenGL ES can mipmap it. */
+#define PARTICLE_TEXTURE_SIZE 64
 
 /** \brief Number of particles spawned per cleared cell during a line-clear
  * event. */
@@ -465,6 +364,27 @@ extern float g_display_scale;
 
 /** @} */
 
+/**
+ * \defgroup REPLAY_VIEW Replay view
+ * \brief Constants for watching a finished game.
+ * @{
+ */
+
+/** \brief Time (seconds) each drop stays on screen while a replay plays. */
+#define REPLAY_STEP_TIME 0.35f
+
+/** \brief Drops skipped by Page Up / Page Down in the replay view. */
+#define REPLAY_PAGE_MOVES REPLAY_KEYFRAME_INTERVAL
+
+/** \brief Vertical position (px) of the replay scrub bar, in the gap
+ * between the grid and the tray. */
+#define REPLAY_BAR_Y(gm) (GRID_Y + (float) (gm)->grid_h * CELL(gm) + 18.0f)
+
+/** \brief Height (px) of the replay scrub bar. */
+#define REPLAY_BAR_H 24.0f
+
+/** @} */
+
 /**
  * \defgroup ASSET_PATHS Asset file names
  * \brief File names for fonts, audio samples, and the high-score record.
@@ -486,6 +406,13 @@ extern float g_display_scale;
 /** \brief File name (inside DATA/) of the persisted game settings. */
 #define SETTINGS_FILENAME "blockblaster_settings.txt"
 
+/** \brief File name (inside DATA/) of the replay of the last game. */
+#define REPLAY_LAST_FILENAME "blockblaster_last.bbr"
+
+/** \brief File name pattern (inside DATA/) of the replay of a high-score
+ * entry, formatted with its replay seed. */
+#define REPLAY_SCORE_FILENAME_FMT "blockblaster_replay_%016llx.bbr"
+
 /** \brief File name (inside DATA/) of the game font. */
 #define FONT_FILENAME "game_sans_serif_7.ttf"
 
@@ -542,18 +469,6 @@ extern const char *android_internal_path;
 
 /** @} */
 
-/**
- * \defgroup COMBO_LIMITS Combo multiplier limits
- * \brief Cap on the score multiplier accumulated through consecutive clears.
- * @{
- */
-
-/** \brief Maximum score multiplier achievable through consecutive line clears.
- */
-#define MAX_MULTIPLIER 20.0f
-
-/** @} */
-
 /**
  * \defgroup BONUS_POPUP Bonus score popup
  * \brief Constants governing the animated score-gain popup shown after clears.
@@ -619,6 +534,8 @@ typedef struct {
     long score;                         /* Score achieved. */
     int highest_combo;                  /* Highest combo reached. */
     char name[MAX_PLAYER_NAME_LEN + 1]; /* Player name (null-terminated). */
+    uint64_t replay_seed;               /* Seed of the game's replay
+                                           (0 = none). */
 } HighScoreEntry;
 
 /**
@@ -634,22 +551,81 @@ typedef struct {
 } Theme;
 
 /**
- * \brief A single particle used for burst and sparkle visual effects.
+ * \brief Kinds of pre-rendered tile held in the TileAtlas, one column each.
+ */
+typedef enum {
+    TILE_CELL = 0,   /* Grid cell: theme fill and stroke. */
+    TILE_FLASH,      /* Grid cell being cleared: flash fill, theme stroke. */
+    TILE_GHOST,      /* Drop preview: theme fill at 40% alpha, no stroke. */
+    TILE_PIECE,      /* Dragged piece: fill at 85% alpha, theme stroke. */
+    TILE_RETURN,     /* Piece returning to the tray: fill at 65% alpha. */
+    TILE_SHADOW,     /* Shadow under the floating piece. */
+    TILE_PREVIEW,    /* Tray preview cell, dark stroke. */
+    TILE_KIND_COUNT  /* Number of kinds (not a valid kind). */
+} TileKind;
+
+/** \brief Atlas row of the untinted tiles: cells without a theme, and the
+ * red ghost shown where a piece cannot be dropped. */
+#define TILE_ROW_PLAIN THEMES_COUNT
+
+/** \brief Rows of the tile atlas: one per theme plus TILE_ROW_PLAIN. */
+#define TILE_ROWS (THEMES_COUNT + 1)
+
+/**
+ * \brief Every tile the play scene draws, pre-rendered into one bitmap.
+ *
+ * Slot (kind, row) holds the tile of that kind in that theme, drawn with
+ * the primitives the scene used to draw it with every frame, at the
+ * current cell size and display scale.  The tiles are then drawn as
+ * regions of a single texture, which Allegro batches while bitmap drawing
+ * is held.  The atlas is rebuilt before a frame when marked dirty (layout
+ * change) or when the cell size it was built for no longer matches.
+ */
+typedef struct {
+    ALLEGRO_BITMAP *bitmap;      /* NULL until built, or if it cannot be. */
+    bool dirty;                  /* Rebuild before the next frame. */
+    float cell;                  /* CELL the tiles were built for. */
+    float tray_cell;             /* Tray preview cell they were built for. */
+    float scale;                 /* Atlas pixels per virtual pixel. */
+    int slot;                    /* Side of one slot (atlas pixels). */
+    int pad;                     /* Transparent margin around each tile. */
+    float size[TILE_KIND_COUNT]; /* Side of each kind's tile (atlas
+                                    pixels). */
+} TileAtlas;
+
+/**
+ * \brief A cached piece of the play scene background.
  *
- * Particles are updated each frame: velocity is integrated, a simple gravity
- * force is applied, and alpha fades with remaining lifetime.
+ * Holds what the scene draws over the virtual rectangle (x, y, w, h),
+ * rendered at the display scale, so a frame blits it instead of drawing
+ * it again.
  */
 typedef struct {
-    float x;           /* Current horizontal position (virtual pixels). */
-    float y;           /* Current vertical position (virtual pixels). */
-    float vx;          /* Horizontal velocity (pixels/second). */
-    float vy;          /* Vertical velocity (pixels/second). */
-    float life;        /* Remaining lifetime (seconds). */
-    float life0;       /* Initial lifetime used to compute the fade fraction. */
-    float size;        /* Radius (pixels) of the rendered circle. */
-    ALLEGRO_COLOR col; /* Base colour; alpha is modulated by life/life0. */
-    bool alive; /* True while the particle should be updated and drawn. */
-} Particle;
+    ALLEGRO_BITMAP *bitmap; /* NULL until built, or if it cannot be. */
+    float x;                /* Virtual rectangle the bitmap covers. */
+    float y;
+    float w;
+    float h;
+} BackgroundPart;
+
+/**
+ * \brief Static background of the play scene, redrawn once per layout.
+ *
+ * The grid part (panel and cell outlines) moves with the screen shake;
+ * the tray part (slot boxes and label) does not, hence two bitmaps.  The
+ * layer is rebuilt before a frame when marked dirty (layout or settings
+ * change) or when the layout it was built for no longer matches.
+ */
+typedef struct {
+    BackgroundPart grid; /* Grid panel and cell outlines. */
+    BackgroundPart tray; /* Tray slot boxes and label. */
+    bool dirty;          /* Rebuild before the next frame. */
+    float cell;          /* CELL the layer was built for. */
+    float scale;         /* Display scale it was built for. */
+    int grid_w;          /* Grid size it was built for. */
+    int grid_h;
+    int tray_count;      /* Tray slots it was built for. */
+} BackgroundLayer;
 
 /**
  * \brief An animated "+N points" popup shown after a line-clear event.
@@ -687,66 +663,6 @@ typedef struct {
     bool alive;    /* True while the popup should be updated and drawn. */
 } ComboPopup;
 
-/**
- * \brief Total number of named colour themes available in the theme table.
- *
- * The theme_table array inside GameContext is sized to this value and
- * populated at startup by init_themes().
- */
-#define THEMES_COUNT 8
-
-/* ======================================================================== */
-/* Piece definitions                                                         */
-/* ======================================================================== */
-
-/**
- * \brief Maximum dimension (width or height) of any shape, in cells.
- *
- * All shapes are stored in a SHAPE_MAX x SHAPE_MAX boolean grid regardless
- * of their actual footprint.
- */
-#define SHAPE_MAX 5
-
-/**
- * \brief Immutable descriptor of a tetromino-like block shape.
- *
- * Shapes are defined as a boolean grid of up to SHAPE_MAX x SHAPE_MAX cells.
- * Only cells where cells[y][x] is true contribute to the shape's footprint.
- */
-typedef struct {
-    int w;                 /* Actual width of the shape in cells. */
-    int h;                 /* Actual height of the shape in cells. */
-    bool cells[SHAPE_MAX]
-              [SHAPE_MAX]; /* Cell occupancy grid; cells[row][col]. */
-    const char *name;      /* Short debug name identifying the shape. */
-} Shape;
-
-/**
- * \brief A single piece slot in the player's tray.
- *
- * Each slot holds one Shape and the colour theme applied to it when placed.
- * Once placed on the grid the slot is marked used and no longer shown.
- */
-typedef struct {
-    Shape shape; /* The block shape held by this tray slot. */
-    bool used;   /* True once the player has placed this piece on the grid. */
-    Theme theme; /* Colour theme used when drawing and placing the piece. */
-} Piece;
-
-/**
- * \brief The 10x10 play grid.
- *
- * Each cell stores an occupancy flag and the colour theme of the piece that
- * occupies it, so cleared cells can be drawn with the correct colour during
- * the flash animation.
- */
-typedef struct {
-    bool occ[GRID_H_MAX][GRID_W_MAX];         /* True for each occupied cell. */
-    Theme cell_theme[GRID_H_MAX][GRID_W_MAX]; /* Per-cell colour theme. */
-    bool has_theme[GRID_H_MAX]
-                  [GRID_W_MAX]; /* True when cell_theme[y][x] is valid. */
-} Grid;
-
 /** @} */ /* end STRUCTS */
 
 /* ======================================================================== */
@@ -757,28 +673,48 @@ typedef struct {
  * \brief Top-level game state machine states.
  */
 typedef enum {
-    STATE_MENU = 0,    /* The main menu is shown. */
-    STATE_PLAY = 1,    /* A game session is active. */
-    STATE_GAMEOVER = 2 /* The game-over overlay is displayed. */
+    STATE_MENU = 0,     /* The main menu is shown. */
+    STATE_PLAY = 1,     /* A game session is active. */
+    STATE_GAMEOVER = 2, /* The game-over overlay is displayed. */
+    STATE_REPLAY = 3    /* The finished game is replayed with a scrub bar. */
 } GAME_STATES;
 
+/**
+ * \brief Audio resources owned by one game context.
+ *
+ * Loaded by blockblaster_load_all_audio() once the audio subsystem is up
+ * (ok is true) and released by blockblaster_destroy_all_audio().
+ */
+typedef struct {
+    ALLEGRO_SAMPLE *sfx_place;        /* Piece placed on the grid. */
+    ALLEGRO_SAMPLE *sfx_select;       /* Piece picked up / button pressed. */
+    ALLEGRO_SAMPLE *sfx_send_to_tray; /* Piece returned to the tray. */
+    ALLEGRO_SAMPLE *sfx_break_lines;  /* One or more lines cleared. */
+    ALLEGRO_SAMPLE *sfx_music[5];     /* Intro, end, then 3 in-game tracks. */
+    ALLEGRO_SAMPLE_INSTANCE *music_instance; /* Active music track (only one
+                                                plays at a time). */
+    int music_current_track; /* Index into sfx_music[] playing, or -1. */
+    bool ok; /* True when the audio subsystem was initialised successfully. */
+} GameAudio;
+
 /**
  * \brief All mutable state for a running game session.
  *
- * A single instance of this structure is allocated on the stack in main()
- * and passed by pointer to every subsystem.
+ * Everything a game needs (board size, canvas size, audio, random streams)
+ * lives here rather than in globals, so several contexts can coexist in one
+ * process.  Initialise with blockblaster_init_context(); main() keeps one on
+ * the stack and passes it by pointer to every subsystem.
  */
 typedef struct {
     GAME_STATES state; /* Current state of the game state machine. */
-    Grid grid;         /* The 10x10 play grid. */
-    Piece tray[PIECES_PER_SET_MAX]; /* Piece slots offered each turn. */
+    CoreGame core; /* Rules state: grid, tray, bag, score and combo. */
+
+    /* ---- Board layout ---- */
+    int grid_w;     /* Columns of the current game (copied from settings). */
+    int grid_h;     /* Rows of the current game (copied from settings). */
+    int tray_count; /* Pieces offered per set in the current game. */
 
-    long score;      /* Player's score for the current session. */
     long high_score; /* All-time best score (derived from high_scores[0]). */
-    int combo;       /* Number of consecutive moves that each cleared a line. */
-    int highest_combo;    /** Highest combo for the current session. */
-    float last_move_mult; /* Score multiplier applied on the previous move. */
-    int combo_miss; /* Non-clearing placements since the last line clear. */
 
     /* ---- High-score table ---- */
     HighScoreEntry high_scores[MAX_HIGH_SCORES]; /* Top-5 high scores. */
@@ -792,7 +728,7 @@ typedef struct {
 
     /* ---- Drag state ---- */
     bool dragging;      /* True while the player is dragging a piece. */
-    int dragging_index; /* Tray index (0..PIECES_PER_SET-1) of the dragged
+    int dragging_index; /* Tray index (0..tray_count-1) of the dragged
                            piece. */
     float mouse_x; /* Current pointer horizontal position in virtual space. */
     float mouse_y; /* Current pointer vertical position in virtual space. */
@@ -813,33 +749,15 @@ typedef struct {
     bool clearing; /* True while the clear-flash animation is running; input
                       is blocked. */
     float clear_t; /* Remaining time (seconds) of the clear animation. */
-    bool pending_clear[GRID_H_MAX][GRID_W_MAX]; /* Cells flagged for removal at
-                                                   the end of the clear
-                                                   animation. */
+    uint32_t pending_rows; /* Rows (bit y) removed at the end of the clear
+                              animation. */
+    uint32_t pending_cols; /* Columns (bit x) removed at the end of the clear
+                              animation. */
 
     /* ---- Per-cell pop animation ---- */
     float pop_t[GRID_H_MAX][GRID_W_MAX]; /* Remaining pop-scale animation time
                                              for each cell. */
 
-    /* ---- Game mode ---- */
-    int start_mode; /* Start mode: 0 = empty grid, 1 = partially filled grid.
-                     */
-
-    /**
-     * \brief Theme assignment mode.
-     *
-     * 0 = each piece receives its own random theme.
-     * 1 = all pieces in a set share one randomly chosen theme.
-     */
-    int theme_mode;
-    Theme set_theme; /* Shared theme for the current set (used when theme_mode
-                        == 1). */
-
-    /* ---- Bag randomizer ---- */
-    int bag[BAG_SIZE]; /* Array of shape indices for the current bag cycle. */
-    int bag_len;       /* Number of entries in the current bag. */
-    int bag_pos;       /* Next draw position within the bag array. */
-
     /* ---- Screen shake ---- */
     float shake_t;        /* Remaining duration (seconds) of the current shake
                              effect. */
@@ -850,11 +768,20 @@ typedef struct {
     float cam_y; /* Vertical camera offset applied to the playfield each
                     frame. */
 
+    Rng fx_rng; /* Cosmetic stream: particles, shake and music choice.  Kept
+                   apart from core.rng so effects never shift the bag. */
+
     /* ---- Particles ---- */
-    Particle particles[MAX_PARTICLES]; /* Pool of all particles; unused slots
-                                          have alive = false. */
-    Theme theme_table[THEMES_COUNT];   /* Runtime colour theme palette,
-                                          populated by init_themes(). */
+    ParticleSystem *particles;       /* Pool of MAX_PARTICLES particles, NULL
+                                        if it could not be allocated. */
+    ALLEGRO_BITMAP *particle_tex;    /* White disc tinted per particle, NULL
+                                        to draw plain circles instead. */
+    ALLEGRO_VERTEX *particle_vtx;    /* Two triangles per particle, refilled
+                                        every frame. */
+    Theme theme_table[THEMES_COUNT]; /* Runtime colour theme palette,
+                                        populated by init_themes(). */
+    TileAtlas tiles;                 /* Pre-rendered tiles of every theme. */
+    BackgroundLayer background;      /* Cached static scene background. */
 
     /* ---- Bonus score popups ---- */
     BonusPopup bonus_popups[MAX_BONUS_POPUPS]; /* Pool of bonus-score popups. */
@@ -883,6 +810,8 @@ typedef struct {
     float return_end_y; /* Target vertical position (centre of tray slot). */
 
     /* ---- Display info ---- */
+    int win_w; /* Virtual canvas width; set by update_view_offset(). */
+    int win_h; /* Virtual canvas height; set by update_view_offset(). */
     int display_width;   /* Current physical display width in pixels. */
     int display_height;  /* Current physical display height in pixels. */
     float view_offset_x; /* Horizontal letterbox offset applied by the base
@@ -909,6 +838,24 @@ typedef struct {
     bool confirm_exit;   /* True while the exit-confirmation dialog is visible.
                           */
     bool sound_on; /* True when audio playback (music and sfx) is enabled. */
+    GameAudio audio; /* Sound effects, music tracks and playback state. */
+
+    /* ---- Hints ---- */
+    bool hint_on;     /* True when the hint overlay is enabled. */
+    HintEngine *hint; /* Background solver, created on first use. */
+
+    /* ---- Undo ---- */
+    bool undo_on;      /* Undo / redo allowed in the running game. */
+    UndoHistory *undo; /* States before each drop, created on first use. */
+
+    /* ---- Replay ---- */
+    Replay replay;         /* Recording of the current (or last) game. */
+    bool replay_indexed;   /* Keyframes built and verified: watchable. */
+    int replay_move;       /* Drops shown in the replay view. */
+    bool replay_playing;   /* The replay view steps on its own. */
+    bool replay_scrubbing; /* The scrub bar is being dragged. */
+    float replay_t;        /* Time left before the next automatic step. */
+    CoreGame replay_final; /* Final state, restored when leaving the view. */
 
     float scale;   /* Uniform display scale used to fit the virtual canvas onto
                       the screen. */
@@ -917,10 +864,14 @@ typedef struct {
     int setting_tray_count; /* Pieces per set chosen by the player (1..4). */
     int setting_grid_size;  /* Grid side length chosen by the player
                                (10, 15 or 20). */
+    bool setting_fair_tray; /* Only deal sets that can be placed in full. */
+    bool setting_undo;      /* Allow undo / redo in new games. */
 
 } GameContext;
 
-#include "blockblaster_shapes.h"
+/** \brief True when cell (x, y) is flagged by the running clear animation. */
+#define GM_PENDING_CLEAR(gm, x, y)                                             \
+    ((((gm)->pending_rows >> (y)) & 1u) || (((gm)->pending_cols >> (x)) & 1u))
 
 #ifdef __cplusplus
 }
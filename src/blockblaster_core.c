@@ -0,0 +1,1303 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_core.c
+ * \brief Headless game rules: grid, bag, tray, scoring, drop and game-over.
+ *
+ * No Allegro, audio, logging or file I/O in here; see blockblaster_core.h.
+ */
+
+#include "blockblaster_core.h"
+
+#include "blockblaster_simd.h"
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+/* ======================================================================== */
+/* Random numbers                                                            */
+/* ======================================================================== */
+
+/** \brief PCG32 state multiplier. */
+#define RNG_MULT 6364136223846793005ull
+
+/**
+ * \brief Seed a generator on the given stream.
+ *
+ * \param r       Generator to seed.
+ * \param seed    Starting point within the stream.
+ * \param stream  Stream selector (e.g. RNG_STREAM_GAMEPLAY).
+ */
+void blockblaster_rng_seed(Rng *r, uint64_t seed, uint64_t stream)
+{
+    r->state = 0u;
+    r->inc = (stream << 1u) | 1u;
+    blockblaster_rng_next(r);
+    r->state += seed;
+    blockblaster_rng_next(r);
+}
+
+/**
+ * \brief Return the next 32 random bits.
+ *
+ * \param r  Generator (seeded on first use if zero-initialised).
+ * \return   Uniformly distributed 32-bit value.
+ */
+uint32_t blockblaster_rng_next(Rng *r)
+{
+    if (!r->inc)
+        blockblaster_rng_seed(r, 0u, 0u);
+    uint64_t old = r->state;
+    r->state = old * RNG_MULT + r->inc;
+    uint32_t xorshifted = (uint32_t) (((old >> 18u) ^ old) >> 27u);
+    uint32_t rot = (uint32_t) (old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31u));
+}
+
+/**
+ * \brief Return a random integer in the inclusive range [a, b].
+ *
+ * Unbiased (Lemire's multiply-and-reject).  If b <= a the function returns
+ * a directly without drawing.
+ *
+ * \param r  Generator.
+ * \param a  Lower bound (inclusive).
+ * \param b  Upper bound (inclusive).
+ * \return   Pseudo-random integer in [a, b].
+ */
+int blockblaster_irand(Rng *r, int a, int b)
+{
+    if (b <= a)
+        return a;
+    uint32_t range = (uint32_t) (b - a) + 1u;
+    uint64_t m = (uint64_t) blockblaster_rng_next(r) * range;
+    if ((uint32_t) m < range) {
+        uint32_t threshold = (0u - range) % range;
+        while ((uint32_t) m < threshold)
+            m = (uint64_t) blockblaster_rng_next(r) * range;
+    }
+    return a + (int) (m >> 32);
+}
+
+/**
+ * \brief Return a random float in [0.0, 1.0).
+ *
+ * \param r  Generator.
+ * \return   Pseudo-random float with 24 uniformly distributed bits.
+ */
+float blockblaster_frand01(Rng *r)
+{
+    return (float) (blockblaster_rng_next(r) >> 8) * (1.0f / 16777216.0f);
+}
+
+/**
+ * \brief Return a random float in [a, b).
+ *
+ * \param r  Generator.
+ * \param a  Lower bound.
+ * \param b  Upper bound.
+ * \return   Pseudo-random float in [a, b).
+ */
+float blockblaster_frand(Rng *r, float a, float b)
+{
+    return a + (b - a) * blockblaster_frand01(r);
+}
+
+/**
+ * \brief Fisher-Yates shuffle of an integer array in-place.
+ *
+ * \param r  Generator.
+ * \param a  Array of integers to shuffle.
+ * \param n  Number of elements in the array.
+ */
+void blockblaster_shuffle_ints(Rng *r, int *a, int n)
+{
+    for (int i = n - 1; i > 0; i--) {
+        int j = blockblaster_irand(r, 0, i);
+        int tmp = a[i];
+        a[i] = a[j];
+        a[j] = tmp;
+    }
+}
+
+/* Pick a random theme index. */
+static int random_theme(Rng *r)
+{
+    return blockblaster_irand(r, 0, THEMES_COUNT - 1);
+}
+
+/* ======================================================================== */
+/* Grid                                                                      */
+/* ======================================================================== */
+
+/**
+ * \brief Resize the grid and reset every cell to unoccupied with no theme.
+ *
+ * \param g  Grid to clear.
+ * \param w  Number of columns (1..GRID_W_MAX).
+ * \param h  Number of rows (1..GRID_H_MAX).
+ */
+void blockblaster_grid_clear(Grid *g, int w, int h)
+{
+    g->w = w;
+    g->h = h;
+    memset(g->rows, 0, sizeof(g->rows));
+    memset(g->cols, 0, sizeof(g->cols));
+    memset(g->row_fill, 0, sizeof(g->row_fill));
+    memset(g->col_fill, 0, sizeof(g->col_fill));
+    memset(g->cell_theme, 0, sizeof(g->cell_theme));
+    memset(g->has_theme, 0, sizeof(g->has_theme));
+}
+
+/* Mark the empty cell (x, y) as occupied in both bitboards and bump the
+   row and column fill counters. */
+static void grid_set_cell(Grid *g, int x, int y)
+{
+    g->rows[y] |= 1u << x;
+    g->cols[x] |= 1u << y;
+    g->row_fill[y]++;
+    g->col_fill[x]++;
+}
+
+/**
+ * \brief Test whether a shape occupies the cell at (x, y).
+ *
+ * Out-of-bounds coordinates return false.
+ *
+ * \param s  Shape to query.
+ * \param x  Column within the shape.
+ * \param y  Row within the shape.
+ * \return   true if the cell is filled.
+ */
+bool blockblaster_shape_cell(const Shape *s, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= s->w || y >= s->h)
+        return false;
+    return s->cells[y][x];
+}
+
+/* Return true when the bounding box of m placed at (gx, gy) lies entirely
+   inside grid g. */
+static bool mask_in_bounds(const Grid *g, const ShapeMask *m, int gx, int gy)
+{
+    return gx + m->min_x >= 0 && gy + m->min_y >= 0 &&
+           gx + m->max_x < g->w && gy + m->max_y < g->h;
+}
+
+/* Shift a shape mask by off bits (off may be negative, down to -min_x, as
+   the bounding-box check guarantees no filled bit is shifted out). */
+static uint32_t shift_mask(uint32_t m, int off)
+{
+    return (off >= 0) ? (m << off) : (m >> -off);
+}
+
+/* OR the shape m at (gx, gy) into a pair of row/column bitboards.  The
+   placement must already be known to lie inside the grid. */
+static void stamp_mask(uint32_t rows[GRID_H_MAX], uint32_t cols[GRID_W_MAX],
+                       const ShapeMask *m, int gx, int gy)
+{
+    for (int sy = m->min_y; sy <= m->max_y; sy++)
+        rows[gy + sy] |= shift_mask(m->rows[sy], gx);
+    for (int sx = m->min_x; sx <= m->max_x; sx++)
+        cols[gx + sx] |= shift_mask(m->cols[sx], gy);
+}
+
+/**
+ * \brief Test whether shape m can be placed at grid position (gx, gy).
+ *
+ * Returns false if the shape's bounding box would leave the grid or any
+ * filled cell would land on an already-occupied cell.  Each shape row is
+ * shifted onto the matching grid row bitboard and tested with a single AND.
+ *
+ * \param g   Current grid state.
+ * \param m   Bitmask form of the shape to test.
+ * \param gx  Target column for the shape's top-left corner.
+ * \param gy  Target row for the shape's top-left corner.
+ * \return    true if placement is valid.
+ */
+bool blockblaster_can_place_at(const Grid *g, const ShapeMask *m, int gx,
+                               int gy)
+{
+    if (!mask_in_bounds(g, m, gx, gy))
+        return false;
+    for (int sy = m->min_y; sy <= m->max_y; sy++)
+        if (g->rows[gy + sy] & shift_mask(m->rows[sy], gx))
+            return false;
+    return true;
+}
+
+/**
+ * \brief Scan the entire grid for at least one valid placement of shape m.
+ *
+ * Runs the placement-scan kernel selected at startup (AVX2, SSE2, NEON or
+ * scalar, see blockblaster_simd.c), which tests every horizontal anchor of
+ * several anchor rows at once.
+ *
+ * \param g  Current grid state.
+ * \param m  Bitmask form of the shape to test.
+ * \return   true if at least one position allows the shape to be placed.
+ */
+bool blockblaster_any_valid_placement(const Grid *g, const ShapeMask *m)
+{
+    return blockblaster_scan_any(g->rows, g->w, g->h, m);
+}
+
+/**
+ * \brief Stamp shape m onto the grid at (gx, gy) with the given theme.
+ *
+ * The shape's row and column masks are ORed into the grid bitboards and
+ * each filled cell is assigned the theme index.  Caller must ensure the
+ * placement is valid (see blockblaster_can_place_at()); a placement whose
+ * bounding box leaves the grid is ignored.
+ *
+ * \param g      Grid to modify.
+ * \param m      Bitmask form of the shape to place.
+ * \param gx     Column for the shape's top-left corner.
+ * \param gy     Row for the shape's top-left corner.
+ * \param theme  Theme index applied to the newly occupied cells.
+ */
+void blockblaster_place_shape(Grid *g, const ShapeMask *m, int gx, int gy,
+                              int theme)
+{
+    if (!mask_in_bounds(g, m, gx, gy))
+        return;
+    stamp_mask(g->rows, g->cols, m, gx, gy);
+    for (int i = 0; i < m->cell_count; i++) {
+        int x = gx + m->cells[i][0];
+        int y = gy + m->cells[i][1];
+        g->row_fill[y]++;
+        g->col_fill[x]++;
+        g->cell_theme[y][x] = (uint8_t) theme;
+        g->has_theme[y][x] = true;
+    }
+}
+
+/**
+ * \brief Find the completed rows and columns inside a window of the grid.
+ *
+ * Only rows y0..y1 and columns x0..x1 are checked, using the fill counters,
+ * so after a drop the caller passes the placed shape's bounding box: no
+ * other line can have been completed by it.
+ *
+ * \param g         Current grid state.
+ * \param x0        First column to check.
+ * \param y0        First row to check.
+ * \param x1        Last column to check (inclusive).
+ * \param y1        Last row to check (inclusive).
+ * \param out_rows  Output: bit y set for each full row.
+ * \param out_cols  Output: bit x set for each full column.
+ * \return          Total number of full lines (rows + columns).
+ */
+int blockblaster_find_full_lines(const Grid *g, int x0, int y0, int x1, int y1,
+                                 uint32_t *out_rows, uint32_t *out_cols)
+{
+    uint32_t full_rows = 0;
+    uint32_t full_cols = 0;
+
+    for (int y = y0; y <= y1; y++)
+        if (g->row_fill[y] == g->w)
+            full_rows |= 1u << y;
+    for (int x = x0; x <= x1; x++)
+        if (g->col_fill[x] == g->h)
+            full_cols |= 1u << x;
+
+    *out_rows = full_rows;
+    *out_cols = full_cols;
+    return GRID_POPCOUNT(full_rows) + GRID_POPCOUNT(full_cols);
+}
+
+/**
+ * \brief Count the cells covered by a set of full rows and columns.
+ *
+ * Every cell of a full line is occupied, so the count follows directly from
+ * the number of lines, minus the cells shared by a row and a column.
+ *
+ * \param g          Grid the lines belong to (only its size is used).
+ * \param full_rows  Bit y set for each full row.
+ * \param full_cols  Bit x set for each full column.
+ * \return           Number of distinct occupied cells in those lines.
+ */
+int blockblaster_count_cells_in_lines(const Grid *g, uint32_t full_rows,
+                                      uint32_t full_cols)
+{
+    int nr = GRID_POPCOUNT(full_rows);
+    int nc = GRID_POPCOUNT(full_cols);
+    return nr * g->w + nc * g->h - nr * nc;
+}
+
+/**
+ * \brief Remove the given rows and columns from the grid.
+ *
+ * Clears the bitboard bits and has_theme of every cell in those lines and
+ * refreshes the fill counters from the updated bitboards, one popcount per
+ * row and column instead of a per-cell pass.
+ *
+ * \param g          Grid to modify.
+ * \param full_rows  Bit y set for each row to remove.
+ * \param full_cols  Bit x set for each column to remove.
+ */
+void blockblaster_clear_lines(Grid *g, uint32_t full_rows, uint32_t full_cols)
+{
+    if (!full_rows && !full_cols)
+        return;
+
+    for (int y = 0; y < g->h; y++) {
+        uint32_t clear =
+            ((full_rows >> y) & 1u) ? GRID_FULL_ROW(g) : full_cols;
+        g->rows[y] &= ~clear;
+        g->row_fill[y] = (uint8_t) GRID_POPCOUNT(g->rows[y]);
+        for (; clear; clear &= clear - 1)
+            g->has_theme[y][__builtin_ctz(clear)] = false;
+    }
+    for (int x = 0; x < g->w; x++) {
+        uint32_t clear =
+            ((full_cols >> x) & 1u) ? GRID_FULL_COL(g) : full_rows;
+        g->cols[x] &= ~clear;
+        g->col_fill[x] = (uint8_t) GRID_POPCOUNT(g->cols[x]);
+    }
+}
+
+/**
+ * \brief Randomly occupy count cells on the grid (partial-fill start mode).
+ *
+ * Cells are chosen at random; already-occupied cells are skipped.  The
+ * loop gives up after 5000 attempts to prevent infinite spinning on a
+ * nearly-full grid.
+ *
+ * \param g      Grid to fill.
+ * \param r      Generator used to pick the cells.
+ * \param count  Desired number of cells to occupy.
+ */
+void blockblaster_random_fill(Grid *g, Rng *r, int count)
+{
+    int tries = 0;
+    while (count > 0 && tries < 5000) {
+        tries++;
+        int x = blockblaster_irand(r, 0, g->w - 1);
+        int y = blockblaster_irand(r, 0, g->h - 1);
+        if (!GRID_OCC(g, x, y)) {
+            grid_set_cell(g, x, y);
+            count--;
+        }
+    }
+}
+
+/**
+ * \brief Predict which rows and columns would be full if shape m were
+ *        placed at (gx, gy).
+ *
+ * The grid is left untouched: the shape is stamped into a copy of the
+ * bitboards.  A placement leaving the grid predicts only the lines that
+ * are already full.
+ *
+ * \param g         Current grid state.
+ * \param m         Shape being considered for placement.
+ * \param gx        Grid column of the shape's top-left corner.
+ * \param gy        Grid row of the shape's top-left corner.
+ * \param out_rows  Output: bit y set for each row that would be full.
+ * \param out_cols  Output: bit x set for each column that would be full.
+ */
+void blockblaster_predict_full_lines(const Grid *g, const ShapeMask *m, int gx,
+                                     int gy, uint32_t *out_rows,
+                                     uint32_t *out_cols)
+{
+    uint32_t rows[GRID_H_MAX];
+    uint32_t cols[GRID_W_MAX];
+    memcpy(rows, g->rows, sizeof(rows));
+    memcpy(cols, g->cols, sizeof(cols));
+
+    if (mask_in_bounds(g, m, gx, gy))
+        stamp_mask(rows, cols, m, gx, gy);
+
+    uint32_t full_rows = 0;
+    uint32_t full_cols = 0;
+    for (int y = 0; y < g->h; y++)
+        if (rows[y] == GRID_FULL_ROW(g))
+            full_rows |= 1u << y;
+    for (int x = 0; x < g->w; x++)
+        if (cols[x] == GRID_FULL_COL(g))
+            full_cols |= 1u << x;
+    *out_rows = full_rows;
+    *out_cols = full_cols;
+}
+
+/* ======================================================================== */
+/* Bag randomizer                                                            */
+/* ======================================================================== */
+
+/* Number of SHAPES[] entries as a constant expression (SHAPES_COUNT is a
+   const int and cannot size arrays). */
+#define SHAPE_TABLE_LEN ((int) (sizeof(SHAPES) / sizeof(SHAPES[0])))
+
+/* Vose alias table for one difficulty level: pick a column i uniformly,
+   keep it with probability prob[i], otherwise take alias[i]. */
+typedef struct {
+    float prob[SHAPE_TABLE_LEN];
+    uint16_t alias[SHAPE_TABLE_LEN];
+} AliasTable;
+
+/* One table per quantised difficulty level; built by
+   blockblaster_shape_sampler_init(). */
+static AliasTable shape_alias[DIFFICULTY_LEVELS];
+static bool shape_alias_ready = false;
+
+/**
+ * \brief Draw weight of a shape at a given difficulty.
+ *
+ * Linear interpolation between an easy-biased and a hard-biased weight,
+ * scaled by the shape's weight column: at t = 0 shapes with a low
+ * difficulty are strongly favoured, at t = 1 those with a high one are.
+ * Every shape always keeps at least weight * MIN_DIFFICULTY_WEIGHT.
+ *
+ * \param shape  Index into the SHAPES[] array.
+ * \param t      Difficulty in [0, 1] (score / DIFFICULTY_MAX_SCORE).
+ * \return       Unnormalised weight.
+ */
+float blockblaster_shape_weight(int shape, float t)
+{
+    const Shape *s = &SHAPES[shape];
+    float d = s->difficulty;
+    return (float) s->weight *
+           (MIN_DIFFICULTY_WEIGHT + (1.0f - MIN_DIFFICULTY_WEIGHT) *
+                                        ((1.0f - d) * (1.0f - t) + d * t));
+}
+
+/**
+ * \brief Map a score to its quantised difficulty level.
+ *
+ * \param score  Player score (clamped to [0, DIFFICULTY_MAX_SCORE]).
+ * \return       Level in [0, DIFFICULTY_LEVELS), rounded to nearest.
+ */
+int blockblaster_difficulty_level(long score)
+{
+    if (score <= 0)
+        return 0;
+    if (score >= DIFFICULTY_MAX_SCORE)
+        return DIFFICULTY_LEVELS - 1;
+    return (int) ((score * (DIFFICULTY_LEVELS - 1) +
+                   DIFFICULTY_MAX_SCORE / 2) /
+                  DIFFICULTY_MAX_SCORE);
+}
+
+/* Build the alias table for difficulty t with Vose's method: scale the
+   weights so they average 1, then repeatedly pair an under-full column
+   with an over-full one that donates the remainder. */
+static void alias_build(AliasTable *a, float t)
+{
+    double p[SHAPE_TABLE_LEN];
+    int small[SHAPE_TABLE_LEN], large[SHAPE_TABLE_LEN];
+    int ns = 0, nl = 0;
+    double total = 0.0;
+
+    for (int i = 0; i < SHAPE_TABLE_LEN; i++) {
+        p[i] = blockblaster_shape_weight(i, t);
+        total += p[i];
+    }
+    for (int i = 0; i < SHAPE_TABLE_LEN; i++) {
+        p[i] = p[i] * SHAPE_TABLE_LEN / total;
+        if (p[i] < 1.0)
+            small[ns++] = i;
+        else
+            large[nl++] = i;
+    }
+    while (ns > 0 && nl > 0) {
+        int sm = small[--ns];
+        int lg = large[--nl];
+        a->prob[sm] = (float) p[sm];
+        a->alias[sm] = (uint16_t) lg;
+        p[lg] = (p[lg] + p[sm]) - 1.0;
+        if (p[lg] < 1.0)
+            small[ns++] = lg;
+        else
+            large[nl++] = lg;
+    }
+    /* Whatever is left is 1.0 up to rounding error. */
+    while (nl > 0) {
+        int lg = large[--nl];
+        a->prob[lg] = 1.0f;
+        a->alias[lg] = (uint16_t) lg;
+    }
+    while (ns > 0) {
+        int sm = small[--ns];
+        a->prob[sm] = 1.0f;
+        a->alias[sm] = (uint16_t) sm;
+    }
+}
+
+/**
+ * \brief Build the alias tables for every difficulty level.
+ *
+ * Called once at startup; blockblaster_shape_draw() also calls it lazily.
+ * Call it before starting worker threads so they only ever read the tables.
+ */
+void blockblaster_shape_sampler_init(void)
+{
+    for (int l = 0; l < DIFFICULTY_LEVELS; l++)
+        alias_build(&shape_alias[l],
+                    (float) l / (float) (DIFFICULTY_LEVELS - 1));
+    shape_alias_ready = true;
+}
+
+/**
+ * \brief Draw a shape index weighted by the difficulty curve, in O(1).
+ *
+ * Uses the cached alias table of the score's difficulty level, so the
+ * result follows blockblaster_shape_weight() at t = level / (levels - 1),
+ * within half a level of score / DIFFICULTY_MAX_SCORE.
+ *
+ * \param r      Generator.
+ * \param score  Current player score used to compute difficulty.
+ * \return       Index into the SHAPES[] array.
+ */
+int blockblaster_shape_draw(Rng *r, long score)
+{
+    if (!shape_alias_ready)
+        blockblaster_shape_sampler_init();
+    const AliasTable *a = &shape_alias[blockblaster_difficulty_level(score)];
+    int i = blockblaster_irand(r, 0, SHAPE_TABLE_LEN - 1);
+    return (blockblaster_frand01(r) < a->prob[i]) ? i : a->alias[i];
+}
+
+/* Fill the bag with BAG_SIZE shape indices using the weighted picker, then
+   shuffle so consecutive draws from the same bag are randomised. */
+static void bag_refill(CoreGame *c)
+{
+    c->bag_len = BAG_SIZE;
+    for (int i = 0; i < c->bag_len; i++)
+        c->bag[i] = blockblaster_shape_draw(&c->rng, c->score);
+    blockblaster_shuffle_ints(&c->rng, c->bag, c->bag_len);
+    c->bag_pos = 0;
+}
+
+/* Draw the next shape index from the bag, refilling when exhausted. */
+static int bag_next_shape_index(CoreGame *c)
+{
+    if (c->bag_len <= 0 || c->bag_pos >= c->bag_len)
+        bag_refill(c);
+    return c->bag[c->bag_pos++];
+}
+
+/* ======================================================================== */
+/* Piece / tray                                                              */
+/* ======================================================================== */
+
+/* Monotonic clock in microseconds, for the fair-tray budget. */
+static double core_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e6 + (double) ts.tv_nsec * 1e-3;
+}
+
+/* Draw one set of shapes and themes into every tray slot. */
+static void deal_tray(CoreGame *c)
+{
+    if (c->theme_mode == 1)
+        c->set_theme = random_theme(&c->rng);
+
+    for (int i = 0; i < c->tray_count; i++) {
+        c->tray[i].used = false;
+        int si = bag_next_shape_index(c);
+        c->tray[i].shape = SHAPES[si];
+        c->tray[i].shape_id = si;
+        if (c->theme_mode == 1)
+            c->tray[i].theme = c->set_theme;
+        else
+            c->tray[i].theme = random_theme(&c->rng);
+        blockblaster_placement_map_rebuild(c, i);
+    }
+}
+
+/**
+ * \brief Assign new shapes (and themes) to all tray slots.
+ *
+ * In theme_mode 1 all pieces share a single random theme; otherwise each
+ * piece gets its own.  Shapes are drawn from the bag randomizer and the
+ * placement map of every slot is rebuilt against the current grid.
+ *
+ * With c->fair_tray set, a set is drawn again from the bag until
+ * blockblaster_tray_feasible() proves it can be placed in full within
+ * FAIR_TRAY_DRAW_NODES nodes, up to FAIR_TRAY_MAX_DRAWS sets and within
+ * c->fair_budget_us; when the budget runs out the last set is kept.  The
+ * time spent is recorded in c->fair.
+ *
+ * \param c  Game rules state.
+ */
+void blockblaster_refill_tray(CoreGame *c)
+{
+    if (!c->fair_tray) {
+        deal_tray(c);
+        return;
+    }
+
+    double t0 = core_now_us();
+    for (int draw = 0;; draw++) {
+        deal_tray(c);
+
+        double budget = 0.0;
+        if (c->fair_budget_us > 0) {
+            budget = (double) c->fair_budget_us - (core_now_us() - t0);
+            if (budget <= 0.0) {
+                c->fair.budget_hits++;
+                break;
+            }
+        }
+        long nodes = 0;
+        int f = blockblaster_tray_feasible(c, FAIR_TRAY_DRAW_NODES, budget,
+                                           &nodes);
+        c->fair.nodes += nodes;
+        if (f == 1)
+            break;
+        if (draw + 1 == FAIR_TRAY_MAX_DRAWS) {
+            c->fair.budget_hits++;
+            break;
+        }
+        c->fair.redraws++;
+    }
+
+    double dt = core_now_us() - t0;
+    if (c->fair_budget_us > 0 && dt >= (double) c->fair_budget_us)
+        c->fair.timeouts++;
+    c->fair.deals++;
+    c->fair.last_us = dt;
+    c->fair.total_us += dt;
+    if (dt > c->fair.max_us)
+        c->fair.max_us = dt;
+}
+
+/**
+ * \brief Check whether every tray slot has been placed on the grid.
+ *
+ * \param c  Game rules state.
+ * \return   true if all pieces are used.
+ */
+bool blockblaster_tray_all_used(const CoreGame *c)
+{
+    for (int i = 0; i < c->tray_count; i++)
+        if (!c->tray[i].used)
+            return false;
+    return true;
+}
+
+/**
+ * \brief Check whether none of the remaining tray pieces can be placed.
+ *
+ * Used to detect game-over: if no unused piece has a valid placement the
+ * game ends.  Reads the placement maps, so this is an "any bit set" test
+ * over each unused slot.
+ *
+ * \param c  Game rules state.
+ * \return   true if no remaining piece fits on the grid.
+ */
+bool blockblaster_none_placeable(const CoreGame *c)
+{
+    for (int i = 0; i < c->tray_count; i++) {
+        if (c->tray[i].used)
+            continue;
+        if (blockblaster_placement_map_any(c, i))
+            return false;
+    }
+    return true;
+}
+
+/* ======================================================================== */
+/* Tray feasibility                                                          */
+/* ======================================================================== */
+
+/* Failed positions remembered by one feasibility check, as a power of two
+   (different orders often reach the same board). */
+#define FEASIBLE_MEMO_BITS 12
+
+/* Depth-first search state of blockblaster_tray_feasible(). */
+typedef struct {
+    const CoreGame *c;
+    long nodes;
+    long node_cap;
+    double deadline; /* core_now_us() limit, or 0 for none. */
+    bool out_of_budget;
+    int order[PIECES_PER_SET_MAX]; /* Slots in search order. */
+    uint64_t memo[1 << FEASIBLE_MEMO_BITS]; /* Keys of failed positions. */
+} FeasibleSearch;
+
+/* Legal anchor columns of m on anchor row gy of the row bitboards. */
+static uint32_t rows_anchor_mask(const uint32_t *rows, int w, int h,
+                                 const ShapeMask *m, int gy)
+{
+    if (gy + m->min_y < 0 || gy + m->max_y >= h || m->max_x >= w)
+        return 0;
+    uint32_t blocked = 0;
+    for (int i = 0; i < m->cell_count; i++)
+        blocked |= rows[gy + m->cells[i][1]] >> m->cells[i][0];
+    return ~blocked & GRID_BITS(w - m->max_x);
+}
+
+/* Remove the completed rows and columns of a row-bitboard board.  A column
+   is full when every row has its bit, so no column view is needed. */
+static void rows_clear_full(uint32_t *rows, int w, int h)
+{
+    uint32_t full = GRID_BITS(w);
+    uint32_t full_cols = full;
+    for (int y = 0; y < h; y++)
+        full_cols &= rows[y];
+    for (int y = 0; y < h; y++)
+        rows[y] = (rows[y] == full) ? 0 : (rows[y] & ~full_cols);
+}
+
+/* Fewest empty cells of any row or column: no line can be cleared by
+   placing fewer cells than this. */
+static int rows_min_gap(const uint32_t *rows, int w, int h)
+{
+    int gap = w;
+    uint8_t col_fill[GRID_W_MAX] = {0};
+    for (int y = 0; y < h; y++) {
+        int empty = w - GRID_POPCOUNT(rows[y]);
+        if (empty < gap)
+            gap = empty;
+        for (uint32_t r = rows[y]; r; r &= r - 1)
+            col_fill[__builtin_ctz(r)]++;
+    }
+    for (int x = 0; x < w; x++)
+        if (h - col_fill[x] < gap)
+            gap = h - col_fill[x];
+    return gap;
+}
+
+/* Memo key of a position: board rows and the slots left to place. */
+static uint64_t feasible_key(const uint32_t *rows, int h, uint32_t remaining)
+{
+    uint64_t k = 0x9e3779b97f4a7c15ull * (remaining + 1);
+    for (int y = 0; y < h; y++)
+        k = (k ^ rows[y]) * 0xbf58476d1ce4e5b9ull;
+    return (k ^ (k >> 31)) | 1u;
+}
+
+/* True if the slots in `remaining` can all be placed, in some order, on
+   the row-bitboard board rows[] (which has no completed line).
+
+   Slots are tried in the fixed order fs->order.  Two placements that clear
+   nothing give the same board either way round, so after a move that
+   cleared nothing, slots earlier in that order than `min_rank` may only
+   be placed where they clear a line.  A slot with no anchor at all can
+   only be placed after a clear, which is impossible when the other slots
+   together have fewer cells than the smallest gap of any line. */
+static bool feasible_search(FeasibleSearch *fs, const uint32_t *rows,
+                            uint32_t remaining, int min_rank)
+{
+    const CoreGame *c = fs->c;
+    int w = c->grid.w, h = c->grid.h;
+
+    if (++fs->nodes > fs->node_cap ||
+        ((fs->nodes & 255) == 0 && fs->deadline > 0.0 &&
+         core_now_us() > fs->deadline)) {
+        fs->out_of_budget = true;
+        return false;
+    }
+
+    uint64_t key =
+        feasible_key(rows, h, remaining | (uint32_t) min_rank << 8);
+    uint64_t *memo = &fs->memo[key & ((1u << FEASIBLE_MEMO_BITS) - 1)];
+    if (*memo == key)
+        return false;
+
+    uint32_t anchors[PIECES_PER_SET_MAX][GRID_H_MAX];
+    bool any[PIECES_PER_SET_MAX];
+    int cells = 0, stuck = 0;
+    for (int k = 0; k < c->tray_count; k++) {
+        int i = fs->order[k];
+        if (!((remaining >> i) & 1u))
+            continue;
+        const ShapeMask *m = &SHAPE_MASKS[c->tray[i].shape_id];
+        cells += m->cell_count;
+        uint32_t seen = 0;
+        for (int gy = 0; gy < h; gy++) {
+            anchors[i][gy] = rows_anchor_mask(rows, w, h, m, gy);
+            seen |= anchors[i][gy];
+        }
+        any[i] = seen != 0;
+        if (!any[i] && m->cell_count > stuck)
+            stuck = m->cell_count;
+    }
+
+    /* Last piece: any anchor will do. */
+    if (GRID_POPCOUNT(remaining) == 1)
+        return any[__builtin_ctz(remaining)];
+    if (stuck && cells - stuck < rows_min_gap(rows, w, h))
+        return false;
+
+    for (int k = 0; k < c->tray_count; k++) {
+        int i = fs->order[k];
+        if (!((remaining >> i) & 1u) || !any[i])
+            continue;
+        /* Equal shapes are interchangeable: only try the first. */
+        bool dup = false;
+        for (int j = 0; j < k; j++)
+            if (((remaining >> fs->order[j]) & 1u) &&
+                c->tray[fs->order[j]].shape_id == c->tray[i].shape_id)
+                dup = true;
+        if (dup)
+            continue;
+
+        const ShapeMask *m = &SHAPE_MASKS[c->tray[i].shape_id];
+        uint32_t rest = remaining & ~(1u << i);
+        for (int gy = 0; gy < h; gy++) {
+            for (uint32_t bits = anchors[i][gy]; bits; bits &= bits - 1) {
+                int gx = __builtin_ctz(bits);
+                uint32_t next[GRID_H_MAX];
+                memcpy(next, rows, sizeof(uint32_t) * (size_t) h);
+                bool full = false;
+                for (int sy = m->min_y; sy <= m->max_y; sy++) {
+                    next[gy + sy] |= m->rows[sy] << gx;
+                    full |= next[gy + sy] == GRID_BITS(w);
+                }
+                for (int sx = m->min_x; sx <= m->max_x && !full; sx++) {
+                    uint32_t col = 1u << (gx + sx);
+                    full = true;
+                    for (int y = 0; y < h && full; y++)
+                        full = (next[y] & col) != 0;
+                }
+                if (!full && k < min_rank)
+                    continue;
+                if (full)
+                    rows_clear_full(next, w, h);
+
+                if (feasible_search(fs, next, rest, full ? 0 : k + 1))
+                    return true;
+                if (fs->out_of_budget)
+                    return false;
+            }
+        }
+    }
+    *memo = key;
+    return false;
+}
+
+/**
+ * \brief Check whether some order places every unused tray piece.
+ *
+ * Depth-first search over slot orders and anchors, clearing completed
+ * lines between placements as blockblaster_core_drop() does (and any line
+ * already complete on c's grid before the first).  Stops at the first
+ * complete order.
+ *
+ * \param c          Game rules state (not modified).
+ * \param node_cap   Search nodes allowed.
+ * \param budget_us  Time allowed in microseconds, or 0 for no limit.
+ * \param nodes      If non-NULL, receives the nodes searched.
+ * \return           1 if an order places every piece, 0 if none does, -1 if
+ *                   the budget ran out first.
+ */
+int blockblaster_tray_feasible(const CoreGame *c, long node_cap,
+                               double budget_us, long *nodes)
+{
+    FeasibleSearch fs;
+    fs.c = c;
+    fs.nodes = 0;
+    fs.node_cap = node_cap;
+    fs.deadline = (budget_us > 0.0) ? core_now_us() + budget_us : 0.0;
+    fs.out_of_budget = false;
+    memset(fs.memo, 0, sizeof(fs.memo));
+
+    uint32_t remaining = 0;
+    for (int i = 0; i < c->tray_count; i++)
+        if (!c->tray[i].used)
+            remaining |= 1u << i;
+
+    /* Lines completed by the move that dealt this tray are still on the
+       grid when blockblaster_core_place() refills: clear them first. */
+    uint32_t rows[GRID_H_MAX];
+    memcpy(rows, c->grid.rows, sizeof(uint32_t) * (size_t) c->grid.h);
+    rows_clear_full(rows, c->grid.w, c->grid.h);
+
+    /* Search order: the slots with the fewest anchors first, as they are
+       the likeliest to fail. */
+    int count[PIECES_PER_SET_MAX];
+    for (int i = 0; i < c->tray_count; i++) {
+        int anchors = 0;
+        if (!c->tray[i].used) {
+            const ShapeMask *m = &SHAPE_MASKS[c->tray[i].shape_id];
+            for (int gy = 0; gy < c->grid.h; gy++)
+                anchors += GRID_POPCOUNT(
+                    rows_anchor_mask(rows, c->grid.w, c->grid.h, m, gy));
+        }
+        int k = i;
+        while (k > 0 && count[k - 1] > anchors) {
+            fs.order[k] = fs.order[k - 1];
+            count[k] = count[k - 1];
+            k--;
+        }
+        fs.order[k] = i;
+        count[k] = anchors;
+    }
+
+    int result = 1;
+    if (remaining && !feasible_search(&fs, rows, remaining, 0))
+        result = fs.out_of_budget ? -1 : 0;
+    if (nodes)
+        *nodes = fs.nodes;
+    return result;
+}
+
+/* ======================================================================== */
+/* Placement maps                                                            */
+/* ======================================================================== */
+
+/* Return the legal anchor columns of shape m on anchor row gy as a bitmask
+   (bit gx set when m fits with its top-left corner at (gx, gy)).  Each
+   filled shape cell (sx, sy) rules out the anchors that would put it on an
+   occupied cell, which is grid row gy + sy shifted right by sx. */
+static uint32_t anchor_row_mask(const Grid *g, const ShapeMask *m, int gy)
+{
+    if (gy + m->min_y < 0 || gy + m->max_y >= g->h || m->max_x >= g->w)
+        return 0;
+    uint32_t blocked = 0;
+    for (int i = 0; i < m->cell_count; i++)
+        blocked |= g->rows[gy + m->cells[i][1]] >> m->cells[i][0];
+    return ~blocked & GRID_BITS(g->w - m->max_x);
+}
+
+/**
+ * \brief Recompute every row of the placement map of tray slot i.
+ *
+ * The map of a used slot is cleared to all-zero.
+ *
+ * \param c  Game rules state (place_map[i] updated in-place).
+ * \param i  Tray slot index.
+ */
+void blockblaster_placement_map_rebuild(CoreGame *c, int i)
+{
+    memset(c->place_map[i], 0, sizeof(c->place_map[i]));
+    if (c->tray[i].used)
+        return;
+    const ShapeMask *m = &SHAPE_MASKS[c->tray[i].shape_id];
+    for (int gy = 0; gy < c->grid.h; gy++)
+        c->place_map[i][gy] = anchor_row_mask(&c->grid, m, gy);
+}
+
+/**
+ * \brief Refresh the placement maps after grid rows y0..y1 changed.
+ *
+ * For each unused tray slot only the anchor rows whose shape footprint
+ * overlaps rows y0..y1 are recomputed; every other anchor row is unaffected
+ * by the change.
+ *
+ * \param c   Game rules state.
+ * \param y0  First changed grid row.
+ * \param y1  Last changed grid row (inclusive).
+ */
+void blockblaster_placement_map_update_rows(CoreGame *c, int y0, int y1)
+{
+    for (int i = 0; i < c->tray_count; i++) {
+        if (c->tray[i].used)
+            continue;
+        const ShapeMask *m = &SHAPE_MASKS[c->tray[i].shape_id];
+        int a0 = y0 - m->max_y;
+        int a1 = y1 - m->min_y;
+        if (a0 < 0)
+            a0 = 0;
+        if (a1 > c->grid.h - 1)
+            a1 = c->grid.h - 1;
+        for (int gy = a0; gy <= a1; gy++)
+            c->place_map[i][gy] = anchor_row_mask(&c->grid, m, gy);
+    }
+}
+
+/**
+ * \brief Refresh the placement maps after lines were removed from the grid.
+ *
+ * Cleared rows only affect the anchor rows around them.  A cleared column
+ * frees a cell in every row, so in that case all anchor rows are refreshed.
+ *
+ * \param c          Game rules state.
+ * \param full_rows  Bit y set for each removed row.
+ * \param full_cols  Bit x set for each removed column.
+ */
+void blockblaster_placement_map_after_clear(CoreGame *c, uint32_t full_rows,
+                                            uint32_t full_cols)
+{
+    if (full_cols)
+        blockblaster_placement_map_update_rows(c, 0, c->grid.h - 1);
+    else if (full_rows)
+        blockblaster_placement_map_update_rows(c, __builtin_ctz(full_rows),
+                                               31 - __builtin_clz(full_rows));
+}
+
+/**
+ * \brief Test whether the placement map of tray slot i has any legal anchor.
+ *
+ * \param c  Game rules state.
+ * \param i  Tray slot index.
+ * \return   true if the piece in slot i fits somewhere on the grid.
+ */
+bool blockblaster_placement_map_any(const CoreGame *c, int i)
+{
+    uint32_t any = 0;
+    for (int gy = 0; gy < c->grid.h; gy++)
+        any |= c->place_map[i][gy];
+    return any != 0;
+}
+
+/**
+ * \brief Test whether tray slot i can be placed with its top-left at
+ *        (gx, gy).
+ *
+ * Anchors on the grid are answered from the placement map.  Anchors off the
+ * grid (only possible for shapes with an empty first row or column) fall
+ * back to blockblaster_can_place_at().
+ *
+ * \param c   Game rules state.
+ * \param i   Tray slot index.
+ * \param gx  Target column for the shape's top-left corner.
+ * \param gy  Target row for the shape's top-left corner.
+ * \return    true if placement is valid.
+ */
+bool blockblaster_placement_map_test(const CoreGame *c, int i, int gx, int gy)
+{
+    if (c->tray[i].used)
+        return false;
+    if (gx >= 0 && gy >= 0 && gx < c->grid.w && gy < c->grid.h)
+        return ((c->place_map[i][gy] >> gx) & 1u) != 0;
+    return blockblaster_can_place_at(&c->grid,
+                                     &SHAPE_MASKS[c->tray[i].shape_id], gx, gy);
+}
+
+/* ======================================================================== */
+/* Score                                                                     */
+/* ======================================================================== */
+
+/**
+ * \brief Score of a line clear, before placement points.
+ *
+ * \param combo          Combo counter, already raised by lines_cleared.
+ * \param lines_cleared  Number of full rows + columns cleared (> 0).
+ * \param cleared_cells  Total occupied cells removed by those lines.
+ * \param out_mult       If non-NULL, receives the multiplier applied.
+ * \return               Clear score gained.
+ */
+int blockblaster_clear_gain(int combo, int lines_cleared, int cleared_cells,
+                            float *out_mult)
+{
+    float mult = 1.0f + (float) combo;
+    if (mult > MAX_MULTIPLIER)
+        mult = MAX_MULTIPLIER;
+
+    int base_clear = cleared_cells * SCORE_PER_CLEARED_CELL;
+    int line_bonus = lines_cleared * SCORE_PER_LINE_BONUS;
+    int multi_bonus = (lines_cleared > 1)
+                          ? (SCORE_MULTI_LINE_BONUS * (lines_cleared - 1))
+                          : 0;
+
+    int subtotal = base_clear + line_bonus + multi_bonus;
+    if (out_mult)
+        *out_mult = mult;
+    return (int) roundf((float) subtotal * mult);
+}
+
+/**
+ * \brief Calculate and apply the score for a single placement move.
+ *
+ * Awards points for placed cells, cleared cells, line bonuses and multi-line
+ * bonuses.  Maintains the combo counter: consecutive clearing moves increase
+ * the multiplier; three consecutive non-clearing moves reset it.
+ *
+ * \param c              Game rules state (score, combo updated in-place).
+ * \param placed_cells   Number of cells the placed shape occupies.
+ * \param lines_cleared  Number of full rows + columns cleared this move.
+ * \param cleared_cells  Total occupied cells removed by those lines.
+ * \param out_clear_gain If non-NULL, receives the clear-only portion of the
+ *                       score gain (before placement points).
+ * \param out_mult       If non-NULL, receives the effective multiplier used.
+ * \return               Total score gained this move (placed + cleared).
+ */
+int blockblaster_score_move(CoreGame *c, int placed_cells, int lines_cleared,
+                            int cleared_cells, int *out_clear_gain,
+                            float *out_mult)
+{
+    int gained_total = 0;
+    int clear_gain = 0;
+    float mult = 1.0f;
+
+    int place_gain = placed_cells * SCORE_PER_PLACED_CELL;
+    gained_total += place_gain;
+
+    if (lines_cleared > 0) {
+        c->combo += lines_cleared;
+        if (c->combo > c->highest_combo)
+            c->highest_combo = c->combo;
+        c->combo_miss = 0;
+
+        clear_gain = blockblaster_clear_gain(c->combo, lines_cleared,
+                                             cleared_cells, &mult);
+        gained_total += clear_gain;
+    } else {
+        if (c->combo > 0) {
+            c->combo_miss += 1;
+            if (c->combo_miss > 3) {
+                c->combo = 0;
+                c->combo_miss = 0;
+                c->last_move_mult = 1.0f;
+                mult = 1.0f;
+            } else {
+                mult = c->last_move_mult;
+            }
+        } else {
+            c->last_move_mult = 1.0f;
+            mult = 1.0f;
+        }
+    }
+    if (out_clear_gain)
+        *out_clear_gain = clear_gain;
+    if (out_mult)
+        *out_mult = mult;
+    c->last_move_mult = mult;
+    c->score += gained_total;
+    return gained_total;
+}
+
+/* ======================================================================== */
+/* Game flow                                                                 */
+/* ======================================================================== */
+
+/**
+ * \brief Start a new game: size the grid, reset the score and deal a tray.
+ *
+ * Mode 1 pre-fills FILL_MIN..FILL_MAX random cells (any line that happens
+ * to be complete is removed).  game_over is set straight away when none of
+ * the first pieces fits.  All randomness comes from c->rng, which is not
+ * reseeded here: seed it first for a reproducible game.
+ *
+ * \param c           Game rules state (fully reset by this call).
+ * \param grid_w      Number of columns (1..GRID_W_MAX).
+ * \param grid_h      Number of rows (1..GRID_H_MAX).
+ * \param tray_count  Pieces per set (1..PIECES_PER_SET_MAX).
+ * \param mode        0 = empty grid, 1 = partially filled grid.
+ */
+void blockblaster_core_start(CoreGame *c, int grid_w, int grid_h,
+                             int tray_count, int mode)
+{
+    c->tray_count = tray_count;
+    c->score = 0;
+    c->combo = 0;
+    c->highest_combo = 0;
+    c->last_move_mult = 1.0f;
+    c->combo_miss = 0;
+    c->game_over = false;
+    c->theme_mode = 0;
+    c->bag_len = 0;
+    c->bag_pos = 0;
+    memset(&c->fair, 0, sizeof(c->fair));
+
+    c->start_mode = mode;
+    blockblaster_grid_clear(&c->grid, grid_w, grid_h);
+
+    if (mode == 1) {
+        int fill = blockblaster_irand(&c->rng, FILL_MIN, FILL_MAX);
+        blockblaster_random_fill(&c->grid, &c->rng, fill);
+        uint32_t full_rows, full_cols;
+        if (blockblaster_find_full_lines(&c->grid, 0, 0, grid_w - 1,
+                                         grid_h - 1, &full_rows, &full_cols))
+            blockblaster_clear_lines(&c->grid, full_rows, full_cols);
+    }
+
+    blockblaster_refill_tray(c);
+    c->game_over = blockblaster_none_placeable(c);
+
+    /* Every set after the opening one shares a single theme. */
+    c->theme_mode = 1;
+    c->set_theme = random_theme(&c->rng);
+}
+
+/**
+ * \brief Place tray slot `slot` with its top-left at (gx, gy) and score it.
+ *
+ * Completed lines are reported in *out but left on the grid, so a caller
+ * can animate them before calling blockblaster_core_clear().  The slot is
+ * marked used and a new set is dealt once the whole tray is placed.  When
+ * the move completes no line, game_over is updated immediately.
+ *
+ * \param c     Game rules state.
+ * \param slot  Tray slot index.
+ * \param gx    Grid column for the shape's top-left corner.
+ * \param gy    Grid row for the shape's top-left corner.
+ * \param out   If non-NULL, receives the outcome of the move.
+ * \return      false (state untouched) if the slot is used or the
+ *              placement is illegal.
+ */
+bool blockblaster_core_place(CoreGame *c, int slot, int gx, int gy,
+                             CoreMove *out)
+{
+    if (slot < 0 || slot >= c->tray_count ||
+        !blockblaster_placement_map_test(c, slot, gx, gy))
+        return false;
+
+    Piece *p = &c->tray[slot];
+    const ShapeMask *m = &SHAPE_MASKS[p->shape_id];
+    blockblaster_place_shape(&c->grid, m, gx, gy, p->theme);
+    blockblaster_placement_map_update_rows(c, gy + m->min_y, gy + m->max_y);
+
+    /* Only lines crossing the placed shape can have been completed. */
+    CoreMove mv = {0};
+    mv.placed_cells = m->cell_count;
+    mv.lines = blockblaster_find_full_lines(
+        &c->grid, gx + m->min_x, gy + m->min_y, gx + m->max_x, gy + m->max_y,
+        &mv.full_rows, &mv.full_cols);
+    if (mv.lines > 0)
+        mv.cleared_cells = blockblaster_count_cells_in_lines(
+            &c->grid, mv.full_rows, mv.full_cols);
+    mv.gain = blockblaster_score_move(c, mv.placed_cells, mv.lines,
+                                      mv.cleared_cells, &mv.clear_gain,
+                                      &mv.mult);
+
+    p->used = true;
+    blockblaster_placement_map_rebuild(c, slot);
+
+    if (blockblaster_tray_all_used(c)) {
+        blockblaster_refill_tray(c);
+        mv.refilled = true;
+    }
+    if (mv.lines == 0)
+        c->game_over = blockblaster_none_placeable(c);
+
+    if (out)
+        *out = mv;
+    return true;
+}
+
+/**
+ * \brief Remove completed lines reported by blockblaster_core_place() and
+ *        update game_over.
+ *
+ * \param c          Game rules state.
+ * \param full_rows  Bit y set for each row to remove.
+ * \param full_cols  Bit x set for each column to remove.
+ */
+void blockblaster_core_clear(CoreGame *c, uint32_t full_rows,
+                             uint32_t full_cols)
+{
+    blockblaster_clear_lines(&c->grid, full_rows, full_cols);
+    blockblaster_placement_map_after_clear(c, full_rows, full_cols);
+    c->game_over = blockblaster_none_placeable(c);
+}
+
+/**
+ * \brief Place, score and clear in one step (no animation).
+ *
+ * \param c     Game rules state.
+ * \param slot  Tray slot index.
+ * \param gx    Grid column for the shape's top-left corner.
+ * \param gy    Grid row for the shape's top-left corner.
+ * \param out   If non-NULL, receives the outcome of the move.
+ * \return      false (state untouched) if the move is illegal.
+ */
+bool blockblaster_core_drop(CoreGame *c, int slot, int gx, int gy,
+                            CoreMove *out)
+{
+    CoreMove mv;
+    if (!blockblaster_core_place(c, slot, gx, gy, &mv))
+        return false;
+    if (mv.lines > 0)
+        blockblaster_core_clear(c, mv.full_rows, mv.full_cols);
+    if (out)
+        *out = mv;
+    return true;
+}
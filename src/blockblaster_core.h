@@ -0,0 +1,487 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_core.h
+ * \brief Headless game rules: grid, bag, tray, scoring, drop and game-over.
+ *
+ * Everything declared here is plain C with no Allegro, audio or platform
+ * dependency, so it can be built on its own as libblockblaster_core.a
+ * (`make core`) and driven at full CPU speed by simulations, solvers and
+ * benchmarks.  The game embeds one CoreGame in its GameContext and adds
+ * animation, sound and input on top.
+ *
+ * Colour themes are referred to by index into the renderer's theme table;
+ * the rules only draw the index so the random sequence matches the game.
+ */
+
+#ifndef __BLOCKBLASTER_CORE__
+#define __BLOCKBLASTER_CORE__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * \defgroup CORE_GRID Grid and tray limits
+ * \brief Compile-time bounds used for array sizes.
+ * @{
+ */
+
+/** \brief Maximum number of columns (compile-time, used for array sizes).
+ * Must not exceed 32: each grid row is stored as a uint32_t bitboard. */
+#define GRID_W_MAX 20
+
+/** \brief Maximum number of rows (compile-time, used for array sizes).
+ * Must not exceed 32: each grid column is stored as a uint32_t bitboard. */
+#define GRID_H_MAX 20
+
+/** \brief Maximum pieces per set (compile-time, used for array sizes). */
+#define PIECES_PER_SET_MAX 4
+
+/** @} */
+
+/**
+ * \defgroup DIFFICULTY Difficulty ramp
+ * \brief Constants governing the score-based difficulty ramp.
+ *
+ * At score 0 the bag is filled with easy shapes.  At DIFFICULTY_MAX_SCORE
+ * the bag favours the hardest shapes.  Easy shapes are never completely absent
+ * even at maximum difficulty, and hard shapes always have some chance even at
+ * score 0 (see MIN_DIFFICULTY_WEIGHT).
+ *
+ * The weight for each shape is:
+ *   w(d,t) = n * (MIN_DIFFICULTY_WEIGHT +
+ *                 (1 - MIN_DIFFICULTY_WEIGHT) * lerp(1-d, d, t))
+ *
+ * where n and d are the shape's weight and difficulty columns in SHAPES[]
+ * (d: 0 = easiest, 1 = hardest) and
+ * t = min(score, DIFFICULTY_MAX_SCORE) / DIFFICULTY_MAX_SCORE.
+ * @{
+ */
+
+/** \brief Score at which the shape picker reaches maximum difficulty. */
+#define DIFFICULTY_MAX_SCORE 75000
+
+/**
+ * \brief Minimum probability weight assigned to any shape at any difficulty.
+ *
+ * Prevents any shape from having zero probability; both easy and hard shapes
+ * are always reachable.  Value 0.01 means a 1% floor weight.
+ */
+#define MIN_DIFFICULTY_WEIGHT 0.01f
+
+/**
+ * \brief Number of quantised difficulty levels between score 0 and
+ * DIFFICULTY_MAX_SCORE.
+ *
+ * One alias table is cached per level, so a shape draw is O(1).  With 256
+ * levels t is rounded by at most 1/510, which moves any shape's probability
+ * by well under 0.01%.
+ */
+#define DIFFICULTY_LEVELS 256
+
+/** @} */
+
+/**
+ * \defgroup SCORING Scoring constants
+ * \brief Point values awarded for placement and line-clearing events.
+ * @{
+ */
+
+/** \brief Points awarded per occupied cell placed on the grid. */
+#define SCORE_PER_PLACED_CELL 1
+
+/** \brief Points awarded per cell cleared from the grid. */
+#define SCORE_PER_CLEARED_CELL 10
+
+/** \brief Bonus points awarded per complete line (row or column) cleared. */
+#define SCORE_PER_LINE_BONUS 25
+
+/** \brief Extra bonus points per additional line cleared beyond the first. */
+#define SCORE_MULTI_LINE_BONUS 50
+
+/**
+ * \brief Multiplier increment per consecutive clearing move.
+ *
+ * Each move that clears at least one line increases the combo counter by 1,
+ * raising the effective multiplier by this fraction.
+ */
+#define COMBO_STEP_MULT 0.25f
+
+/** \brief Maximum score multiplier achievable through consecutive line clears.
+ */
+#define MAX_MULTIPLIER 20.0f
+
+/** @} */
+
+/**
+ * \defgroup PARTIAL_FILL Partial-fill starting mode
+ * \brief Range of random cells pre-filled in the "partially filled" start mode.
+ * @{
+ */
+
+/** \brief Minimum number of cells pre-filled when starting with a partial grid.
+ */
+#define FILL_MIN 16
+
+/** \brief Maximum number of cells pre-filled when starting with a partial grid.
+ */
+#define FILL_MAX 28
+
+/** @} */
+
+/**
+ * \defgroup BAG Bag randomizer
+ * \brief Constants for the weighted bag-randomizer used to draw shapes.
+ * @{
+ */
+
+/**
+ * \brief Number of shape draws in one bag cycle before the bag is reshuffled.
+ *
+ * Can be set to SHAPES_COUNT to draw each shape exactly once per cycle.
+ */
+#define BAG_SIZE 24
+
+/** @} */
+
+/**
+ * \defgroup FAIR_TRAY Fair-tray mode
+ * \brief Limits of the feasibility check run on each deal in fair-tray mode.
+ *
+ * A tray is kept once the check proves that some order places all of its
+ * pieces (clearing lines in between); otherwise, or when the proof takes
+ * more than FAIR_TRAY_DRAW_NODES search nodes, it is redrawn from the bag.
+ * The node limit keeps dealing deterministic; the time budget
+ * (CoreGame.fair_budget_us) additionally makes it depend on machine speed,
+ * so headless runs that must replay leave it at 0.
+ * @{
+ */
+
+/** \brief CPU budget of one fair deal (all checks and redraws), in us. */
+#define FAIR_TRAY_BUDGET_US 1000
+
+/** \brief Feasibility search nodes allowed per drawn tray. */
+#define FAIR_TRAY_DRAW_NODES 4096
+
+/** \brief Trays drawn per fair deal at most. */
+#define FAIR_TRAY_MAX_DRAWS 16
+
+/** @} */
+
+/**
+ * \brief Total number of named colour themes available in the theme table.
+ *
+ * Pieces and grid cells store an index in [0, THEMES_COUNT); the renderer
+ * maps it to colours through GameContext.theme_table.
+ */
+#define THEMES_COUNT 8
+
+/* ======================================================================== */
+/* Random numbers                                                            */
+/* ======================================================================== */
+
+/**
+ * \brief PCG32 random number generator (O'Neill, pcg-random.org).
+ *
+ * 64-bit state, 32-bit output, and an odd increment that selects one of
+ * 2^63 independent streams.  Seeding the same value on different streams
+ * gives unrelated sequences, so one seed can drive both the gameplay and
+ * the cosmetic stream, and every game or worker thread can own its own
+ * generator.  A zero-initialised Rng seeds itself with seed 0, stream 0
+ * on first use.
+ */
+typedef struct {
+    uint64_t state; /* Current state. */
+    uint64_t inc;   /* Stream increment (always odd once seeded). */
+} Rng;
+
+/** \brief Stream for everything that affects the game outcome (bag, themes,
+ * partial fill). */
+#define RNG_STREAM_GAMEPLAY 1
+
+/** \brief Stream for purely visual or audible randomness (particles,
+ * screen shake, music choice). */
+#define RNG_STREAM_COSMETIC 2
+
+/* ======================================================================== */
+/* Piece definitions                                                         */
+/* ======================================================================== */
+
+/**
+ * \brief Maximum dimension (width or height) of any shape, in cells.
+ *
+ * All shapes are stored in a SHAPE_MAX x SHAPE_MAX boolean grid regardless
+ * of their actual footprint.
+ */
+#define SHAPE_MAX 5
+
+/**
+ * \brief Immutable descriptor of a tetromino-like block shape.
+ *
+ * Shapes are defined as a boolean grid of up to SHAPE_MAX x SHAPE_MAX cells.
+ * Only cells where cells[y][x] is true contribute to the shape's footprint.
+ * weight and difficulty feed the bag randomizer (see DIFFICULTY).
+ */
+typedef struct {
+    int w;                 /* Actual width of the shape in cells. */
+    int h;                 /* Actual height of the shape in cells. */
+    bool cells[SHAPE_MAX]
+              [SHAPE_MAX]; /* Cell occupancy grid; cells[row][col]. */
+    const char *name;      /* Short debug name identifying the shape. */
+    int weight;       /* Relative draw frequency at equal difficulty. */
+    float difficulty; /* 0 = easiest .. 1 = hardest; drives the ramp. */
+} Shape;
+
+/**
+ * \brief Precomputed bitmask form of a Shape, used by the placement rules.
+ *
+ * One ShapeMask exists per SHAPES[] entry (see SHAPE_MASKS[] in the
+ * generated blockblaster_shape_masks.h).  rows[sy] has bit sx set when
+ * cells[sy][sx] is filled and cols[sx] holds the transposed view, so a
+ * shape row can be shifted straight onto a grid row bitboard.
+ */
+typedef struct {
+    int w;          /* Width of the shape's SHAPE_MAX grid footprint. */
+    int h;          /* Height of the shape's SHAPE_MAX grid footprint. */
+    int cell_count; /* Number of filled cells (popcount of rows[]). */
+    int min_x;      /* Bounding box of the filled cells, inclusive. */
+    int min_y;
+    int max_x;
+    int max_y;
+    uint32_t rows[SHAPE_MAX]; /* Row masks; bit sx = cell (sx, sy). */
+    uint32_t cols[SHAPE_MAX]; /* Column masks; bit sy = cell (sx, sy). */
+    signed char cells[SHAPE_MAX * SHAPE_MAX]
+                     [2]; /* (x, y) offsets of the cell_count filled cells. */
+} ShapeMask;
+
+/**
+ * \brief A single piece slot in the player's tray.
+ *
+ * Each slot holds one Shape and the colour theme applied to it when placed.
+ * Once placed on the grid the slot is marked used and no longer shown.
+ */
+typedef struct {
+    Shape shape;  /* The block shape held by this tray slot. */
+    int shape_id; /* Index of shape in SHAPES[] / SHAPE_MASKS[]. */
+    bool used;  /* True once the player has placed this piece on the grid. */
+    int theme;  /* Theme index used when drawing and placing the piece. */
+} Piece;
+
+/**
+ * \brief Spare zero rows after the last row bitboard.
+ *
+ * The vector placement-scan kernels load several consecutive rows at once
+ * and may read up to 7 rows past the last grid row; the padding keeps those
+ * loads inside the Grid.
+ */
+#define GRID_ROW_PAD 8
+
+/**
+ * \brief The play grid (up to GRID_W_MAX x GRID_H_MAX cells).
+ *
+ * Occupancy is stored as bitboards: rows[y] holds one bit per column (bit x
+ * set when cell (x, y) is occupied) and cols[x] holds the transposed view
+ * (bit y set when cell (x, y) is occupied).  Both views are kept in sync by
+ * every function that modifies the grid, so placement tests and full-line
+ * detection are a few AND / compare operations per row or column.
+ *
+ * row_fill[] and col_fill[] count the occupied cells of each row and
+ * column.  They are updated alongside the bitboards so completed lines can
+ * be found by checking only the rows and columns a placement touched, and
+ * so placement scans can skip rows and columns without enough free cells.
+ *
+ * Each cell also stores the theme index of the piece that occupies it, so
+ * cleared cells can be drawn with the correct colour during the flash
+ * animation.
+ */
+typedef struct {
+    int w; /* Number of columns in use (at most GRID_W_MAX). */
+    int h; /* Number of rows in use (at most GRID_H_MAX). */
+    uint32_t rows[GRID_H_MAX + GRID_ROW_PAD]; /* Row bitboards; bit x = cell
+                                                 (x, y).  Entries past h
+                                                 are always 0. */
+    uint32_t cols[GRID_W_MAX]; /* Column bitboards; bit y = cell (x, y). */
+    uint8_t row_fill[GRID_H_MAX]; /* Occupied cells in row y. */
+    uint8_t col_fill[GRID_W_MAX]; /* Occupied cells in column x. */
+    uint8_t cell_theme[GRID_H_MAX][GRID_W_MAX]; /* Per-cell theme index. */
+    bool has_theme[GRID_H_MAX]
+                  [GRID_W_MAX]; /* True when cell_theme[y][x] is valid. */
+} Grid;
+
+/** \brief Bitboard mask with one bit set for each of the first n cells. */
+#define GRID_BITS(n) ((uint32_t) ((1ull << (n)) - 1ull))
+
+/** \brief Row bitboard value of a completely filled row of grid g. */
+#define GRID_FULL_ROW(g) GRID_BITS((g)->w)
+
+/** \brief Column bitboard value of a completely filled column of grid g. */
+#define GRID_FULL_COL(g) GRID_BITS((g)->h)
+
+/** \brief True when cell (x, y) of grid g is occupied. */
+#define GRID_OCC(g, x, y) ((((g)->rows[(y)] >> (x)) & 1u) != 0)
+
+/** \brief Number of set bits in a row, column or shape bitmask. */
+#define GRID_POPCOUNT(m) __builtin_popcount((unsigned int) (m))
+
+/* ======================================================================== */
+/* Game rules state                                                          */
+/* ======================================================================== */
+
+/**
+ * \brief Statistics of the fair-tray checks of one game.
+ */
+typedef struct {
+    long deals;       /* Trays dealt in fair-tray mode. */
+    long redraws;     /* Trays drawn again, not proven placeable. */
+    long budget_hits; /* Deals that kept an unproven tray. */
+    long nodes;       /* Feasibility search nodes over all deals. */
+    long timeouts;    /* Deals that ran into the time budget, so may be
+                         dealt differently by a replay. */
+    double last_us;   /* Time spent on the last deal, microseconds. */
+    double max_us;    /* Slowest deal, microseconds. */
+    double total_us;  /* Time over all deals, microseconds. */
+} FairTrayStats;
+
+/**
+ * \brief Rules-only state of one game: grid, tray, bag and score.
+ *
+ * Carries its own grid size, tray count and random stream, so any number
+ * of games of different sizes can run side by side, and a game seeded
+ * with blockblaster_rng_seed(&c->rng, seed, RNG_STREAM_GAMEPLAY) before
+ * blockblaster_core_start() replays bit-exactly.
+ */
+typedef struct {
+    Grid grid;                      /* The play grid (holds w and h). */
+    int tray_count;                 /* Pieces offered per set (1..4). */
+    Piece tray[PIECES_PER_SET_MAX]; /* Piece slots offered each turn. */
+    uint32_t place_map[PIECES_PER_SET_MAX]
+                      [GRID_H_MAX]; /* Legal anchors per tray slot: bit gx of
+                                       place_map[i][gy] set when tray[i] fits
+                                       with its top-left at (gx, gy).  All
+                                       zero for used slots. */
+
+    long score;           /* Score for the current session. */
+    int combo;            /* Consecutive moves that each cleared a line. */
+    int highest_combo;    /* Highest combo for the current session. */
+    float last_move_mult; /* Score multiplier applied on the previous move. */
+    int combo_miss; /* Non-clearing placements since the last line clear. */
+
+    int start_mode; /* Start mode: 0 = empty grid, 1 = partially filled grid.
+                     */
+
+    /**
+     * \brief Theme assignment mode.
+     *
+     * 0 = each piece receives its own random theme.
+     * 1 = all pieces in a set share one randomly chosen theme.
+     */
+    int theme_mode;
+    int set_theme; /* Shared theme index for the current set (theme_mode 1).
+                    */
+
+    int bag[BAG_SIZE]; /* Array of shape indices for the current bag cycle. */
+    int bag_len;       /* Number of entries in the current bag. */
+    int bag_pos;       /* Next draw position within the bag array. */
+
+    Rng rng;        /* Gameplay stream: bag draws, themes, partial fill. */
+    bool game_over; /* True once none of the remaining pieces fits. */
+
+    bool fair_tray;      /* Redraw trays that cannot be placed in full.  Set
+                            before blockblaster_core_start(). */
+    long fair_budget_us; /* Time budget per fair deal (0 = node limit only).
+                          */
+    FairTrayStats fair;  /* Reset by blockblaster_core_start(). */
+} CoreGame;
+
+/**
+ * \brief Outcome of one placement, filled by blockblaster_core_place().
+ */
+typedef struct {
+    int placed_cells;   /* Cells occupied by the placed shape. */
+    int lines;          /* Completed rows + columns. */
+    uint32_t full_rows; /* Bit y set for each completed row. */
+    uint32_t full_cols; /* Bit x set for each completed column. */
+    int cleared_cells;  /* Distinct cells covered by the completed lines. */
+    int gain;           /* Total score gained (placement + clear). */
+    int clear_gain;     /* Clear-only part of gain. */
+    float mult;         /* Multiplier applied to the clear. */
+    bool refilled;      /* True when the move emptied the tray and a new set
+                           was drawn. */
+} CoreMove;
+
+#include "blockblaster_shapes.h"
+
+/* ---- Random numbers ---- */
+void blockblaster_rng_seed(Rng *r, uint64_t seed, uint64_t stream);
+uint32_t blockblaster_rng_next(Rng *r);
+int blockblaster_irand(Rng *r, int a, int b);
+float blockblaster_frand01(Rng *r);
+float blockblaster_frand(Rng *r, float a, float b);
+void blockblaster_shuffle_ints(Rng *r, int *a, int n);
+
+/* ---- Grid ---- */
+void blockblaster_grid_clear(Grid *g, int w, int h);
+bool blockblaster_shape_cell(const Shape *s, int x, int y);
+bool blockblaster_can_place_at(const Grid *g, const ShapeMask *m, int gx,
+                               int gy);
+bool blockblaster_any_valid_placement(const Grid *g, const ShapeMask *m);
+void blockblaster_place_shape(Grid *g, const ShapeMask *m, int gx, int gy,
+                              int theme);
+int blockblaster_find_full_lines(const Grid *g, int x0, int y0, int x1, int y1,
+                                 uint32_t *out_rows, uint32_t *out_cols);
+int blockblaster_count_cells_in_lines(const Grid *g, uint32_t full_rows,
+                                      uint32_t full_cols);
+void blockblaster_clear_lines(Grid *g, uint32_t full_rows, uint32_t full_cols);
+void blockblaster_random_fill(Grid *g, Rng *r, int count);
+void blockblaster_predict_full_lines(const Grid *g, const ShapeMask *m, int gx,
+                                     int gy, uint32_t *out_rows,
+                                     uint32_t *out_cols);
+
+/* ---- Shape sampler ---- */
+float blockblaster_shape_weight(int shape, float t);
+int blockblaster_difficulty_level(long score);
+void blockblaster_shape_sampler_init(void);
+int blockblaster_shape_draw(Rng *r, long score);
+
+/* ---- Piece / tray ---- */
+void blockblaster_refill_tray(CoreGame *c);
+int blockblaster_tray_feasible(const CoreGame *c, long node_cap,
+                               double budget_us, long *nodes);
+bool blockblaster_tray_all_used(const CoreGame *c);
+bool blockblaster_none_placeable(const CoreGame *c);
+
+/* ---- Placement maps ---- */
+void blockblaster_placement_map_rebuild(CoreGame *c, int i);
+void blockblaster_placement_map_update_rows(CoreGame *c, int y0, int y1);
+void blockblaster_placement_map_after_clear(CoreGame *c, uint32_t full_rows,
+                                            uint32_t full_cols);
+bool blockblaster_placement_map_any(const CoreGame *c, int i);
+bool blockblaster_placement_map_test(const CoreGame *c, int i, int gx, int gy);
+
+/* ---- Score ---- */
+int blockblaster_clear_gain(int combo, int lines_cleared, int cleared_cells,
+                            float *out_mult);
+int blockblaster_score_move(CoreGame *c, int placed_cells, int lines_cleared,
+                            int cleared_cells, int *out_clear_gain,
+                            float *out_mult);
+
+/* ---- Game flow ---- */
+void blockblaster_core_start(CoreGame *c, int grid_w, int grid_h,
+                             int tray_count, int mode);
+bool blockblaster_core_place(CoreGame *c, int slot, int gx, int gy,
+                             CoreMove *out);
+void blockblaster_core_clear(CoreGame *c, uint32_t full_rows,
+                             uint32_t full_cols);
+bool blockblaster_core_drop(CoreGame *c, int slot, int gx, int gy,
+                            CoreMove *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLOCKBLASTER_CORE__ */
@@ -0,0 +1,209 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_env.c
+ * \brief Training environment and env protocol encoding.
+ *
+ * Pure functions over an Env and byte buffers: the transport (stdio or a
+ * socket) lives in blockblaster_env_server.c.
+ */
+
+#include "blockblaster_env.h"
+
+#include <string.h>
+
+/* ======================================================================== */
+/* Little-endian encoding                                                    */
+/* ======================================================================== */
+
+static void put_u16(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t) v;
+    p[1] = (uint8_t) (v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    put_u16(p, v);
+    put_u16(p + 2, v >> 16);
+}
+
+static void put_u64(uint8_t *p, uint64_t v)
+{
+    put_u32(p, (uint32_t) v);
+    put_u32(p + 4, (uint32_t) (v >> 32));
+}
+
+static uint64_t get_u64(const uint8_t *p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--)
+        v = v << 8 | p[i];
+    return v;
+}
+
+/* Counter clamped to a u16 field. */
+static uint32_t clamp_u16(int v)
+{
+    return v < 0 ? 0u : v > 0xFFFF ? 0xFFFFu : (uint32_t) v;
+}
+
+/* ======================================================================== */
+/* Environment                                                               */
+/* ======================================================================== */
+
+/**
+ * \brief Start a new game, seeded like the game seeds its gameplay stream.
+ *
+ * \param e      Environment.
+ * \param seed   Gameplay seed; the same seed and settings give the same
+ *               game.
+ * \param grid   Grid side length (1 - GRID_W_MAX).
+ * \param tray   Pieces per set (1 - PIECES_PER_SET_MAX).
+ * \param mode   0 = empty grid, 1 = partially filled grid.
+ * \param flags  ENV_RESET_* bits.
+ * \return       false (game unchanged) if a parameter is out of range.
+ */
+bool blockblaster_env_reset(Env *e, uint64_t seed, int grid, int tray,
+                            int mode, int flags)
+{
+    if (grid < 1 || grid > GRID_W_MAX || grid > GRID_H_MAX || tray < 1 ||
+        tray > PIECES_PER_SET_MAX || (mode != 0 && mode != 1) ||
+        (flags & ~ENV_RESET_FAIR) != 0)
+        return false;
+
+    blockblaster_rng_seed(&e->core.rng, seed, RNG_STREAM_GAMEPLAY);
+    e->core.fair_tray = (flags & ENV_RESET_FAIR) != 0;
+    e->core.fair_budget_us = 0;
+    blockblaster_core_start(&e->core, grid, grid, tray, mode);
+    e->started = true;
+    e->steps = 0;
+    return true;
+}
+
+/**
+ * \brief Encode the current state as an observation (see blockblaster_env.h
+ *        for the layout).  An environment never reset encodes as all zero.
+ *
+ * \param e    Environment.
+ * \param out  ENV_OBS_SIZE bytes.
+ */
+void blockblaster_env_observe(const Env *e, uint8_t *out)
+{
+    memset(out, 0, ENV_OBS_SIZE);
+    if (!e->started)
+        return;
+
+    const CoreGame *c = &e->core;
+    out[0] = (uint8_t) c->grid.w;
+    out[1] = (uint8_t) c->grid.h;
+    out[2] = (uint8_t) c->tray_count;
+    out[3] = c->game_over ? 1 : 0;
+    put_u16(out + 4, clamp_u16(c->combo));
+    put_u16(out + 6, clamp_u16(c->combo_miss));
+    put_u64(out + 8, (uint64_t) (int64_t) c->score);
+    for (int y = 0; y < c->grid.h; y++)
+        put_u32(out + 16 + 4 * y, c->grid.rows[y]);
+
+    uint8_t *slot = out + 16 + 4 * GRID_H_MAX;
+    for (int i = 0; i < PIECES_PER_SET_MAX; i++, slot += 8) {
+        if (i >= c->tray_count || c->tray[i].used) {
+            slot[0] = 0xFF;
+            continue;
+        }
+        const ShapeMask *m = &SHAPE_MASKS[c->tray[i].shape_id];
+        slot[0] = (uint8_t) c->tray[i].shape_id;
+        slot[1] = (uint8_t) m->w;
+        slot[2] = (uint8_t) m->h;
+        for (int sy = 0; sy < SHAPE_MAX; sy++)
+            slot[3 + sy] = (uint8_t) m->rows[sy];
+    }
+}
+
+/**
+ * \brief Drop tray slot `slot` with its top-left at (gx, gy), with the
+ *        rules of blockblaster_try_drop() (place, score, clear at once).
+ *
+ * \param e     Environment (must have been reset).
+ * \param slot  Tray slot index.
+ * \param gx    Grid column of the shape's top-left corner.
+ * \param gy    Grid row of the shape's top-left corner.
+ * \param out   Receives the outcome.
+ */
+void blockblaster_env_step(Env *e, int slot, int gx, int gy, EnvStep *out)
+{
+    CoreMove mv;
+    e->steps++;
+    out->placed = blockblaster_core_drop(&e->core, slot, gx, gy, &mv);
+    out->lines = out->placed ? mv.lines : 0;
+    out->reward = out->placed ? mv.gain : 0;
+    out->done = e->core.game_over;
+}
+
+/* ======================================================================== */
+/* Protocol                                                                  */
+/* ======================================================================== */
+
+/**
+ * \brief Size of the request that starts with opcode `op`.
+ *
+ * \param op  First byte of the request.
+ * \return    Request size in bytes, or 0 for an unknown opcode.
+ */
+int blockblaster_env_request_size(int op)
+{
+    switch (op) {
+    case ENV_OP_RESET:
+        return 13;
+    case ENV_OP_OBSERVE:
+    case ENV_OP_CLOSE:
+        return 1;
+    case ENV_OP_STEP:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * \brief Carry out one complete request and encode its reply.
+ *
+ * \param e      Environment of the session.
+ * \param req    blockblaster_env_request_size(req[0]) bytes; the opcode
+ *               must be known.
+ * \param reply  At least ENV_REPLY_MAX bytes.
+ * \return       Reply size in bytes (0 for ENV_OP_CLOSE).
+ */
+int blockblaster_env_handle(Env *e, const uint8_t *req, uint8_t *reply)
+{
+    switch (req[0]) {
+    case ENV_OP_RESET:
+        reply[0] = blockblaster_env_reset(e, get_u64(req + 1), req[9],
+                                          req[10], req[11], req[12])
+                       ? ENV_STATUS_OK
+                       : ENV_STATUS_BAD_ARGS;
+        blockblaster_env_observe(e, reply + 1);
+        return 1 + ENV_OBS_SIZE;
+    case ENV_OP_OBSERVE:
+        reply[0] = e->started ? ENV_STATUS_OK : ENV_STATUS_NO_GAME;
+        blockblaster_env_observe(e, reply + 1);
+        return 1 + ENV_OBS_SIZE;
+    case ENV_OP_STEP: {
+        EnvStep st = {0};
+        if (e->started) {
+            blockblaster_env_step(e, req[1], req[2], req[3], &st);
+            reply[0] = ENV_STATUS_OK;
+        } else {
+            reply[0] = ENV_STATUS_NO_GAME;
+        }
+        reply[1] = st.placed ? 1 : 0;
+        reply[2] = st.done ? 1 : 0;
+        reply[3] = (uint8_t) st.lines;
+        put_u32(reply + 4, (uint32_t) st.reward);
+        blockblaster_env_observe(e, reply + 8);
+        return 8 + ENV_OBS_SIZE;
+    }
+    default:
+        return 0;
+    }
+}
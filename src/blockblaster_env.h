@@ -0,0 +1,123 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_env.h
+ * \brief Training environment: reset / observe / step on a CoreGame, and
+ *        the binary protocol BlockBlasterEnv speaks over a byte stream.
+ *
+ * A step has the semantics of blockblaster_try_drop() without the
+ * animation: a legal drop places, scores and clears the piece in one go,
+ * an illegal one (used slot, piece off the board or overlapping) leaves
+ * the game untouched, like a piece sent back to the tray.  The reward is
+ * the score gained by the move.
+ *
+ * Protocol (all integers little-endian).  The client sends requests; each
+ * request gets exactly one reply of a fixed size, so a client may pipeline
+ * any number of requests before reading the replies.
+ *
+ * | Request     | Bytes | Layout                                          |
+ * |-------------|-------|-------------------------------------------------|
+ * | reset       | 13    | 'R', seed u64, grid u8, tray u8, mode u8, flags |
+ * | observe     | 1     | 'O'                                             |
+ * | step        | 4     | 'S', slot u8, gx u8, gy u8                      |
+ * | close       | 1     | 'Q' (no reply)                                  |
+ *
+ * reset flags: bit 0 = fair trays (node limit only, so seeded games
+ * replay exactly).
+ *
+ * | Reply        | Bytes | Layout                                         |
+ * |--------------|-------|------------------------------------------------|
+ * | reset/observe| 129   | status u8, observation                         |
+ * | step         | 136   | status u8, placed u8, done u8, lines u8,       |
+ * |              |       | reward i32, observation                        |
+ *
+ * The observation (ENV_OBS_SIZE bytes):
+ *
+ * | Offset | Type       | Field                                           |
+ * |--------|------------|-------------------------------------------------|
+ * | 0      | u8         | grid width                                      |
+ * | 1      | u8         | grid height                                     |
+ * | 2      | u8         | tray count                                      |
+ * | 3      | u8         | flags: bit 0 = game over                        |
+ * | 4      | u16        | combo                                           |
+ * | 6      | u16        | combo misses since the last clear               |
+ * | 8      | i64        | score                                           |
+ * | 16     | u32[20]    | grid rows, bit x = cell (x, y); unused rows 0   |
+ * | 96     | 8 per slot | shape id (0xFF = used), shape w, shape h,       |
+ * |        |            | 5 row masks (bit sx = cell (sx, sy))            |
+ *
+ * A request with an unknown opcode gets a single ENV_STATUS_BAD_REQUEST
+ * byte and the server closes the stream, since it can no longer find the
+ * request boundaries.
+ */
+
+#ifndef __BLOCKBLASTER_ENV__
+#define __BLOCKBLASTER_ENV__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "blockblaster_core.h"
+
+/**
+ * \defgroup ENV_PROTOCOL Environment protocol
+ * \brief Opcodes, status codes and frame sizes of the env protocol.
+ * @{
+ */
+
+#define ENV_OP_RESET 'R'   /**< Start a new game. */
+#define ENV_OP_OBSERVE 'O' /**< Read the current observation. */
+#define ENV_OP_STEP 'S'    /**< Drop one tray piece. */
+#define ENV_OP_CLOSE 'Q'   /**< End the session. */
+
+#define ENV_STATUS_OK 0          /**< Request carried out. */
+#define ENV_STATUS_BAD_ARGS 1    /**< Reset parameters out of range (the
+                                      game is unchanged). */
+#define ENV_STATUS_NO_GAME 2     /**< Observe or step before any reset. */
+#define ENV_STATUS_BAD_REQUEST 3 /**< Unknown opcode; the stream closes. */
+
+#define ENV_RESET_FAIR 1 /**< reset flags: deal fair trays. */
+
+/** \brief Observation size in bytes. */
+#define ENV_OBS_SIZE (16 + 4 * GRID_H_MAX + 8 * PIECES_PER_SET_MAX)
+
+/** \brief Longest request (reset) in bytes. */
+#define ENV_REQUEST_MAX 13
+
+/** \brief Longest reply (step) in bytes. */
+#define ENV_REPLY_MAX (8 + ENV_OBS_SIZE)
+
+/** @} */
+
+/**
+ * \brief One environment session: the game and whether it was reset yet.
+ */
+typedef struct {
+    CoreGame core; /* Game state. */
+    bool started;  /* False until the first successful reset. */
+    long steps;    /* Step requests since the last reset. */
+} Env;
+
+/**
+ * \brief Outcome of blockblaster_env_step().
+ */
+typedef struct {
+    bool placed; /* False for an illegal drop (state unchanged). */
+    bool done;   /* Game over after the step. */
+    int lines;   /* Rows + columns cleared. */
+    int reward;  /* Score gained. */
+} EnvStep;
+
+bool blockblaster_env_reset(Env *e, uint64_t seed, int grid, int tray,
+                            int mode, int flags);
+void blockblaster_env_observe(const Env *e, uint8_t *out);
+void blockblaster_env_step(Env *e, int slot, int gx, int gy, EnvStep *out);
+int blockblaster_env_request_size(int op);
+int blockblaster_env_handle(Env *e, const uint8_t *req, uint8_t *reply);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLOCKBLASTER_ENV__ */
@@ -0,0 +1,514 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_env_server.c
+ * \brief Headless environment server for training placement bots.
+ *
+ * Serves the binary protocol of blockblaster_env.h with no display or
+ * audio: by default one session on stdin/stdout (spawn it as a child
+ * process), or with -u one session per connection on a Unix domain socket,
+ * each on its own thread.
+ *
+ * Requests are read in blocks and every complete request in a block is
+ * answered before the replies are written back in one go, so a client that
+ * pipelines requests pays one system call per block rather than per step.
+ *
+ * -b runs a self-test instead: it first checks that an unknown opcode
+ * arriving when the reply buffer is full is still answered, then a client
+ * thread plays random legal moves against a session over a socket pair,
+ * one request at a time, checks that the rewards add up to the reported
+ * score and prints the step rate.
+ *
+ * Usage: BlockBlasterEnv [-u socket_path] [-b steps]
+ */
+
+#include "blockblaster_env.h"
+#include "blockblaster_simd.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#else
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+/* Size of the request and reply buffers of a session. */
+#define ENV_IO_BUF 65536
+
+/* Default number of steps of the -b self-test. */
+#define ENV_BENCH_STEPS 1000000
+
+/* Wall-clock time in seconds. */
+static double env_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/* Write all n bytes of buf, retrying short writes.  Returns false on error
+   (e.g. the client went away). */
+static bool write_all(int fd, const uint8_t *buf, size_t n)
+{
+    while (n > 0) {
+        ssize_t w = write(fd, buf, n);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return false;
+        buf += w;
+        n -= (size_t) w;
+    }
+    return true;
+}
+
+/* Read exactly n bytes into buf.  Returns false on error or end of file. */
+static bool read_all(int fd, uint8_t *buf, size_t n)
+{
+    while (n > 0) {
+        ssize_t r = read(fd, buf, n);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        buf += r;
+        n -= (size_t) r;
+    }
+    return true;
+}
+
+/* ======================================================================== */
+/* Session                                                                   */
+/* ======================================================================== */
+
+/* Buffers and game of one session. */
+typedef struct {
+    Env env;
+    uint8_t in[ENV_IO_BUF];
+    uint8_t out[ENV_IO_BUF];
+} EnvSession;
+
+/* Serve one session until the client closes the stream, sends
+   ENV_OP_CLOSE or sends an unknown opcode.  Returns false if the session
+   could not be allocated. */
+static bool env_serve(int in_fd, int out_fd)
+{
+    EnvSession *s = calloc(1, sizeof(*s));
+    if (!s)
+        return false;
+
+    size_t have = 0;
+    bool open = true;
+    while (open) {
+        ssize_t n = read(in_fd, s->in + have, sizeof(s->in) - have);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        have += (size_t) n;
+
+        size_t pos = 0, olen = 0;
+        while (pos < have) {
+            /* Room for the longest reply, which also covers the single
+               status byte of a bad request. */
+            if (olen + ENV_REPLY_MAX > sizeof(s->out)) {
+                if (!write_all(out_fd, s->out, olen))
+                    goto done;
+                olen = 0;
+            }
+            int size = blockblaster_env_request_size(s->in[pos]);
+            if (size == 0) {
+                s->out[olen++] = ENV_STATUS_BAD_REQUEST;
+                open = false;
+                break;
+            }
+            if (have - pos < (size_t) size)
+                break;
+            if (s->in[pos] == ENV_OP_CLOSE) {
+                open = false;
+                break;
+            }
+            olen += (size_t) blockblaster_env_handle(&s->env, s->in + pos,
+                                                     s->out + olen);
+            pos += (size_t) size;
+        }
+        if (olen > 0 && !write_all(out_fd, s->out, olen))
+            break;
+        /* Keep a partial request for the next read. */
+        memmove(s->in, s->in + pos, have - pos);
+        have -= pos;
+    }
+done:
+    free(s);
+    return true;
+}
+
+#ifndef _WIN32
+
+/* Thread serving one socket connection. */
+static void *env_connection(void *arg)
+{
+    int fd = (int) (intptr_t) arg;
+    if (!env_serve(fd, fd))
+        fprintf(stderr, "out of memory for a session\n");
+    close(fd);
+    return NULL;
+}
+
+/* Accept connections on a Unix domain socket at `path` forever. */
+static int env_listen(const char *path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "socket path too long: %s\n", path);
+        return 1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lfd < 0) {
+        perror("socket");
+        return 1;
+    }
+    unlink(path);
+    if (bind(lfd, (struct sockaddr *) &addr, sizeof(addr)) < 0 ||
+        listen(lfd, 64) < 0) {
+        perror(path);
+        close(lfd);
+        return 1;
+    }
+    fprintf(stderr, "BlockBlasterEnv listening on %s\n", path);
+
+    for (;;) {
+        int fd = accept(lfd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("accept");
+            break;
+        }
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, env_connection,
+                           (void *) (intptr_t) fd) != 0) {
+            fprintf(stderr, "could not start a session thread\n");
+            close(fd);
+            continue;
+        }
+        pthread_detach(tid);
+    }
+    close(lfd);
+    unlink(path);
+    return 1;
+}
+
+/* ======================================================================== */
+/* Self-test                                                                 */
+/* ======================================================================== */
+
+/* Client side of the self-test. */
+typedef struct {
+    int fd;
+    long steps;    /* Steps to play. */
+    long games;    /* Games finished. */
+    long illegal;  /* Steps the server refused (must stay 0). */
+    long mismatch; /* Observations whose score differs from the rewards. */
+} EnvBench;
+
+/* True when the shape of observation slot `slot` fits at (gx, gy). */
+static bool obs_fits(const uint8_t *obs, int slot, int gx, int gy)
+{
+    int w = obs[0], h = obs[1];
+    const uint8_t *sl = obs + 16 + 4 * GRID_H_MAX + 8 * slot;
+    for (int sy = 0; sy < SHAPE_MAX; sy++) {
+        uint32_t r = (uint32_t) sl[3 + sy] << gx;
+        if (r == 0)
+            continue;
+        if (gy + sy >= h || (r >> w) != 0)
+            return false;
+        const uint8_t *row = obs + 16 + 4 * (gy + sy);
+        uint32_t g = (uint32_t) row[0] | (uint32_t) row[1] << 8 |
+                     (uint32_t) row[2] << 16 | (uint32_t) row[3] << 24;
+        if (r & g)
+            return false;
+    }
+    return true;
+}
+
+/* Pick a legal move from an observation, scanning from a random slot and
+   anchor.  Returns false if no piece fits. */
+static bool obs_pick(const uint8_t *obs, Rng *r, uint8_t *req)
+{
+    int w = obs[0], h = obs[1], tray = obs[2];
+    int s0 = blockblaster_irand(r, 0, tray - 1);
+    int a0 = blockblaster_irand(r, 0, w * h - 1);
+    for (int k = 0; k < tray; k++) {
+        int slot = (s0 + k) % tray;
+        if (obs[16 + 4 * GRID_H_MAX + 8 * slot] == 0xFF)
+            continue;
+        for (int j = 0; j < w * h; j++) {
+            int a = (a0 + j) % (w * h);
+            if (obs_fits(obs, slot, a % w, a / w)) {
+                req[0] = ENV_OP_STEP;
+                req[1] = (uint8_t) slot;
+                req[2] = (uint8_t) (a % w);
+                req[3] = (uint8_t) (a / w);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* Signed 64-bit little-endian field of an observation. */
+static int64_t obs_score(const uint8_t *obs)
+{
+    uint64_t v = 0;
+    for (int i = 15; i >= 8; i--)
+        v = v << 8 | obs[i];
+    return (int64_t) v;
+}
+
+static void *env_bench_client(void *arg)
+{
+    EnvBench *b = arg;
+    uint8_t req[ENV_REQUEST_MAX], reply[ENV_REPLY_MAX];
+    Rng r;
+    blockblaster_rng_seed(&r, 1, 3);
+
+    uint64_t seed = 1;
+    int64_t score = 0;
+    bool need_reset = true;
+    const uint8_t *obs = reply + 1;
+    for (long i = 0; i < b->steps;) {
+        if (need_reset) {
+            memset(req, 0, sizeof(req));
+            req[0] = ENV_OP_RESET;
+            for (int k = 0; k < 8; k++)
+                req[1 + k] = (uint8_t) (seed >> (8 * k));
+            req[9] = (uint8_t) (10 + 5 * (seed % 3));
+            req[10] = PIECES_PER_SET_MAX;
+            seed++;
+            if (!write_all(b->fd, req, 13) ||
+                !read_all(b->fd, reply, 1 + ENV_OBS_SIZE))
+                break;
+            obs = reply + 1;
+            score = 0;
+            need_reset = false;
+        }
+        if (!obs_pick(obs, &r, req)) {
+            need_reset = true;
+            b->games++;
+            continue;
+        }
+        if (!write_all(b->fd, req, 4) ||
+            !read_all(b->fd, reply, 8 + ENV_OBS_SIZE))
+            break;
+        i++;
+        obs = reply + 8;
+        if (reply[1] == 0)
+            b->illegal++;
+        score += (int32_t) ((uint32_t) reply[4] | (uint32_t) reply[5] << 8 |
+                            (uint32_t) reply[6] << 16 |
+                            (uint32_t) reply[7] << 24);
+        if (score != obs_score(obs))
+            b->mismatch++;
+        if (reply[2]) {
+            need_reset = true;
+            b->games++;
+        }
+    }
+    req[0] = ENV_OP_CLOSE;
+    write_all(b->fd, req, 1);
+    shutdown(b->fd, SHUT_WR);
+    return NULL;
+}
+
+/* Server side of the bad request check: serve one session, then signal
+   the end of the replies. */
+static void *env_check_server(void *arg)
+{
+    int fd = *(int *) arg;
+    if (!env_serve(fd, fd))
+        fprintf(stderr, "out of memory for a session\n");
+    shutdown(fd, SHUT_WR);
+    return NULL;
+}
+
+/* Send observe and step requests whose replies fill the reply buffer
+   exactly, then an unknown opcode in the same block, and check that the
+   server answers every request and ends with a single BAD_REQUEST byte:
+   the status byte must fit after a reply block that fills ENV_IO_BUF
+   exactly. */
+static int env_check_bad_request(void)
+{
+    const size_t obs = 1 + ENV_OBS_SIZE, step = ENV_REPLY_MAX;
+    size_t n_obs = 0;
+    while (n_obs * obs <= ENV_IO_BUF && (ENV_IO_BUF - n_obs * obs) % step)
+        n_obs++;
+    if (n_obs * obs > ENV_IO_BUF) {
+        printf("bad request check: replies cannot fill the buffer, "
+               "skipped\n");
+        return 0;
+    }
+    size_t n_step = (ENV_IO_BUF - n_obs * obs) / step;
+
+    size_t len = n_obs + 4 * n_step + 1;
+    uint8_t *req = calloc(len, 1);
+    uint8_t *reply = malloc(ENV_IO_BUF + 2);
+    int sv[2];
+    if (!req || !reply || socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+        fprintf(stderr, "bad request check: setup failed\n");
+        free(req);
+        free(reply);
+        return 1;
+    }
+    memset(req, ENV_OP_OBSERVE, n_obs);
+    for (size_t i = 0; i < n_step; i++)
+        req[n_obs + 4 * i] = ENV_OP_STEP;
+    req[len - 1] = 'X';
+
+    /* Queue the whole stream before the server starts, so its first read
+       takes it as one block. */
+    bool ok = write_all(sv[1], req, len);
+    shutdown(sv[1], SHUT_WR);
+    pthread_t tid;
+    if (ok && pthread_create(&tid, NULL, env_check_server, &sv[0]) != 0)
+        ok = false;
+    size_t got = 0;
+    if (ok) {
+        for (;;) {
+            ssize_t r = read(sv[1], reply + got, ENV_IO_BUF + 2 - got);
+            if (r < 0 && errno == EINTR)
+                continue;
+            if (r <= 0)
+                break;
+            got += (size_t) r;
+            if (got == ENV_IO_BUF + 2)
+                break;
+        }
+        pthread_join(tid, NULL);
+    }
+    close(sv[0]);
+    close(sv[1]);
+
+    ok = ok && got == ENV_IO_BUF + 1 &&
+         reply[ENV_IO_BUF] == ENV_STATUS_BAD_REQUEST;
+    printf("bad request after %zu observe + %zu step replies: %s\n", n_obs,
+           n_step, ok ? "ok" : "FAILED");
+    free(req);
+    free(reply);
+    return ok ? 0 : 1;
+}
+
+/* Play `steps` random legal steps through a socket pair, one request at a
+   time, and report the rate. */
+static int env_bench(long steps)
+{
+    if (env_check_bad_request() != 0)
+        return 1;
+
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+        perror("socketpair");
+        return 1;
+    }
+    EnvBench b = {.fd = sv[1], .steps = steps};
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, env_bench_client, &b) != 0) {
+        fprintf(stderr, "could not start the client thread\n");
+        return 1;
+    }
+    double t0 = env_now();
+    bool ok = env_serve(sv[0], sv[0]);
+    pthread_join(tid, NULL);
+    double dt = env_now() - t0;
+    close(sv[0]);
+    close(sv[1]);
+
+    printf("%ld steps, %ld games in %.2f s: %.0f steps/s (one request in "
+           "flight)\n",
+           steps, b.games, dt, (double) steps / dt);
+    if (!ok || b.illegal || b.mismatch) {
+        printf("FAILED: %ld illegal steps, %ld score mismatches\n", b.illegal,
+               b.mismatch);
+        return 1;
+    }
+    return 0;
+}
+
+#endif /* !_WIN32 */
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-u socket_path] [-b steps]\n"
+            "  (no option)  serve one session on stdin/stdout\n"
+            "  -u  serve sessions on a Unix domain socket\n"
+            "  -b  self-test: play random steps over a socket pair "
+            "(default %d)\n",
+            prog, ENV_BENCH_STEPS);
+}
+
+/**
+ * \brief Environment server entry point.
+ *
+ * \param argc  Argument count.
+ * \param argv  Options, see usage().
+ * \return      0 on success, 1 on a bad option or failure.
+ */
+int main(int argc, char *argv[])
+{
+    const char *socket_path = NULL;
+    long bench_steps = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "u:b:h")) != -1) {
+        switch (opt) {
+        case 'u':
+            socket_path = optarg;
+            break;
+        case 'b':
+            bench_steps = atol(optarg);
+            if (bench_steps <= 0)
+                bench_steps = ENV_BENCH_STEPS;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    /* Both are built lazily on first use; build them before any session
+       thread starts so no thread races on the shared tables. */
+    blockblaster_scan_init();
+    blockblaster_shape_sampler_init();
+
+#ifndef _WIN32
+    /* A client that goes away must end its session, not the server. */
+    signal(SIGPIPE, SIG_IGN);
+    if (bench_steps > 0)
+        return env_bench(bench_steps);
+    if (socket_path)
+        return env_listen(socket_path);
+#else
+    if (bench_steps > 0 || socket_path) {
+        fprintf(stderr, "-u and -b need Unix domain sockets\n");
+        return 1;
+    }
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    return env_serve(0, 1) ? 0 : 1;
+}
@@ -0,0 +1,370 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_features.c
+ * \brief Board evaluation features computed on the grid bitboards.
+ *
+ * Every metric is built from row-wide operations: a row shifted by one is
+ * its left or right neighbours, the rows above and below are its vertical
+ * neighbours, and a popcount turns the resulting mask into a count.  The
+ * connected regions use a flood fill that spreads a whole row at a time
+ * (along runs of empty cells with a carry and a Kogge-Stone fill, then one
+ * row up or down), and the largest square erodes the empty mask by one
+ * cell per step.
+ */
+
+#include "blockblaster_features.h"
+
+#include <string.h>
+
+/* ======================================================================== */
+/* Row kernels                                                               */
+/* ======================================================================== */
+
+/* Holes of row y: empty cells whose four neighbours are occupied or outside
+   the grid. */
+static int row_holes(const uint32_t *rows, int w, int h, int y)
+{
+    const uint32_t full = GRID_BITS(w);
+    uint32_t r = rows[y];
+    uint32_t up = (y > 0) ? rows[y - 1] : full;
+    uint32_t down = (y + 1 < h) ? rows[y + 1] : full;
+    uint32_t left = (r << 1) | 1u;
+    uint32_t right = (r >> 1) | (1u << (w - 1));
+    return GRID_POPCOUNT(~r & full & left & right & up & down);
+}
+
+/* Edges of row y: occupied/empty changes between horizontal neighbours of
+   the row, plus those between row y and row y + 1. */
+static int row_transitions(const uint32_t *rows, int w, int h, int y)
+{
+    uint32_t r = rows[y];
+    int t = GRID_POPCOUNT((r ^ (r >> 1)) & GRID_BITS(w - 1));
+    if (y + 1 < h)
+        t += GRID_POPCOUNT(r ^ rows[y + 1]);
+    return t;
+}
+
+/* Spread the seed bits x along the runs of set bits of e that hold them.
+   Towards the high bits, adding the seeds to e carries through the rest of
+   each run from its lowest seed and clears it; towards the low bits, a
+   Kogge-Stone fill in five steps. */
+static uint32_t fill_runs(uint32_t x, uint32_t e)
+{
+    x &= e;
+    uint32_t up = x | (e & ~(e + x));
+    uint32_t down = x, pass = e;
+    for (int s = 1; s < 32; s <<= 1) {
+        down |= pass & (down >> s);
+        pass &= pass >> s;
+    }
+    return up | down;
+}
+
+/* Grow the region of e (rows y0 .. h - 1) holding the lowest cell of row
+   y0 into reg.  Each generation spreads the rows that changed into the rows
+   above and below them along the runs of e, until none changes. */
+static void grow_region(uint32_t *reg, const uint32_t *e, int y0, int h)
+{
+    for (int y = y0 + 1; y < h; y++)
+        reg[y] = 0;
+    reg[y0] = fill_runs(e[y0] & (0u - e[y0]), e[y0]);
+    for (uint32_t dirty = 1u << y0; dirty;) {
+        uint32_t next = 0;
+        for (; dirty; dirty &= dirty - 1) {
+            int y = __builtin_ctz(dirty);
+            for (int n = y - 1; n <= y + 1; n += 2) {
+                if (n < y0 || n >= h)
+                    continue;
+                uint32_t seed = reg[y] & e[n] & ~reg[n];
+                if (seed) {
+                    reg[n] = fill_runs(reg[n] | seed, e[n]);
+                    next |= 1u << n;
+                }
+            }
+        }
+        dirty = next;
+    }
+}
+
+/* ======================================================================== */
+/* Single metrics                                                            */
+/* ======================================================================== */
+
+/**
+ * \brief Count the empty cells of a board.
+ *
+ * \param rows  Row bitboards (bit x of rows[y] set when (x, y) is occupied).
+ * \param w     Columns in use.
+ * \param h     Rows in use.
+ * \return      Number of empty cells.
+ */
+int blockblaster_board_empty(const uint32_t *rows, int w, int h)
+{
+    int filled = 0;
+    for (int y = 0; y < h; y++)
+        filled += GRID_POPCOUNT(rows[y]);
+    return w * h - filled;
+}
+
+/**
+ * \brief Count the holes of a board: empty cells boxed in on all four
+ *        sides, the grid border counting as occupied.
+ *
+ * \param rows  Row bitboards.
+ * \param w     Columns in use.
+ * \param h     Rows in use.
+ * \return      Number of holes.
+ */
+int blockblaster_board_holes(const uint32_t *rows, int w, int h)
+{
+    int holes = 0;
+    for (int y = 0; y < h; y++)
+        holes += row_holes(rows, w, h, y);
+    return holes;
+}
+
+/**
+ * \brief Count the occupied/empty edges between neighbouring cells of a
+ *        board (a measure of how ragged it is).
+ *
+ * \param rows  Row bitboards.
+ * \param w     Columns in use.
+ * \param h     Rows in use.
+ * \return      Horizontal plus vertical transitions.
+ */
+int blockblaster_board_transitions(const uint32_t *rows, int w, int h)
+{
+    int t = 0;
+    for (int y = 0; y < h; y++)
+        t += row_transitions(rows, w, h, y);
+    return t;
+}
+
+/**
+ * \brief Count the 4-connected regions of empty cells of a board.
+ *
+ * Each region is grown from one seed cell a row at a time: a row that
+ * changed fills the rows above and below it along their runs of empty
+ * cells, so a region takes about as many steps as it spans rows (more for
+ * winding ones), not one step per cell.
+ *
+ * \param rows  Row bitboards.
+ * \param w     Columns in use.
+ * \param h     Rows in use.
+ * \return      Number of regions (0 on a full board).
+ */
+int blockblaster_board_regions(const uint32_t *rows, int w, int h)
+{
+    uint32_t left[GRID_H_MAX]; /* Empty cells not in a counted region. */
+    uint32_t reg[GRID_H_MAX];  /* Region being grown. */
+    for (int y = 0; y < h; y++)
+        left[y] = ~rows[y] & GRID_BITS(w);
+
+    int regions = 0;
+    for (int y0 = 0; y0 < h; y0++) {
+        while (left[y0]) {
+            grow_region(reg, left, y0, h);
+            for (int y = y0; y < h; y++)
+                left[y] &= ~reg[y];
+            regions++;
+        }
+    }
+    return regions;
+}
+
+/**
+ * \brief Find the lines of a board that are near completion.
+ *
+ * Works on rows (lines = rows, len = w) as well as on columns (lines =
+ * cols, len = h).
+ *
+ * \param lines  Line bitboards.
+ * \param n      Number of lines.
+ * \param len    Cells per line.
+ * \return       Bit i set when line i has 1 .. FEATURES_NEAR_GAP empty
+ *               cells.
+ */
+uint32_t blockblaster_board_near_lines(const uint32_t *lines, int n, int len)
+{
+    uint32_t near = 0;
+    for (int i = 0; i < n; i++) {
+        unsigned gap = (unsigned) (len - GRID_POPCOUNT(lines[i]));
+        near |= (uint32_t) (gap - 1u < FEATURES_NEAR_GAP) << i;
+    }
+    return near;
+}
+
+/**
+ * \brief Find the largest empty square of a board.
+ *
+ * Starts from the empty cells (the top-left corners of empty 1x1 squares)
+ * and erodes them: a (k + 1)x(k + 1) square fits at (x, y) when k x k
+ * squares fit at (x, y), (x + 1, y), (x, y + 1) and (x + 1, y + 1), which
+ * is two shifts and three ANDs per row.  Stops as soon as no square of the
+ * next size fits, or at cap.
+ *
+ * \param rows   Row bitboards.
+ * \param w      Columns in use.
+ * \param h      Rows in use.
+ * \param cap    Largest side of interest (<= 0 for no limit): callers that
+ *               only ask "does a k x k square fit?" pass k.
+ * \param out_x  If not NULL, receives the left column of one largest
+ *               square (-1 when the board is full).
+ * \param out_y  If not NULL, receives its top row (-1 when full).
+ * \return       Side of the largest empty square, at most cap.
+ */
+int blockblaster_board_square(const uint32_t *rows, int w, int h, int cap,
+                              int *out_x, int *out_y)
+{
+    uint32_t e[GRID_H_MAX]; /* Top-left corners of empty squares of side
+                               `side + 1`, for anchor rows 0 .. n - 1. */
+    uint32_t any = 0;
+    for (int y = 0; y < h; y++) {
+        e[y] = ~rows[y] & GRID_BITS(w);
+        any |= e[y];
+    }
+
+    int side = 0, sx = -1, sy = -1;
+    int n = h;
+    while (any) {
+        side++;
+        for (sy = 0; !e[sy]; sy++)
+            ;
+        sx = __builtin_ctz(e[sy]);
+        if (side == cap)
+            break;
+        n--;
+        any = 0;
+        for (int y = 0; y < n; y++) {
+            e[y] &= (e[y] >> 1) & e[y + 1] & (e[y + 1] >> 1);
+            any |= e[y];
+        }
+    }
+    if (out_x)
+        *out_x = sx;
+    if (out_y)
+        *out_y = sy;
+    return side;
+}
+
+/* ======================================================================== */
+/* All features of a grid                                                    */
+/* ======================================================================== */
+
+/* Recount the per-row state that depends on rows `dirty` (holes look at
+   the rows above and below, transitions at the row below), the near
+   flags of rows `dirty` and columns `dirty_cols`, and adjust the totals. */
+static void features_update(BoardFeatures *f, const Grid *g, uint32_t dirty,
+                            uint32_t dirty_cols)
+{
+    const uint32_t all = GRID_BITS(g->h);
+    dirty &= all;
+    dirty_cols &= GRID_BITS(g->w);
+
+    for (uint32_t b = dirty; b; b &= b - 1) {
+        int y = __builtin_ctz(b);
+        int empty = g->w - g->row_fill[y];
+        f->empty += empty - f->row_empty[y];
+        f->row_empty[y] = (uint8_t) empty;
+        unsigned gap = (unsigned) empty;
+        f->near_row_bits = (f->near_row_bits & ~(1u << y)) |
+                           (uint32_t) (gap - 1u < FEATURES_NEAR_GAP) << y;
+    }
+    for (uint32_t b = (dirty | dirty << 1 | dirty >> 1) & all; b;
+         b &= b - 1) {
+        int y = __builtin_ctz(b);
+        int holes = row_holes(g->rows, g->w, g->h, y);
+        f->holes += holes - f->row_holes[y];
+        f->row_holes[y] = (uint8_t) holes;
+    }
+    for (uint32_t b = (dirty | dirty >> 1) & all; b; b &= b - 1) {
+        int y = __builtin_ctz(b);
+        int trans = row_transitions(g->rows, g->w, g->h, y);
+        f->transitions += trans - f->row_trans[y];
+        f->row_trans[y] = (uint8_t) trans;
+    }
+    for (uint32_t b = dirty_cols; b; b &= b - 1) {
+        int x = __builtin_ctz(b);
+        unsigned gap = (unsigned) (g->h - g->col_fill[x]);
+        f->near_col_bits = (f->near_col_bits & ~(1u << x)) |
+                           (uint32_t) (gap - 1u < FEATURES_NEAR_GAP) << x;
+    }
+    f->near_rows = GRID_POPCOUNT(f->near_row_bits);
+    f->near_cols = GRID_POPCOUNT(f->near_col_bits);
+}
+
+/**
+ * \brief Compute every feature of a grid from scratch.
+ *
+ * \param f  Receives the features and the incremental state (the regions
+ *           are counted separately, see blockblaster_board_regions()).
+ * \param g  Grid to describe.
+ */
+void blockblaster_features_compute(BoardFeatures *f, const Grid *g)
+{
+    memset(f, 0, sizeof(*f));
+    f->w = g->w;
+    f->h = g->h;
+    features_update(f, g, GRID_BITS(g->h), GRID_BITS(g->w));
+    f->square = blockblaster_board_square(g->rows, g->w, g->h, 0,
+                                          &f->square_x, &f->square_y);
+}
+
+/**
+ * \brief Update the features after blockblaster_place_shape().
+ *
+ * Only the rows and columns the shape covers, and the rows next to them,
+ * are recounted.  Filling cells can only shrink squares, so the largest
+ * square is searched again only when the shape landed on the one found
+ * last time.
+ *
+ * \param f   Features of the grid before the placement.
+ * \param g   Grid after the placement.
+ * \param m   Placed shape.
+ * \param gx  Grid column of the shape's top-left corner.
+ * \param gy  Grid row of the shape's top-left corner.
+ */
+void blockblaster_features_after_place(BoardFeatures *f, const Grid *g,
+                                       const ShapeMask *m, int gx, int gy)
+{
+    features_update(f, g,
+                    GRID_BITS(m->max_y - m->min_y + 1) << (gy + m->min_y),
+                    GRID_BITS(m->max_x - m->min_x + 1) << (gx + m->min_x));
+
+    if (f->square == 0)
+        return;
+    uint32_t span = GRID_BITS(f->square) << f->square_x;
+    for (int y = f->square_y; y < f->square_y + f->square; y++) {
+        if (g->rows[y] & span) {
+            f->square = blockblaster_board_square(
+                g->rows, g->w, g->h, 0, &f->square_x, &f->square_y);
+            return;
+        }
+    }
+}
+
+/**
+ * \brief Update the features after blockblaster_clear_lines().
+ *
+ * Cleared rows only affect the rows around them; a cleared column frees a
+ * cell in every row, so in that case all rows are recounted (and all
+ * columns for a cleared row).  Freed cells can grow squares, so the
+ * largest square is searched again.
+ *
+ * \param f          Features of the grid before the clear.
+ * \param g          Grid after the clear.
+ * \param full_rows  Bit y set for each removed row.
+ * \param full_cols  Bit x set for each removed column.
+ */
+void blockblaster_features_after_clear(BoardFeatures *f, const Grid *g,
+                                       uint32_t full_rows,
+                                       uint32_t full_cols)
+{
+    if (!full_rows && !full_cols)
+        return;
+    features_update(f, g, full_cols ? GRID_BITS(g->h) : full_rows,
+                    full_rows ? GRID_BITS(g->w) : full_cols);
+    f->square = blockblaster_board_square(g->rows, g->w, g->h, 0,
+                                          &f->square_x, &f->square_y);
+}
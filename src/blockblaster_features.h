@@ -0,0 +1,86 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_features.h
+ * \brief Board evaluation features computed on the grid bitboards.
+ *
+ * Bots, hints and the solver rank boards by a handful of shape-independent
+ * metrics: empty cells, holes, occupied/empty edges, connected empty
+ * regions, lines close to completion and the largest empty square.  Each
+ * metric works on whole row bitboards (one 32-bit word per row) with
+ * shifts, masks and popcounts, so a row of up to 32 cells costs a few
+ * instructions instead of a loop over its cells.
+ *
+ * The functions taking a row array accept any bitboard copy of a grid
+ * (Grid.rows, or a search's own board).  BoardFeatures bundles the
+ * metrics of one Grid that can be kept up to date incrementally: after a
+ * placement or a clear only the rows and columns that changed (and their
+ * neighbours) are recounted.  The regions are not part of it: a placement
+ * can cut a region where the cut only shows far from the shape, and a
+ * cleared line can merge regions anywhere along it, so callers count them
+ * on demand with blockblaster_board_regions().
+ */
+
+#ifndef __BLOCKBLASTER_FEATURES__
+#define __BLOCKBLASTER_FEATURES__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "blockblaster_core.h"
+
+/** \brief A line is near completion when 1 .. FEATURES_NEAR_GAP of its
+ * cells are empty. */
+#define FEATURES_NEAR_GAP 2
+
+/**
+ * \brief Incrementally maintained evaluation features of one grid.
+ *
+ * Fill with blockblaster_features_compute(), then either recompute or
+ * follow the grid with blockblaster_features_after_place() and
+ * blockblaster_features_after_clear().  The per-row counts are the
+ * incremental state; the totals are what callers read.
+ */
+typedef struct {
+    int w;           /* Grid size the features describe. */
+    int h;
+    int empty;       /* Empty cells. */
+    int holes;       /* Empty cells boxed in on all four sides (the grid
+                        border counts as occupied). */
+    int transitions; /* Occupied/empty edges between neighbouring cells. */
+    int near_rows;   /* Rows with 1 .. FEATURES_NEAR_GAP empty cells. */
+    int near_cols;   /* Columns with 1 .. FEATURES_NEAR_GAP empty cells. */
+    int square;      /* Side of the largest empty square (0 when full). */
+    int square_x;    /* Top-left cell of one such square (-1 when full). */
+    int square_y;
+    uint8_t row_empty[GRID_H_MAX]; /* Empty cells of row y. */
+    uint8_t row_holes[GRID_H_MAX]; /* Holes in row y. */
+    uint8_t row_trans[GRID_H_MAX]; /* Edges inside row y and between rows
+                                      y and y + 1. */
+    uint32_t near_row_bits;        /* Bit y set for each near row. */
+    uint32_t near_col_bits;        /* Bit x set for each near column. */
+} BoardFeatures;
+
+/* ---- Single metrics ---- */
+int blockblaster_board_empty(const uint32_t *rows, int w, int h);
+int blockblaster_board_holes(const uint32_t *rows, int w, int h);
+int blockblaster_board_transitions(const uint32_t *rows, int w, int h);
+int blockblaster_board_regions(const uint32_t *rows, int w, int h);
+uint32_t blockblaster_board_near_lines(const uint32_t *lines, int n, int len);
+int blockblaster_board_square(const uint32_t *rows, int w, int h, int cap,
+                              int *out_x, int *out_y);
+
+/* ---- All features of a grid ---- */
+void blockblaster_features_compute(BoardFeatures *f, const Grid *g);
+void blockblaster_features_after_place(BoardFeatures *f, const Grid *g,
+                                       const ShapeMask *m, int gx, int gy);
+void blockblaster_features_after_clear(BoardFeatures *f, const Grid *g,
+                                       uint32_t full_rows,
+                                       uint32_t full_cols);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLOCKBLASTER_FEATURES__ */
@@ -3,6 +3,9 @@
 /**
  * \file blockblaster_game.c
  * \brief Game logic, utilities, save/load, particles, and platform helpers.
+ *
+ * The rules themselves (grid, bag, tray, scoring) live in the headless
+ * blockblaster_core.c; this file adds animation, sound and input on top.
  */
 
 #include "blockblaster_game.h"
@@ -22,56 +25,10 @@
 #include <allegro5/allegro_android.h>
 #endif
 
-/* Runtime grid dimensions and tray count (declared extern in context.h). */
-int GRID_W = 10;
-int GRID_H = 10;
-int PIECES_PER_SET = 4;
-
-/* Display scale factor used by line-width macros to guarantee a minimum
-   physical pixel width.  Updated every time the view offset is recalculated. */
-float g_display_scale = 1.0f;
-
 /* ======================================================================== */
 /* Utility                                                                   */
 /* ======================================================================== */
 
-/**
- * \brief Return a random integer in the inclusive range [a, b].
- *
- * If b <= a the function returns a directly.
- *
- * \param a  Lower bound (inclusive).
- * \param b  Upper bound (inclusive).
- * \return   Pseudo-random integer in [a, b].
- */
-int blockblaster_irand(int a, int b)
-{
-    if (b <= a)
-        return a;
-    return a + (rand() % (b - a + 1));
-}
-
-/**
- * \brief Return a random float in [0.0, 1.0].
- * \return  Pseudo-random float uniformly distributed in [0, 1].
- */
-float blockblaster_frand01(void)
-{
-    return (float) rand() / (float) RAND_MAX;
-}
-
-/**
- * \brief Return a random float in [a, b].
- *
- * \param a  Lower bound.
- * \param b  Upper bound.
- * \return   Pseudo-random float in [a, b].
- */
-float blockblaster_frand(float a, float b)
-{
-    return a + (b - a) * blockblaster_frand01();
-}
-
 /**
  * \brief Clamp a float to the range [lo, hi].
  *
@@ -111,22 +68,6 @@ float blockblaster_lerpf(float a, float b, float t)
     return a + (b - a) * t;
 }
 
-/**
- * \brief Fisher-Yates shuffle of an integer array in-place.
- *
- * \param a  Array of integers to shuffle.
- * \param n  Number of elements in the array.
- */
-void blockblaster_shuffle_ints(int *a, int n)
-{
-    for (int i = n - 1; i > 0; i--) {
-        int j = blockblaster_irand(0, i);
-        int tmp = a[i];
-        a[i] = a[j];
-        a[j] = tmp;
-    }
-}
-
 /* ======================================================================== */
 /* Platform                                                                  */
 /* ======================================================================== */
@@ -341,8 +282,8 @@ void blockblaster_android_hide_keyboard(void)
  */
 float blockblaster_font_effective_scale(const GameContext *gm)
 {
-    float sx = (float) WIN_W / (float) WIN_W_DEFAULT;
-    float sy = (float) WIN_H / (float) WIN_H_DEFAULT;
+    float sx = (float) gm->win_w / (float) WIN_W_DEFAULT;
+    float sy = (float) gm->win_h / (float) WIN_H_DEFAULT;
     float s = (sx < sy ? sx : sy);
 #ifdef ALLEGRO_ANDROID
     float density_scale =
@@ -404,385 +345,29 @@ void blockblaster_init_themes(Theme out[THEMES_COUNT])
     out[7] = (Theme) {al_map_rgb(240, 240, 140), al_map_rgb(26, 26, 18)};
 }
 
-/**
- * \brief Pick a random theme from the game's theme table.
- *
- * \param gm  Game context containing the initialised theme_table.
- * \return    A copy of a randomly selected Theme.
- */
-Theme blockblaster_random_theme(GameContext *gm)
-{
-    int idx = blockblaster_irand(0, THEMES_COUNT - 1);
-    return gm->theme_table[idx];
-}
-
-/* ======================================================================== */
-/* Grid                                                                      */
-/* ======================================================================== */
-
-/**
- * \brief Reset every cell in the grid to unoccupied with no theme.
- *
- * \param g  Grid to clear.
- */
-void blockblaster_grid_clear(Grid *g)
-{
-    for (int y = 0; y < GRID_H; y++)
-        for (int x = 0; x < GRID_W; x++) {
-            g->occ[y][x] = false;
-            g->has_theme[y][x] = false;
-            g->cell_theme[y][x] = (Theme) {0};
-        }
-}
-
-/**
- * \brief Test whether a shape occupies the cell at (x, y).
- *
- * Out-of-bounds coordinates return false.
- *
- * \param s  Shape to query.
- * \param x  Column within the shape.
- * \param y  Row within the shape.
- * \return   true if the cell is filled.
- */
-bool blockblaster_shape_cell(const Shape *s, int x, int y)
-{
-    if (x < 0 || y < 0 || x >= s->w || y >= s->h)
-        return false;
-    return s->cells[y][x];
-}
-
-/**
- * \brief Test whether shape s can be placed at grid position (gx, gy).
- *
- * Returns false if any filled cell of the shape would land outside the
- * grid or on an already-occupied cell.
- *
- * \param g   Current grid state.
- * \param s   Shape to test.
- * \param gx  Target column for the shape's top-left corner.
- * \param gy  Target row for the shape's top-left corner.
- * \return    true if placement is valid.
- */
-bool blockblaster_can_place_at(const Grid *g, const Shape *s, int gx, int gy)
-{
-    for (int sy = 0; sy < s->h; sy++) {
-        for (int sx = 0; sx < s->w; sx++) {
-            if (!blockblaster_shape_cell(s, sx, sy))
-                continue;
-            int x = gx + sx;
-            int y = gy + sy;
-            if (x < 0 || y < 0 || x >= GRID_W || y >= GRID_H)
-                return false;
-            if (g->occ[y][x])
-                return false;
-        }
-    }
-    return true;
-}
-
-/**
- * \brief Scan the entire grid for at least one valid placement of shape s.
- *
- * \param g  Current grid state.
- * \param s  Shape to test.
- * \return   true if at least one position allows the shape to be placed.
- */
-bool blockblaster_any_valid_placement(const Grid *g, const Shape *s)
-{
-    for (int gy = 0; gy < GRID_H; gy++)
-        for (int gx = 0; gx < GRID_W; gx++)
-            if (blockblaster_can_place_at(g, s, gx, gy))
-                return true;
-    return false;
-}
-
-/**
- * \brief Stamp shape s onto the grid at (gx, gy) with the given theme.
- *
- * Each filled cell of the shape sets the corresponding grid cell to
- * occupied and assigns the colour theme.  Caller must ensure the placement
- * is valid (see blockblaster_can_place_at()).
- *
- * \param g      Grid to modify.
- * \param s      Shape to place.
- * \param gx     Column for the shape's top-left corner.
- * \param gy     Row for the shape's top-left corner.
- * \param theme  Colour theme applied to the newly occupied cells.
- */
-void blockblaster_place_shape(Grid *g, const Shape *s, int gx, int gy,
-                              Theme theme)
-{
-    for (int sy = 0; sy < s->h; sy++) {
-        for (int sx = 0; sx < s->w; sx++) {
-            if (!blockblaster_shape_cell(s, sx, sy))
-                continue;
-            int x = gx + sx;
-            int y = gy + sy;
-            if (x >= 0 && y >= 0 && x < GRID_W && y < GRID_H) {
-                g->occ[y][x] = true;
-                g->cell_theme[y][x] = theme;
-                g->has_theme[y][x] = true;
-            }
-        }
-    }
-}
-
-/* Return true if every cell in row y is occupied. */
-static bool is_row_full(bool grid[GRID_H_MAX][GRID_W_MAX], int y)
-{
-    for (int x = 0; x < GRID_W; x++)
-        if (!grid[y][x])
-            return false;
-    return true;
-}
-
-/* Return true if every cell in column x is occupied. */
-static bool is_col_full(bool grid[GRID_H_MAX][GRID_W_MAX], int x)
-{
-    for (int y = 0; y < GRID_H; y++)
-        if (!grid[y][x])
-            return false;
-    return true;
-}
-
-/**
- * \brief Build a boolean mask of cells that belong to fully completed rows
- *        or columns.
- *
- * \param g         Current grid state.
- * \param out_mask  Output mask; true for every cell in a full row or column.
- * \return          Total number of full lines (rows + columns).
- */
-int blockblaster_build_clear_mask(const Grid *g,
-                                  bool out_mask[GRID_H_MAX][GRID_W_MAX])
-{
-    bool full_row[GRID_H_MAX] = {0};
-    bool full_col[GRID_W_MAX] = {0};
-
-    for (int y = 0; y < GRID_H; y++)
-        full_row[y] = is_row_full((bool (*)[GRID_W_MAX]) g->occ, y);
-    for (int x = 0; x < GRID_W; x++)
-        full_col[x] = is_col_full((bool (*)[GRID_W_MAX]) g->occ, x);
-
-    int lines = 0;
-    for (int y = 0; y < GRID_H; y++)
-        if (full_row[y])
-            lines++;
-    for (int x = 0; x < GRID_W; x++)
-        if (full_col[x])
-            lines++;
-
-    for (int y = 0; y < GRID_H; y++)
-        for (int x = 0; x < GRID_W; x++)
-            out_mask[y][x] = (full_row[y] || full_col[x]);
-    return lines;
-}
-
-/**
- * \brief Count how many occupied cells are flagged by the clear mask.
- *
- * \param g     Current grid state.
- * \param mask  Boolean clear mask (from blockblaster_build_clear_mask()).
- * \return      Number of occupied cells under the mask.
- */
-int blockblaster_count_cells_in_mask(const Grid *g,
-                                     bool mask[GRID_H_MAX][GRID_W_MAX])
-{
-    int c = 0;
-    for (int y = 0; y < GRID_H; y++)
-        for (int x = 0; x < GRID_W; x++)
-            if (mask[y][x] && g->occ[y][x])
-                c++;
-    return c;
-}
-
-/**
- * \brief Remove all cells marked by the clear mask from the grid.
- *
- * Sets occ and has_theme to false for each flagged cell.
- *
- * \param g     Grid to modify.
- * \param mask  Boolean clear mask.
- */
-void blockblaster_apply_clear_mask(Grid *g, bool mask[GRID_H_MAX][GRID_W_MAX])
-{
-    for (int y = 0; y < GRID_H; y++)
-        for (int x = 0; x < GRID_W; x++)
-            if (mask[y][x]) {
-                g->occ[y][x] = false;
-                g->has_theme[y][x] = false;
-            }
-}
-
-/* ======================================================================== */
-/* Bag randomizer                                                            */
-/* ======================================================================== */
-
-/**
- * \brief Pick a shape index weighted by the current difficulty curve.
- *
- * Uses a linear interpolation between easy-biased and hard-biased weight
- * distributions based on the current score.  At score 0 easy shapes (low
- * index) are strongly favoured; at DIFFICULTY_MAX_SCORE hard shapes (high
- * index) are favoured.  Every shape always retains at least
- * MIN_DIFFICULTY_WEIGHT probability.
- *
- * \param score  Current player score used to compute difficulty.
- * \return       Index into the SHAPES[] array.
- */
-static int weighted_shape_index(int score)
-{
-    float t = (float) score / (float) DIFFICULTY_MAX_SCORE;
-    if (t < 0.0f)
-        t = 0.0f;
-    if (t > 1.0f)
-        t = 1.0f;
-
-    float weights[128];
-    float total = 0.0f;
-    for (int i = 0; i < SHAPES_COUNT; i++) {
-        float d =
-            (SHAPES_COUNT > 1) ? (float) i / (float) (SHAPES_COUNT - 1) : 0.5f;
-        float w = MIN_DIFFICULTY_WEIGHT + (1.0f - MIN_DIFFICULTY_WEIGHT) *
-                                              ((1.0f - d) * (1.0f - t) + d * t);
-        weights[i] = w;
-        total += w;
-    }
-
-    float r = blockblaster_frand(0.0f, total);
-    float acc = 0.0f;
-    for (int i = 0; i < SHAPES_COUNT; i++) {
-        acc += weights[i];
-        if (r < acc)
-            return i;
-    }
-    return SHAPES_COUNT - 1;
-}
-
-/* Fill the bag with BAG_SIZE shape indices using the weighted picker, then
-   shuffle so consecutive draws from the same bag are randomised. */
-static void bag_refill(GameContext *gm)
-{
-    gm->bag_len = BAG_SIZE;
-    for (int i = 0; i < gm->bag_len; i++)
-        gm->bag[i] = weighted_shape_index(gm->score);
-    blockblaster_shuffle_ints(gm->bag, gm->bag_len);
-    gm->bag_pos = 0;
-}
-
-/* Draw the next shape index from the bag, refilling when exhausted. */
-static int bag_next_shape_index(GameContext *gm)
-{
-    if (gm->bag_len <= 0 || gm->bag_pos >= gm->bag_len)
-        bag_refill(gm);
-    return gm->bag[gm->bag_pos++];
-}
-
 /* ======================================================================== */
 /* Piece / tray                                                              */
 /* ======================================================================== */
 
-/**
- * \brief Assign new shapes (and themes) to all tray slots.
- *
- * In theme_mode 1 all pieces share a single random theme; otherwise each
- * piece gets its own.  Shapes are drawn from the bag randomizer.
- *
- * \param gm  Game context.
- */
-void blockblaster_refill_tray(GameContext *gm)
-{
-    if (gm->theme_mode == 1)
-        gm->set_theme = blockblaster_random_theme(gm);
-
-    for (int i = 0; i < PIECES_PER_SET; i++) {
-        gm->tray[i].used = false;
-        int si = bag_next_shape_index(gm);
-        gm->tray[i].shape = SHAPES[si];
-        if (gm->theme_mode == 1)
-            gm->tray[i].theme = gm->set_theme;
-        else
-            gm->tray[i].theme = blockblaster_random_theme(gm);
-    }
-}
-
-/**
- * \brief Check whether every tray slot has been placed on the grid.
- *
- * \param gm  Game context.
- * \return    true if all pieces are used.
- */
-bool blockblaster_tray_all_used(const GameContext *gm)
-{
-    for (int i = 0; i < PIECES_PER_SET; i++)
-        if (!gm->tray[i].used)
-            return false;
-    return true;
-}
-
-/**
- * \brief Check whether none of the remaining tray pieces can be placed.
- *
- * Used to detect game-over: if no unused piece has a valid placement the
- * game ends.
- *
- * \param gm  Game context.
- * \return    true if no remaining piece fits on the grid.
- */
-bool blockblaster_none_placeable(const GameContext *gm)
-{
-    for (int i = 0; i < PIECES_PER_SET; i++) {
-        if (gm->tray[i].used)
-            continue;
-        if (blockblaster_any_valid_placement(&gm->grid, &gm->tray[i].shape))
-            return false;
-    }
-    return true;
-}
-
-/**
- * \brief Randomly occupy count cells on the grid (partial-fill start mode).
- *
- * Cells are chosen at random; already-occupied cells are skipped.  The
- * loop gives up after 5000 attempts to prevent infinite spinning on a
- * nearly-full grid.
- *
- * \param g      Grid to fill.
- * \param count  Desired number of cells to occupy.
- */
-void blockblaster_random_fill(Grid *g, int count)
-{
-    int tries = 0;
-    while (count > 0 && tries < 5000) {
-        tries++;
-        int x = blockblaster_irand(0, GRID_W - 1);
-        int y = blockblaster_irand(0, GRID_H - 1);
-        if (!g->occ[y][x]) {
-            g->occ[y][x] = true;
-            count--;
-        }
-    }
-}
-
 /**
  * \brief Compute the bounding rectangle of the i-th tray slot.
  *
- * \param i   Tray slot index (0 .. PIECES_PER_SET-1).
+ * \param gm  Game context (provides the layout).
+ * \param i   Tray slot index (0 .. gm->tray_count-1).
  * \param x1  Output: left edge (virtual pixels).
  * \param y1  Output: top edge (virtual pixels).
  * \param x2  Output: right edge (virtual pixels).
  * \param y2  Output: bottom edge (virtual pixels).
  */
-void blockblaster_tray_piece_rect(int i, float *x1, float *y1, float *x2,
-                                  float *y2)
+void blockblaster_tray_piece_rect(const GameContext *gm, int i, float *x1,
+                                  float *y1, float *x2, float *y2)
 {
-    float bx = TRAY_X + i * (TRAY_BOX + TRAY_BOX_GAP);
-    float by = TRAY_Y;
+    float bx = TRAY_X(gm) + i * (TRAY_BOX(gm) + TRAY_BOX_GAP);
+    float by = TRAY_Y(gm);
     *x1 = bx;
     *y1 = by;
-    *x2 = bx + TRAY_BOX;
-    *y2 = by + TRAY_BOX;
+    *x2 = bx + TRAY_BOX(gm);
+    *y2 = by + TRAY_BOX(gm);
 }
 
 /**
@@ -793,6 +378,7 @@ void blockblaster_tray_piece_rect(int i, float *x1, float *y1, float *x2,
  * on a filled cell that cell is returned; otherwise the nearest filled
  * cell is chosen (Euclidean distance).
  *
+ * \param gm       Game context (provides the tray box size).
  * \param s        Shape being picked up.
  * \param rect_w   Width of the tray slot rectangle.
  * \param rect_h   Height of the tray slot rectangle.
@@ -801,11 +387,11 @@ void blockblaster_tray_piece_rect(int i, float *x1, float *y1, float *x2,
  * \param out_sx   Output: shape column of the grabbed cell.
  * \param out_sy   Output: shape row of the grabbed cell.
  */
-void blockblaster_compute_grab_cell(const Shape *s, float rect_w, float rect_h,
-                                    float local_x, float local_y, int *out_sx,
-                                    int *out_sy)
+void blockblaster_compute_grab_cell(const GameContext *gm, const Shape *s,
+                                    float rect_w, float rect_h, float local_x,
+                                    float local_y, int *out_sx, int *out_sy)
 {
-    float pc = TRAY_BOX / 9.0f;
+    float pc = TRAY_BOX(gm) / 9.0f;
     float pw = s->w * pc;
     float ph = s->h * pc;
     float px = (rect_w - pw) * 0.5f;
@@ -847,111 +433,35 @@ void blockblaster_compute_grab_cell(const Shape *s, float rect_w, float rect_h,
     *out_sy = best_y;
 }
 
-/* ======================================================================== */
-/* Score                                                                     */
-/* ======================================================================== */
-
-/**
- * \brief Calculate and apply the score for a single placement move.
- *
- * Awards points for placed cells, cleared cells, line bonuses and multi-line
- * bonuses.  Maintains the combo counter: consecutive clearing moves increase
- * the multiplier; three consecutive non-clearing moves reset it.
- *
- * \param gm             Game context (score, combo state updated in-place).
- * \param placed_cells   Number of cells the placed shape occupies.
- * \param lines_cleared  Number of full rows + columns cleared this move.
- * \param cleared_cells  Total occupied cells removed by those lines.
- * \param out_clear_gain If non-NULL, receives the clear-only portion of the
- *                       score gain (before placement points).
- * \param out_mult       If non-NULL, receives the effective multiplier used.
- * \return               Total score gained this move (placed + cleared).
- */
-int blockblaster_score_move(GameContext *gm, int placed_cells,
-                            int lines_cleared, int cleared_cells,
-                            int *out_clear_gain, float *out_mult)
-{
-    int gained_total = 0;
-    int clear_gain = 0;
-    float mult = 1.0f;
-
-    int place_gain = placed_cells * SCORE_PER_PLACED_CELL;
-    gained_total += place_gain;
-
-    if (lines_cleared > 0) {
-        gm->combo += lines_cleared;
-        if (gm->combo > gm->highest_combo)
-            gm->highest_combo = gm->combo;
-        gm->combo_miss = 0;
-
-        mult = 1.0f + (float) gm->combo;
-        if (mult > MAX_MULTIPLIER)
-            mult = MAX_MULTIPLIER;
-
-        int base_clear = cleared_cells * SCORE_PER_CLEARED_CELL;
-        int line_bonus = lines_cleared * SCORE_PER_LINE_BONUS;
-        int multi_bonus = (lines_cleared > 1)
-                              ? (SCORE_MULTI_LINE_BONUS * (lines_cleared - 1))
-                              : 0;
-
-        int subtotal = base_clear + line_bonus + multi_bonus;
-        clear_gain = (int) roundf((float) subtotal * mult);
-        gained_total += clear_gain;
-    } else {
-        if (gm->combo > 0) {
-            gm->combo_miss += 1;
-            if (gm->combo_miss > 3) {
-                gm->combo = 0;
-                gm->combo_miss = 0;
-                gm->last_move_mult = 1.0f;
-                mult = 1.0f;
-            } else {
-                mult = gm->last_move_mult;
-            }
-        } else {
-            gm->last_move_mult = 1.0f;
-            mult = 1.0f;
-        }
-    }
-    if (out_clear_gain)
-        *out_clear_gain = clear_gain;
-    if (out_mult)
-        *out_mult = mult;
-    gm->last_move_mult = mult;
-    gm->score += gained_total;
-    if (gm->score > gm->high_score)
-        gm->high_score = gm->score;
-    return gained_total;
-}
-
 /* ======================================================================== */
 /* Animation                                                                 */
 /* ======================================================================== */
 
 /**
- * \brief Start the clear-flash animation for the cells in mask.
+ * \brief Start the clear-flash animation for the given lines.
  *
- * Copies the mask into gm->pending_clear and sets the clearing flag so
- * that input is blocked and the flash timer begins counting down.
+ * Records the lines in gm->pending_rows / gm->pending_cols and sets the
+ * clearing flag so that input is blocked and the flash timer begins
+ * counting down.
  *
- * \param gm    Game context.
- * \param mask  Boolean mask of cells to clear after the animation.
+ * \param gm         Game context.
+ * \param full_rows  Bit y set for each row to clear after the animation.
+ * \param full_cols  Bit x set for each column to clear after the animation.
  */
-void blockblaster_begin_clear(GameContext *gm,
-                              bool mask[GRID_H_MAX][GRID_W_MAX])
+void blockblaster_begin_clear(GameContext *gm, uint32_t full_rows,
+                              uint32_t full_cols)
 {
     gm->clearing = true;
     gm->clear_t = CLEAR_FLASH_TIME;
-    for (int y = 0; y < GRID_H; y++)
-        for (int x = 0; x < GRID_W; x++)
-            gm->pending_clear[y][x] = mask[y][x];
+    gm->pending_rows = full_rows;
+    gm->pending_cols = full_cols;
 }
 
 /**
  * \brief Complete the clear animation: remove flagged cells and check for
  *        game-over.
  *
- * Called when clear_t reaches zero.  Applies the pending clear mask to the
+ * Called when clear_t reaches zero.  Removes the pending lines from the
  * grid, resets animation state, and triggers game-over if no remaining
  * piece can be placed.
  *
@@ -959,19 +469,20 @@ void blockblaster_begin_clear(GameContext *gm,
  */
 void blockblaster_finish_clear(GameContext *gm)
 {
-    blockblaster_apply_clear_mask(&gm->grid, gm->pending_clear);
-    for (int y = 0; y < GRID_H; y++)
-        for (int x = 0; x < GRID_W; x++)
-            gm->pending_clear[y][x] = false;
+    blockblaster_core_clear(&gm->core, gm->pending_rows, gm->pending_cols);
+    gm->pending_rows = 0;
+    gm->pending_cols = 0;
 
     gm->clearing = false;
     gm->clear_t = 0.0f;
 
-    if (gm->state == STATE_PLAY && blockblaster_none_placeable(gm)) {
+    if (gm->state == STATE_PLAY && gm->core.game_over) {
         n_log(LOG_INFO, "Game over (post-clear): none of the offered pieces "
                         "can be placed.");
         blockblaster_set_gameover(gm);
     }
+
+    blockblaster_refresh_hint(gm);
 }
 
 /**
@@ -986,7 +497,7 @@ void blockblaster_finish_clear(GameContext *gm)
 void blockblaster_start_return(GameContext *gm, int tray_index)
 {
     float x1, y1, x2, y2;
-    blockblaster_tray_piece_rect(tray_index, &x1, &y1, &x2, &y2);
+    blockblaster_tray_piece_rect(gm, tray_index, &x1, &y1, &x2, &y2);
 
     gm->returning = true;
     gm->return_index = tray_index;
@@ -1013,9 +524,9 @@ void blockblaster_start_return(GameContext *gm, int tray_index)
 void blockblaster_clear_predicted(GameContext *gm)
 {
     gm->has_predicted_clear = false;
-    for (int y = 0; y < GRID_H; y++)
+    for (int y = 0; y < gm->grid_h; y++)
         gm->pred_full_row[y] = false;
-    for (int x = 0; x < GRID_W; x++)
+    for (int x = 0; x < gm->grid_w; x++)
         gm->pred_full_col[x] = false;
 }
 
@@ -1023,9 +534,8 @@ void blockblaster_clear_predicted(GameContext *gm)
  * \brief Predict which rows and columns would be cleared if piece p were
  *        placed at (gx, gy).
  *
- * Builds a temporary copy of the grid with the piece stamped on, then
- * scans for full rows/columns.  The results are stored in
- * gm->pred_full_row[] and gm->pred_full_col[] for the renderer to
+ * Uses blockblaster_predict_full_lines() and expands the resulting masks
+ * into gm->pred_full_row[] and gm->pred_full_col[] for the renderer to
  * highlight.
  *
  * \param gm  Game context (predicted arrays updated in-place).
@@ -1036,27 +546,15 @@ void blockblaster_clear_predicted(GameContext *gm)
 void blockblaster_compute_predicted_clear(GameContext *gm, const Piece *p,
                                           int gx, int gy)
 {
-    bool temp[GRID_H_MAX][GRID_W_MAX];
-    for (int y = 0; y < GRID_H; y++)
-        for (int x = 0; x < GRID_W; x++)
-            temp[y][x] = gm->grid.occ[y][x];
-
-    for (int sy = 0; sy < p->shape.h; sy++) {
-        for (int sx = 0; sx < p->shape.w; sx++) {
-            if (!blockblaster_shape_cell(&p->shape, sx, sy))
-                continue;
-            int x = gx + sx;
-            int y = gy + sy;
-            if (x >= 0 && y >= 0 && x < GRID_W && y < GRID_H)
-                temp[y][x] = true;
-        }
-    }
+    uint32_t full_rows, full_cols;
+    blockblaster_predict_full_lines(&gm->core.grid, &SHAPE_MASKS[p->shape_id],
+                                    gx, gy, &full_rows, &full_cols);
 
     gm->has_predicted_clear = true;
-    for (int y = 0; y < GRID_H; y++)
-        gm->pred_full_row[y] = is_row_full(temp, y);
-    for (int x = 0; x < GRID_W; x++)
-        gm->pred_full_col[x] = is_col_full(temp, x);
+    for (int y = 0; y < gm->grid_h; y++)
+        gm->pred_full_row[y] = ((full_rows >> y) & 1u) != 0;
+    for (int x = 0; x < gm->grid_w; x++)
+        gm->pred_full_col[x] = ((full_cols >> x) & 1u) != 0;
 }
 
 /* ======================================================================== */
@@ -1083,15 +581,15 @@ void blockblaster_update_drop_preview(GameContext *gm)
         return;
     }
 
-    Piece *p = &gm->tray[gm->dragging_index];
+    Piece *p = &gm->core.tray[gm->dragging_index];
     if (p->used) {
         blockblaster_clear_predicted(gm);
         return;
     }
 
-    float gx1 = GRID_X, gy1 = GRID_Y;
-    float gx2 = GRID_X + GRID_W * CELL;
-    float gy2 = GRID_Y + GRID_H * CELL;
+    float gx1 = GRID_X(gm), gy1 = GRID_Y;
+    float gx2 = GRID_X(gm) + gm->grid_w * CELL(gm);
+    float gy2 = GRID_Y + gm->grid_h * CELL(gm);
 
     float my = gm->mouse_y;
 #ifdef ALLEGRO_ANDROID
@@ -1103,8 +601,8 @@ void blockblaster_update_drop_preview(GameContext *gm)
         return;
     }
 
-    int mouse_gx = (int) floorf((gm->mouse_x - GRID_X) / CELL);
-    int mouse_gy = (int) floorf((my - GRID_Y) / CELL);
+    int mouse_gx = (int) floorf((gm->mouse_x - GRID_X(gm)) / CELL(gm));
+    int mouse_gy = (int) floorf((my - GRID_Y) / CELL(gm));
 
     int gx = mouse_gx - gm->grab_sx;
     int gy = mouse_gy - gm->grab_sy;
@@ -1112,7 +610,7 @@ void blockblaster_update_drop_preview(GameContext *gm)
     gm->preview_cell_x = gx;
     gm->preview_cell_y = gy;
     gm->can_drop_preview =
-        blockblaster_can_place_at(&gm->grid, &p->shape, gx, gy);
+        blockblaster_placement_map_test(&gm->core, gm->dragging_index, gx, gy);
 
     if (gm->can_drop_preview)
         blockblaster_compute_predicted_clear(gm, p, gx, gy);
@@ -1137,83 +635,88 @@ void blockblaster_try_drop(GameContext *gm)
     if (gm->clearing)
         return;
 
-    float old_mult = gm->last_move_mult;
+    float old_mult = gm->core.last_move_mult;
 
     int drop_index = gm->dragging_index;
-    Piece *p = &gm->tray[drop_index];
+    Piece *p = &gm->core.tray[drop_index];
     gm->dragging = false;
 
     if (p->used) {
-        blockblaster_play_sfx(sfx_send_to_tray, gm);
+        blockblaster_play_sfx(gm->audio.sfx_send_to_tray, gm);
         return;
     }
-    if (!gm->can_drop_preview) {
-        blockblaster_play_sfx(sfx_send_to_tray, gm);
+    /* Check the drop before recording it, so a refused one leaves no undo
+       level behind. */
+    if (!gm->can_drop_preview ||
+        !blockblaster_placement_map_test(&gm->core, drop_index,
+                                         gm->preview_cell_x,
+                                         gm->preview_cell_y)) {
+        blockblaster_play_sfx(gm->audio.sfx_send_to_tray, gm);
         blockblaster_start_return(gm, drop_index);
         return;
     }
 
-    blockblaster_play_sfx(sfx_place, gm);
-
-    blockblaster_place_shape(&gm->grid, &p->shape, gm->preview_cell_x,
-                             gm->preview_cell_y, p->theme);
+    /* The move may deal a new set into this slot: keep what the effects
+       need from the dropped piece first. */
+    const ShapeMask *m = &SHAPE_MASKS[p->shape_id];
+    Theme theme = gm->theme_table[p->theme];
+    if (gm->undo_on)
+        blockblaster_undo_record(gm->undo, &gm->core,
+                                 REPLAY_MOVE(drop_index, gm->preview_cell_x,
+                                             gm->preview_cell_y));
+    CoreMove mv;
+    if (!blockblaster_core_place(&gm->core, drop_index, gm->preview_cell_x,
+                                 gm->preview_cell_y, &mv))
+        return;
+    blockblaster_replay_add(&gm->replay, drop_index, gm->preview_cell_x,
+                            gm->preview_cell_y);
 
-    int placed_cells = 0;
-    for (int sy = 0; sy < p->shape.h; sy++) {
-        for (int sx = 0; sx < p->shape.w; sx++) {
-            if (!blockblaster_shape_cell(&p->shape, sx, sy))
-                continue;
-            placed_cells++;
-            int gx = gm->preview_cell_x + sx;
-            int gy = gm->preview_cell_y + sy;
-            if (gx >= 0 && gy >= 0 && gx < GRID_W && gy < GRID_H)
-                gm->pop_t[gy][gx] = PLACE_POP_TIME;
-        }
-    }
+    blockblaster_play_sfx(gm->audio.sfx_place, gm);
+    if (gm->core.score > gm->high_score)
+        gm->high_score = gm->core.score;
 
-    bool mask[GRID_H_MAX][GRID_W_MAX];
-    int lines = blockblaster_build_clear_mask(&gm->grid, mask);
-    int cleared_cells = 0;
-    if (lines > 0) {
-        cleared_cells = blockblaster_count_cells_in_mask(&gm->grid, mask);
-        blockblaster_play_sfx(sfx_break_lines, gm);
+    for (int i = 0; i < m->cell_count; i++) {
+        int gx = gm->preview_cell_x + m->cells[i][0];
+        int gy = gm->preview_cell_y + m->cells[i][1];
+        gm->pop_t[gy][gx] = PLACE_POP_TIME;
     }
 
-    int clear_gain = 0;
-    float applied_mult = 1.0f;
-    blockblaster_score_move(gm, placed_cells, lines, cleared_cells, &clear_gain,
-                            &applied_mult);
+    int lines = mv.lines;
+    if (lines > 0)
+        blockblaster_play_sfx(gm->audio.sfx_break_lines, gm);
 
-    if (lines > 0 && applied_mult > old_mult + 0.001f)
-        blockblaster_start_combo_popup(gm, applied_mult, p->theme);
+    if (lines > 0 && mv.mult > old_mult + 0.001f)
+        blockblaster_start_combo_popup(gm, mv.mult, theme);
 
     if (lines > 0) {
         int spawned = 0;
-        for (int y = 0; y < GRID_H; y++) {
-            for (int x = 0; x < GRID_W; x++) {
-                if (!mask[y][x] || !gm->grid.occ[y][x])
-                    continue;
-                float cx = GRID_X + x * CELL + CELL * 0.5f;
-                float cy = GRID_Y + y * CELL + CELL * 0.5f;
+        for (int y = 0; y < gm->grid_h; y++) {
+            uint32_t row = ((mv.full_rows >> y) & 1u)
+                               ? GRID_FULL_ROW(&gm->core.grid)
+                               : mv.full_cols;
+            for (; row; row &= row - 1) {
+                int x = __builtin_ctz(row);
+                float cx = GRID_X(gm) + x * CELL(gm) + CELL(gm) * 0.5f;
+                float cy = GRID_Y + y * CELL(gm) + CELL(gm) * 0.5f;
                 int n = PARTICLES_PER_CLEARED_CELL;
                 if (spawned + n > PARTICLES_CAP_PER_CLEAR)
                     n = PARTICLES_CAP_PER_CLEAR - spawned;
                 if (n <= 0)
                     break;
-                blockblaster_spawn_particles(gm, cx, cy, p->theme, n);
+                blockblaster_spawn_particles(gm, cx, cy, theme, n);
                 spawned += n;
             }
             if (spawned >= PARTICLES_CAP_PER_CLEAR)
                 break;
         }
-        if (clear_gain > 0) {
-            float bx = GRID_X + (float) GRID_W * CELL;
-            float by = GRID_Y + (float) GRID_H * CELL + 5.0f;
-            blockblaster_spawn_bonus_popup(gm, bx, by, clear_gain, applied_mult,
-                                           p->theme);
-            blockblaster_spawn_particles(gm, bx, by, p->theme, BONUS_PARTICLES);
+        if (mv.clear_gain > 0) {
+            float bx = GRID_X(gm) + (float) gm->grid_w * CELL(gm);
+            float by = GRID_Y + (float) gm->grid_h * CELL(gm) + 5.0f;
+            blockblaster_spawn_bonus_popup(gm, bx, by, mv.clear_gain, mv.mult,
+                                           theme);
+            blockblaster_spawn_particles(gm, bx, by, theme, BONUS_PARTICLES);
         }
-        blockblaster_begin_clear(gm, mask);
+        blockblaster_begin_clear(gm, mv.full_rows, mv.full_cols);
     }
 
     if (lines >= 2) {
@@ -1225,15 +728,12 @@ void blockblaster_try_drop(GameContext *gm)
         gm->shake_strength = SHAKE_STRENGTH * 0.6f;
     }
 
-    p->used = true;
-
-    if (blockblaster_tray_all_used(gm))
-        blockblaster_refill_tray(gm);
-
-    if (!gm->clearing && blockblaster_none_placeable(gm)) {
+    if (gm->core.game_over) {
         n_log(LOG_INFO, "Game over: none of the offered pieces can be placed.");
         blockblaster_set_gameover(gm);
     }
+
+    blockblaster_refresh_hint(gm);
 }
 
 /* ======================================================================== */
@@ -1243,10 +743,10 @@ void blockblaster_try_drop(GameContext *gm)
 /**
  * \brief Spawn count particles at (x, y) with configurable size and speed.
  *
- * Each particle is given a random launch angle, speed in [speed_min,
- * speed_max], and size in [size_min, size_max] scaled by the current font
- * scale.  If the particle pool is full, remaining particles are silently
- * dropped.
+ * Fills a ParticleBurst (radius scaled by the current font scale, colour
+ * from the theme fill) and emits it from the cosmetic random stream; see
+ * blockblaster_particles_emit().  If the particle pool is full, remaining
+ * particles are silently dropped.
  *
  * \param gm         Game context (particle pool updated in-place).
  * \param x          Horizontal spawn centre (virtual pixels).
@@ -1263,34 +763,21 @@ void blockblaster_spawn_particles_scaled(GameContext *gm, float x, float y,
                                          float size_max, float speed_min,
                                          float speed_max)
 {
-    for (int k = 0; k < count; k++) {
-        int idx = -1;
-        for (int i = 0; i < MAX_PARTICLES; i++) {
-            if (!gm->particles[i].alive) {
-                idx = i;
-                break;
-            }
-        }
-        if (idx < 0)
-            return;
+    float sc = blockblaster_font_effective_scale(gm);
+    if (sc <= 0.0f)
+        sc = 1.0f;
 
-        Particle *p = &gm->particles[idx];
-        float ang = blockblaster_frand(0.0f, 6.2831853f);
-        float spd = blockblaster_frand(speed_min, speed_max);
-
-        p->x = x + blockblaster_frand(-6.0f, 6.0f);
-        p->y = y + blockblaster_frand(-6.0f, 6.0f);
-        p->vx = cosf(ang) * spd;
-        p->vy = sinf(ang) * spd - blockblaster_frand(10.0f, 90.0f);
-        p->life0 = p->life =
-            blockblaster_frand(PARTICLE_LIFE_MIN, PARTICLE_LIFE_MAX);
-        float sc = blockblaster_font_effective_scale(gm);
-        if (sc <= 0.0f)
-            sc = 1.0f;
-        p->size = blockblaster_frand(size_min, size_max) * sc;
-        p->col = t.fill;
-        p->alive = true;
-    }
+    ParticleBurst b = {.x = x,
+                       .y = y,
+                       .r = t.fill.r,
+                       .g = t.fill.g,
+                       .b = t.fill.b,
+                       .size_min = size_min,
+                       .size_max = size_max,
+                       .scale = sc,
+                       .speed_min = speed_min,
+                       .speed_max = speed_max};
+    blockblaster_particles_emit(gm->particles, &gm->fx_rng, &b, count);
 }
 
 /**
@@ -1362,15 +849,15 @@ void blockblaster_start_combo_popup(GameContext *gm, float mult, Theme theme)
     gm->combo_popup.mult = mult;
     gm->combo_popup.theme = theme;
 
-    float grid_w_px = (float) GRID_W * CELL;
-    float grid_h_px = (float) GRID_H * CELL;
-    gm->combo_popup.x = GRID_X;
+    float grid_w_px = (float) gm->grid_w * CELL(gm);
+    float grid_h_px = (float) gm->grid_h * CELL(gm);
+    gm->combo_popup.x = GRID_X(gm);
     gm->combo_popup.y = GRID_Y;
     gm->combo_popup.vx = grid_w_px / COMBO_POP_LIFE;
     gm->combo_popup.vy = grid_h_px / COMBO_POP_LIFE;
 
     snprintf(gm->combo_popup.text, sizeof(gm->combo_popup.text), "COMBO x%d",
-             gm->combo);
+             gm->core.combo);
 
     float mclamp = mult;
     if (mclamp < 1.0f)
@@ -1387,7 +874,7 @@ void blockblaster_start_combo_popup(GameContext *gm, float mult, Theme theme)
     float sp_min = 80.0f + 14.0f * mclamp;
     float sp_max = 180.0f + 26.0f * mclamp;
 
-    blockblaster_spawn_particles_scaled(gm, GRID_X, GRID_Y, theme, count,
+    blockblaster_spawn_particles_scaled(gm, GRID_X(gm), GRID_Y, theme, count,
                                         sz_min, sz_max, sp_min, sp_max);
 }
 
@@ -1395,6 +882,31 @@ void blockblaster_start_combo_popup(GameContext *gm, float mult, Theme theme)
 /* Game flow                                                                 */
 /* ======================================================================== */
 
+/**
+ * \brief Reset a context to its defaults: menu state, 600x900 canvas,
+ *        10x10 board with 4 pieces per set, no audio loaded.
+ *
+ * Call once per context before any other blockblaster_* function.  The
+ * random streams are left unseeded (seed them afterwards for a
+ * reproducible session).
+ *
+ * \param gm  Context to initialise.
+ */
+void blockblaster_init_context(GameContext *gm)
+{
+    memset(gm, 0, sizeof(*gm));
+    gm->state = STATE_MENU;
+    gm->grid_w = GRID_SIZE_DEFAULT;
+    gm->grid_h = GRID_SIZE_DEFAULT;
+    gm->tray_count = PIECES_PER_SET_DEFAULT;
+    gm->win_w = WIN_W_DEFAULT;
+    gm->win_h = WIN_H_DEFAULT;
+    gm->scale = 1.0f;
+    gm->audio.music_current_track = -1;
+    gm->setting_tray_count = PIECES_PER_SET_DEFAULT;
+    gm->setting_grid_size = GRID_SIZE_DEFAULT;
+}
+
 /**
  * \brief Transition to the game-over state and open the name editor.
  *
@@ -1407,6 +919,26 @@ void blockblaster_start_combo_popup(GameContext *gm, float mult, Theme theme)
  */
 void blockblaster_set_gameover(GameContext *gm)
 {
+    const FairTrayStats *fs = &gm->core.fair;
+    if (gm->core.fair_tray && fs->deals > 0)
+        n_log(LOG_INFO,
+              "Fair trays: %ld deals, %.1f us mean, %.1f us max, "
+              "%ld redraws, %ld budget hits",
+              fs->deals, fs->total_us / (double) fs->deals, fs->max_us,
+              fs->redraws, fs->budget_hits);
+
+    /* The game can be watched only if re-simulating the drops gives back
+       the game that was played: a fair deal cut short by the clock may
+       have dealt other trays than the node-limited re-simulation. */
+    blockblaster_replay_finish(&gm->replay, &gm->core);
+    CoreGame check;
+    gm->replay_indexed =
+        !gm->replay.lost && blockblaster_replay_index(&gm->replay) &&
+        blockblaster_replay_verify(&gm->replay, &check, NULL) == REPLAY_OK &&
+        memcmp(check.grid.rows, gm->core.grid.rows,
+               (size_t) gm->core.grid.h * sizeof(uint32_t)) == 0;
+    blockblaster_save_replay(&gm->replay, REPLAY_LAST_FILENAME);
+
     /* Pre-fill with last player name; the player can edit before confirming. */
     if (gm->player_name[0] == '\0')
         snprintf(gm->player_name, MAX_PLAYER_NAME_LEN + 1, "%s",
@@ -1429,9 +961,8 @@ void blockblaster_set_gameover(GameContext *gm)
 /**
  * \brief Initialise a new game session.
  *
- * Applies the player's chosen grid size and tray count, clears the grid,
- * optionally pre-fills cells (mode 1), refills the tray, and resets all
- * animation and scoring state.
+ * Applies the player's chosen grid size and tray count, starts the rules
+ * state (see blockblaster_core_start()), and resets all animation state.
  *
  * \param gm    Game context (fully reset by this call).
  * \param mode  0 = empty grid, 1 = partially filled grid.
@@ -1442,11 +973,6 @@ void blockblaster_start_game(GameContext *gm, int mode)
     blockblaster_apply_settings(gm);
 
     gm->state = STATE_PLAY;
-    gm->score = 0;
-    gm->combo = 0;
-    gm->highest_combo = 0;
-    gm->last_move_mult = 1.0f;
-    gm->combo_miss = 0;
     gm->combo_popup.alive = false;
 
     gm->dragging = false;
@@ -1458,27 +984,35 @@ void blockblaster_start_game(GameContext *gm, int mode)
 
     gm->clearing = false;
     gm->clear_t = 0.0f;
-    for (int y = 0; y < GRID_H; y++)
-        for (int x = 0; x < GRID_W; x++) {
-            gm->pending_clear[y][x] = false;
+    gm->pending_rows = 0;
+    gm->pending_cols = 0;
+    for (int y = 0; y < gm->grid_h; y++)
+        for (int x = 0; x < gm->grid_w; x++)
             gm->pop_t[y][x] = 0.0f;
-        }
 
-    gm->start_mode = mode;
-    blockblaster_grid_clear(&gm->grid);
-
-    if (mode == 1) {
-        int fill = blockblaster_irand(FILL_MIN, FILL_MAX);
-        blockblaster_random_fill(&gm->grid, fill);
-        bool tmp[GRID_H_MAX][GRID_W_MAX];
-        int lines = blockblaster_build_clear_mask(&gm->grid, tmp);
-        if (lines > 0)
-            blockblaster_apply_clear_mask(&gm->grid, tmp);
+    /* Each game plays from its own seed, drawn from the running stream, so
+       that its replay only needs that seed and the drops. */
+    uint64_t seed = (uint64_t) blockblaster_rng_next(&gm->core.rng) << 32;
+    seed |= blockblaster_rng_next(&gm->core.rng);
+    blockblaster_rng_seed(&gm->core.rng, seed, RNG_STREAM_GAMEPLAY);
+    blockblaster_replay_begin(&gm->replay, seed, gm->grid_w, gm->tray_count,
+                              mode, gm->core.fair_tray);
+
+    blockblaster_core_start(&gm->core, gm->grid_w, gm->grid_h,
+                            gm->tray_count, mode);
+
+    gm->undo_on = gm->setting_undo;
+    if (gm->undo_on && !gm->undo) {
+        gm->undo = blockblaster_undo_create();
+        if (!gm->undo) {
+            n_log(LOG_ERR, "Could not create the undo history.");
+            gm->undo_on = false;
+        }
     }
+    if (gm->undo_on)
+        blockblaster_undo_reset(gm->undo);
 
-    blockblaster_refill_tray(gm);
-
-    if (blockblaster_none_placeable(gm)) {
+    if (gm->core.game_over) {
         n_log(LOG_INFO,
               "Immediate game over: none of the offered pieces can be placed.");
         blockblaster_set_gameover(gm);
@@ -1488,19 +1022,217 @@ void blockblaster_start_game(GameContext *gm, int mode)
     gm->shake_strength = 0.0f;
     gm->cam_x = gm->cam_y = 0.0f;
 
-    for (int i = 0; i < MAX_PARTICLES; i++)
-        gm->particles[i].alive = false;
+    blockblaster_particles_clear(gm->particles);
     for (int i = 0; i < MAX_BONUS_POPUPS; i++)
         gm->bonus_popups[i].alive = false;
 
-    gm->theme_mode = 1;
-    gm->set_theme = blockblaster_random_theme(gm);
-
     /* Prepare player name from last saved name */
     snprintf(gm->player_name, sizeof(gm->player_name), "%s",
              gm->last_player_name);
     gm->editing_name = false;
     gm->name_cursor = 0;
+
+    blockblaster_refresh_hint(gm);
+}
+
+/* ======================================================================== */
+/* Hints                                                                     */
+/* ======================================================================== */
+
+/**
+ * \brief Restart the background hint search on the current board, or
+ *        cancel it when no hint applies.
+ *
+ * Called after every change of the board.  While cleared lines are still
+ * animating the board is not final yet: the search is cancelled and
+ * restarted by blockblaster_finish_clear().
+ *
+ * \param gm  Game context.
+ */
+void blockblaster_refresh_hint(GameContext *gm)
+{
+    if (gm->hint_on && gm->state == STATE_PLAY && !gm->clearing &&
+        !gm->core.game_over)
+        blockblaster_hint_request(gm->hint, &gm->core);
+    else
+        blockblaster_hint_cancel(gm->hint);
+}
+
+/**
+ * \brief Switch the hint overlay on or off.
+ *
+ * The hint engine and its worker thread are created the first time hints
+ * are enabled.
+ *
+ * \param gm  Game context.
+ */
+void blockblaster_toggle_hint(GameContext *gm)
+{
+    gm->hint_on = !gm->hint_on;
+    if (gm->hint_on && !gm->hint) {
+        gm->hint = blockblaster_hint_create();
+        if (!gm->hint) {
+            n_log(LOG_ERR, "Could not create the hint engine.");
+            gm->hint_on = false;
+        }
+    }
+    blockblaster_refresh_hint(gm);
+}
+
+/* ======================================================================== */
+/* Undo                                                                      */
+/* ======================================================================== */
+
+/* Put the board back after an undo or redo: stop the effects of the
+   previous drop and restart the hint search. */
+static void undo_settle(GameContext *gm)
+{
+    for (int y = 0; y < gm->grid_h; y++)
+        for (int x = 0; x < gm->grid_w; x++)
+            gm->pop_t[y][x] = 0.0f;
+    gm->combo_popup.alive = false;
+    for (int i = 0; i < MAX_BONUS_POPUPS; i++)
+        gm->bonus_popups[i].alive = false;
+    gm->shake_t = 0.0f;
+    blockblaster_clear_predicted(gm);
+    blockblaster_play_sfx(gm->audio.sfx_send_to_tray, gm);
+    blockblaster_refresh_hint(gm);
+}
+
+/**
+ * \brief Take back the last drop, when the running game allows undo.
+ *
+ * Ignored while a piece is dragged or animated; a line clear still
+ * flashing is completed first.  The drop is also removed from the replay,
+ * so the replay stays the line of play that was kept.
+ *
+ * \param gm  Game context (in STATE_PLAY).
+ */
+void blockblaster_undo_move(GameContext *gm)
+{
+    if (!gm->undo_on || gm->state != STATE_PLAY || gm->dragging ||
+        gm->returning)
+        return;
+    if (gm->clearing)
+        blockblaster_finish_clear(gm);
+    if (gm->state != STATE_PLAY || !blockblaster_undo(gm->undo, &gm->core))
+        return;
+    blockblaster_replay_undo(&gm->replay);
+    undo_settle(gm);
+}
+
+/**
+ * \brief Make again the drop taken back last.
+ *
+ * \param gm  Game context (in STATE_PLAY).
+ */
+void blockblaster_redo_move(GameContext *gm)
+{
+    uint16_t m;
+    if (!gm->undo_on || gm->state != STATE_PLAY || gm->dragging ||
+        gm->returning || gm->clearing ||
+        !blockblaster_redo(gm->undo, &gm->core, &m))
+        return;
+    blockblaster_replay_add(&gm->replay, REPLAY_MOVE_SLOT(m),
+                            REPLAY_MOVE_GX(m), REPLAY_MOVE_GY(m));
+    undo_settle(gm);
+}
+
+/* ======================================================================== */
+/* Replay view                                                               */
+/* ======================================================================== */
+
+/**
+ * \brief Show the board as it was after a given number of drops.
+ *
+ * Seeks through the replay keyframes, so the cost does not depend on the
+ * position.  Running animations are dropped: the board jumps straight to
+ * the requested state.
+ *
+ * \param gm    Game context (in STATE_REPLAY).
+ * \param move  Number of drops to show; clamped to the recorded range.
+ * \return      false if the game cannot be rebuilt at that position.
+ */
+bool blockblaster_show_replay_move(GameContext *gm, int move)
+{
+    if (move < 0)
+        move = 0;
+    if (move > gm->replay.count)
+        move = gm->replay.count;
+    if (!blockblaster_replay_seek(&gm->replay, move, &gm->core)) {
+        n_log(LOG_ERR, "Replay: cannot rebuild the game after %d drops.",
+              move);
+        return false;
+    }
+    gm->replay_move = move;
+
+    gm->clearing = false;
+    gm->clear_t = 0.0f;
+    gm->pending_rows = 0;
+    gm->pending_cols = 0;
+    for (int y = 0; y < gm->grid_h; y++)
+        for (int x = 0; x < gm->grid_w; x++)
+            gm->pop_t[y][x] = 0.0f;
+    gm->combo_popup.alive = false;
+    for (int i = 0; i < MAX_BONUS_POPUPS; i++)
+        gm->bonus_popups[i].alive = false;
+    return true;
+}
+
+/**
+ * \brief Switch from the game-over overlay to watching the finished game.
+ *
+ * The replay starts from the opening deal and plays on its own; the final
+ * state is kept aside and restored by blockblaster_leave_replay_view().
+ * Does nothing when the replay could not be indexed.
+ *
+ * \param gm  Game context (in STATE_GAMEOVER).
+ */
+void blockblaster_enter_replay_view(GameContext *gm)
+{
+    if (!gm->replay_indexed)
+        return;
+    gm->replay_final = gm->core;
+    gm->state = STATE_REPLAY;
+    gm->replay_playing = true;
+    gm->replay_scrubbing = false;
+    gm->replay_t = REPLAY_STEP_TIME;
+    if (!blockblaster_show_replay_move(gm, 0))
+        blockblaster_leave_replay_view(gm);
+}
+
+/**
+ * \brief Return from the replay view to the game-over overlay.
+ *
+ * \param gm  Game context.
+ */
+void blockblaster_leave_replay_view(GameContext *gm)
+{
+    gm->core = gm->replay_final;
+    gm->replay_playing = false;
+    gm->replay_scrubbing = false;
+    gm->state = STATE_GAMEOVER;
+}
+
+/**
+ * \brief Advance a playing replay by one drop every REPLAY_STEP_TIME.
+ *
+ * Playback pauses on the last drop and while the scrub bar is dragged.
+ *
+ * \param gm  Game context (in STATE_REPLAY).
+ * \param dt  Elapsed time in seconds.
+ */
+void blockblaster_update_replay_view(GameContext *gm, float dt)
+{
+    if (!gm->replay_playing || gm->replay_scrubbing)
+        return;
+    gm->replay_t -= dt;
+    if (gm->replay_t > 0.0f)
+        return;
+    gm->replay_t = REPLAY_STEP_TIME;
+    if (gm->replay_move >= gm->replay.count ||
+        !blockblaster_show_replay_move(gm, gm->replay_move + 1))
+        gm->replay_playing = false;
 }
 
 /* ======================================================================== */
@@ -1515,8 +1247,9 @@ void blockblaster_start_game(GameContext *gm, int mode)
  * canvas is the default 600x900 and a uniform scale + offset centres it
  * within the window.
  *
- * Also updates g_display_scale (used by the line-width macros) and kills
- * any active combo popup so it doesn't render at stale coordinates.
+ * Also kills any active combo popup so it doesn't render at stale
+ * coordinates, and marks the tile atlas and the background layer for a
+ * rebuild at the new size.
  *
  * \param gm  Game context (display dimensions, scale, offsets updated).
  */
@@ -1535,29 +1268,30 @@ void blockblaster_update_view_offset(GameContext *gm)
 #endif
 
     if (is_fs) {
-        WIN_W = gm->display_width;
-        WIN_H = gm->display_height;
+        gm->win_w = gm->display_width;
+        gm->win_h = gm->display_height;
         gm->scale = 1.0f;
         gm->view_offset_x = 0.0f;
         gm->view_offset_y = 0.0f;
     } else {
-        WIN_W = WIN_W_DEFAULT;
-        WIN_H = WIN_H_DEFAULT;
-        float sx = (float) gm->display_width / (float) WIN_W;
-        float sy = (float) gm->display_height / (float) WIN_H;
+        gm->win_w = WIN_W_DEFAULT;
+        gm->win_h = WIN_H_DEFAULT;
+        float sx = (float) gm->display_width / (float) gm->win_w;
+        float sy = (float) gm->display_height / (float) gm->win_h;
         gm->scale = (sx < sy) ? sx : sy;
         if (gm->scale < 0.1f)
             gm->scale = 0.1f;
-        float scaled_w = (float) WIN_W * gm->scale;
-        float scaled_h = (float) WIN_H * gm->scale;
+        float scaled_w = (float) gm->win_w * gm->scale;
+        float scaled_h = (float) gm->win_h * gm->scale;
         gm->view_offset_x =
             floorf(((float) gm->display_width - scaled_w) * 0.5f);
         gm->view_offset_y =
             floorf(((float) gm->display_height - scaled_h) * 0.5f);
     }
 
-    g_display_scale = gm->scale;
     gm->combo_popup.alive = false;
+    gm->tiles.dirty = true;
+    gm->background.dirty = true;
 }
 
 /**
@@ -1675,10 +1409,12 @@ void blockblaster_save_high_scores(const GameContext *gm)
         if (off >= (int) sizeof(buf) - 1)
             break;
         off +=
-            snprintf(buf + off, sizeof(buf) - off, "%d %d %d %ld %d %.5s\n",
+            snprintf(buf + off, sizeof(buf) - off,
+                     "%d %d %d %ld %d %.5s %016llx\n",
                      gm->high_scores[i].grid_w, gm->high_scores[i].grid_h,
                      gm->high_scores[i].tray_count, gm->high_scores[i].score,
-                     gm->high_scores[i].highest_combo, gm->high_scores[i].name);
+                     gm->high_scores[i].highest_combo, gm->high_scores[i].name,
+                     (unsigned long long) gm->high_scores[i].replay_seed);
     }
     al_fwrite(af, buf, off);
     al_fclose(af);
@@ -1691,10 +1427,11 @@ void blockblaster_save_high_scores(const GameContext *gm)
         return;
     fprintf(f, "%d\n", gm->high_score_count);
     for (int i = 0; i < gm->high_score_count; i++) {
-        fprintf(f, "%d %d %d %ld %d %.5s\n", gm->high_scores[i].grid_w,
-                gm->high_scores[i].grid_h, gm->high_scores[i].tray_count,
-                gm->high_scores[i].score, gm->high_scores[i].highest_combo,
-                gm->high_scores[i].name);
+        fprintf(f, "%d %d %d %ld %d %.5s %016llx\n",
+                gm->high_scores[i].grid_w, gm->high_scores[i].grid_h,
+                gm->high_scores[i].tray_count, gm->high_scores[i].score,
+                gm->high_scores[i].highest_combo, gm->high_scores[i].name,
+                (unsigned long long) gm->high_scores[i].replay_seed);
     }
     fclose(f);
 #endif
@@ -1709,7 +1446,8 @@ void blockblaster_save_high_scores(const GameContext *gm)
  * \brief Load the high-score table from disk.
  *
  * Supports both the current multi-entry format (grid_w grid_h tray_count
- * score combo name) and the legacy single-score format (score combo).
+ * score combo name, then the replay seed in hex when the entry has a
+ * replay) and the legacy single-score format (score combo).
  * Missing or malformed files result in an empty table.
  *
  * \param gm  Game context (high_scores and high_score_count updated).
@@ -1759,6 +1497,16 @@ void blockblaster_load_high_scores(GameContext *gm)
             gm->high_scores[i].grid_w = gw;
             gm->high_scores[i].grid_h = gh;
             gm->high_scores[i].tray_count = tc;
+            /* Optional replay seed, on this line only. */
+            char line[128];
+            size_t len = strcspn(p, "\n");
+            if (len >= sizeof(line))
+                len = sizeof(line) - 1;
+            memcpy(line, p, len);
+            line[len] = '\0';
+            unsigned long long seed = 0;
+            if (sscanf(line, "%*d %*d %*d %*d %*d %*s %llx", &seed) == 1)
+                gm->high_scores[i].replay_seed = seed;
         } else if (sscanf(p, "%ld %d %5s", &gm->high_scores[i].score,
                           &gm->high_scores[i].highest_combo, name) >= 2) {
             gm->high_scores[i].grid_w = 10;
@@ -1818,6 +1566,12 @@ void blockblaster_load_high_scores(GameContext *gm)
             gm->high_scores[i].grid_w = gw;
             gm->high_scores[i].grid_h = gh;
             gm->high_scores[i].tray_count = tc;
+            /* Optional replay seed, up to the end of the line. */
+            char rest[64];
+            unsigned long long seed = 0;
+            if (fgets(rest, sizeof(rest), f) &&
+                sscanf(rest, "%llx", &seed) == 1)
+                gm->high_scores[i].replay_seed = seed;
         } else {
             /* Fall back to old format: score combo name */
             fseek(f, saved_pos, SEEK_SET);
@@ -1852,12 +1606,39 @@ done:
     n_log(LOG_INFO, "Loaded %d high scores", gm->high_score_count);
 }
 
+/* Delete the replay file of a score entry that left the table. */
+static void remove_score_replay(uint64_t seed)
+{
+    char file[64];
+    snprintf(file, sizeof(file), REPLAY_SCORE_FILENAME_FMT,
+             (unsigned long long) seed);
+#ifdef ALLEGRO_ANDROID
+    al_set_standard_file_interface();
+    ALLEGRO_PATH *path = al_get_standard_path(ALLEGRO_USER_DATA_PATH);
+    al_set_path_filename(path, file);
+    bool ok = al_remove_filename(al_path_cstr(path, '/'));
+    al_destroy_path(path);
+    al_android_set_apk_file_interface();
+#else
+    char path[512];
+    snprintf(path, sizeof(path), "%s%s", SAVE_DIR, file);
+    bool ok = remove(path) == 0;
+#endif
+#ifdef __EMSCRIPTEN__
+    emscripten_save_flush_internal();
+#endif
+    if (!ok)
+        n_log(LOG_ERR, "Could not remove replay %s", file);
+}
+
 /**
  * \brief Insert a new entry into the high-score table (sorted descending).
  *
  * If the score qualifies for the top MAX_HIGH_SCORES the entry is
  * inserted at the correct position and lower entries are shifted down.
- * Entries beyond MAX_HIGH_SCORES are discarded.
+ * The game's replay is saved as REPLAY_SCORE_FILENAME_FMT (named by its
+ * seed) and the entry records that seed.  An entry pushed past
+ * MAX_HIGH_SCORES is discarded along with its replay file.
  *
  * \param gm     Game context.
  * \param score  Score to insert.
@@ -1878,28 +1659,99 @@ void blockblaster_insert_high_score(GameContext *gm, long score, int combo,
     if (pos >= MAX_HIGH_SCORES)
         return; /* Didn't make the top 5 */
 
-    /* Shift lower entries down */
+    /* Shift lower entries down; a full table drops its last entry, and
+       that entry's replay unless another entry still uses the file. */
     int new_count = gm->high_score_count + 1;
-    if (new_count > MAX_HIGH_SCORES)
+    if (new_count > MAX_HIGH_SCORES) {
         new_count = MAX_HIGH_SCORES;
+        uint64_t seed = gm->high_scores[MAX_HIGH_SCORES - 1].replay_seed;
+        bool shared = false;
+        for (int i = 0; i < MAX_HIGH_SCORES - 1; i++)
+            shared = shared || gm->high_scores[i].replay_seed == seed;
+        if (seed != 0 && !shared)
+            remove_score_replay(seed);
+    }
     for (int i = new_count - 1; i > pos; i--)
         gm->high_scores[i] = gm->high_scores[i - 1];
 
     /* Insert */
-    gm->high_scores[pos].grid_w = GRID_W;
-    gm->high_scores[pos].grid_h = GRID_H;
-    gm->high_scores[pos].tray_count = PIECES_PER_SET;
+    gm->high_scores[pos].grid_w = gm->grid_w;
+    gm->high_scores[pos].grid_h = gm->grid_h;
+    gm->high_scores[pos].tray_count = gm->tray_count;
     gm->high_scores[pos].score = score;
     gm->high_scores[pos].highest_combo = combo;
     snprintf(gm->high_scores[pos].name, sizeof(gm->high_scores[pos].name), "%s",
              name);
 
+    /* Keep the game's replay alongside the entry, named by its seed. */
+    gm->high_scores[pos].replay_seed = 0;
+    if (!gm->replay.lost && gm->replay.score == score) {
+        char file[64];
+        snprintf(file, sizeof(file), REPLAY_SCORE_FILENAME_FMT,
+                 (unsigned long long) gm->replay.seed);
+        if (blockblaster_save_replay(&gm->replay, file))
+            gm->high_scores[pos].replay_seed = gm->replay.seed;
+    }
+
     gm->high_score_count = new_count;
 
     /* Update derived high_score */
     gm->high_score = gm->high_scores[0].score;
 }
 
+/**
+ * \brief Write the encoded replay of a game to disk.
+ *
+ * Replays whose recording was cut short (out of memory) are not written.
+ *
+ * \param r         Replay of a finished game.
+ * \param filename  File name inside the save directory.
+ * \return          true if the file was written.
+ */
+bool blockblaster_save_replay(const Replay *r, const char *filename)
+{
+    if (r->lost)
+        return false;
+    size_t len = blockblaster_replay_size(r);
+    uint8_t *buf = malloc(len);
+    if (!buf)
+        return false;
+    blockblaster_replay_encode(r, buf);
+
+    bool ok = false;
+#ifdef ALLEGRO_ANDROID
+    al_set_standard_file_interface();
+    ALLEGRO_PATH *path = al_get_standard_path(ALLEGRO_USER_DATA_PATH);
+    al_set_path_filename(path, filename);
+    ALLEGRO_FILE *af = al_fopen(al_path_cstr(path, '/'), "wb");
+    al_destroy_path(path);
+    if (af) {
+        ok = al_fwrite(af, buf, len) == len;
+        al_fclose(af);
+    }
+    al_android_set_apk_file_interface();
+#else
+    char path[512];
+    snprintf(path, sizeof(path), "%s%s", SAVE_DIR, filename);
+    FILE *f = fopen(path, "wb");
+    if (f) {
+        ok = fwrite(buf, 1, len, f) == len;
+        ok = fclose(f) == 0 && ok;
+    }
+#endif
+    free(buf);
+
+#ifdef __EMSCRIPTEN__
+    emscripten_save_flush_internal();
+#endif
+    if (ok)
+        n_log(LOG_INFO, "Replay saved: %s (%d moves, score %ld)", filename,
+              r->count, r->score);
+    else
+        n_log(LOG_ERR, "Could not save replay %s", filename);
+    return ok;
+}
+
 /**
  * \brief Persist the sound on/off state to disk.
  *
@@ -2067,12 +1919,16 @@ void blockblaster_load_player_name(char *out, size_t out_sz)
 /* ======================================================================== */
 
 /**
- * \brief Persist the tray count and grid size settings to disk.
+ * \brief Persist the tray count, grid size, fair tray and undo settings to
+ *        disk.
  *
  * \param tray_count  Number of pieces per tray set (1 - 4).
  * \param grid_size   Grid side length (10, 15, or 20).
+ * \param fair_tray   True to only deal sets that can be placed in full.
+ * \param undo        True to allow undo / redo in new games.
  */
-void blockblaster_save_settings(int tray_count, int grid_size)
+void blockblaster_save_settings(int tray_count, int grid_size, bool fair_tray,
+                                bool undo)
 {
 #ifdef ALLEGRO_ANDROID
     al_set_standard_file_interface();
@@ -2085,7 +1941,8 @@ void blockblaster_save_settings(int tray_count, int grid_size)
         return;
     }
     char buf[32];
-    int len = snprintf(buf, sizeof(buf), "%d %d\n", tray_count, grid_size);
+    int len = snprintf(buf, sizeof(buf), "%d %d %d %d\n", tray_count,
+                       grid_size, fair_tray ? 1 : 0, undo ? 1 : 0);
     al_fwrite(f, buf, len);
     al_fclose(f);
     al_android_set_apk_file_interface();
@@ -2095,28 +1952,38 @@ void blockblaster_save_settings(int tray_count, int grid_size)
     FILE *f = fopen(path, "w");
     if (!f)
         return;
-    fprintf(f, "%d %d\n", tray_count, grid_size);
+    fprintf(f, "%d %d %d %d\n", tray_count, grid_size, fair_tray ? 1 : 0,
+            undo ? 1 : 0);
     fclose(f);
 #endif
 
 #ifdef __EMSCRIPTEN__
     emscripten_save_flush_internal();
 #endif
-    n_log(LOG_INFO, "Settings saved: tray=%d grid=%d", tray_count, grid_size);
+    n_log(LOG_INFO, "Settings saved: tray=%d grid=%d fair=%d undo=%d",
+          tray_count, grid_size, fair_tray ? 1 : 0, undo ? 1 : 0);
 }
 
 /**
- * \brief Load the tray count and grid size settings from disk.
+ * \brief Load the tray count, grid size, fair tray and undo settings from
+ *        disk.
  *
- * On failure or out-of-range values, defaults (tray=4, grid=10) are used.
+ * On failure or out-of-range values, defaults (tray=4, grid=10, fair and
+ * undo off) are used.  Files written before the fair tray and undo
+ * settings existed hold only the first two or three values.
  *
  * \param tray_count  Output: number of pieces per set.
  * \param grid_size   Output: grid side length.
+ * \param fair_tray   Output: fair tray dealing enabled.
+ * \param undo        Output: undo / redo allowed.
  */
-void blockblaster_load_settings(int *tray_count, int *grid_size)
+void blockblaster_load_settings(int *tray_count, int *grid_size,
+                                bool *fair_tray, bool *undo)
 {
     *tray_count = 4;
     *grid_size = 10;
+    *fair_tray = false;
+    *undo = false;
 
 #ifdef ALLEGRO_ANDROID
     al_set_standard_file_interface();
@@ -2132,10 +1999,12 @@ void blockblaster_load_settings(int *tray_count, int *grid_size)
     al_fread(f, buf, sizeof(buf) - 1);
     al_fclose(f);
     al_android_set_apk_file_interface();
-    int tc = 4, gs = 10;
-    if (sscanf(buf, "%d %d", &tc, &gs) >= 2) {
+    int tc = 4, gs = 10, ft = 0, un = 0;
+    if (sscanf(buf, "%d %d %d %d", &tc, &gs, &ft, &un) >= 2) {
         *tray_count = tc;
         *grid_size = gs;
+        *fair_tray = ft != 0;
+        *undo = un != 0;
     }
 #else
     char path[512];
@@ -2143,10 +2012,12 @@ void blockblaster_load_settings(int *tray_count, int *grid_size)
     FILE *f = fopen(path, "r");
     if (!f)
         return;
-    int tc = 4, gs = 10;
-    if (fscanf(f, "%d %d", &tc, &gs) >= 2) {
+    int tc = 4, gs = 10, ft = 0, un = 0;
+    if (fscanf(f, "%d %d %d %d", &tc, &gs, &ft, &un) >= 2) {
         *tray_count = tc;
         *grid_size = gs;
+        *fair_tray = ft != 0;
+        *undo = un != 0;
     }
     fclose(f);
 #endif
@@ -2159,22 +2030,26 @@ void blockblaster_load_settings(int *tray_count, int *grid_size)
     if (*grid_size != 10 && *grid_size != 15 && *grid_size != 20)
         *grid_size = 10;
 
-    n_log(LOG_INFO, "Settings loaded: tray=%d grid=%d", *tray_count,
-          *grid_size);
+    n_log(LOG_INFO, "Settings loaded: tray=%d grid=%d fair=%d undo=%d",
+          *tray_count, *grid_size, *fair_tray ? 1 : 0, *undo ? 1 : 0);
 }
 
 /**
- * \brief Apply the persisted settings to the runtime grid/tray globals.
+ * \brief Apply the persisted settings to the context's board layout.
  *
- * Must be called before starting a new game so that GRID_W, GRID_H and
- * PIECES_PER_SET reflect the player's choices.
+ * Must be called before starting a new game so that gm->grid_w, gm->grid_h,
+ * gm->tray_count and the core's fair tray mode reflect the player's choices.
+ * Marks the background layer for a rebuild, as the grid and tray change.
  *
- * \param gm  Game context containing setting_tray_count and
- * setting_grid_size.
+ * \param gm  Game context containing setting_tray_count,
+ * setting_grid_size and setting_fair_tray.
  */
 void blockblaster_apply_settings(GameContext *gm)
 {
-    PIECES_PER_SET = gm->setting_tray_count;
-    GRID_W = gm->setting_grid_size;
-    GRID_H = gm->setting_grid_size;
+    gm->tray_count = gm->setting_tray_count;
+    gm->grid_w = gm->setting_grid_size;
+    gm->grid_h = gm->setting_grid_size;
+    gm->core.fair_tray = gm->setting_fair_tray;
+    gm->core.fair_budget_us = FAIR_TRAY_BUDGET_US;
+    gm->background.dirty = true;
 }
@@ -15,13 +15,9 @@ extern "C" {
 #include "blockblaster_context.h"
 
 /* ---- Utility ---- */
-int blockblaster_irand(int a, int b);
-float blockblaster_frand01(void);
-float blockblaster_frand(float a, float b);
 float blockblaster_clampf(float v, float lo, float hi);
 float blockblaster_smoothstep(float t);
 float blockblaster_lerpf(float a, float b, float t);
-void blockblaster_shuffle_ints(int *a, int n);
 
 /* ---- Platform ---- */
 void blockblaster_get_data_path(const char *ressource, char *out,
@@ -37,40 +33,17 @@ void blockblaster_android_hide_keyboard(void);
 
 /* ---- Theme ---- */
 void blockblaster_init_themes(Theme out[THEMES_COUNT]);
-Theme blockblaster_random_theme(GameContext *gm);
-
-/* ---- Grid ---- */
-void blockblaster_grid_clear(Grid *g);
-bool blockblaster_shape_cell(const Shape *s, int x, int y);
-bool blockblaster_can_place_at(const Grid *g, const Shape *s, int gx, int gy);
-bool blockblaster_any_valid_placement(const Grid *g, const Shape *s);
-void blockblaster_place_shape(Grid *g, const Shape *s, int gx, int gy,
-                              Theme theme);
-int blockblaster_build_clear_mask(const Grid *g,
-                                  bool out_mask[GRID_H_MAX][GRID_W_MAX]);
-int blockblaster_count_cells_in_mask(const Grid *g,
-                                     bool mask[GRID_H_MAX][GRID_W_MAX]);
-void blockblaster_apply_clear_mask(Grid *g, bool mask[GRID_H_MAX][GRID_W_MAX]);
 
 /* ---- Piece / tray ---- */
-void blockblaster_refill_tray(GameContext *gm);
-bool blockblaster_tray_all_used(const GameContext *gm);
-bool blockblaster_none_placeable(const GameContext *gm);
-void blockblaster_random_fill(Grid *g, int count);
-void blockblaster_tray_piece_rect(int i, float *x1, float *y1, float *x2,
-                                  float *y2);
-void blockblaster_compute_grab_cell(const Shape *s, float rect_w, float rect_h,
-                                    float local_x, float local_y, int *out_sx,
-                                    int *out_sy);
-
-/* ---- Score ---- */
-int blockblaster_score_move(GameContext *gm, int placed_cells,
-                            int lines_cleared, int cleared_cells,
-                            int *out_clear_gain, float *out_mult);
+void blockblaster_tray_piece_rect(const GameContext *gm, int i, float *x1,
+                                  float *y1, float *x2, float *y2);
+void blockblaster_compute_grab_cell(const GameContext *gm, const Shape *s,
+                                    float rect_w, float rect_h, float local_x,
+                                    float local_y, int *out_sx, int *out_sy);
 
 /* ---- Animation ---- */
-void blockblaster_begin_clear(GameContext *gm,
-                              bool mask[GRID_H_MAX][GRID_W_MAX]);
+void blockblaster_begin_clear(GameContext *gm, uint32_t full_rows,
+                              uint32_t full_cols);
 void blockblaster_finish_clear(GameContext *gm);
 void blockblaster_start_return(GameContext *gm, int tray_index);
 void blockblaster_clear_predicted(GameContext *gm);
@@ -93,9 +66,24 @@ void blockblaster_spawn_bonus_popup(GameContext *gm, float x, float y,
 void blockblaster_start_combo_popup(GameContext *gm, float mult, Theme theme);
 
 /* ---- Game flow ---- */
+void blockblaster_init_context(GameContext *gm);
 void blockblaster_start_game(GameContext *gm, int mode);
 void blockblaster_set_gameover(GameContext *gm);
 
+/* ---- Hints ---- */
+void blockblaster_refresh_hint(GameContext *gm);
+void blockblaster_toggle_hint(GameContext *gm);
+
+/* ---- Undo ---- */
+void blockblaster_undo_move(GameContext *gm);
+void blockblaster_redo_move(GameContext *gm);
+
+/* ---- Replay view ---- */
+bool blockblaster_show_replay_move(GameContext *gm, int move);
+void blockblaster_enter_replay_view(GameContext *gm);
+void blockblaster_leave_replay_view(GameContext *gm);
+void blockblaster_update_replay_view(GameContext *gm, float dt);
+
 /* ---- View ---- */
 void blockblaster_update_view_offset(GameContext *gm);
 void blockblaster_screen_to_virtual(const GameContext *gm, float sx, float sy,
@@ -106,12 +94,15 @@ void blockblaster_save_high_scores(const GameContext *gm);
 void blockblaster_load_high_scores(GameContext *gm);
 void blockblaster_insert_high_score(GameContext *gm, long score, int combo,
                                     const char *name);
+bool blockblaster_save_replay(const Replay *r, const char *filename);
 void blockblaster_save_sound_state(bool on);
 bool blockblaster_load_sound_state(void);
 void blockblaster_save_player_name(const char *name);
 void blockblaster_load_player_name(char *out, size_t out_sz);
-void blockblaster_save_settings(int tray_count, int grid_size);
-void blockblaster_load_settings(int *tray_count, int *grid_size);
+void blockblaster_save_settings(int tray_count, int grid_size, bool fair_tray,
+                                bool undo);
+void blockblaster_load_settings(int *tray_count, int *grid_size,
+                                bool *fair_tray, bool *undo);
 void blockblaster_apply_settings(GameContext *gm);
 
 #if defined(__EMSCRIPTEN__)
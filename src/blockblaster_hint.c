@@ -0,0 +1,246 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_hint.c
+ * \brief Background hint engine implementation.
+ *
+ * Hand-over between the two threads:
+ *  - snapshots go main -> worker under a mutex held only for the copy, and
+ *    posting one raises `cancel`, which the solver polls once per node;
+ *  - results go worker -> main through three HintResult buffers: the worker
+ *    fills `back`, then atomically swaps it with `middle` and flags it
+ *    fresh; the main thread swaps a fresh `middle` with `front` when it
+ *    polls.  Neither side ever waits for the other.
+ */
+
+#include "blockblaster_hint.h"
+
+#include "nilorea/n_log.h"
+
+#include <allegro5/allegro.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Bits of HintEngine.middle: buffer index, and the fresh flag set when the
+   worker publishes and cleared when the main thread takes the buffer. */
+#define HINT_INDEX 3
+#define HINT_FRESH 4
+
+/** \brief Hint engine state (see blockblaster_hint.h). */
+struct HintEngine {
+    Solver solver;          /* Owned by the worker thread. */
+    CoreGame work;          /* Worker's copy of the snapshot being solved. */
+    ALLEGRO_THREAD *thread; /* Worker, or NULL to solve inline. */
+    ALLEGRO_MUTEX *mutex;   /* Guards snapshot, snapshot_seq, pending, quit. */
+    ALLEGRO_COND *cond;     /* Signalled when pending or quit is raised. */
+    CoreGame snapshot;      /* Latest posted game. */
+    uint32_t snapshot_seq;  /* Number of the latest posted game. */
+    bool pending;           /* Snapshot not picked up by the worker yet. */
+    bool quit;              /* Worker must exit. */
+    int cancel;             /* Non-zero stops the running search (atomic). */
+
+    HintResult buf[3]; /* Triple buffer of results. */
+    int back;          /* Buffer the worker fills next. */
+    int middle;        /* Last published buffer | HINT_FRESH (atomic). */
+    int front;         /* Buffer the main thread reads. */
+    uint32_t seq;      /* Main thread: number of the current board, 0 when no
+                          hint is wanted. */
+};
+
+/* Solve c for the best tray order and the best anchor of every unused
+   slot.  Returns false if the search was cancelled half-way. */
+static bool hint_compute(Solver *s, const CoreGame *c, uint32_t seq,
+                         HintResult *out)
+{
+    SolverResult r;
+    memset(out, 0, sizeof(*out));
+    out->seq = seq;
+
+    s->root_slot = -1;
+    if (!blockblaster_solver_solve(s, c, &r))
+        return !s->aborted;
+    out->order_count = r.count;
+    memcpy(out->order, r.moves, sizeof(r.moves[0]) * (size_t) r.count);
+    out->has_anchor[r.moves[0].slot] = true;
+    out->anchor[r.moves[0].slot] = r.moves[0];
+
+    /* Other slots: best sequence when the player starts with that one. */
+    for (int i = 0; i < c->tray_count; i++) {
+        if (c->tray[i].used || out->has_anchor[i])
+            continue;
+        s->root_slot = i;
+        bool ok = blockblaster_solver_solve(s, c, &r);
+        s->root_slot = -1;
+        if (s->aborted)
+            return false;
+        if (ok) {
+            out->has_anchor[i] = true;
+            out->anchor[i] = r.moves[0];
+        }
+    }
+    return true;
+}
+
+/* Publish buf[back] and take the previous middle buffer as the new back. */
+static void hint_publish(HintEngine *h)
+{
+    h->back = __atomic_exchange_n(&h->middle, h->back | HINT_FRESH,
+                                  __ATOMIC_ACQ_REL) &
+              HINT_INDEX;
+}
+
+/* Worker: wait for a snapshot, solve it, publish, repeat. */
+static void *hint_worker(ALLEGRO_THREAD *thread, void *arg)
+{
+    (void) thread;
+    HintEngine *h = arg;
+
+    for (;;) {
+        al_lock_mutex(h->mutex);
+        while (!h->pending && !h->quit)
+            al_wait_cond(h->cond, h->mutex);
+        if (h->quit) {
+            al_unlock_mutex(h->mutex);
+            break;
+        }
+        h->work = h->snapshot;
+        uint32_t seq = h->snapshot_seq;
+        h->pending = false;
+        __atomic_store_n(&h->cancel, 0, __ATOMIC_RELAXED);
+        al_unlock_mutex(h->mutex);
+
+        if (hint_compute(&h->solver, &h->work, seq, &h->buf[h->back]))
+            hint_publish(h);
+    }
+    return NULL;
+}
+
+/**
+ * \brief Create a hint engine and start its worker thread.
+ *
+ * \return  The engine, or NULL if its solver could not be allocated.
+ */
+HintEngine *blockblaster_hint_create(void)
+{
+    HintEngine *h = calloc(1, sizeof(*h));
+    if (!h)
+        return NULL;
+    if (!blockblaster_solver_init(&h->solver, SOLVER_TT_BITS_DEFAULT)) {
+        free(h);
+        return NULL;
+    }
+    h->solver.cancel = &h->cancel;
+    h->front = 0;
+    h->middle = 1;
+    h->back = 2;
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+    h->mutex = al_create_mutex();
+    h->cond = al_create_cond();
+    if (h->mutex && h->cond)
+        h->thread = al_create_thread(hint_worker, h);
+    if (h->thread)
+        al_start_thread(h->thread);
+#endif
+    if (!h->thread)
+        n_log(LOG_INFO, "Hint engine: no worker thread, solving inline");
+    return h;
+}
+
+/**
+ * \brief Stop the worker thread and release the engine.
+ *
+ * \param h  Engine from blockblaster_hint_create(), or NULL.
+ */
+void blockblaster_hint_destroy(HintEngine *h)
+{
+    if (!h)
+        return;
+    if (h->thread) {
+        al_lock_mutex(h->mutex);
+        h->quit = true;
+        __atomic_store_n(&h->cancel, 1, __ATOMIC_RELAXED);
+        al_signal_cond(h->cond);
+        al_unlock_mutex(h->mutex);
+        al_destroy_thread(h->thread);
+    }
+    if (h->cond)
+        al_destroy_cond(h->cond);
+    if (h->mutex)
+        al_destroy_mutex(h->mutex);
+    blockblaster_solver_free(&h->solver);
+    free(h);
+}
+
+/**
+ * \brief Post the current board: cancel the running search and start a new
+ *        one on a snapshot of c.
+ *
+ * Only the snapshot copy happens on the calling thread.  Results for
+ * earlier boards are no longer returned by blockblaster_hint_poll().
+ *
+ * \param h  Engine (NULL is ignored).
+ * \param c  Game to solve; copied, so it may change right after the call.
+ */
+void blockblaster_hint_request(HintEngine *h, const CoreGame *c)
+{
+    if (!h)
+        return;
+    if (++h->seq == 0)
+        h->seq = 1;
+
+    if (!h->thread) {
+        if (hint_compute(&h->solver, c, h->seq, &h->buf[h->back]))
+            hint_publish(h);
+        return;
+    }
+
+    al_lock_mutex(h->mutex);
+    __atomic_store_n(&h->cancel, 1, __ATOMIC_RELAXED);
+    h->snapshot = *c;
+    h->snapshot_seq = h->seq;
+    h->pending = true;
+    al_signal_cond(h->cond);
+    al_unlock_mutex(h->mutex);
+}
+
+/**
+ * \brief Drop the current hint and stop the running search, e.g. while
+ *        cleared lines are still animating or once the game is over.
+ *
+ * \param h  Engine (NULL is ignored).
+ */
+void blockblaster_hint_cancel(HintEngine *h)
+{
+    if (!h)
+        return;
+    if (++h->seq == 0)
+        h->seq = 1;
+    if (!h->thread)
+        return;
+
+    al_lock_mutex(h->mutex);
+    __atomic_store_n(&h->cancel, 1, __ATOMIC_RELAXED);
+    h->pending = false;
+    al_unlock_mutex(h->mutex);
+}
+
+/**
+ * \brief Latest hint for the board last posted with
+ *        blockblaster_hint_request().  Never blocks.
+ *
+ * \param h  Engine (NULL is allowed).
+ * \return   The hint, valid until the next poll, or NULL while the search
+ *           for the current board is still running (or was cancelled).
+ */
+const HintResult *blockblaster_hint_poll(HintEngine *h)
+{
+    if (!h)
+        return NULL;
+    if (__atomic_load_n(&h->middle, __ATOMIC_ACQUIRE) & HINT_FRESH)
+        h->front =
+            __atomic_exchange_n(&h->middle, h->front, __ATOMIC_ACQ_REL) &
+            HINT_INDEX;
+    const HintResult *r = &h->buf[h->front];
+    return (r->seq != 0 && r->seq == h->seq) ? r : NULL;
+}
@@ -0,0 +1,51 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_hint.h
+ * \brief Background hint engine: best anchor and tray order for the player.
+ *
+ * The engine runs the tray-ordering solver on a worker thread against a
+ * snapshot of the running game.  The main loop posts a new snapshot after
+ * every move that changes the board, which cancels the search in progress,
+ * and polls for the latest result once per frame.  Neither call waits for
+ * the search: results are handed over through a lock-free triple buffer.
+ *
+ * When no worker thread can be started (e.g. a WebAssembly build without
+ * thread support) the engine solves inline when a snapshot is posted.
+ */
+
+#ifndef __BLOCKBLASTER_HINT__
+#define __BLOCKBLASTER_HINT__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "blockblaster_solver.h"
+
+/**
+ * \brief Hint for one board position.
+ */
+typedef struct {
+    uint32_t seq; /* Snapshot number this hint answers (0 = none yet). */
+    int order_count;                      /* Moves in the best tray order. */
+    PolicyMove order[PIECES_PER_SET_MAX]; /* Best tray order, play order. */
+    bool has_anchor[PIECES_PER_SET_MAX];  /* Slot fits somewhere. */
+    PolicyMove anchor[PIECES_PER_SET_MAX]; /* Best anchor for each slot when
+                                              that slot is played next. */
+} HintResult;
+
+/** \brief Hint engine (worker thread, solver and result buffers). */
+typedef struct HintEngine HintEngine;
+
+HintEngine *blockblaster_hint_create(void);
+void blockblaster_hint_destroy(HintEngine *h);
+void blockblaster_hint_request(HintEngine *h, const CoreGame *c);
+void blockblaster_hint_cancel(HintEngine *h);
+const HintResult *blockblaster_hint_poll(HintEngine *h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLOCKBLASTER_HINT__ */
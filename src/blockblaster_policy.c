@@ -0,0 +1,161 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_policy.c
+ * \brief Built-in placement policies (first fit, uniform random, greedy).
+ *
+ * Every policy enumerates legal moves straight from the placement maps:
+ * bit gx of c->place_map[slot][gy] is set when the slot's shape fits with
+ * its top-left corner at (gx, gy), and used slots have all-zero maps.
+ */
+
+#include "blockblaster_policy.h"
+
+#include <string.h>
+
+/* Greedy: score of one completed line, in units of the crowding term (at
+   most 2 * GRID_W_MAX per placed cell), so clearing always wins. */
+#define GREEDY_LINE_WEIGHT 4096
+
+/* ======================================================================== */
+/* Policies                                                                  */
+/* ======================================================================== */
+
+/* First legal anchor in slot, row, column order. */
+static bool policy_first(const CoreGame *c, Rng *r, PolicyMove *out)
+{
+    (void) r;
+    for (int i = 0; i < c->tray_count; i++) {
+        for (int gy = 0; gy < c->grid.h; gy++) {
+            uint32_t bits = c->place_map[i][gy];
+            if (bits) {
+                out->slot = i;
+                out->gx = __builtin_ctz(bits);
+                out->gy = gy;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* Uniformly random legal move over all (slot, anchor) pairs. */
+static bool policy_random(const CoreGame *c, Rng *r, PolicyMove *out)
+{
+    int n = blockblaster_policy_legal_moves(c);
+    if (n == 0)
+        return false;
+    int k = blockblaster_irand(r, 0, n - 1);
+    for (int i = 0; i < c->tray_count; i++) {
+        for (int gy = 0; gy < c->grid.h; gy++) {
+            uint32_t bits = c->place_map[i][gy];
+            int cnt = GRID_POPCOUNT(bits);
+            if (k >= cnt) {
+                k -= cnt;
+                continue;
+            }
+            while (k-- > 0)
+                bits &= bits - 1;
+            out->slot = i;
+            out->gx = __builtin_ctz(bits);
+            out->gy = gy;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Greedy value of placing m at (gx, gy): completed lines first, then how
+   crowded the rows and columns the shape lands on already are, which keeps
+   pieces packed against each other and the walls. */
+static int greedy_value(const Grid *g, const ShapeMask *m, int gx, int gy)
+{
+    int lines = 0;
+    for (int sy = m->min_y; sy <= m->max_y; sy++)
+        if ((g->rows[gy + sy] | (m->rows[sy] << gx)) == GRID_FULL_ROW(g))
+            lines++;
+    for (int sx = m->min_x; sx <= m->max_x; sx++)
+        if ((g->cols[gx + sx] | (m->cols[sx] << gy)) == GRID_FULL_COL(g))
+            lines++;
+
+    int crowd = 0;
+    for (int i = 0; i < m->cell_count; i++)
+        crowd += g->row_fill[gy + m->cells[i][1]] +
+                 g->col_fill[gx + m->cells[i][0]];
+    return lines * GREEDY_LINE_WEIGHT + crowd;
+}
+
+/* One-ply greedy: best greedy_value() over every legal move, ties broken
+   uniformly at random. */
+static bool policy_greedy(const CoreGame *c, Rng *r, PolicyMove *out)
+{
+    int best = -1;
+    int ties = 0;
+    for (int i = 0; i < c->tray_count; i++) {
+        const ShapeMask *m = &SHAPE_MASKS[c->tray[i].shape_id];
+        for (int gy = 0; gy < c->grid.h; gy++) {
+            for (uint32_t bits = c->place_map[i][gy]; bits;
+                 bits &= bits - 1) {
+                int gx = __builtin_ctz(bits);
+                int v = greedy_value(&c->grid, m, gx, gy);
+                if (v < best)
+                    continue;
+                if (v > best) {
+                    best = v;
+                    ties = 0;
+                }
+                /* Reservoir sampling over the moves tied for best. */
+                if (blockblaster_irand(r, 0, ties++) == 0) {
+                    out->slot = i;
+                    out->gx = gx;
+                    out->gy = gy;
+                }
+            }
+        }
+    }
+    return best >= 0;
+}
+
+/* ======================================================================== */
+/* Registry                                                                  */
+/* ======================================================================== */
+
+/** \brief Built-in policies; the first entry is the default. */
+const Policy POLICIES[] = {
+    {"greedy", "clear lines first, then pack into crowded rows/columns",
+     policy_greedy},
+    {"random", "uniformly random legal move", policy_random},
+    {"first", "first legal anchor in slot/row/column order", policy_first},
+};
+
+/** \brief Number of entries in POLICIES[]. */
+const int POLICIES_COUNT = (int) (sizeof(POLICIES) / sizeof(POLICIES[0]));
+
+/**
+ * \brief Count the legal moves (slot, anchor pairs) of a game.
+ *
+ * \param c  Game rules state.
+ * \return   Number of set bits over all placement maps.
+ */
+int blockblaster_policy_legal_moves(const CoreGame *c)
+{
+    int n = 0;
+    for (int i = 0; i < c->tray_count; i++)
+        for (int gy = 0; gy < c->grid.h; gy++)
+            n += GRID_POPCOUNT(c->place_map[i][gy]);
+    return n;
+}
+
+/**
+ * \brief Look up a policy by name.
+ *
+ * \param name  Policy name, e.g. "greedy".
+ * \return      The policy, or NULL if no policy has that name.
+ */
+const Policy *blockblaster_policy_find(const char *name)
+{
+    for (int i = 0; i < POLICIES_COUNT; i++)
+        if (strcmp(POLICIES[i].name, name) == 0)
+            return &POLICIES[i];
+    return NULL;
+}
@@ -0,0 +1,61 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_policy.h
+ * \brief Pluggable placement policies for headless play.
+ *
+ * A policy looks at a CoreGame and picks the next move: a tray slot and the
+ * anchor for the shape's top-left corner.  Policies only read the game
+ * (legal anchors come from CoreGame.place_map) and draw any randomness from
+ * the generator they are given, so a game driven by a policy replays
+ * exactly from its seeds.  New policies are added to POLICIES[].
+ */
+
+#ifndef __BLOCKBLASTER_POLICY__
+#define __BLOCKBLASTER_POLICY__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "blockblaster_core.h"
+
+/**
+ * \brief One move chosen by a policy.
+ */
+typedef struct {
+    int slot; /* Tray slot to place. */
+    int gx;   /* Grid column of the shape's top-left corner. */
+    int gy;   /* Grid row of the shape's top-left corner. */
+} PolicyMove;
+
+/**
+ * \brief Policy callback.
+ *
+ * \param c    Game to move in (not modified).
+ * \param r    Generator for any random choice the policy makes.
+ * \param out  Receives the chosen move.
+ * \return     false if no unused slot fits anywhere (the game is over).
+ */
+typedef bool (*PolicyFn)(const CoreGame *c, Rng *r, PolicyMove *out);
+
+/**
+ * \brief A named policy.
+ */
+typedef struct {
+    const char *name;        /* Short name used on command lines. */
+    const char *description; /* One-line summary for usage text. */
+    PolicyFn choose;         /* Move picker. */
+} Policy;
+
+extern const Policy POLICIES[];
+extern const int POLICIES_COUNT;
+
+int blockblaster_policy_legal_moves(const CoreGame *c);
+const Policy *blockblaster_policy_find(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLOCKBLASTER_POLICY__ */
@@ -9,9 +9,11 @@
 
 #include "blockblaster_game.h"
 #include "blockblaster_ui.h"
+#include "nilorea/n_log.h"
 
 #include <allegro5/allegro_primitives.h>
 #include <math.h>
+#include <stdlib.h>
 
 #if defined(__ANDROID__)
 #include <allegro5/allegro_android.h>
@@ -39,22 +41,354 @@ void blockblaster_draw_round_tile(float x1, float y1, float x2, float y2,
     al_draw_rounded_rectangle(x1, y1, x2, y2, r, r, stroke, width);
 }
 
+/* ======================================================================== */
+/* Tile atlas                                                                */
+/* ======================================================================== */
+
+/* How one kind of tile looks in one atlas row, in virtual pixels. */
+typedef struct {
+    ALLEGRO_COLOR fill;
+    ALLEGRO_COLOR stroke;
+    bool stroked;
+    float size;   /* Side of the tile. */
+    float radius; /* Corner radius. */
+} TileStyle;
+
+/* Style of tile kind in atlas row (a theme index or TILE_ROW_PLAIN), as
+   the grid, tray and floating piece draw it at the current layout. */
+static TileStyle tile_style(const GameContext *gm, int row, TileKind kind)
+{
+    Theme th;
+    if (row < THEMES_COUNT) {
+        th = gm->theme_table[row];
+    } else {
+        th.fill = al_map_rgb(120, 190, 255);
+        th.stroke = GRID_LINE_COLOR;
+    }
+    ALLEGRO_COLOR f = th.fill;
+    float cell = CELL(gm);
+    TileStyle st = {th.fill, th.stroke, true, cell * 0.84f, cell * 0.135f};
+
+    switch (kind) {
+    case TILE_CELL:
+        break;
+    case TILE_FLASH:
+        st.fill = al_map_rgba_f(1.0f, 0.85f, 0.45f, 1.0f);
+        break;
+    case TILE_GHOST:
+        st.fill = row < THEMES_COUNT ? al_map_rgba_f(f.r, f.g, f.b, 0.40f)
+                                     : al_map_rgba(255, 90, 90, 120);
+        st.stroked = false;
+        st.size = cell - 12.0f * UI_SCALE(gm);
+        break;
+    case TILE_PIECE:
+    case TILE_RETURN:
+        st.fill = al_map_rgba_f(f.r, f.g, f.b,
+                                kind == TILE_PIECE ? 0.85f : 0.65f);
+        st.size = cell;
+        st.radius = cell * 0.22f;
+        break;
+    case TILE_SHADOW:
+        st.fill = al_map_rgba(0, 0, 0, 90);
+        st.stroked = false;
+        st.size = cell;
+        st.radius = cell * 0.22f;
+        break;
+    default: { /* TILE_PREVIEW */
+        float pc = TRAY_BOX(gm) / 9.0f;
+        st.stroke = al_map_rgb(30, 30, 35);
+        st.size = pc * (1.0f - 2.0f * 0.055f);
+        st.radius = pc * 0.20f;
+        break;
+    }
+    }
+    return st;
+}
+
+/* Draw a tile of the given style over the rectangle (x1, y1, x2, y2) with
+   primitives; the radius follows the rectangle's size. */
+static void draw_tile_style(const GameContext *gm, const TileStyle *st,
+                            float x1, float y1, float x2, float y2)
+{
+    float r = st->radius * (x2 - x1) / st->size;
+    if (st->stroked)
+        blockblaster_draw_round_tile(x1, y1, x2, y2, r, st->fill, st->stroke,
+                                     ROUNDED_LINE_WIDTH(gm));
+    else
+        al_draw_filled_rounded_rectangle(x1, y1, x2, y2, r, r, st->fill);
+}
+
+/**
+ * \brief Release the tile atlas.
+ *
+ * \param gm  Game context.
+ */
+void blockblaster_tile_atlas_destroy(GameContext *gm)
+{
+    if (gm->tiles.bitmap)
+        al_destroy_bitmap(gm->tiles.bitmap);
+    gm->tiles.bitmap = NULL;
+}
+
+/* Rebuild the atlas if the layout changed since it was drawn.  On failure
+   the tiles are drawn with primitives until the next layout change. */
+static void update_tile_atlas(GameContext *gm)
+{
+    TileAtlas *a = &gm->tiles;
+    float cell = CELL(gm);
+    float tray_cell = TRAY_BOX(gm) / 9.0f;
+    /* A NULL bitmap with a matching layout is a failed build: keep the
+       primitive fallback rather than retrying every frame. */
+    if (!a->dirty && a->cell == cell && a->tray_cell == tray_cell &&
+        a->scale == gm->scale)
+        return;
+
+    blockblaster_tile_atlas_destroy(gm);
+    a->dirty = false;
+    a->cell = cell;
+    a->tray_cell = tray_cell;
+    a->scale = gm->scale;
+    a->pad = (int) ceilf(ROUNDED_LINE_WIDTH(gm) * gm->scale * 0.5f) + 1;
+
+    float largest = 0.0f;
+    for (int k = 0; k < TILE_KIND_COUNT; k++) {
+        a->size[k] = tile_style(gm, 0, (TileKind) k).size * gm->scale;
+        if (a->size[k] > largest)
+            largest = a->size[k];
+    }
+    a->slot = (int) ceilf(largest) + 2 * a->pad;
+
+    int flags = al_get_new_bitmap_flags();
+    al_set_new_bitmap_flags(flags | ALLEGRO_MIN_LINEAR | ALLEGRO_MAG_LINEAR);
+    a->bitmap =
+        al_create_bitmap(a->slot * TILE_KIND_COUNT, a->slot * TILE_ROWS);
+    al_set_new_bitmap_flags(flags);
+    if (!a->bitmap) {
+        n_log(LOG_ERR, "Could not create the %dx%d tile atlas.",
+              a->slot * TILE_KIND_COUNT, a->slot * TILE_ROWS);
+        return;
+    }
+
+    /* Same primitives and blender as the scene, so every texel holds what
+       drawing the tile straight onto the screen would have blended in. */
+    ALLEGRO_STATE state;
+    al_store_state(&state, ALLEGRO_STATE_TARGET_BITMAP);
+    al_set_target_bitmap(a->bitmap);
+    al_clear_to_color(al_map_rgba(0, 0, 0, 0));
+    ALLEGRO_TRANSFORM t;
+    al_identity_transform(&t);
+    al_scale_transform(&t, gm->scale, gm->scale);
+    al_use_transform(&t);
+    for (int row = 0; row < TILE_ROWS; row++) {
+        for (int k = 0; k < TILE_KIND_COUNT; k++) {
+            TileStyle st = tile_style(gm, row, (TileKind) k);
+            float x1 = (float) (k * a->slot + a->pad) / gm->scale;
+            float y1 = (float) (row * a->slot + a->pad) / gm->scale;
+            draw_tile_style(gm, &st, x1, y1, x1 + st.size, y1 + st.size);
+        }
+    }
+    al_restore_state(&state);
+}
+
+/* Draw tile kind of atlas row over the rectangle (x1, y1, x2, y2), from the
+   atlas when there is one. */
+static void draw_tile(const GameContext *gm, int row, TileKind kind, float x1,
+                      float y1, float x2, float y2)
+{
+    const TileAtlas *a = &gm->tiles;
+    if (!a->bitmap) {
+        TileStyle st = tile_style(gm, row, kind);
+        draw_tile_style(gm, &st, x1, y1, x2, y2);
+        return;
+    }
+    float src = a->size[kind] + 2.0f * (float) a->pad;
+    float k = (x2 - x1) / a->size[kind]; /* virtual pixels per texel */
+    float dx = x1 - (float) a->pad * k;
+    float dy = y1 - (float) a->pad * k;
+    /* A tile drawn at its atlas size lands on whole screen pixels, so its
+       texels are copied 1:1 instead of being filtered across two pixels.
+       Scaled tiles (pop, return) are resampled either way. */
+    if (fabsf(k * a->scale - 1.0f) < 0.001f) {
+        dx = roundf(dx * a->scale) / a->scale;
+        dy = roundf(dy * a->scale) / a->scale;
+    }
+    al_draw_scaled_bitmap(a->bitmap, (float) (kind * a->slot),
+                          (float) (row * a->slot), src, src, dx, dy, src * k,
+                          src * k, 0);
+}
+
+/* Hold bitmap drawing around a run of atlas tiles, so Allegro sends them
+   as one batch.  Primitives must not be drawn while held. */
+static void hold_tiles(const GameContext *gm, bool hold)
+{
+    if (gm->tiles.bitmap)
+        al_hold_bitmap_drawing(hold);
+}
+
+/* ======================================================================== */
+/* Background layer                                                          */
+/* ======================================================================== */
+
+/* Background panel and cell outlines of the grid. */
+static void draw_grid_background(const GameContext *gm)
+{
+    float margin = 10.0f * UI_SCALE(gm);
+    blockblaster_draw_round_tile(
+        GRID_X(gm) - margin, GRID_Y - margin,
+        GRID_X(gm) + gm->grid_w * CELL(gm) + margin,
+        GRID_Y + gm->grid_h * CELL(gm) + margin, 10.0f * UI_SCALE(gm),
+        al_map_rgb(20, 20, 26), GRID_LINE_COLOR, GRID_LINE_WIDTH(gm));
+
+    for (int y = 0; y < gm->grid_h; y++) {
+        for (int x = 0; x < gm->grid_w; x++) {
+            float x1 = GRID_X(gm) + x * CELL(gm);
+            float y1 = GRID_Y + y * CELL(gm);
+            al_draw_rectangle(x1, y1, x1 + CELL(gm), y1 + CELL(gm),
+                              GRID_LINE_COLOR, GRID_LINE_WIDTH(gm));
+        }
+    }
+}
+
+/* Empty tray slot boxes and the label above them. */
+static void draw_tray_background(const GameContext *gm)
+{
+    for (int i = 0; i < gm->tray_count; i++) {
+        float x1, y1, x2, y2;
+        blockblaster_tray_piece_rect(gm, i, &x1, &y1, &x2, &y2);
+        blockblaster_draw_round_tile(x1, y1, x2, y2, 12.0f * UI_SCALE(gm),
+                                     al_map_rgb(22, 22, 28), GRID_LINE_COLOR,
+                                     GRID_LINE_WIDTH(gm));
+    }
+    al_draw_textf(gm->font, al_map_rgb(220, 220, 235), GRID_X(gm),
+                  TRAY_Y(gm) - 34, 0, "Pieces (drag onto grid):");
+}
+
+/**
+ * \brief Release the cached background layer.
+ *
+ * \param gm  Game context.
+ */
+void blockblaster_background_destroy(GameContext *gm)
+{
+    BackgroundPart *parts[] = {&gm->background.grid, &gm->background.tray};
+    for (int i = 0; i < 2; i++) {
+        if (parts[i]->bitmap)
+            al_destroy_bitmap(parts[i]->bitmap);
+        parts[i]->bitmap = NULL;
+    }
+}
+
+/* Render draw() over the virtual rectangle (x1, y1, x2, y2) into a new
+   bitmap of part.  The rectangle is widened to whole screen pixels so the
+   bitmap lands on the pixel grid and blits without resampling.  On failure
+   the part stays empty and is drawn directly. */
+static void build_background_part(const GameContext *gm, BackgroundPart *part,
+                                  float x1, float y1, float x2, float y2,
+                                  void (*draw)(const GameContext *gm))
+{
+    float s = gm->scale;
+    float px = floorf(x1 * s);
+    float py = floorf(y1 * s);
+    int bw = (int) ceilf(x2 * s - px);
+    int bh = (int) ceilf(y2 * s - py);
+    part->x = px / s;
+    part->y = py / s;
+    part->w = (float) bw / s;
+    part->h = (float) bh / s;
+
+    part->bitmap = al_create_bitmap(bw, bh);
+    if (!part->bitmap) {
+        n_log(LOG_ERR, "Could not create a %dx%d background bitmap.", bw, bh);
+        return;
+    }
+
+    /* Same primitives and blender as the scene, as for the tile atlas. */
+    ALLEGRO_STATE state;
+    al_store_state(&state, ALLEGRO_STATE_TARGET_BITMAP);
+    al_set_target_bitmap(part->bitmap);
+    al_clear_to_color(al_map_rgba(0, 0, 0, 0));
+    ALLEGRO_TRANSFORM t;
+    al_identity_transform(&t);
+    al_translate_transform(&t, -part->x, -part->y);
+    al_scale_transform(&t, s, s);
+    al_use_transform(&t);
+    draw(gm);
+    al_restore_state(&state);
+}
+
+/* Rebuild the background layer if it was invalidated or the layout it was
+   drawn for changed.  A part whose bitmap could not be created stays NULL
+   and is drawn directly until then, without retrying every frame. */
+static void update_background(GameContext *gm)
+{
+    BackgroundLayer *b = &gm->background;
+    if (!b->dirty && b->cell == CELL(gm) && b->scale == gm->scale &&
+        b->grid_w == gm->grid_w && b->grid_h == gm->grid_h &&
+        b->tray_count == gm->tray_count)
+        return;
+
+    blockblaster_background_destroy(gm);
+    b->dirty = false;
+    b->cell = CELL(gm);
+    b->scale = gm->scale;
+    b->grid_w = gm->grid_w;
+    b->grid_h = gm->grid_h;
+    b->tray_count = gm->tray_count;
+
+    /* Half the outline spills past each rectangle, plus a pixel of
+       antialiasing. */
+    float pad = GRID_LINE_WIDTH(gm) * 0.5f + 1.0f / gm->scale;
+    float margin = 10.0f * UI_SCALE(gm) + pad;
+    build_background_part(gm, &b->grid, GRID_X(gm) - margin, GRID_Y - margin,
+                          GRID_X(gm) + gm->grid_w * CELL(gm) + margin,
+                          GRID_Y + gm->grid_h * CELL(gm) + margin,
+                          draw_grid_background);
+
+    float label_y = TRAY_Y(gm) - 34;
+    float bottom = TRAY_Y(gm) + TRAY_BOX(gm);
+    if (gm->font && label_y + al_get_font_line_height(gm->font) > bottom)
+        bottom = label_y + al_get_font_line_height(gm->font);
+    build_background_part(gm, &b->tray, 0.0f, label_y - pad,
+                          (float) gm->win_w, bottom + pad,
+                          draw_tray_background);
+}
+
+/* Blit part, or draw it directly when it has no bitmap. */
+static void draw_background_part(const GameContext *gm,
+                                 const BackgroundPart *part,
+                                 void (*draw)(const GameContext *gm))
+{
+    if (!part->bitmap) {
+        draw(gm);
+        return;
+    }
+    al_draw_scaled_bitmap(part->bitmap, 0.0f, 0.0f,
+                          (float) al_get_bitmap_width(part->bitmap),
+                          (float) al_get_bitmap_height(part->bitmap), part->x,
+                          part->y, part->w, part->h, 0);
+}
+
+/* ======================================================================== */
+/* Scene                                                                     */
+/* ======================================================================== */
+
 /**
  * \brief Draw a small shape preview (used in the tray display).
  *
- * Each filled cell of the shape is rendered as a rounded tile at the given
- * cell size, inset slightly from its neighbours.
+ * Each filled cell of the shape is drawn as a TILE_PREVIEW tile of the
+ * theme at the given cell size, inset slightly from its neighbours.
  *
- * \param s     Shape to draw.
- * \param px    X origin of the preview (top-left corner).
- * \param py    Y origin of the preview (top-left corner).
- * \param cell  Size of each cell in pixels.
- * \param col   Fill colour for the cells.
+ * \param gm     Game context (tile atlas).
+ * \param s      Shape to draw.
+ * \param px     X origin of the preview (top-left corner).
+ * \param py     Y origin of the preview (top-left corner).
+ * \param cell   Size of each cell in pixels.
+ * \param theme  Theme index of the cells.
  */
-void blockblaster_draw_shape_preview(const Shape *s, float px, float py,
-                                     float cell, ALLEGRO_COLOR col)
+void blockblaster_draw_shape_preview(const GameContext *gm, const Shape *s,
+                                     float px, float py, float cell,
+                                     int theme)
 {
-    float r = cell * 0.20f;
     float gap = cell * 0.055f;
     for (int y = 0; y < s->h; y++) {
         for (int x = 0; x < s->w; x++) {
@@ -64,9 +398,38 @@ void blockblaster_draw_shape_preview(const Shape *s, float px, float py,
             float y1 = py + y * cell;
             float x2 = x1 + cell;
             float y2 = y1 + cell;
-            blockblaster_draw_round_tile(x1 + gap, y1 + gap, x2 - gap, y2 - gap,
-                                         r, col, al_map_rgb(30, 30, 35),
-                                         ROUNDED_LINE_WIDTH);
+            draw_tile(gm, theme, TILE_PREVIEW, x1 + gap, y1 + gap, x2 - gap,
+                      y2 - gap);
+        }
+    }
+}
+
+/* Outline piece p anchored at (gx, gy) in the hint colour; label > 0 is
+   drawn in the shape's first cell. */
+static void draw_hint_piece(const GameContext *gm, const Piece *p, int gx,
+                            int gy, int label)
+{
+    float inset = 3.0f * UI_SCALE(gm);
+    bool labelled = false;
+    for (int sy = 0; sy < p->shape.h; sy++) {
+        for (int sx = 0; sx < p->shape.w; sx++) {
+            if (!blockblaster_shape_cell(&p->shape, sx, sy))
+                continue;
+            float x1 = GRID_X(gm) + (gx + sx) * CELL(gm);
+            float y1 = GRID_Y + (gy + sy) * CELL(gm);
+            float x2 = x1 + CELL(gm);
+            float y2 = y1 + CELL(gm);
+            blockblaster_draw_round_tile(x1 + inset, y1 + inset, x2 - inset,
+                                         y2 - inset, CELL(gm) * 0.135f,
+                                         al_map_rgba(0, 0, 0, 0), HINT_COLOR,
+                                         ROUNDED_LINE_WIDTH(gm));
+            if (label > 0 && !labelled) {
+                float ty =
+                    (y1 + y2 - al_get_font_line_height(gm->font)) * 0.5f;
+                al_draw_textf(gm->font, HINT_COLOR, (x1 + x2) * 0.5f, ty,
+                              ALLEGRO_ALIGN_CENTER, "%d", label);
+                labelled = true;
+            }
         }
     }
 }
@@ -78,182 +441,190 @@ void blockblaster_draw_shape_preview(const Shape *s, float px, float py,
  * Occupied cells render with their assigned theme colour, applying a flash
  * tint during the clear animation and a pop scale on recent placements.
  * The ghost preview overlay shows where the dragged piece would land,
- * tinted green or red depending on placement validity.
+ * tinted green or red depending on placement validity.  With hints on, the
+ * best anchor for the dragged piece (or, between drags, the numbered best
+ * tray order) is outlined from the latest hint engine result.  The panel
+ * and cell outlines are blitted from the cached background layer.
  *
  * \param gm  Game context.
  */
 void blockblaster_draw_grid(const GameContext *gm)
 {
-    float margin = 10.0f * UI_SCALE;
-
-    /* Background panel */
-    blockblaster_draw_round_tile(
-        GRID_X - margin, GRID_Y - margin, GRID_X + GRID_W * CELL + margin,
-        GRID_Y + GRID_H * CELL + margin, 10.0f * UI_SCALE,
-        al_map_rgb(20, 20, 26), GRID_LINE_COLOR, GRID_LINE_WIDTH);
+    /* Background panel and cell outlines */
+    draw_background_part(gm, &gm->background.grid, draw_grid_background);
 
     /* Predicted-clear highlight */
     if (gm->dragging && gm->can_drop_preview && gm->has_predicted_clear) {
-        Theme th = gm->tray[gm->dragging_index].theme;
+        int ti = gm->core.tray[gm->dragging_index].theme;
+        Theme th = gm->theme_table[ti];
         ALLEGRO_COLOR rowc =
             al_map_rgba_f(th.fill.r, th.fill.g, th.fill.b, 0.10f);
         ALLEGRO_COLOR colc =
             al_map_rgba_f(th.fill.r, th.fill.g, th.fill.b, 0.10f);
 
-        for (int y = 0; y < GRID_H; y++) {
+        for (int y = 0; y < gm->grid_h; y++) {
             if (!gm->pred_full_row[y])
                 continue;
-            float y1 = GRID_Y + y * CELL;
-            float y2 = y1 + CELL;
-            al_draw_filled_rectangle(GRID_X, y1, GRID_X + GRID_W * CELL, y2,
+            float y1 = GRID_Y + y * CELL(gm);
+            float y2 = y1 + CELL(gm);
+            al_draw_filled_rectangle(GRID_X(gm), y1,
+                                     GRID_X(gm) + gm->grid_w * CELL(gm), y2,
                                      rowc);
         }
-        for (int x = 0; x < GRID_W; x++) {
+        for (int x = 0; x < gm->grid_w; x++) {
             if (!gm->pred_full_col[x])
                 continue;
-            float x1 = GRID_X + x * CELL;
-            float x2 = x1 + CELL;
-            al_draw_filled_rectangle(x1, GRID_Y, x2, GRID_Y + GRID_H * CELL,
-                                     colc);
+            float x1 = GRID_X(gm) + x * CELL(gm);
+            float x2 = x1 + CELL(gm);
+            al_draw_filled_rectangle(x1, GRID_Y, x2,
+                                     GRID_Y + gm->grid_h * CELL(gm), colc);
         }
     }
 
-    /* Grid cells */
-    for (int y = 0; y < GRID_H; y++) {
-        for (int x = 0; x < GRID_W; x++) {
-            float x1 = GRID_X + x * CELL;
-            float y1 = GRID_Y + y * CELL;
-            float x2 = x1 + CELL;
-            float y2 = y1 + CELL;
-
-            al_draw_rectangle(x1, y1, x2, y2, GRID_LINE_COLOR, GRID_LINE_WIDTH);
-
-            bool occ = gm->grid.occ[y][x];
+    /* Grid cells (a popped tile stays inside its cell, so drawing every
+       line first changes nothing) */
+    hold_tiles(gm, true);
+    for (int y = 0; y < gm->grid_h; y++) {
+        for (int x = 0; x < gm->grid_w; x++) {
+            bool occ = GRID_OCC(&gm->core.grid, x, y);
+            bool pending = gm->clearing && GM_PENDING_CLEAR(gm, x, y);
+            if (!occ && !pending)
+                continue;
 
             float flash = 0.0f;
-            if (gm->clearing && gm->pending_clear[y][x])
+            if (pending)
                 flash = blockblaster_clampf(gm->clear_t / CLEAR_FLASH_TIME,
                                             0.0f, 1.0f);
 
             float pop = blockblaster_clampf(gm->pop_t[y][x] / PLACE_POP_TIME,
                                             0.0f, 1.0f);
 
-            if (occ || (gm->clearing && gm->pending_clear[y][x])) {
-                Theme th;
-                if (gm->grid.has_theme[y][x]) {
-                    th = gm->grid.cell_theme[y][x];
-                } else {
-                    th.fill = al_map_rgb(120, 190, 255);
-                    th.stroke = GRID_LINE_COLOR;
-                }
-
-                ALLEGRO_COLOR base = th.fill;
-                ALLEGRO_COLOR stroke = th.stroke;
-
-                if (flash > 0.0f)
-                    base = al_map_rgba_f(1.0f, 0.85f, 0.45f, 1.0f);
+            int row = gm->core.grid.has_theme[y][x]
+                          ? gm->core.grid.cell_theme[y][x]
+                          : TILE_ROW_PLAIN;
+            float scale = 1.0f + 0.12f * pop;
+            float cx = GRID_X(gm) + (x + 0.5f) * CELL(gm);
+            float cy = GRID_Y + (y + 0.5f) * CELL(gm);
+            float hw = (CELL(gm) * 0.42f) * scale;
 
-                float scale = 1.0f + 0.12f * pop;
-                float cx = (x1 + x2) * 0.5f;
-                float cy = (y1 + y2) * 0.5f;
-                float hw = (CELL * 0.42f) * scale;
-                float hh = (CELL * 0.42f) * scale;
-
-                float tx1 = cx - hw;
-                float ty1 = cy - hh;
-                float tx2 = cx + hw;
-                float ty2 = cy + hh;
-
-                blockblaster_draw_round_tile(tx1, ty1, tx2, ty2, CELL * 0.135f,
-                                             base, stroke, ROUNDED_LINE_WIDTH);
+            draw_tile(gm, row, flash > 0.0f ? TILE_FLASH : TILE_CELL, cx - hw,
+                      cy - hw, cx + hw, cy + hw);
+        }
+    }
+    hold_tiles(gm, false);
+
+    /* Hint: best anchor for the dragged piece, otherwise the best order of
+       the whole tray (numbered) */
+    const HintResult *hint =
+        gm->hint_on ? blockblaster_hint_poll(gm->hint) : NULL;
+    if (hint && !gm->clearing) {
+        if (gm->dragging) {
+            int i = gm->dragging_index;
+            if (hint->has_anchor[i])
+                draw_hint_piece(gm, &gm->core.tray[i], hint->anchor[i].gx,
+                                hint->anchor[i].gy, 0);
+        } else {
+            for (int k = 0; k < hint->order_count; k++) {
+                const PolicyMove *mv = &hint->order[k];
+                draw_hint_piece(gm, &gm->core.tray[mv->slot], mv->gx, mv->gy,
+                                k + 1);
             }
         }
     }
 
     /* Ghost preview */
     if (gm->dragging) {
-        const Piece *p = &gm->tray[gm->dragging_index];
+        const Piece *p = &gm->core.tray[gm->dragging_index];
         if (!p->used) {
-            Theme th = gm->tray[gm->dragging_index].theme;
-            ALLEGRO_COLOR base = th.fill;
-            ALLEGRO_COLOR c = gm->can_drop_preview
-                                  ? al_map_rgba_f(base.r, base.g, base.b, 0.40f)
-                                  : al_map_rgba(255, 90, 90, 120);
-            float ghost_inset = 6.0f * UI_SCALE;
+            int row = gm->can_drop_preview ? p->theme : TILE_ROW_PLAIN;
+            float ghost_inset = 6.0f * UI_SCALE(gm);
+            hold_tiles(gm, true);
             for (int sy = 0; sy < p->shape.h; sy++) {
                 for (int sx = 0; sx < p->shape.w; sx++) {
                     if (!blockblaster_shape_cell(&p->shape, sx, sy))
                         continue;
                     int gx = gm->preview_cell_x + sx;
                     int gy = gm->preview_cell_y + sy;
-                    if (gx < 0 || gy < 0 || gx >= GRID_W || gy >= GRID_H)
+                    if (gx < 0 || gy < 0 || gx >= gm->grid_w ||
+                        gy >= gm->grid_h)
                         continue;
 
-                    float x1 = GRID_X + gx * CELL;
-                    float y1 = GRID_Y + gy * CELL;
-                    float x2 = x1 + CELL;
-                    float y2 = y1 + CELL;
-                    blockblaster_draw_round_tile(
-                        x1 + ghost_inset, y1 + ghost_inset, x2 - ghost_inset,
-                        y2 - ghost_inset, CELL * 0.135f, c,
-                        al_map_rgba(0, 0, 0, 0), ROUNDED_LINE_WIDTH);
+                    float x1 = GRID_X(gm) + gx * CELL(gm);
+                    float y1 = GRID_Y + gy * CELL(gm);
+                    float x2 = x1 + CELL(gm);
+                    float y2 = y1 + CELL(gm);
+                    draw_tile(gm, row, TILE_GHOST, x1 + ghost_inset,
+                              y1 + ghost_inset, x2 - ghost_inset,
+                              y2 - ghost_inset);
                 }
             }
+            hold_tiles(gm, false);
         }
     }
 }
 
+/* Label shown instead of the piece in tray slot i, or NULL when the slot
+   shows its piece. */
+static const char *tray_slot_label(const GameContext *gm, int i)
+{
+    if (gm->returning && gm->return_index == i)
+        return "(returning)";
+    if (gm->core.tray[i].used)
+        return "(placed)";
+    if (gm->dragging && gm->dragging_index == i)
+        return "(placing)";
+    return NULL;
+}
+
 /**
  * \brief Draw the piece tray below the grid.
  *
  * Each tray slot is rendered as a rounded rectangle.  Used pieces show
  * "(placed)", the currently dragged piece shows "(placing)", and unused
- * pieces display a shape preview.  A label is drawn above the tray.
+ * pieces display a shape preview.  A label is drawn above the tray.  The
+ * boxes and label are blitted from the cached background layer.
  *
  * \param gm  Game context.
  */
 void blockblaster_draw_tray(const GameContext *gm)
 {
     ALLEGRO_FONT *font = gm->font;
-    for (int i = 0; i < PIECES_PER_SET; i++) {
-        float x1, y1, x2, y2;
-        blockblaster_tray_piece_rect(i, &x1, &y1, &x2, &y2);
-
-        blockblaster_draw_round_tile(x1, y1, x2, y2, 12.0f * UI_SCALE,
-                                     al_map_rgb(22, 22, 28), GRID_LINE_COLOR,
-                                     GRID_LINE_WIDTH);
 
-        if (gm->returning && gm->return_index == i) {
-            al_draw_textf(font, al_map_rgb(120, 120, 130), x1 + (x2 - x1) / 2,
-                          y1 + (y2 - y1) / 2, ALLEGRO_ALIGN_CENTER,
-                          "(returning)");
-            continue;
-        }
+    /* Slot boxes and label */
+    draw_background_part(gm, &gm->background.tray, draw_tray_background);
 
-        if (gm->tray[i].used) {
-            al_draw_textf(font, al_map_rgb(120, 120, 130), x1 + (x2 - x1) / 2,
-                          y1 + (y2 - y1) / 2, ALLEGRO_ALIGN_CENTER, "(placed)");
+    /* Previews of the pieces waiting in the tray: atlas tiles only, so
+       they batch */
+    hold_tiles(gm, true);
+    for (int i = 0; i < gm->tray_count; i++) {
+        if (tray_slot_label(gm, i))
             continue;
-        }
-        if (gm->dragging && gm->dragging_index == i) {
-            al_draw_textf(font, al_map_rgb(120, 120, 130), x1 + (x2 - x1) / 2,
-                          y1 + (y2 - y1) / 2, ALLEGRO_ALIGN_CENTER,
-                          "(placing)");
-            continue;
-        }
+        float x1, y1, x2, y2;
+        blockblaster_tray_piece_rect(gm, i, &x1, &y1, &x2, &y2);
 
-        const Shape *s = &gm->tray[i].shape;
-        float pc = TRAY_BOX / 9.0f;
+        const Shape *s = &gm->core.tray[i].shape;
+        float pc = TRAY_BOX(gm) / 9.0f;
         float pw = s->w * pc;
         float ph = s->h * pc;
         float px = x1 + ((x2 - x1) - pw) * 0.5f;
         float py = y1 + ((y2 - y1) - ph) * 0.5f;
 
-        blockblaster_draw_shape_preview(s, px, py, pc, gm->tray[i].theme.fill);
+        blockblaster_draw_shape_preview(gm, s, px, py, pc,
+                                        gm->core.tray[i].theme);
     }
+    hold_tiles(gm, false);
 
-    al_draw_textf(font, al_map_rgb(220, 220, 235), GRID_X, TRAY_Y - 34, 0,
-                  "Pieces (drag onto grid):");
+    /* Labels of the other slots, after the batch: glyphs come from the
+       font's own texture and would flush it */
+    for (int i = 0; i < gm->tray_count; i++) {
+        const char *label = tray_slot_label(gm, i);
+        if (!label)
+            continue;
+        float x1, y1, x2, y2;
+        blockblaster_tray_piece_rect(gm, i, &x1, &y1, &x2, &y2);
+        al_draw_text(font, al_map_rgb(120, 120, 130), x1 + (x2 - x1) / 2,
+                     y1 + (y2 - y1) / 2, ALLEGRO_ALIGN_CENTER, label);
+    }
 }
 
 /**
@@ -272,13 +643,13 @@ void blockblaster_draw_floating_piece(const GameContext *gm)
         return;
 
     int idx = gm->dragging ? gm->dragging_index : gm->return_index;
-    const Piece *p = &gm->tray[idx];
+    const Piece *p = &gm->core.tray[idx];
     if (p->used)
         return;
 
     float mx = gm->mouse_x;
     float my = gm->mouse_y;
-    float pc = (float) CELL;
+    float pc = (float) CELL(gm);
 
 #ifdef ALLEGRO_ANDROID
     my -= ANDROID_PIECE_Y_OFFSET * blockblaster_android_display_density();
@@ -290,49 +661,33 @@ void blockblaster_draw_floating_piece(const GameContext *gm)
         t = blockblaster_smoothstep(t);
         mx = blockblaster_lerpf(gm->return_start_x, gm->return_end_x, t);
         my = blockblaster_lerpf(gm->return_start_y, gm->return_end_y, t);
-        pc = blockblaster_lerpf((float) CELL, TRAY_BOX / 9.0f, t);
+        pc = blockblaster_lerpf((float) CELL(gm), TRAY_BOX(gm) / 9.0f, t);
     }
 
-    float r = pc * 0.22f;
-    float shadow_dx = 4.0f * UI_SCALE;
-    float shadow_dy = 6.0f * UI_SCALE;
+    float shadow_dx = 4.0f * UI_SCALE(gm);
+    float shadow_dy = 6.0f * UI_SCALE(gm);
 
     float px = mx - (gm->grab_sx + 0.5f) * pc;
     float py = my - (gm->grab_sy + 0.5f) * pc;
 
-    /* Shadow */
-    for (int sy = 0; sy < p->shape.h; sy++) {
-        for (int sx = 0; sx < p->shape.w; sx++) {
-            if (!blockblaster_shape_cell(&p->shape, sx, sy))
-                continue;
-            float x1 = px + sx * pc;
-            float y1 = py + sy * pc;
-            float x2 = x1 + pc;
-            float y2 = y1 + pc;
-            al_draw_filled_rounded_rectangle(x1 + shadow_dx, y1 + shadow_dy,
-                                             x2 + shadow_dx, y2 + shadow_dy, r,
-                                             r, al_map_rgba(0, 0, 0, 90));
-        }
-    }
-
-    /* Tiles */
-    ALLEGRO_COLOR fill = p->theme.fill;
-    ALLEGRO_COLOR stroke = p->theme.stroke;
-    float alpha = gm->returning ? 0.65f : 0.85f;
-    ALLEGRO_COLOR fill_a = al_map_rgba_f(fill.r, fill.g, fill.b, alpha);
-
-    for (int sy = 0; sy < p->shape.h; sy++) {
-        for (int sx = 0; sx < p->shape.w; sx++) {
-            if (!blockblaster_shape_cell(&p->shape, sx, sy))
-                continue;
-            float x1 = px + sx * pc;
-            float y1 = py + sy * pc;
-            float x2 = x1 + pc;
-            float y2 = y1 + pc;
-            blockblaster_draw_round_tile(x1, y1, x2, y2, r, fill_a, stroke,
-                                         ROUNDED_LINE_WIDTH);
+    /* Shadow, then tiles */
+    TileKind kind = gm->returning ? TILE_RETURN : TILE_PIECE;
+    hold_tiles(gm, true);
+    for (int pass = 0; pass < 2; pass++) {
+        float dx = pass == 0 ? shadow_dx : 0.0f;
+        float dy = pass == 0 ? shadow_dy : 0.0f;
+        for (int sy = 0; sy < p->shape.h; sy++) {
+            for (int sx = 0; sx < p->shape.w; sx++) {
+                if (!blockblaster_shape_cell(&p->shape, sx, sy))
+                    continue;
+                float x1 = px + sx * pc + dx;
+                float y1 = py + sy * pc + dy;
+                draw_tile(gm, p->theme, pass == 0 ? TILE_SHADOW : kind, x1,
+                          y1, x1 + pc, y1 + pc);
+            }
         }
     }
+    hold_tiles(gm, false);
 }
 
 /**
@@ -343,13 +698,120 @@ void blockblaster_draw_floating_piece(const GameContext *gm)
 void blockblaster_draw_ui(const GameContext *gm)
 {
     ALLEGRO_FONT *font = gm->font;
-    al_draw_textf(font, al_map_rgb(245, 245, 245), GRID_X, 18, 0, "Score: %ld",
-                  gm->score);
+    al_draw_textf(font, al_map_rgb(245, 245, 245), GRID_X(gm), 18, 0,
+                  "Score: %ld", gm->core.score);
+
+    if (gm->core.combo > 0) {
+        al_draw_textf(font, al_map_rgb(255, 230, 140),
+                      GRID_X(gm) + gm->grid_w * CELL(gm), 18,
+                      ALLEGRO_ALIGN_RIGHT, "Combo: x%d", gm->core.combo);
+    }
+
+    if (gm->hint_on)
+        al_draw_textf(font, HINT_COLOR,
+                      GRID_X(gm) + gm->grid_w * CELL(gm) * 0.5f, 18,
+                      ALLEGRO_ALIGN_CENTER, "Hints (H)");
+}
+
+/* ======================================================================== */
+/* Particles                                                                 */
+/* ======================================================================== */
 
-    if (gm->combo > 0) {
-        al_draw_textf(font, al_map_rgb(255, 230, 140), GRID_X + GRID_W * CELL,
-                      18, ALLEGRO_ALIGN_RIGHT, "Combo: x%d", gm->combo);
+/**
+ * \brief Create the particle texture and vertex array.
+ *
+ * The texture is a white disc on a transparent background with mipmaps,
+ * so a particle scaled down to a few pixels keeps a smooth edge.  Must be
+ * called once the display exists; any previous batch is released first.
+ *
+ * \param gm  Game context.
+ * \return    false if either could not be created; particles are then
+ *            drawn one circle at a time.
+ */
+bool blockblaster_particle_batch_create(GameContext *gm)
+{
+    blockblaster_particle_batch_destroy(gm);
+
+    int flags = al_get_new_bitmap_flags();
+    al_set_new_bitmap_flags(flags | ALLEGRO_MIN_LINEAR | ALLEGRO_MAG_LINEAR |
+                            ALLEGRO_MIPMAP);
+    gm->particle_tex =
+        al_create_bitmap(PARTICLE_TEXTURE_SIZE, PARTICLE_TEXTURE_SIZE);
+    al_set_new_bitmap_flags(flags);
+    gm->particle_vtx = malloc(sizeof(ALLEGRO_VERTEX) * 6 * MAX_PARTICLES);
+    if (!gm->particle_tex || !gm->particle_vtx) {
+        blockblaster_particle_batch_destroy(gm);
+        return false;
     }
+
+    ALLEGRO_STATE state;
+    al_store_state(&state, ALLEGRO_STATE_TARGET_BITMAP);
+    al_set_target_bitmap(gm->particle_tex);
+    al_clear_to_color(al_map_rgba(0, 0, 0, 0));
+    al_draw_filled_circle(PARTICLE_TEXTURE_SIZE / 2.0f,
+                          PARTICLE_TEXTURE_SIZE / 2.0f,
+                          PARTICLE_TEXTURE_SIZE / 2.0f - 1.0f,
+                          al_map_rgb(255, 255, 255));
+    al_restore_state(&state);
+    return true;
+}
+
+/**
+ * \brief Release the particle texture and vertex array.
+ *
+ * \param gm  Game context.
+ */
+void blockblaster_particle_batch_destroy(GameContext *gm)
+{
+    if (gm->particle_tex)
+        al_destroy_bitmap(gm->particle_tex);
+    gm->particle_tex = NULL;
+    free(gm->particle_vtx);
+    gm->particle_vtx = NULL;
+}
+
+/* Draw every live particle.  Each one is a textured quad (two triangles)
+   tinted with its colour and alpha, and the whole pool goes out in a
+   single al_draw_prim() call.  Without a batch, falls back to one circle
+   per particle. */
+static void draw_particles(const GameContext *gm)
+{
+    const ParticleSystem *ps = gm->particles;
+    if (!ps)
+        return;
+    int n = ps->count < MAX_PARTICLES ? ps->count : MAX_PARTICLES;
+
+    if (!gm->particle_tex) {
+        for (int i = 0; i < n; i++) {
+            ALLEGRO_COLOR c =
+                al_map_rgba_f(ps->r[i], ps->g[i], ps->b[i], ps->alpha[i]);
+            al_draw_filled_circle(ps->x[i], ps->y[i], ps->size[i], c);
+        }
+        return;
+    }
+    if (n == 0)
+        return;
+
+    /* The disc leaves a one-pixel margin in the texture: widen the quad so
+       the visible radius is the particle size. */
+    const float s = PARTICLE_TEXTURE_SIZE;
+    const float k = s / (s - 2.0f);
+    ALLEGRO_VERTEX *v = gm->particle_vtx;
+    for (int i = 0; i < n; i++, v += 6) {
+        float h = ps->size[i] * k;
+        float x0 = ps->x[i] - h, x1 = ps->x[i] + h;
+        float y0 = ps->y[i] - h, y1 = ps->y[i] + h;
+        ALLEGRO_COLOR c =
+            al_map_rgba_f(ps->r[i], ps->g[i], ps->b[i], ps->alpha[i]);
+        v[0] = (ALLEGRO_VERTEX){x0, y0, 0.0f, 0.0f, 0.0f, c};
+        v[1] = (ALLEGRO_VERTEX){x1, y0, 0.0f, s, 0.0f, c};
+        v[2] = (ALLEGRO_VERTEX){x1, y1, 0.0f, s, s, c};
+        v[3] = v[0];
+        v[4] = v[2];
+        v[5] = (ALLEGRO_VERTEX){x0, y1, 0.0f, 0.0f, s, c};
+    }
+    al_draw_prim(gm->particle_vtx, NULL, gm->particle_tex, 0, n * 6,
+                 ALLEGRO_PRIM_TRIANGLE_LIST);
 }
 
 /**
@@ -366,6 +828,8 @@ void blockblaster_draw_play_scene(GameContext *gm)
 {
     ALLEGRO_FONT *font = gm->font;
 
+    update_tile_atlas(gm);
+    update_background(gm);
     al_clear_to_color(al_map_rgb(12, 12, 16));
     ALLEGRO_TRANSFORM old, t;
     al_copy_transform(&old, al_get_current_transform());
@@ -377,15 +841,7 @@ void blockblaster_draw_play_scene(GameContext *gm)
     blockblaster_draw_grid(gm);
     blockblaster_draw_ui(gm);
 
-    /* Particles */
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        Particle *p = &gm->particles[i];
-        if (!p->alive)
-            continue;
-        float a = blockblaster_clampf(p->life / p->life0, 0.0f, 1.0f);
-        ALLEGRO_COLOR c = al_map_rgba_f(p->col.r, p->col.g, p->col.b, a);
-        al_draw_filled_circle(p->x, p->y, p->size, c);
-    }
+    draw_particles(gm);
 
     /* Combo popup */
     if (gm->combo_popup.alive) {
@@ -20,8 +20,15 @@ void blockblaster_draw_round_tile(float x1, float y1, float x2, float y2,
                                   ALLEGRO_COLOR stroke, float width);
 
 /** \brief Draw a miniature shape preview at the given position. */
-void blockblaster_draw_shape_preview(const Shape *s, float px, float py,
-                                     float cell, ALLEGRO_COLOR col);
+void blockblaster_draw_shape_preview(const GameContext *gm, const Shape *s,
+                                     float px, float py, float cell,
+                                     int theme);
+
+/** \brief Release the pre-rendered tile atlas. */
+void blockblaster_tile_atlas_destroy(GameContext *gm);
+
+/** \brief Release the cached grid and tray background bitmaps. */
+void blockblaster_background_destroy(GameContext *gm);
 
 /** \brief Draw the play grid (cells, ghost preview, predicted-clear overlay).
  */
@@ -36,6 +43,12 @@ void blockblaster_draw_floating_piece(const GameContext *gm);
 /** \brief Draw the in-game HUD (score, combo). */
 void blockblaster_draw_ui(const GameContext *gm);
 
+/** \brief Create the particle texture and vertex array. */
+bool blockblaster_particle_batch_create(GameContext *gm);
+
+/** \brief Release the particle texture and vertex array. */
+void blockblaster_particle_batch_destroy(GameContext *gm);
+
 /** \brief Draw the complete in-game scene for one frame. */
 void blockblaster_draw_play_scene(GameContext *gm);
 
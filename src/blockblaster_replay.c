@@ -0,0 +1,634 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_replay.c
+ * \brief Replay recording, encoding and verification.
+ */
+
+#include "blockblaster_replay.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Drops the buffer is first sized for. */
+#define REPLAY_INITIAL_CAP 256
+
+/* Bytes of one keyframe of a grid x grid game with tray slots: row
+   bitboards, cell themes, tray (shape, theme, used), bag with length and
+   position, random stream, then score, combo, highest combo, combo_miss,
+   last multiplier, set theme, theme mode and game-over flag. */
+#define KEYFRAME_SIZE(grid, tray)                                              \
+    ((grid) * 4 + (grid) * (grid) + (tray) * 3 + BAG_SIZE + 2 + 16 + 24 + 3)
+
+/* Largest keyframe of any game. */
+#define KEYFRAME_MAX KEYFRAME_SIZE(GRID_W_MAX, PIECES_PER_SET_MAX)
+
+/* Size of the keyframe section header: interval, size and count. */
+#define KEYFRAME_SECTION_SIZE 8
+
+/* Unchanged bytes between two changed ones that are cheaper to copy into
+   the run than to start a new run for. */
+#define KEYFRAME_GAP_MAX 3
+
+static const char REPLAY_MAGIC[4] = {'B', 'B', 'R', 'P'};
+
+static const char *const REPLAY_STATUS_NAMES[REPLAY_STATUS_COUNT] = {
+    "ok",
+    "bad header",
+    "illegal move",
+    "not over",
+    "score mismatch",
+    "unverifiable (fair deal cut by the clock)",
+    "bad keyframe"};
+
+/* ======================================================================== */
+/* Little-endian encoding                                                    */
+/* ======================================================================== */
+
+static void put_le(uint8_t *p, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        p[i] = (uint8_t) (v >> (8 * i));
+}
+
+static uint64_t get_le(const uint8_t *p, int bytes)
+{
+    uint64_t v = 0;
+    for (int i = bytes - 1; i >= 0; i--)
+        v = v << 8 | p[i];
+    return v;
+}
+
+/* Write v as a LEB128 varint at out (if non-NULL); returns its length. */
+static size_t put_varint(uint8_t *out, uint32_t v)
+{
+    size_t n = 0;
+    do {
+        uint8_t b = (uint8_t) (v & 0x7F);
+        v >>= 7;
+        if (out)
+            out[n] = (uint8_t) (b | (v ? 0x80 : 0));
+        n++;
+    } while (v);
+    return n;
+}
+
+/* Read a varint from [*p, end), advancing *p; false on a truncated or
+   oversized varint. */
+static bool get_varint(const uint8_t **p, const uint8_t *end, uint32_t *v)
+{
+    uint32_t x = 0;
+    for (int shift = 0; shift < 32 && *p < end; shift += 7) {
+        uint8_t b = *(*p)++;
+        x |= (uint32_t) (b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *v = x;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* True when the grid and tray size of r are in range, so its game can be
+   started and its keyframes loaded. */
+static bool replay_settings_ok(const Replay *r)
+{
+    return r->grid >= 1 && r->grid <= GRID_W_MAX && r->grid <= GRID_H_MAX &&
+           r->tray >= 1 && r->tray <= PIECES_PER_SET_MAX;
+}
+
+/* ======================================================================== */
+/* Recording                                                                 */
+/* ======================================================================== */
+
+/**
+ * \brief Start recording a game.  Call before blockblaster_core_start(),
+ *        with the seed the gameplay stream was seeded with.
+ *
+ * \param r     Replay (zero-initialised or used before).
+ * \param seed  Gameplay seed (stream RNG_STREAM_GAMEPLAY).
+ * \param grid  Grid side length.
+ * \param tray  Pieces per set.
+ * \param mode  0 = empty grid, 1 = partially filled grid.
+ * \param fair  Fair trays.
+ */
+void blockblaster_replay_begin(Replay *r, uint64_t seed, int grid, int tray,
+                               int mode, bool fair)
+{
+    r->seed = seed;
+    r->grid = grid;
+    r->tray = tray;
+    r->mode = mode;
+    r->fair = fair;
+    r->fair_timeouts = 0;
+    r->score = 0;
+    r->highest_combo = 0;
+    r->count = 0;
+    r->lost = false;
+    r->key_count = 0;
+}
+
+/**
+ * \brief Append one accepted drop.
+ *
+ * \param r     Replay.
+ * \param slot  Tray slot dropped.
+ * \param gx    Grid column of the shape's top-left corner.
+ * \param gy    Grid row of the shape's top-left corner.
+ * \return      false if the drop could not be stored (r->lost is set).
+ */
+bool blockblaster_replay_add(Replay *r, int slot, int gx, int gy)
+{
+    if (r->count == r->cap) {
+        int cap = r->cap ? r->cap * 2 : REPLAY_INITIAL_CAP;
+        uint16_t *m = realloc(r->moves, (size_t) cap * sizeof(*m));
+        if (!m) {
+            r->lost = true;
+            return false;
+        }
+        r->moves = m;
+        r->cap = cap;
+    }
+    r->moves[r->count++] = REPLAY_MOVE(slot, gx, gy);
+    return true;
+}
+
+/**
+ * \brief Remove the last drop, when the player takes it back.
+ *
+ * The game state must go back to the one before that drop, random stream
+ * included, so that the remaining drops still replay exactly.
+ *
+ * \param r  Replay.
+ */
+void blockblaster_replay_undo(Replay *r)
+{
+    if (r->count > 0)
+        r->count--;
+}
+
+/**
+ * \brief Record the result of the finished game.
+ *
+ * \param r  Replay.
+ * \param c  The game, once over.
+ */
+void blockblaster_replay_finish(Replay *r, const CoreGame *c)
+{
+    r->score = c->score;
+    r->highest_combo = c->highest_combo;
+    r->fair_timeouts = c->fair.timeouts;
+}
+
+/**
+ * \brief Release the drop buffer.
+ *
+ * \param r  Replay.
+ */
+void blockblaster_replay_free(Replay *r)
+{
+    free(r->moves);
+    free(r->keys);
+    memset(r, 0, sizeof(*r));
+}
+
+/* ======================================================================== */
+/* Keyframes                                                                 */
+/* ======================================================================== */
+
+/* Serialise the rules state of c into k (KEYFRAME_SIZE bytes). */
+static void keyframe_store(const CoreGame *c, uint8_t *k)
+{
+    const Grid *g = &c->grid;
+    for (int y = 0; y < g->h; y++, k += 4)
+        put_le(k, g->rows[y], 4);
+    for (int y = 0; y < g->h; y++)
+        for (int x = 0; x < g->w; x++)
+            *k++ = g->has_theme[y][x] ? g->cell_theme[y][x] : 0xFF;
+    for (int i = 0; i < c->tray_count; i++) {
+        *k++ = (uint8_t) c->tray[i].shape_id;
+        *k++ = (uint8_t) c->tray[i].theme;
+        *k++ = c->tray[i].used ? 1 : 0;
+    }
+    for (int i = 0; i < BAG_SIZE; i++)
+        *k++ = (uint8_t) c->bag[i];
+    *k++ = (uint8_t) c->bag_len;
+    *k++ = (uint8_t) c->bag_pos;
+
+    uint32_t mult;
+    memcpy(&mult, &c->last_move_mult, sizeof(mult));
+    put_le(k, c->rng.state, 8);
+    put_le(k + 8, c->rng.inc, 8);
+    put_le(k + 16, (uint64_t) (int64_t) c->score, 8);
+    put_le(k + 24, (uint32_t) c->combo, 4);
+    put_le(k + 28, (uint32_t) c->highest_combo, 4);
+    put_le(k + 32, (uint32_t) c->combo_miss, 4);
+    put_le(k + 36, mult, 4);
+    k[40] = (uint8_t) c->set_theme;
+    k[41] = (uint8_t) c->theme_mode;
+    k[42] = c->game_over ? 1 : 0;
+}
+
+/* Rebuild the rules state of a game of r from keyframe k.  Out-of-range
+   values (from a damaged file) are clamped so the state stays usable;
+   blockblaster_replay_verify() reports them. */
+static void keyframe_load(const Replay *r, const uint8_t *k, CoreGame *c)
+{
+    memset(c, 0, sizeof(*c));
+    Grid *g = &c->grid;
+    blockblaster_grid_clear(g, r->grid, r->grid);
+    for (int y = 0; y < g->h; y++, k += 4) {
+        uint32_t row = (uint32_t) get_le(k, 4) & GRID_FULL_ROW(g);
+        g->rows[y] = row;
+        g->row_fill[y] = (uint8_t) GRID_POPCOUNT(row);
+        for (; row; row &= row - 1) {
+            int x = __builtin_ctz(row);
+            g->cols[x] |= 1u << y;
+            g->col_fill[x]++;
+        }
+    }
+    for (int y = 0; y < g->h; y++)
+        for (int x = 0; x < g->w; x++, k++) {
+            g->has_theme[y][x] = *k != 0xFF;
+            g->cell_theme[y][x] = *k != 0xFF ? *k % THEMES_COUNT : 0;
+        }
+    c->tray_count = r->tray;
+    for (int i = 0; i < r->tray; i++, k += 3) {
+        int id = k[0] < SHAPES_COUNT ? k[0] : 0;
+        c->tray[i].shape_id = id;
+        c->tray[i].shape = SHAPES[id];
+        c->tray[i].theme = k[1] % THEMES_COUNT;
+        c->tray[i].used = k[2] != 0;
+    }
+    for (int i = 0; i < BAG_SIZE; i++, k++)
+        c->bag[i] = *k < SHAPES_COUNT ? *k : 0;
+    c->bag_len = k[0] <= BAG_SIZE ? k[0] : BAG_SIZE;
+    c->bag_pos = k[1] <= c->bag_len ? k[1] : c->bag_len;
+    k += 2;
+
+    uint32_t mult = (uint32_t) get_le(k + 36, 4);
+    c->rng.state = get_le(k, 8);
+    c->rng.inc = get_le(k + 8, 8) | 1u;
+    c->score = (long) (int64_t) get_le(k + 16, 8);
+    c->combo = (int) get_le(k + 24, 4);
+    c->highest_combo = (int) get_le(k + 28, 4);
+    c->combo_miss = (int) get_le(k + 32, 4);
+    memcpy(&c->last_move_mult, &mult, sizeof(mult));
+    c->set_theme = k[40] % THEMES_COUNT;
+    c->theme_mode = k[41] ? 1 : 0;
+    c->game_over = k[42] != 0;
+
+    c->start_mode = r->mode;
+    c->fair_tray = r->fair;
+    for (int i = 0; i < r->tray; i++)
+        blockblaster_placement_map_rebuild(c, i);
+}
+
+/* Delta-code keyframe cur against prev (zeros when prev is NULL), n bytes
+   each, into out, or only count the bytes when out is NULL.  Returns the
+   coded length. */
+static size_t keyframe_encode(const uint8_t *prev, const uint8_t *cur, int n,
+                              uint8_t *out)
+{
+#define KEY_DIFF(j) ((prev ? prev[j] : 0) ^ cur[j])
+    size_t len = 0;
+    int i = 0;
+    while (i < n) {
+        int z = i;
+        while (z < n && KEY_DIFF(z) == 0)
+            z++;
+        /* Extend the run of changed bytes over short unchanged gaps. */
+        int end = z;
+        while (end < n) {
+            if (KEY_DIFF(end) != 0) {
+                end++;
+                continue;
+            }
+            int gap = end;
+            while (gap < n && gap - end < KEYFRAME_GAP_MAX &&
+                   KEY_DIFF(gap) == 0)
+                gap++;
+            if (gap == n || gap - end >= KEYFRAME_GAP_MAX)
+                break;
+            end = gap;
+        }
+        len += put_varint(out ? out + len : NULL, (uint32_t) (z - i));
+        len += put_varint(out ? out + len : NULL, (uint32_t) (end - z));
+        for (int j = z; j < end; j++, len++)
+            if (out)
+                out[len] = (uint8_t) KEY_DIFF(j);
+        i = end;
+    }
+    return len;
+#undef KEY_DIFF
+}
+
+/* Decode one keyframe of n bytes from [*p, end) against prev (zeros when
+   NULL) into cur, advancing *p.  Returns false on malformed data. */
+static bool keyframe_decode(const uint8_t **p, const uint8_t *end,
+                            const uint8_t *prev, uint8_t *cur, int n)
+{
+    uint32_t i = 0, un = (uint32_t) n;
+    while (i < un) {
+        uint32_t z, lit;
+        if (!get_varint(p, end, &z) || !get_varint(p, end, &lit) ||
+            z > un - i || lit > un - i - z || lit > (size_t) (end - *p) ||
+            (z == 0 && lit == 0))
+            return false;
+        for (uint32_t j = 0; j < z; j++, i++)
+            cur[i] = prev ? prev[i] : 0;
+        for (uint32_t j = 0; j < lit; j++, i++)
+            cur[i] = (uint8_t) ((prev ? prev[i] : 0) ^ *(*p)++);
+    }
+    return true;
+}
+
+/* Make room for count keyframes of r->key_size bytes. */
+static bool keyframe_reserve(Replay *r, int count)
+{
+    size_t need = (size_t) count * (size_t) r->key_size;
+    if (need <= r->key_cap)
+        return true;
+    uint8_t *k = realloc(r->keys, need);
+    if (!k)
+        return false;
+    r->keys = k;
+    r->key_cap = need;
+    return true;
+}
+
+/**
+ * \brief Build the keyframes of a recorded game by re-simulating it.
+ *
+ * Stores the state after every REPLAY_KEYFRAME_INTERVAL drops.  Call once
+ * the game is over (before encoding) so blockblaster_replay_seek() and the
+ * encoded file can use them.
+ *
+ * \param r  Replay.
+ * \return   false if a drop is illegal, the settings are out of range or
+ *           out of memory; the keyframes before the failure are kept.
+ */
+bool blockblaster_replay_index(Replay *r)
+{
+    CoreGame c;
+    r->key_count = 0;
+    r->key_interval = REPLAY_KEYFRAME_INTERVAL;
+    r->key_size = KEYFRAME_SIZE(r->grid, r->tray);
+    if (!blockblaster_replay_start(r, &c) ||
+        !keyframe_reserve(r, r->count / r->key_interval))
+        return false;
+    for (int i = 0; i < r->count; i++) {
+        uint16_t m = r->moves[i];
+        if (!blockblaster_core_drop(&c, REPLAY_MOVE_SLOT(m), REPLAY_MOVE_GX(m),
+                                    REPLAY_MOVE_GY(m), NULL))
+            return false;
+        if ((i + 1) % r->key_interval == 0)
+            keyframe_store(&c, r->keys + (size_t) r->key_count++ * r->key_size);
+    }
+    return true;
+}
+
+/**
+ * \brief Rebuild the game state after a given number of drops.
+ *
+ * Starts from the nearest keyframe at or before move (or from the opening
+ * deal) and replays fewer than REPLAY_KEYFRAME_INTERVAL drops, so the cost
+ * does not grow with the position.
+ *
+ * \param r     Replay (keyframes optional, see blockblaster_replay_index()).
+ * \param move  Number of drops to apply, 0 - r->count.
+ * \param c     Receives the state.
+ * \return      false if move or the replay settings are out of range or a
+ *              drop is illegal.
+ */
+bool blockblaster_replay_seek(const Replay *r, int move, CoreGame *c)
+{
+    if (move < 0 || move > r->count || !replay_settings_ok(r))
+        return false;
+    int k = r->key_interval > 0 ? move / r->key_interval : 0;
+    if (k > r->key_count)
+        k = r->key_count;
+    int from = 0;
+    if (k > 0) {
+        keyframe_load(r, r->keys + (size_t) (k - 1) * r->key_size, c);
+        from = k * r->key_interval;
+    } else if (!blockblaster_replay_start(r, c)) {
+        return false;
+    }
+    for (int i = from; i < move; i++) {
+        uint16_t m = r->moves[i];
+        if (!blockblaster_core_drop(c, REPLAY_MOVE_SLOT(m), REPLAY_MOVE_GX(m),
+                                    REPLAY_MOVE_GY(m), NULL))
+            return false;
+    }
+    return true;
+}
+
+/* ======================================================================== */
+/* Encoding                                                                  */
+/* ======================================================================== */
+
+/**
+ * \brief Size of the encoded replay in bytes.
+ *
+ * \param r  Replay.
+ * \return   Header, two bytes per drop and the coded keyframes.
+ */
+size_t blockblaster_replay_size(const Replay *r)
+{
+    size_t len =
+        REPLAY_HEADER_SIZE + 2 * (size_t) r->count + KEYFRAME_SECTION_SIZE;
+    for (int k = 0; k < r->key_count; k++)
+        len += keyframe_encode(
+            k > 0 ? r->keys + (size_t) (k - 1) * r->key_size : NULL,
+            r->keys + (size_t) k * r->key_size, r->key_size, NULL);
+    return len;
+}
+
+/**
+ * \brief Encode a replay (see blockblaster_replay.h for the layout).
+ *
+ * \param r    Replay.
+ * \param out  blockblaster_replay_size(r) bytes.
+ */
+void blockblaster_replay_encode(const Replay *r, uint8_t *out)
+{
+    memcpy(out, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    out[4] = REPLAY_VERSION;
+    out[5] = (uint8_t) r->grid;
+    out[6] = (uint8_t) r->tray;
+    out[7] = (uint8_t) ((r->mode ? 1 : 0) | (r->fair ? 2 : 0));
+    put_le(out + 8, r->seed, 8);
+    put_le(out + 16, (uint64_t) (int64_t) r->score, 8);
+    put_le(out + 24, (uint32_t) r->highest_combo, 4);
+    put_le(out + 28, (uint32_t) r->fair_timeouts, 4);
+    put_le(out + 32, (uint32_t) r->count, 4);
+    for (int i = 0; i < r->count; i++)
+        put_le(out + REPLAY_HEADER_SIZE + 2 * i, r->moves[i], 2);
+
+    uint8_t *p = out + REPLAY_HEADER_SIZE + 2 * (size_t) r->count;
+    put_le(p, (uint32_t) r->key_interval, 2);
+    put_le(p + 2, (uint32_t) r->key_size, 2);
+    put_le(p + 4, (uint32_t) r->key_count, 4);
+    p += KEYFRAME_SECTION_SIZE;
+    for (int k = 0; k < r->key_count; k++)
+        p += keyframe_encode(
+            k > 0 ? r->keys + (size_t) (k - 1) * r->key_size : NULL,
+            r->keys + (size_t) k * r->key_size, r->key_size, p);
+}
+
+/**
+ * \brief Decode an encoded replay into r, growing its drop buffer.
+ *
+ * \param r    Replay (zero-initialised or used before).
+ * \param buf  Encoded replay.
+ * \param len  Bytes in buf.
+ * \return     false if buf is not a complete replay of a known version,
+ *             its grid or tray size is out of range, or out of memory.
+ */
+bool blockblaster_replay_decode(Replay *r, const uint8_t *buf, size_t len)
+{
+    if (len < REPLAY_HEADER_SIZE ||
+        memcmp(buf, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0 || buf[4] < 1 ||
+        buf[4] > REPLAY_VERSION)
+        return false;
+    uint32_t count = (uint32_t) get_le(buf + 32, 4);
+    if (count > (len - REPLAY_HEADER_SIZE) / 2 || count > INT32_MAX / 2)
+        return false;
+
+    blockblaster_replay_begin(r, get_le(buf + 8, 8), buf[5], buf[6],
+                              buf[7] & 1, (buf[7] & 2) != 0);
+    if (!replay_settings_ok(r))
+        return false;
+    r->score = (long) (int64_t) get_le(buf + 16, 8);
+    r->highest_combo = (int) get_le(buf + 24, 4);
+    r->fair_timeouts = (long) get_le(buf + 28, 4);
+    if ((int) count > r->cap) {
+        uint16_t *m = realloc(r->moves, count * sizeof(*m));
+        if (!m)
+            return false;
+        r->moves = m;
+        r->cap = (int) count;
+    }
+    for (uint32_t i = 0; i < count; i++)
+        r->moves[i] = (uint16_t) get_le(buf + REPLAY_HEADER_SIZE + 2 * i, 2);
+    r->count = (int) count;
+    if (buf[4] < 2)
+        return true;
+
+    /* Keyframes (version 2). */
+    const uint8_t *p = buf + REPLAY_HEADER_SIZE + 2 * (size_t) count;
+    const uint8_t *end = buf + len;
+    if (end - p < KEYFRAME_SECTION_SIZE)
+        return false;
+    int interval = (int) get_le(p, 2);
+    int size = (int) get_le(p + 2, 2);
+    uint32_t keys = (uint32_t) get_le(p + 4, 4);
+    p += KEYFRAME_SECTION_SIZE;
+    if (keys == 0)
+        return true;
+    if (interval <= 0 || size != KEYFRAME_SIZE(r->grid, r->tray) ||
+        size > KEYFRAME_MAX || keys > count / (uint32_t) interval)
+        return false;
+    r->key_interval = interval;
+    r->key_size = size;
+    if (!keyframe_reserve(r, (int) keys))
+        return false;
+    for (uint32_t k = 0; k < keys; k++)
+        if (!keyframe_decode(&p, end,
+                             k > 0 ? r->keys + (size_t) (k - 1) * size : NULL,
+                             r->keys + (size_t) k * size, size))
+            return false;
+    r->key_count = (int) keys;
+    return true;
+}
+
+/* ======================================================================== */
+/* Verification                                                              */
+/* ======================================================================== */
+
+/**
+ * \brief Start the game of a replay: seed, settings and opening deal.
+ *
+ * Fair deals run on the node limit only, so the result does not depend on
+ * the speed of the machine.
+ *
+ * \param r  Replay.
+ * \param c  Game to start.
+ * \return   false if the replay settings are out of range.
+ */
+bool blockblaster_replay_start(const Replay *r, CoreGame *c)
+{
+    if (!replay_settings_ok(r))
+        return false;
+    memset(c, 0, sizeof(*c));
+    blockblaster_rng_seed(&c->rng, r->seed, RNG_STREAM_GAMEPLAY);
+    c->fair_tray = r->fair;
+    blockblaster_core_start(c, r->grid, r->grid, r->tray, r->mode);
+    return true;
+}
+
+/**
+ * \brief Re-simulate a replay and compare it with its claimed result.
+ *
+ * \param r          Replay.
+ * \param c          Scratch game; holds the final position on return.
+ * \param fail_move  If non-NULL, receives the index of the first illegal
+ *                   drop (or -1).
+ * \return           REPLAY_OK when every drop is legal, every keyframe
+ *                   matches, the game is over after the last drop and
+ *                   score and highest combo match.
+ */
+ReplayStatus blockblaster_replay_verify(const Replay *r, CoreGame *c,
+                                        int *fail_move)
+{
+    if (fail_move)
+        *fail_move = -1;
+    if (!blockblaster_replay_start(r, c))
+        return REPLAY_BAD_HEADER;
+
+    ReplayStatus st = REPLAY_OK;
+    uint8_t key[KEYFRAME_MAX];
+    for (int i = 0; i < r->count; i++) {
+        uint16_t m = r->moves[i];
+        if (!blockblaster_core_drop(c, REPLAY_MOVE_SLOT(m), REPLAY_MOVE_GX(m),
+                                    REPLAY_MOVE_GY(m), NULL)) {
+            if (fail_move)
+                *fail_move = i;
+            st = REPLAY_ILLEGAL_MOVE;
+            break;
+        }
+        int k = r->key_interval > 0 ? (i + 1) / r->key_interval - 1 : -1;
+        if (k >= 0 && k < r->key_count && (i + 1) % r->key_interval == 0) {
+            keyframe_store(c, key);
+            if (memcmp(key, r->keys + (size_t) k * r->key_size,
+                       (size_t) r->key_size) != 0) {
+                if (fail_move)
+                    *fail_move = i;
+                st = REPLAY_BAD_KEYFRAME;
+                break;
+            }
+        }
+    }
+    if (st == REPLAY_OK && !c->game_over)
+        st = REPLAY_NOT_OVER;
+    if (st == REPLAY_OK &&
+        (c->score != r->score || c->highest_combo != r->highest_combo))
+        st = REPLAY_SCORE_MISMATCH;
+    if (st != REPLAY_OK && r->fair && r->fair_timeouts > 0)
+        st = REPLAY_UNVERIFIABLE;
+    return st;
+}
+
+/**
+ * \brief Short description of a verification status.
+ *
+ * \param s  Status.
+ * \return   Static string.
+ */
+const char *blockblaster_replay_status_name(ReplayStatus s)
+{
+    if ((unsigned) s >= REPLAY_STATUS_COUNT)
+        return "unknown";
+    return REPLAY_STATUS_NAMES[s];
+}
@@ -0,0 +1,141 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_replay.h
+ * \brief Deterministic game replays: recording, encoding and verification.
+ *
+ * A game is fully determined by its gameplay seed, its settings and the
+ * drops the player made, so a replay stores only those, plus the result
+ * the game claimed (score and highest combo, as in HighScoreEntry) so that
+ * re-simulating it checks the claim.
+ *
+ * Encoded replays are little-endian:
+ *
+ * | Offset | Type      | Field                                            |
+ * |--------|-----------|--------------------------------------------------|
+ * | 0      | char[4]   | "BBRP"                                           |
+ * | 4      | u8        | format version (REPLAY_VERSION)                  |
+ * | 5      | u8        | grid side length                                 |
+ * | 6      | u8        | tray count                                       |
+ * | 7      | u8        | flags: bit 0 = partially filled start, bit 1 =   |
+ * |        |           | fair trays                                       |
+ * | 8      | u64       | gameplay seed (stream RNG_STREAM_GAMEPLAY)       |
+ * | 16     | i64       | claimed score                                    |
+ * | 24     | u32       | claimed highest combo                            |
+ * | 28     | u32       | fair deals decided by the clock                  |
+ * | 32     | u32       | number of drops                                  |
+ * | 36     | u16 each  | drops: slot | gx << 2 | gy << 7                  |
+ * | ...    | u16       | keyframe interval, in drops (version 2)          |
+ * | ...    | u16       | keyframe size, in bytes                          |
+ * | ...    | u32       | number of keyframes                              |
+ * | ...    | bytes     | keyframes, each delta-coded against the previous |
+ *
+ * Keyframe k is the rules state after (k + 1) * interval drops: grid
+ * occupancy and cell themes, tray, bag and bag position, random stream,
+ * score and combo counters (see blockblaster_replay_index()).  Each one is
+ * XORed with the previous keyframe (the first with zeros) and stored as
+ * runs: a varint count of unchanged bytes, a varint count of changed
+ * bytes, then the changed bytes, until the keyframe is complete.  Cells
+ * untouched since the previous keyframe cost nothing, so a keyframe takes
+ * a fraction of a full snapshot (the bench reports the overhead per drop).
+ *
+ * Once decoded, any position is the nearest keyframe plus fewer than
+ * interval drops, so blockblaster_replay_seek() runs in bounded time
+ * however long the game.
+ *
+ * Fair trays in the game also stop on a CPU budget, so a deal cut short by
+ * the clock may not be dealt the same way again; such games record the
+ * number of affected deals and a mismatch on them is reported as
+ * REPLAY_UNVERIFIABLE rather than as a failure.
+ */
+
+#ifndef __BLOCKBLASTER_REPLAY__
+#define __BLOCKBLASTER_REPLAY__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "blockblaster_core.h"
+
+#include <stddef.h>
+
+/** \brief Encoded replay format version (version 1, without keyframes,
+ * is still read). */
+#define REPLAY_VERSION 2
+
+/** \brief Drops between keyframes. */
+#define REPLAY_KEYFRAME_INTERVAL 64
+
+/** \brief Size of the encoded header, before the drops. */
+#define REPLAY_HEADER_SIZE 36
+
+/** \brief Encode one drop (slot < 4, gx and gy < 32) in 16 bits. */
+#define REPLAY_MOVE(slot, gx, gy)                                              \
+    ((uint16_t) ((slot) | (gx) << 2 | (gy) << 7))
+#define REPLAY_MOVE_SLOT(m) ((m) & 3)
+#define REPLAY_MOVE_GX(m) (((m) >> 2) & 31)
+#define REPLAY_MOVE_GY(m) (((m) >> 7) & 31)
+
+/**
+ * \brief Outcome of blockblaster_replay_verify().
+ */
+typedef enum {
+    REPLAY_OK = 0,         /* Re-simulation matches the claimed result. */
+    REPLAY_BAD_HEADER,     /* Settings out of range. */
+    REPLAY_ILLEGAL_MOVE,   /* A drop does not fit (or the game was over). */
+    REPLAY_NOT_OVER,       /* The drops end before the game is over. */
+    REPLAY_SCORE_MISMATCH, /* Final score or highest combo differs. */
+    REPLAY_UNVERIFIABLE,   /* Mismatch on a game with clock-cut fair deals. */
+    REPLAY_BAD_KEYFRAME,   /* A keyframe differs from the re-simulation. */
+    REPLAY_STATUS_COUNT    /* Number of statuses (not a valid status). */
+} ReplayStatus;
+
+/**
+ * \brief A recorded game.
+ *
+ * Zero-initialise, then blockblaster_replay_begin() at the start of every
+ * game; the drop and keyframe buffers grow as needed and are kept between
+ * games.
+ */
+typedef struct {
+    uint64_t seed;      /* Gameplay seed of the game. */
+    int grid;           /* Grid side length. */
+    int tray;           /* Pieces per set. */
+    int mode;           /* 0 = empty start, 1 = partially filled start. */
+    bool fair;          /* Fair trays. */
+    long fair_timeouts; /* Fair deals decided by the clock. */
+    long score;         /* Claimed final score. */
+    int highest_combo;  /* Claimed highest combo. */
+    int count;          /* Drops recorded. */
+    int cap;            /* Capacity of moves. */
+    uint16_t *moves;    /* Drops, REPLAY_MOVE() encoded. */
+    bool lost;          /* A drop could not be stored (out of memory). */
+    int key_interval;   /* Drops between keyframes. */
+    int key_size;       /* Bytes per keyframe. */
+    int key_count;      /* Keyframes held. */
+    size_t key_cap;     /* Bytes allocated for keys. */
+    uint8_t *keys;      /* key_count keyframes of key_size bytes. */
+} Replay;
+
+void blockblaster_replay_begin(Replay *r, uint64_t seed, int grid, int tray,
+                               int mode, bool fair);
+bool blockblaster_replay_add(Replay *r, int slot, int gx, int gy);
+void blockblaster_replay_undo(Replay *r);
+void blockblaster_replay_finish(Replay *r, const CoreGame *c);
+void blockblaster_replay_free(Replay *r);
+size_t blockblaster_replay_size(const Replay *r);
+void blockblaster_replay_encode(const Replay *r, uint8_t *out);
+bool blockblaster_replay_decode(Replay *r, const uint8_t *buf, size_t len);
+bool blockblaster_replay_start(const Replay *r, CoreGame *c);
+bool blockblaster_replay_index(Replay *r);
+bool blockblaster_replay_seek(const Replay *r, int move, CoreGame *c);
+ReplayStatus blockblaster_replay_verify(const Replay *r, CoreGame *c,
+                                        int *fail_move);
+const char *blockblaster_replay_status_name(ReplayStatus s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLOCKBLASTER_REPLAY__ */
@@ -0,0 +1,399 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_replay_verify.c
+ * \brief Batch replay verifier.
+ *
+ * Re-simulates replay files (see blockblaster_replay.h) headless and checks
+ * that every drop is legal, that the game is over after the last one, that
+ * the keyframes match the game and that the final score and highest combo
+ * are the ones recorded.  With -s, each entry of a high-score file that
+ * names a replay seed is also checked against the replay of that seed.
+ *
+ * Files are spread over worker threads that claim them one at a time from
+ * a shared counter, so thousands of replays verify in parallel; a replay
+ * only costs its drops (a few microseconds per game).
+ *
+ * -g writes sample replays played by a placement policy, over every grid
+ * size, tray count, start mode and fair trays, to exercise the verifier.
+ *
+ * Usage: BlockBlasterReplay [-t threads] [-s scores_file] file...
+ *        BlockBlasterReplay -g count [-o dir] [-p policy]
+ */
+
+#include "blockblaster_policy.h"
+#include "blockblaster_replay.h"
+#include "blockblaster_simd.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Most worker threads accepted on the command line. */
+#define REPLAY_MAX_THREADS 256
+
+/* Largest replay file read (a 20x20 game rarely passes a few thousand
+   drops, 2 bytes each plus a keyframe every REPLAY_KEYFRAME_INTERVAL). */
+#define REPLAY_MAX_FILE (16 << 20)
+
+/* Most high-score entries read from a scores file. */
+#define REPLAY_MAX_SCORES 64
+
+/* Outcome of one file. */
+typedef struct {
+    bool read; /* File read and decoded. */
+    ReplayStatus status;
+    int fail_move; /* First illegal drop, or -1. */
+    uint64_t seed;
+    int grid;
+    int tray;
+    long score;        /* Claimed score. */
+    int highest_combo; /* Claimed highest combo. */
+    long moves;
+} FileResult;
+
+/* Files shared by all workers. */
+typedef struct {
+    char **paths;
+    FileResult *results;
+    long count;
+    long next; /* Next unclaimed file (atomic). */
+} VerifyRun;
+
+/* Wall-clock time in seconds. */
+static double replay_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/* Read a whole file into *buf (grown as needed).  Returns its length, or
+   -1 if it cannot be read or is larger than REPLAY_MAX_FILE. */
+static long read_file(const char *path, uint8_t **buf, long *cap)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return -1;
+    long len = -1;
+    if (fseek(f, 0, SEEK_END) == 0 && (len = ftell(f)) >= 0 &&
+        len <= REPLAY_MAX_FILE && fseek(f, 0, SEEK_SET) == 0) {
+        if (len > *cap) {
+            uint8_t *b = realloc(*buf, (size_t) len);
+            if (b) {
+                *buf = b;
+                *cap = len;
+            }
+        }
+        if (len > *cap || fread(*buf, 1, (size_t) len, f) != (size_t) len)
+            len = -1;
+    } else {
+        len = -1;
+    }
+    fclose(f);
+    return len;
+}
+
+/* ======================================================================== */
+/* Verification                                                              */
+/* ======================================================================== */
+
+static void *verify_worker(void *arg)
+{
+    VerifyRun *run = arg;
+    Replay r = {0};
+    CoreGame c;
+    uint8_t *buf = NULL;
+    long cap = 0;
+    for (;;) {
+        long i = __atomic_fetch_add(&run->next, 1, __ATOMIC_RELAXED);
+        if (i >= run->count)
+            break;
+        FileResult *fr = &run->results[i];
+        long len = read_file(run->paths[i], &buf, &cap);
+        if (len < 0 || !blockblaster_replay_decode(&r, buf, (size_t) len))
+            continue;
+        fr->read = true;
+        fr->status = blockblaster_replay_verify(&r, &c, &fr->fail_move);
+        fr->seed = r.seed;
+        fr->grid = r.grid;
+        fr->tray = r.tray;
+        fr->score = r.score;
+        fr->highest_combo = r.highest_combo;
+        fr->moves = r.count;
+    }
+    free(buf);
+    blockblaster_replay_free(&r);
+    return NULL;
+}
+
+/* Verify every file of run on nthreads workers.  Returns false if a thread
+   could not be started. */
+static bool verify_run(VerifyRun *run, int nthreads)
+{
+    pthread_t tid[REPLAY_MAX_THREADS];
+    run->next = 0;
+    for (int t = 0; t < nthreads; t++) {
+        if (pthread_create(&tid[t], NULL, verify_worker, run) != 0) {
+            fprintf(stderr, "cannot start worker thread %d\n", t);
+            for (int j = 0; j < t; j++)
+                pthread_join(tid[j], NULL);
+            return false;
+        }
+    }
+    for (int t = 0; t < nthreads; t++)
+        pthread_join(tid[t], NULL);
+    return true;
+}
+
+/* Check the entries of a high-score file (see
+   blockblaster_save_high_scores()) against the verified replays.  Entries
+   without a replay seed are skipped.  Returns the number of entries that
+   failed. */
+static int check_scores(const char *path, const VerifyRun *run)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return 1;
+    }
+    char line[128];
+    int count = 0, failed = 0, checked = 0;
+    if (!fgets(line, sizeof(line), f) || sscanf(line, "%d", &count) != 1)
+        count = 0;
+    for (int e = 0; e < count && e < REPLAY_MAX_SCORES &&
+                    fgets(line, sizeof(line), f);
+         e++) {
+        int gw, gh, tc, combo;
+        long score;
+        char name[8];
+        unsigned long long seed = 0;
+        if (sscanf(line, "%d %d %d %ld %d %7s %llx", &gw, &gh, &tc, &score,
+                   &combo, name, &seed) < 7 ||
+            seed == 0)
+            continue;
+        checked++;
+
+        const FileResult *fr = NULL;
+        for (long i = 0; i < run->count && !fr; i++)
+            if (run->results[i].read && run->results[i].seed == seed)
+                fr = &run->results[i];
+        const char *why = NULL;
+        if (!fr)
+            why = "no replay given";
+        else if (fr->status != REPLAY_OK)
+            why = blockblaster_replay_status_name(fr->status);
+        else if (fr->score != score || fr->highest_combo != combo ||
+                 fr->grid != gw || fr->grid != gh || fr->tray != tc)
+            why = "entry differs from its replay";
+        if (why) {
+            printf("%s: entry %d (%s, %ld): %s\n", path, e + 1, name, score,
+                   why);
+            failed++;
+        }
+    }
+    fclose(f);
+    printf("%s: %d entries with replays, %d failed\n", path, checked, failed);
+    return failed;
+}
+
+/* ======================================================================== */
+/* Sample replays                                                            */
+/* ======================================================================== */
+
+/* Play count games with policy and write their replays to dir, cycling
+   through the grid sizes, tray counts, start modes and fair trays.
+   Returns false on a write error. */
+static bool generate(long count, const char *dir, const Policy *policy)
+{
+    static const int grids[] = {10, 15, 20};
+    Replay r = {0};
+    CoreGame c;
+    uint8_t *buf = NULL;
+    bool ok = true;
+    for (long g = 0; g < count && ok; g++) {
+        int grid = grids[g % 3];
+        int tray = 1 + (int) (g / 3 % PIECES_PER_SET_MAX);
+        int mode = (int) (g / (3 * PIECES_PER_SET_MAX) % 2);
+        bool fair = g / (6 * PIECES_PER_SET_MAX) % 2 != 0;
+        uint64_t seed = (uint64_t) g + 1;
+        Rng pr;
+        blockblaster_rng_seed(&pr, seed, RNG_STREAM_COSMETIC);
+
+        blockblaster_replay_begin(&r, seed, grid, tray, mode, fair);
+        if (!blockblaster_replay_start(&r, &c)) {
+            ok = false;
+            break;
+        }
+        PolicyMove pm;
+        while (!c.game_over && policy->choose(&c, &pr, &pm) &&
+               blockblaster_core_drop(&c, pm.slot, pm.gx, pm.gy, NULL))
+            blockblaster_replay_add(&r, pm.slot, pm.gx, pm.gy);
+        blockblaster_replay_finish(&r, &c);
+        if (!blockblaster_replay_index(&r)) {
+            ok = false;
+            break;
+        }
+
+        size_t len = blockblaster_replay_size(&r);
+        uint8_t *b = realloc(buf, len);
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/sample_%06ld.bbr", dir, g);
+        FILE *f = b ? fopen(path, "wb") : NULL;
+        if (b)
+            buf = b;
+        if (!f) {
+            fprintf(stderr, "%s: cannot write\n", path);
+            ok = false;
+            break;
+        }
+        blockblaster_replay_encode(&r, buf);
+        ok = fwrite(buf, 1, len, f) == len;
+        ok = fclose(f) == 0 && ok && !r.lost;
+    }
+    free(buf);
+    blockblaster_replay_free(&r);
+    return ok;
+}
+
+/* ======================================================================== */
+/* Command line                                                              */
+/* ======================================================================== */
+
+static int default_threads(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > 0)
+        return n > REPLAY_MAX_THREADS ? REPLAY_MAX_THREADS : (int) n;
+#endif
+    return 1;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-t threads] [-s scores_file] file...\n"
+            "       %s -g count [-o dir] [-p policy]\n"
+            "  -t  worker threads (default: online CPUs)\n"
+            "  -s  also check the entries of a high-score file against "
+            "the replays\n"
+            "  -g  write count sample replays played by a policy\n"
+            "  -o  directory for -g (default .)\n"
+            "  -p  placement policy for -g (default %s)\n",
+            prog, prog, POLICIES[0].name);
+}
+
+/**
+ * \brief Replay verifier entry point.
+ *
+ * \param argc  Argument count.
+ * \param argv  Options and replay files, see usage().
+ * \return      0 if every replay (and high-score entry) verified, 1
+ *              otherwise or on a bad option.
+ */
+int main(int argc, char *argv[])
+{
+    int nthreads = default_threads();
+    const char *scores = NULL;
+    const char *dir = ".";
+    const Policy *policy = &POLICIES[0];
+    long gen = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:s:g:o:p:h")) != -1) {
+        switch (opt) {
+        case 't':
+            nthreads = atoi(optarg);
+            break;
+        case 's':
+            scores = optarg;
+            break;
+        case 'g':
+            gen = atol(optarg);
+            break;
+        case 'o':
+            dir = optarg;
+            break;
+        case 'p':
+            policy = blockblaster_policy_find(optarg);
+            if (!policy) {
+                fprintf(stderr, "unknown policy '%s'\n", optarg);
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (nthreads <= 0 || nthreads > REPLAY_MAX_THREADS || gen < 0 ||
+        (gen == 0 && optind >= argc)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    /* Both are built lazily on first use; build them before the workers
+       start so no thread races on the shared tables. */
+    blockblaster_scan_init();
+    blockblaster_shape_sampler_init();
+
+    if (gen > 0) {
+        if (!generate(gen, dir, policy))
+            return 1;
+        printf("Wrote %ld replays to %s\n", gen, dir);
+        return 0;
+    }
+
+    VerifyRun run = {argv + optind, NULL, argc - optind, 0};
+    run.results = calloc((size_t) run.count, sizeof(*run.results));
+    if (!run.results) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    double t0 = replay_now();
+    if (!verify_run(&run, nthreads)) {
+        free(run.results);
+        return 1;
+    }
+    double dt = replay_now() - t0;
+
+    long ok = 0, failed = 0, unverifiable = 0, moves = 0;
+    for (long i = 0; i < run.count; i++) {
+        const FileResult *fr = &run.results[i];
+        if (!fr->read) {
+            printf("%s: not a readable replay\n", run.paths[i]);
+            failed++;
+            continue;
+        }
+        moves += fr->moves;
+        if (fr->status == REPLAY_OK) {
+            ok++;
+            continue;
+        }
+        if (fr->status == REPLAY_UNVERIFIABLE)
+            unverifiable++;
+        else
+            failed++;
+        if (fr->fail_move >= 0)
+            printf("%s: %s (drop %d)\n", run.paths[i],
+                   blockblaster_replay_status_name(fr->status), fr->fail_move);
+        else
+            printf("%s: %s\n", run.paths[i],
+                   blockblaster_replay_status_name(fr->status));
+    }
+    printf("%ld replays, %ld ok, %ld failed, %ld unverifiable, %d thread%s, "
+           "%.0f replays/s, %.4g moves/s\n",
+           run.count, ok, failed, unverifiable, nthreads,
+           nthreads == 1 ? "" : "s", dt > 0.0 ? run.count / dt : 0.0,
+           dt > 0.0 ? moves / dt : 0.0);
+
+    if (scores)
+        failed += check_scores(scores, &run);
+    free(run.results);
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,257 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_shape_masks.h
+ * \brief Precomputed bitmasks for every entry of SHAPES[].
+ *
+ * GENERATED by gen_shape_masks.py from blockblaster_shapes.h -- do not
+ * edit by hand.  Regenerate with `make shape-masks` after changing the
+ * shape table.
+ */
+
+#ifndef __BLOCKBLASTER_SHAPE_MASKS__
+#define __BLOCKBLASTER_SHAPE_MASKS__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Bitmask companion of SHAPES[]; SHAPE_MASKS[i] describes SHAPES[i].
+ */
+static const ShapeMask SHAPE_MASKS[] = {
+    /* [0] 1 */
+    {1, 1, 1, 0, 0, 0, 0,
+     {0x01, 0x00, 0x00, 0x00, 0x00},
+     {0x01, 0x00, 0x00, 0x00, 0x00},
+     {{0, 0}}},
+    /* [1] I2 */
+    {2, 1, 2, 0, 0, 1, 0,
+     {0x03, 0x00, 0x00, 0x00, 0x00},
+     {0x01, 0x01, 0x00, 0x00, 0x00},
+     {{0, 0}, {1, 0}}},
+    /* [2] V2 */
+    {1, 2, 2, 0, 0, 0, 1,
+     {0x01, 0x01, 0x00, 0x00, 0x00},
+     {0x03, 0x00, 0x00, 0x00, 0x00},
+     {{0, 0}, {0, 1}}},
+    /* [3] I3 */
+    {3, 1, 3, 0, 0, 2, 0,
+     {0x07, 0x00, 0x00, 0x00, 0x00},
+     {0x01, 0x01, 0x01, 0x00, 0x00},
+     {{0, 0}, {1, 0}, {2, 0}}},
+    /* [4] V3 */
+    {1, 3, 3, 0, 0, 0, 2,
+     {0x01, 0x01, 0x01, 0x00, 0x00},
+     {0x07, 0x00, 0x00, 0x00, 0x00},
+     {{0, 0}, {0, 1}, {0, 2}}},
+    /* [5] D\2 */
+    {2, 2, 2, 0, 0, 1, 1,
+     {0x01, 0x02, 0x00, 0x00, 0x00},
+     {0x01, 0x02, 0x00, 0x00, 0x00},
+     {{0, 0}, {1, 1}}},
+    /* [6] D/2 */
+    {2, 2, 2, 0, 0, 1, 1,
+     {0x02, 0x01, 0x00, 0x00, 0x00},
+     {0x02, 0x01, 0x00, 0x00, 0x00},
+     {{1, 0}, {0, 1}}},
+    /* [7] L2 */
+    {2, 2, 3, 0, 0, 1, 1,
+     {0x01, 0x03, 0x00, 0x00, 0x00},
+     {0x03, 0x02, 0x00, 0x00, 0x00},
+     {{0, 0}, {0, 1}, {1, 1}}},
+    /* [8] J2 */
+    {2, 2, 3, 0, 0, 1, 1,
+     {0x02, 0x03, 0x00, 0x00, 0x00},
+     {0x02, 0x03, 0x00, 0x00, 0x00},
+     {{1, 0}, {0, 1}, {1, 1}}},
+    /* [9] O2 */
+    {2, 2, 4, 0, 0, 1, 1,
+     {0x03, 0x03, 0x00, 0x00, 0x00},
+     {0x03, 0x03, 0x00, 0x00, 0x00},
+     {{0, 0}, {1, 0}, {0, 1}, {1, 1}}},
+    /* [10] L3a */
+    {3, 2, 4, 0, 0, 2, 1,
+     {0x01, 0x07, 0x00, 0x00, 0x00},
+     {0x03, 0x02, 0x02, 0x00, 0x00},
+     {{0, 0}, {0, 1}, {1, 1}, {2, 1}}},
+    /* [11] L3b */
+    {2, 3, 4, 0, 0, 1, 2,
+     {0x03, 0x01, 0x01, 0x00, 0x00},
+     {0x07, 0x01, 0x00, 0x00, 0x00},
+     {{0, 0}, {1, 0}, {0, 1}, {0, 2}}},
+    /* [12] J3a */
+    {3, 2, 4, 0, 0, 2, 1,
+     {0x04, 0x07, 0x00, 0x00, 0x00},
+     {0x02, 0x02, 0x03, 0x00, 0x00},
+     {{2, 0}, {0, 1}, {1, 1}, {2, 1}}},
+    /* [13] J3b */
+    {2, 3, 4, 0, 0, 1, 2,
+     {0x03, 0x02, 0x02, 0x00, 0x00},
+     {0x01, 0x07, 0x00, 0x00, 0x00},
+     {{0, 0}, {1, 0}, {1, 1}, {1, 2}}},
+    /* [14] T */
+    {3, 2, 4, 0, 0, 2, 1,
+     {0x07, 0x02, 0x00, 0x00, 0x00},
+     {0x01, 0x03, 0x01, 0x00, 0x00},
+     {{0, 0}, {1, 0}, {2, 0}, {1, 1}}},
+    /* [15] T_flip */
+    {3, 2, 4, 0, 0, 2, 1,
+     {0x02, 0x07, 0x00, 0x00, 0x00},
+     {0x02, 0x03, 0x02, 0x00, 0x00},
+     {{1, 0}, {0, 1}, {1, 1}, {2, 1}}},
+    /* [16] T_left */
+    {2, 3, 4, 0, 0, 1, 2,
+     {0x02, 0x03, 0x02, 0x00, 0x00},
+     {0x02, 0x07, 0x00, 0x00, 0x00},
+     {{1, 0}, {0, 1}, {1, 1}, {1, 2}}},
+    /* [17] T_right */
+    {2, 3, 4, 0, 0, 1, 2,
+     {0x01, 0x03, 0x01, 0x00, 0x00},
+     {0x07, 0x02, 0x00, 0x00, 0x00},
+     {{0, 0}, {0, 1}, {1, 1}, {0, 2}}},
+    /* [18] S */
+    {3, 2, 4, 0, 0, 2, 1,
+     {0x03, 0x06, 0x00, 0x00, 0x00},
+     {0x01, 0x03, 0x02, 0x00, 0x00},
+     {{0, 0}, {1, 0}, {1, 1}, {2, 1}}},
+    /* [19] SV */
+    {2, 3, 4, 0, 0, 1, 2,
+     {0x02, 0x03, 0x01, 0x00, 0x00},
+     {0x06, 0x03, 0x00, 0x00, 0x00},
+     {{1, 0}, {0, 1}, {1, 1}, {0, 2}}},
+    /* [20] Z */
+    {3, 2, 4, 0, 0, 2, 1,
+     {0x06, 0x03, 0x00, 0x00, 0x00},
+     {0x02, 0x03, 0x01, 0x00, 0x00},
+     {{1, 0}, {2, 0}, {0, 1}, {1, 1}}},
+    /* [21] ZV */
+    {2, 3, 4, 0, 0, 1, 2,
+     {0x01, 0x03, 0x02, 0x00, 0x00},
+     {0x03, 0x06, 0x00, 0x00, 0x00},
+     {{0, 0}, {0, 1}, {1, 1}, {1, 2}}},
+    /* [22] C3a */
+    {3, 2, 4, 0, 0, 2, 1,
+     {0x07, 0x01, 0x00, 0x00, 0x00},
+     {0x03, 0x01, 0x01, 0x00, 0x00},
+     {{0, 0}, {1, 0}, {2, 0}, {0, 1}}},
+    /* [23] C3c */
+    {3, 2, 4, 0, 0, 2, 1,
+     {0x07, 0x04, 0x00, 0x00, 0x00},
+     {0x01, 0x01, 0x03, 0x00, 0x00},
+     {{0, 0}, {1, 0}, {2, 0}, {2, 1}}},
+    /* [24] I4 */
+    {4, 1, 4, 0, 0, 3, 0,
+     {0x0f, 0x00, 0x00, 0x00, 0x00},
+     {0x01, 0x01, 0x01, 0x01, 0x00},
+     {{0, 0}, {1, 0}, {2, 0}, {3, 0}}},
+    /* [25] V4 */
+    {1, 4, 4, 0, 0, 0, 3,
+     {0x01, 0x01, 0x01, 0x01, 0x00},
+     {0x0f, 0x00, 0x00, 0x00, 0x00},
+     {{0, 0}, {0, 1}, {0, 2}, {0, 3}}},
+    /* [26] L4 */
+    {3, 3, 5, 0, 0, 2, 2,
+     {0x01, 0x01, 0x07, 0x00, 0x00},
+     {0x07, 0x04, 0x04, 0x00, 0x00},
+     {{0, 0}, {0, 1}, {0, 2}, {1, 2}, {2, 2}}},
+    /* [27] J4 */
+    {3, 3, 5, 0, 0, 2, 2,
+     {0x04, 0x04, 0x07, 0x00, 0x00},
+     {0x04, 0x04, 0x07, 0x00, 0x00},
+     {{2, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}}},
+    /* [28] T4 */
+    {3, 3, 5, 0, 0, 2, 2,
+     {0x07, 0x02, 0x02, 0x00, 0x00},
+     {0x01, 0x07, 0x01, 0x00, 0x00},
+     {{0, 0}, {1, 0}, {2, 0}, {1, 1}, {1, 2}}},
+    /* [29] T4R */
+    {3, 3, 5, 0, 0, 2, 2,
+     {0x02, 0x02, 0x07, 0x00, 0x00},
+     {0x04, 0x07, 0x04, 0x00, 0x00},
+     {{1, 0}, {1, 1}, {0, 2}, {1, 2}, {2, 2}}},
+    /* [30] U3x2 */
+    {3, 2, 5, 0, 0, 2, 1,
+     {0x05, 0x07, 0x00, 0x00, 0x00},
+     {0x03, 0x02, 0x03, 0x00, 0x00},
+     {{0, 0}, {2, 0}, {0, 1}, {1, 1}, {2, 1}}},
+    /* [31] U3x2_flip */
+    {3, 2, 5, 0, 0, 2, 1,
+     {0x07, 0x05, 0x00, 0x00, 0x00},
+     {0x03, 0x01, 0x03, 0x00, 0x00},
+     {{0, 0}, {1, 0}, {2, 0}, {0, 1}, {2, 1}}},
+    /* [32] U2x3_right */
+    {2, 3, 5, 0, 0, 1, 2,
+     {0x03, 0x01, 0x03, 0x00, 0x00},
+     {0x07, 0x05, 0x00, 0x00, 0x00},
+     {{0, 0}, {1, 0}, {0, 1}, {0, 2}, {1, 2}}},
+    /* [33] U2x3_left */
+    {2, 3, 5, 0, 0, 1, 2,
+     {0x03, 0x02, 0x03, 0x00, 0x00},
+     {0x05, 0x07, 0x00, 0x00, 0x00},
+     {{0, 0}, {1, 0}, {1, 1}, {0, 2}, {1, 2}}},
+    /* [34] R3x2 */
+    {3, 2, 6, 0, 0, 2, 1,
+     {0x07, 0x07, 0x00, 0x00, 0x00},
+     {0x03, 0x03, 0x03, 0x00, 0x00},
+     {{0, 0}, {1, 0}, {2, 0}, {0, 1}, {1, 1}, {2, 1}}},
+    /* [35] R2x3 */
+    {2, 3, 6, 0, 0, 1, 2,
+     {0x03, 0x03, 0x03, 0x00, 0x00},
+     {0x07, 0x07, 0x00, 0x00, 0x00},
+     {{0, 0}, {1, 0}, {0, 1}, {1, 1}, {0, 2}, {1, 2}}},
+    /* [36] Plus */
+    {3, 3, 5, 0, 0, 2, 2,
+     {0x02, 0x07, 0x02, 0x00, 0x00},
+     {0x02, 0x07, 0x02, 0x00, 0x00},
+     {{1, 0}, {0, 1}, {1, 1}, {2, 1}, {1, 2}}},
+    /* [37] O3 */
+    {3, 3, 9, 0, 0, 2, 2,
+     {0x07, 0x07, 0x07, 0x00, 0x00},
+     {0x07, 0x07, 0x07, 0x00, 0x00},
+     {{0, 0}, {1, 0}, {2, 0}, {0, 1}, {1, 1}, {2, 1}, {0, 2}, {1, 2}, {2, 2}}},
+    /* [38] D\3 */
+    {3, 3, 3, 0, 0, 2, 2,
+     {0x01, 0x02, 0x04, 0x00, 0x00},
+     {0x01, 0x02, 0x04, 0x00, 0x00},
+     {{0, 0}, {1, 1}, {2, 2}}},
+    /* [39] D/3 */
+    {3, 3, 3, 0, 0, 2, 2,
+     {0x04, 0x02, 0x01, 0x00, 0x00},
+     {0x04, 0x02, 0x01, 0x00, 0x00},
+     {{2, 0}, {1, 1}, {0, 2}}},
+    /* [40] I5 */
+    {5, 1, 5, 0, 0, 4, 0,
+     {0x1f, 0x00, 0x00, 0x00, 0x00},
+     {0x01, 0x01, 0x01, 0x01, 0x01},
+     {{0, 0}, {1, 0}, {2, 0}, {3, 0}, {4, 0}}},
+    /* [41] V5 */
+    {1, 5, 5, 0, 0, 0, 4,
+     {0x01, 0x01, 0x01, 0x01, 0x01},
+     {0x1f, 0x00, 0x00, 0x00, 0x00},
+     {{0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}},
+    /* [42] D\4 */
+    {4, 4, 4, 0, 0, 3, 3,
+     {0x01, 0x02, 0x04, 0x08, 0x00},
+     {0x01, 0x02, 0x04, 0x08, 0x00},
+     {{0, 0}, {1, 1}, {2, 2}, {3, 3}}},
+    /* [43] D/4 */
+    {4, 4, 4, 0, 0, 3, 3,
+     {0x08, 0x04, 0x02, 0x01, 0x00},
+     {0x08, 0x04, 0x02, 0x01, 0x00},
+     {{3, 0}, {2, 1}, {1, 2}, {0, 3}}},
+};
+
+/* Fails to compile when SHAPE_MASKS[] and SHAPES[] differ in length;
+   BlockBlasterBench compares every entry. */
+typedef char shape_masks_match_shapes
+    [(sizeof(SHAPE_MASKS) / sizeof(SHAPE_MASKS[0]) ==
+      sizeof(SHAPES) / sizeof(SHAPES[0]))
+         ? 1
+         : -1];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLOCKBLASTER_SHAPE_MASKS__ */
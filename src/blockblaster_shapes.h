@@ -17,10 +17,13 @@
  * \file blockblaster_shapes.h
  * \brief Static table of all block shapes available in the game.
  *
- * Shapes are ordered from easiest (fewest filled cells) to hardest (most
- * filled cells).  This ordering is relied upon by the difficulty-weighting
- * system in bag_refill(): the first shape in the array has the lowest
- * difficulty index (d = 0) and the last has the highest (d = 1).
+ * Every distinct shape appears exactly once.  How often a shape is drawn is
+ * set by its own weight and difficulty columns (see Shape), not by its
+ * position or by repeating it, so per-shape tables such as SHAPE_MASKS[]
+ * hold one entry per distinct shape.
+ *
+ * The bitmask companion table SHAPE_MASKS[] is generated from this file by
+ * gen_shape_masks.py; run `make shape-masks` after editing SHAPES[].
  *
  * \author Castagnier Mickael aka Gull Ra Driel
  * \version 1.0
@@ -37,200 +40,154 @@ extern "C" {
 /**
  * \brief Read-only table of all block shapes offered to the player.
  *
- * Each entry is a Shape descriptor (w, h, cells[][], name).  The array is
- * declared static const so that every translation unit that includes this
- * header shares the same table without multiple-definition errors (the
- * compiler elides unused copies).
+ * Each entry is a Shape descriptor (w, h, cells[][], name, weight,
+ * difficulty).  The array is declared static const so that every
+ * translation unit that includes this header shares the same table without
+ * multiple-definition errors (the compiler elides unused copies).
  *
- * Order matters: shapes must be sorted from fewest to most occupied cells so
- * that weighted_shape_index() can compute a normalised difficulty value d in
- * [0, 1] by position alone.
+ * Entries are listed from easiest to hardest for readability.  The weights
+ * and difficulties reproduce the former table, in which the smallest shapes
+ * were repeated (four dots, bars and "V" pieces, two short diagonals) and
+ * difficulty was the position i / 60: a weight-n entry carries the mean
+ * position of its n former copies.
  */
 static const Shape SHAPES[] = {
 
     /* [X]  single cell dot */
-    {1, 1, {{true}}, "1"},
-    /* [X]  single cell dot (duplicate for statistical balance) */
-    {1, 1, {{true}}, "1"},
-    /* [X]  single cell dot (duplicate for statistical balance) */
-    {1, 1, {{true}}, "1"},
-    /* [X]  single cell dot (duplicate for statistical balance) */
-    {1, 1, {{true}}, "1"},
+    {1, 1, {{true}}, "1", 4, 0.025f},
 
     /* [X][X]  2x1 horizontal bar */
-    {2, 1, {{true, true}}, "I2"},
-    /* [X][X]  2x1 horizontal bar (duplicate for statistical balance) */
-    {2, 1, {{true, true}}, "I2"},
-    /* [X][X]  2x1 horizontal bar (duplicate for statistical balance) */
-    {2, 1, {{true, true}}, "I2"},
-    /* [X][X]  2x1 horizontal bar (duplicate for statistical balance) */
-    {2, 1, {{true, true}}, "I2"},
+    {2, 1, {{true, true}}, "I2", 4, 0.091667f},
 
     /* [X]
        [X]
        1x2 vertical bar */
-    {1, 2, {{true}, {true}}, "V2"},
-    /* [X]
-       [X]
-       1x2 vertical bar (duplicate for statistical balance) */
-    {1, 2, {{true}, {true}}, "V2"},
-    /* [X]
-       [X]
-       1x2 vertical bar (duplicate for statistical balance) */
-    {1, 2, {{true}, {true}}, "V2"},
-    /* [X]
-       [X]
-       1x2 vertical bar (duplicate for statistical balance) */
-    {1, 2, {{true}, {true}}, "V2"},
+    {1, 2, {{true}, {true}}, "V2", 4, 0.158333f},
 
     /* [X][X][X]  3x1 horizontal bar */
-    {3, 1, {{true, true, true}}, "I3"},
-    /* [X][X][X]  3x1 horizontal bar (duplicate for statistical balance) */
-    {3, 1, {{true, true, true}}, "I3"},
-    /* [X][X][X]  3x1 horizontal bar (duplicate for statistical balance) */
-    {3, 1, {{true, true, true}}, "I3"},
-    /* [X][X][X]  3x1 horizontal bar (duplicate for statistical balance) */
-    {3, 1, {{true, true, true}}, "I3"},
+    {3, 1, {{true, true, true}}, "I3", 4, 0.225f},
 
     /* [X]
        [X]
        [X]
        1x3 vertical bar */
-    {1, 3, {{true}, {true}, {true}}, "V3"},
-    /* [X]
-       [X]
-       [X]
-       1x3 vertical bar (duplicate for statistical balance) */
-    {1, 3, {{true}, {true}, {true}}, "V3"},
-    /* [X]
-       [X]
-       [X]
-       1x3 vertical bar (duplicate for statistical balance) */
-    {1, 3, {{true}, {true}, {true}}, "V3"},
-    /* [X]
-       [X]
-       [X]
-       1x3 vertical bar (duplicate for statistical balance) */
-    {1, 3, {{true}, {true}, {true}}, "V3"},
+    {1, 3, {{true}, {true}, {true}}, "V3", 4, 0.291667f},
 
     /* [X][ ]
        [ ][X]
        2x2 diagonal (backslash) */
-    {2, 2, {{true, false}, {false, true}}, "D\\2"},
-    /* [X][ ]
-       [ ][X]
-       2x2 diagonal (backslash) (duplicate for statistical balance) */
-    {2, 2, {{true, false}, {false, true}}, "D\\2"},
+    {2, 2, {{true, false}, {false, true}}, "D\\2", 2, 0.341667f},
 
     /* [ ][X]
        [X][ ]
        2x2 diagonal (forward slash) */
-    {2, 2, {{false, true}, {true, false}}, "D/2"},
-    /* [ ][X]
-       [X][ ]
-       2x2 diagonal (forward slash) (duplicate for statistical balance) */
-    {2, 2, {{false, true}, {true, false}}, "D/2"},
+    {2, 2, {{false, true}, {true, false}}, "D/2", 2, 0.375f},
 
     /* [X][ ]
        [X][X]
        2x2 L-shape (top-right cell missing) */
-    {2, 2, {{true, false}, {true, true}}, "L2"},
+    {2, 2, {{true, false}, {true, true}}, "L2", 1, 0.4f},
 
     /* [ ][X]
        [X][X]
        2x2 J-shape (top-left cell missing) */
-    {2, 2, {{false, true}, {true, true}}, "J2"},
+    {2, 2, {{false, true}, {true, true}}, "J2", 1, 0.416667f},
 
     /* [X][X]
        [X][X]
        2x2 full block */
-    {2, 2, {{true, true}, {true, true}}, "O2"},
+    {2, 2, {{true, true}, {true, true}}, "O2", 1, 0.433333f},
 
     /* [X][ ][ ]
        [X][X][X]
        3x2 L-shape (left column + full bottom row) */
-    {3, 2, {{true, false, false}, {true, true, true}}, "L3a"},
+    {3, 2, {{true, false, false}, {true, true, true}}, "L3a", 1, 0.45f},
 
     /* [X][X]
        [X][ ]
        [X][ ]
        2x3 L-shape (full top row + left column extending down) */
-    {2, 3, {{true, true}, {true, false}, {true, false}}, "L3b"},
+    {2, 3, {{true, true}, {true, false}, {true, false}}, "L3b", 1, 0.466667f},
 
     /* [ ][ ][X]
        [X][X][X]
        3x2 J-shape (right column + full bottom row) */
-    {3, 2, {{false, false, true}, {true, true, true}}, "J3a"},
+    {3, 2, {{false, false, true}, {true, true, true}}, "J3a", 1, 0.483333f},
 
     /* [X][X]
        [ ][X]
        [ ][X]
        2x3 J-shape (full top row + right column extending down) */
-    {2, 3, {{true, true}, {false, true}, {false, true}}, "J3b"},
+    {2, 3, {{true, true}, {false, true}, {false, true}}, "J3b", 1, 0.5f},
 
     /* [X][X][X]
        [ ][X][ ]
        3x2 T-shape (full top row + centre cell below) */
-    {3, 2, {{true, true, true}, {false, true, false}}, "T"},
+    {3, 2, {{true, true, true}, {false, true, false}}, "T", 1, 0.516667f},
 
     /* [ ][X][ ]
        [X][X][X]
        3x2 T-shape flipped (centre cell on top + full bottom row) */
-    {3, 2, {{false, true, false}, {true, true, true}}, "T_flip"},
+    {3, 2, {{false, true, false}, {true, true, true}}, "T_flip", 1, 0.533333f},
 
     /* [ ][X]
        [X][X]
        [ ][X]
        2x3 T-shape rotated left (right column + centre cell to the left) */
-    {2, 3, {{false, true}, {true, true}, {false, true}}, "T_left"},
+    {2, 3, {{false, true}, {true, true}, {false, true}}, "T_left", 1, 0.55f},
 
     /* [X][ ]
        [X][X]
        [X][ ]
        2x3 T-shape rotated right (left column + centre cell to the right) */
-    {2, 3, {{true, false}, {true, true}, {true, false}}, "T_right"},
+    {2,
+     3,
+     {{true, false}, {true, true}, {true, false}},
+     "T_right",
+     1,
+     0.566667f},
 
     /* [X][X][ ]
        [ ][X][X]
        3x2 S-shape (horizontal) */
-    {3, 2, {{true, true, false}, {false, true, true}}, "S"},
+    {3, 2, {{true, true, false}, {false, true, true}}, "S", 1, 0.583333f},
 
     /* [ ][X]
        [X][X]
        [X][ ]
        2x3 S-shape (vertical) */
-    {2, 3, {{false, true}, {true, true}, {true, false}}, "SV"},
+    {2, 3, {{false, true}, {true, true}, {true, false}}, "SV", 1, 0.6f},
 
     /* [ ][X][X]
        [X][X][ ]
        3x2 Z-shape (horizontal mirror of S) */
-    {3, 2, {{false, true, true}, {true, true, false}}, "Z"},
+    {3, 2, {{false, true, true}, {true, true, false}}, "Z", 1, 0.616667f},
 
     /* [X][ ]
        [X][X]
        [ ][X]
        2x3 Z-shape (vertical mirror of SV) */
-    {2, 3, {{true, false}, {true, true}, {false, true}}, "ZV"},
+    {2, 3, {{true, false}, {true, true}, {false, true}}, "ZV", 1, 0.633333f},
 
     /* [X][X][X]
        [X][ ][ ]
        3x2 C-shape open on the right */
-    {3, 2, {{true, true, true}, {true, false, false}}, "C3a"},
+    {3, 2, {{true, true, true}, {true, false, false}}, "C3a", 1, 0.65f},
 
     /* [X][X][X]
        [ ][ ][X]
        3x2 C-shape open on the left */
-    {3, 2, {{true, true, true}, {false, false, true}}, "C3c"},
+    {3, 2, {{true, true, true}, {false, false, true}}, "C3c", 1, 0.666667f},
 
     /* [X][X][X][X]  4x1 horizontal bar */
-    {4, 1, {{true, true, true, true}}, "I4"},
+    {4, 1, {{true, true, true, true}}, "I4", 1, 0.683333f},
 
     /* [X]
        [X]
        [X]
        [X]
        1x4 vertical bar */
-    {1, 4, {{true}, {true}, {true}, {true}}, "V4"},
+    {1, 4, {{true}, {true}, {true}, {true}}, "V4", 1, 0.7f},
 
     /* [X][ ][ ]
        [X][ ][ ]
@@ -239,7 +196,9 @@ static const Shape SHAPES[] = {
     {3,
      3,
      {{true, false, false}, {true, false, false}, {true, true, true}},
-     "L4"},
+     "L4",
+     1,
+     0.716667f},
 
     /* [ ][ ][X]
        [ ][ ][X]
@@ -248,7 +207,9 @@ static const Shape SHAPES[] = {
     {3,
      3,
      {{false, false, true}, {false, false, true}, {true, true, true}},
-     "J4"},
+     "J4",
+     1,
+     0.733333f},
 
     /* [X][X][X]
        [ ][X][ ]
@@ -257,7 +218,9 @@ static const Shape SHAPES[] = {
     {3,
      3,
      {{true, true, true}, {false, true, false}, {false, true, false}},
-     "T4"},
+     "T4",
+     1,
+     0.75f},
 
     /* [ ][X][ ]
        [ ][X][ ]
@@ -266,40 +229,52 @@ static const Shape SHAPES[] = {
     {3,
      3,
      {{false, true, false}, {false, true, false}, {true, true, true}},
-     "T4R"},
+     "T4R",
+     1,
+     0.766667f},
 
     /* [X][ ][X]
        [X][X][X]
        3x2 U-shape open on the bottom */
-    {3, 2, {{true, false, true}, {true, true, true}}, "U3x2"},
+    {3, 2, {{true, false, true}, {true, true, true}}, "U3x2", 1, 0.783333f},
 
     /* [X][X][X]
        [X][ ][X]
        3x2 U-shape open on the top */
-    {3, 2, {{true, true, true}, {true, false, true}}, "U3x2_flip"},
+    {3, 2, {{true, true, true}, {true, false, true}}, "U3x2_flip", 1, 0.8f},
 
     /* [X][X]
        [X][ ]
        [X][X]
        2x3 U-shape open on the right */
-    {2, 3, {{true, true}, {true, false}, {true, true}}, "U2x3_right"},
+    {2,
+     3,
+     {{true, true}, {true, false}, {true, true}},
+     "U2x3_right",
+     1,
+     0.816667f},
 
     /* [X][X]
        [ ][X]
        [X][X]
        2x3 U-shape open on the left */
-    {2, 3, {{true, true}, {false, true}, {true, true}}, "U2x3_left"},
+    {2,
+     3,
+     {{true, true}, {false, true}, {true, true}},
+     "U2x3_left",
+     1,
+     0.833333f},
 
     /* [X][X][X]
        [X][X][X]
        3x2 filled rectangle */
-    {3, 2, {{true, true, true}, {true, true, true}}, "R3x2"},
+    {3, 2, {{true, true, true}, {true, true, true}}, "R3x2", 1, 0.85f},
 
     /* [X][X]
        [X][X]
        [X][X]
        2x3 filled rectangle */
-    {2, 3, {{true, true}, {true, true}, {true, true}}, "R2x3"},
+    {2, 3, {{true, true}, {true, true}, {true, true}}, "R2x3", 1, 0.866667f},
 
     /* [ ][X][ ]
        [X][X][X]
@@ -308,13 +283,20 @@ static const Shape SHAPES[] = {
     {3,
      3,
      {{false, true, false}, {true, true, true}, {false, true, false}},
-     "Plus"},
+     "Plus",
+     1,
+     0.883333f},
 
     /* [X][X][X]
        [X][X][X]
        [X][X][X]
        3x3 full block (hardest fixed shape) */
-    {3, 3, {{true, true, true}, {true, true, true}, {true, true, true}}, "O3"},
+    {3,
+     3,
+     {{true, true, true}, {true, true, true}, {true, true, true}},
+     "O3",
+     1,
+     0.9f},
 
     /* ------------------------------------------------------------------ */
     /* Diagonal shapes                                                     */
@@ -327,7 +309,9 @@ static const Shape SHAPES[] = {
     {3,
      3,
      {{true, false, false}, {false, true, false}, {false, false, true}},
-     "D\\3"},
+     "D\\3",
+     1,
+     0.916667f},
 
     /* [ ][ ][X]
        [ ][X][ ]
@@ -336,10 +320,12 @@ static const Shape SHAPES[] = {
     {3,
      3,
      {{false, false, true}, {false, true, false}, {true, false, false}},
-     "D/3"},
+     "D/3",
+     1,
+     0.933333f},
 
     /* [X][X][X][X][X]  5x1 horizontal bar */
-    {5, 1, {{true, true, true, true, true}}, "I5"},
+    {5, 1, {{true, true, true, true, true}}, "I5", 1, 0.95f},
 
     /* [X]
        [X]
@@ -347,7 +333,7 @@ static const Shape SHAPES[] = {
        [X]
        [X]
        1x5 vertical bar */
-    {1, 5, {{true}, {true}, {true}, {true}, {true}}, "V5"},
+    {1, 5, {{true}, {true}, {true}, {true}, {true}}, "V5", 1, 0.966667f},
 
     /* [X][ ][ ][ ]
        [ ][X][ ][ ]
@@ -360,7 +346,9 @@ static const Shape SHAPES[] = {
       {false, true, false, false},
       {false, false, true, false},
       {false, false, false, true}},
-     "D\\4"},
+     "D\\4",
+     1,
+     0.983333f},
 
     /* [ ][ ][ ][X]
        [ ][ ][X][ ]
@@ -373,7 +361,9 @@ static const Shape SHAPES[] = {
       {false, false, true, false},
       {false, true, false, false},
       {true, false, false, false}},
-     "D/4"},
+     "D/4",
+     1,
+     1.0f},
 
 };
 
@@ -385,6 +375,8 @@ static const Shape SHAPES[] = {
  */
 static const int SHAPES_COUNT = (int) (sizeof(SHAPES) / sizeof(SHAPES[0]));
 
+#include "blockblaster_shape_masks.h"
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,493 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_sim.c
+ * \brief Parallel Monte Carlo self-play simulator for difficulty tuning.
+ *
+ * Plays many headless games with a placement policy (see
+ * blockblaster_policy.h) for every requested grid size and tray count, and
+ * reports throughput, score and game-length distributions and how often
+ * each shape was dealt.  Use it to check the effect of a change to the
+ * difficulty, bag or scoring constants without playing by hand.
+ *
+ * Games are spread over worker threads, one game at a time per thread.
+ * Each worker keeps private statistics that are merged after the run, so
+ * workers share nothing but a game counter and throughput scales with the
+ * number of cores.  Game g of a configuration is seeded from (seed, g) on
+ * its own PCG32 streams, so results do not depend on the thread count.
+ *
+ * Usage: BlockBlasterSim [-n games] [-t threads] [-p policy] [-g sizes]
+ *                        [-k trays] [-m mode] [-x max_moves] [-s seed]
+ */
+
+#include "blockblaster_policy.h"
+#include "blockblaster_simd.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Default number of games per grid size / tray count pair. */
+#define SIM_DEFAULT_GAMES 10000
+
+/* Default move cap; games still running after it count as truncated. */
+#define SIM_DEFAULT_MAX_MOVES 100000
+
+/* Games a worker claims from the shared counter at a time. */
+#define SIM_CHUNK 16
+
+/* Most worker threads accepted on the command line. */
+#define SIM_MAX_THREADS 256
+
+/* Histogram resolution: buckets per power of two (about 3% error on the
+   reported percentiles). */
+#define SIM_HIST_SUB_BITS 5
+#define SIM_HIST_SUB (1 << SIM_HIST_SUB_BITS)
+#define SIM_HIST_BUCKETS (64 * SIM_HIST_SUB)
+
+/* Number of SHAPES[] entries as a constant expression. */
+#define SIM_SHAPES ((int) (sizeof(SHAPE_MASKS) / sizeof(SHAPE_MASKS[0])))
+
+/* Most grid sizes and tray counts in one run. */
+#define SIM_MAX_LIST 8
+
+/* Log-linear histogram of non-negative integers, plus exact moments. */
+typedef struct {
+    long count[SIM_HIST_BUCKETS];
+    long n;
+    double sum;
+    double sumsq;
+    long min;
+    long max;
+} SimHist;
+
+/* Statistics of one grid size / tray count pair. */
+typedef struct {
+    int grid;
+    int tray;
+    long games;
+    long moves;
+    long truncated; /* Games stopped by the move cap. */
+    double seconds; /* Wall time of the whole configuration. */
+    SimHist score;
+    SimHist length;
+    long shapes[SIM_SHAPES]; /* Times each shape was dealt. */
+} SimStats;
+
+/* Parameters shared by all workers of one configuration. */
+typedef struct {
+    const Policy *policy;
+    uint64_t seed;
+    int grid;
+    int tray;
+    int mode;
+    long games;
+    long max_moves;
+    long next; /* Next unclaimed game index (atomic). */
+} SimRun;
+
+/* One worker thread and its private statistics. */
+typedef struct {
+    SimRun *run;
+    SimStats stats;
+} SimWorker;
+
+/* Wall-clock time in seconds. */
+static double sim_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/* ======================================================================== */
+/* Histograms                                                                */
+/* ======================================================================== */
+
+/* Bucket of v: exact below SIM_HIST_SUB, then SIM_HIST_SUB buckets per
+   power of two. */
+static int hist_bucket(long v)
+{
+    if (v < SIM_HIST_SUB)
+        return (int) v;
+    int e = 63 - __builtin_clzll((unsigned long long) v);
+    int shift = e - SIM_HIST_SUB_BITS;
+    return (shift + 1) * SIM_HIST_SUB + (int) (v >> shift) - SIM_HIST_SUB;
+}
+
+/* Smallest value falling in bucket b. */
+static long hist_bucket_low(int b)
+{
+    if (b < SIM_HIST_SUB)
+        return b;
+    int shift = b / SIM_HIST_SUB - 1;
+    return (long) (SIM_HIST_SUB + b % SIM_HIST_SUB) << shift;
+}
+
+static void hist_add(SimHist *h, long v)
+{
+    if (v < 0)
+        v = 0;
+    if (h->n == 0 || v < h->min)
+        h->min = v;
+    if (v > h->max)
+        h->max = v;
+    h->count[hist_bucket(v)]++;
+    h->n++;
+    h->sum += (double) v;
+    h->sumsq += (double) v * (double) v;
+}
+
+static void hist_merge(SimHist *dst, const SimHist *src)
+{
+    if (src->n == 0)
+        return;
+    if (dst->n == 0 || src->min < dst->min)
+        dst->min = src->min;
+    if (src->max > dst->max)
+        dst->max = src->max;
+    for (int b = 0; b < SIM_HIST_BUCKETS; b++)
+        dst->count[b] += src->count[b];
+    dst->n += src->n;
+    dst->sum += src->sum;
+    dst->sumsq += src->sumsq;
+}
+
+/* Value at quantile q in [0, 1]: the low edge of the bucket holding it,
+   clamped to the observed range. */
+static long hist_quantile(const SimHist *h, double q)
+{
+    if (h->n == 0)
+        return 0;
+    long rank = (long) (q * (double) (h->n - 1));
+    long seen = 0;
+    for (int b = 0; b < SIM_HIST_BUCKETS; b++) {
+        seen += h->count[b];
+        if (seen > rank) {
+            long v = hist_bucket_low(b);
+            return v < h->min ? h->min : (v > h->max ? h->max : v);
+        }
+    }
+    return h->max;
+}
+
+static void hist_print(const char *label, const SimStats *st,
+                       const SimHist *h)
+{
+    double mean = h->n ? h->sum / (double) h->n : 0.0;
+    double var = h->n ? h->sumsq / (double) h->n - mean * mean : 0.0;
+    char cfg[16];
+    snprintf(cfg, sizeof(cfg), "%dx%d/%d", st->grid, st->grid, st->tray);
+    printf("%-7s %-9s %10.1f %10.1f %8ld %8ld %8ld %8ld %8ld %9ld\n", label,
+           cfg, mean, var > 0.0 ? sqrt(var) : 0.0, hist_quantile(h, 0.10),
+           hist_quantile(h, 0.50), hist_quantile(h, 0.90),
+           hist_quantile(h, 0.99), h->min, h->max);
+}
+
+/* ======================================================================== */
+/* Self-play                                                                 */
+/* ======================================================================== */
+
+/* Count the shapes of a freshly dealt tray. */
+static void sim_count_tray(const CoreGame *c, SimStats *st)
+{
+    for (int i = 0; i < c->tray_count; i++)
+        st->shapes[c->tray[i].shape_id]++;
+}
+
+/* Play game g of a configuration to the end (or the move cap).  The rules
+   and the policy each get their own stream, derived from the game index
+   and the configuration so every game is independent and reproducible. */
+static void sim_play(const SimRun *run, long g, SimStats *st)
+{
+    static const CoreGame blank = {0};
+    CoreGame c = blank;
+    Rng pr;
+    uint64_t stream = ((uint64_t) run->grid << 48 | (uint64_t) run->tray << 40 |
+                       (uint64_t) g)
+                      << 1;
+    blockblaster_rng_seed(&c.rng, run->seed, stream);
+    blockblaster_rng_seed(&pr, run->seed, stream | 1u);
+
+    blockblaster_core_start(&c, run->grid, run->grid, run->tray, run->mode);
+    sim_count_tray(&c, st);
+
+    long moves = 0;
+    PolicyMove pm;
+    CoreMove mv;
+    while (!c.game_over && moves < run->max_moves) {
+        if (!run->policy->choose(&c, &pr, &pm) ||
+            !blockblaster_core_drop(&c, pm.slot, pm.gx, pm.gy, &mv))
+            break;
+        moves++;
+        if (mv.refilled)
+            sim_count_tray(&c, st);
+    }
+    if (!c.game_over)
+        st->truncated++;
+
+    st->games++;
+    st->moves += moves;
+    hist_add(&st->score, c.score);
+    hist_add(&st->length, moves);
+}
+
+static void *sim_worker(void *arg)
+{
+    SimWorker *w = arg;
+    SimRun *run = w->run;
+    for (;;) {
+        long g0 = __atomic_fetch_add(&run->next, SIM_CHUNK, __ATOMIC_RELAXED);
+        if (g0 >= run->games)
+            break;
+        long g1 = g0 + SIM_CHUNK < run->games ? g0 + SIM_CHUNK : run->games;
+        for (long g = g0; g < g1; g++)
+            sim_play(run, g, &w->stats);
+    }
+    return NULL;
+}
+
+/* Run every game of one configuration on nthreads workers and merge their
+   statistics into *out.  Returns false if a thread could not be started. */
+static bool sim_run(SimRun *run, int nthreads, SimWorker *workers,
+                    SimStats *out)
+{
+    pthread_t tid[SIM_MAX_THREADS];
+    double t0 = sim_now();
+    run->next = 0;
+    for (int t = 0; t < nthreads; t++) {
+        memset(&workers[t].stats, 0, sizeof(workers[t].stats));
+        workers[t].run = run;
+        if (pthread_create(&tid[t], NULL, sim_worker, &workers[t]) != 0) {
+            fprintf(stderr, "cannot start worker thread %d\n", t);
+            for (int j = 0; j < t; j++)
+                pthread_join(tid[j], NULL);
+            return false;
+        }
+    }
+    for (int t = 0; t < nthreads; t++)
+        pthread_join(tid[t], NULL);
+
+    memset(out, 0, sizeof(*out));
+    out->grid = run->grid;
+    out->tray = run->tray;
+    out->seconds = sim_now() - t0;
+    for (int t = 0; t < nthreads; t++) {
+        const SimStats *s = &workers[t].stats;
+        out->games += s->games;
+        out->moves += s->moves;
+        out->truncated += s->truncated;
+        hist_merge(&out->score, &s->score);
+        hist_merge(&out->length, &s->length);
+        for (int k = 0; k < SIM_SHAPES; k++)
+            out->shapes[k] += s->shapes[k];
+    }
+    return true;
+}
+
+/* ======================================================================== */
+/* Command line                                                              */
+/* ======================================================================== */
+
+/* Parse a comma-separated list of integers in [lo, hi].  Returns the
+   number of values, or -1 on a malformed or out-of-range entry. */
+static int parse_list(const char *s, int *out, int max, int lo, int hi)
+{
+    int n = 0;
+    while (*s) {
+        char *end;
+        long v = strtol(s, &end, 10);
+        if (end == s || v < lo || v > hi || n >= max)
+            return -1;
+        out[n++] = (int) v;
+        s = end;
+        if (*s == ',')
+            s++;
+        else if (*s)
+            return -1;
+    }
+    return n;
+}
+
+static int default_threads(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > 0)
+        return n > SIM_MAX_THREADS ? SIM_MAX_THREADS : (int) n;
+#endif
+    return 1;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-n games] [-t threads] [-p policy] [-g sizes] "
+            "[-k trays]\n"
+            "          [-m mode] [-x max_moves] [-s seed]\n"
+            "  -n  games per grid size / tray count (default %d)\n"
+            "  -t  worker threads (default: online CPUs)\n"
+            "  -p  placement policy (default %s)\n"
+            "  -g  comma-separated grid sizes (default 10,15,20)\n"
+            "  -k  comma-separated tray counts (default 1,2,3,4)\n"
+            "  -m  start mode: 0 empty grid, 1 partially filled (default 0)\n"
+            "  -x  move cap per game (default %d)\n"
+            "  -s  base seed (default 1)\n"
+            "Policies:\n",
+            prog, SIM_DEFAULT_GAMES, POLICIES[0].name, SIM_DEFAULT_MAX_MOVES);
+    for (int i = 0; i < POLICIES_COUNT; i++)
+        fprintf(stderr, "  %-8s %s\n", POLICIES[i].name,
+                POLICIES[i].description);
+}
+
+/**
+ * \brief Simulator entry point.
+ *
+ * \param argc  Argument count.
+ * \param argv  Options, see usage().
+ * \return      0 on success, 1 on a bad option or thread failure.
+ */
+int main(int argc, char *argv[])
+{
+    long games = SIM_DEFAULT_GAMES;
+    long max_moves = SIM_DEFAULT_MAX_MOVES;
+    int nthreads = default_threads();
+    int mode = 0;
+    uint64_t seed = 1;
+    const Policy *policy = &POLICIES[0];
+    int grids[SIM_MAX_LIST] = {10, 15, 20};
+    int ngrids = 3;
+    int trays[SIM_MAX_LIST] = {1, 2, 3, 4};
+    int ntrays = 4;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:p:g:k:m:x:s:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            games = atol(optarg);
+            break;
+        case 't':
+            nthreads = atoi(optarg);
+            break;
+        case 'p':
+            policy = blockblaster_policy_find(optarg);
+            if (!policy) {
+                fprintf(stderr, "unknown policy '%s'\n", optarg);
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'g':
+            ngrids = parse_list(optarg, grids, SIM_MAX_LIST, 1, GRID_W_MAX);
+            break;
+        case 'k':
+            ntrays =
+                parse_list(optarg, trays, SIM_MAX_LIST, 1, PIECES_PER_SET_MAX);
+            break;
+        case 'm':
+            mode = atoi(optarg);
+            break;
+        case 'x':
+            max_moves = atol(optarg);
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (games <= 0 || max_moves <= 0 || nthreads <= 0 ||
+        nthreads > SIM_MAX_THREADS || ngrids <= 0 || ntrays <= 0 ||
+        (mode != 0 && mode != 1)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    /* Both are built lazily on first use; build them before the workers
+       start so no thread races on the shared tables. */
+    blockblaster_scan_init();
+    blockblaster_shape_sampler_init();
+
+    int nconfigs = ngrids * ntrays;
+    SimStats *stats = calloc((size_t) nconfigs, sizeof(*stats));
+    SimWorker *workers = calloc((size_t) nthreads, sizeof(*workers));
+    if (!stats || !workers) {
+        fprintf(stderr, "out of memory\n");
+        free(stats);
+        free(workers);
+        return 1;
+    }
+
+    printf("Policy %s, %ld games per configuration, %d thread%s, seed %llu, "
+           "%s start\n\n",
+           policy->name, games, nthreads, nthreads == 1 ? "" : "s",
+           (unsigned long long) seed, mode ? "partially filled" : "empty");
+    printf("%-9s %10s %12s %14s %10s\n", "config", "games", "games/s",
+           "moves/s", "truncated");
+
+    double t0 = sim_now();
+    long total_games = 0;
+    for (int gi = 0; gi < ngrids; gi++) {
+        for (int ti = 0; ti < ntrays; ti++) {
+            SimStats *st = &stats[gi * ntrays + ti];
+            SimRun run = {policy, seed,  grids[gi], trays[ti],
+                          mode,   games, max_moves, 0};
+            if (!sim_run(&run, nthreads, workers, st)) {
+                free(stats);
+                free(workers);
+                return 1;
+            }
+            total_games += st->games;
+            char cfg[16];
+            snprintf(cfg, sizeof(cfg), "%dx%d/%d", st->grid, st->grid,
+                     st->tray);
+            printf("%-9s %10ld %12.1f %14.4g %10ld\n", cfg, st->games,
+                   st->seconds > 0.0 ? st->games / st->seconds : 0.0,
+                   st->seconds > 0.0 ? st->moves / st->seconds : 0.0,
+                   st->truncated);
+            fflush(stdout);
+        }
+    }
+    double total_dt = sim_now() - t0;
+    printf("%-9s %10ld %12.1f\n", "total", total_games,
+           total_dt > 0.0 ? total_games / total_dt : 0.0);
+
+    printf("\n%-7s %-9s %10s %10s %8s %8s %8s %8s %8s %9s\n", "", "config",
+           "mean", "stddev", "p10", "p50", "p90", "p99", "min", "max");
+    for (int c = 0; c < nconfigs; c++)
+        hist_print("score", &stats[c], &stats[c].score);
+    for (int c = 0; c < nconfigs; c++)
+        hist_print("moves", &stats[c], &stats[c].length);
+
+    /* Shape frequencies as a percentage of all shapes dealt, one column
+       per configuration. */
+    printf("\n%-10s", "shape %");
+    for (int c = 0; c < nconfigs; c++) {
+        char cfg[16];
+        snprintf(cfg, sizeof(cfg), "%dx%d/%d", stats[c].grid, stats[c].grid,
+                 stats[c].tray);
+        printf(" %8s", cfg);
+    }
+    printf("\n");
+    for (int k = 0; k < SIM_SHAPES; k++) {
+        printf("%-10s", SHAPES[k].name);
+        for (int c = 0; c < nconfigs; c++) {
+            long dealt = 0;
+            for (int j = 0; j < SIM_SHAPES; j++)
+                dealt += stats[c].shapes[j];
+            printf(" %8.3f",
+                   dealt ? 100.0 * (double) stats[c].shapes[k] / dealt : 0.0);
+        }
+        printf("\n");
+    }
+
+    free(stats);
+    free(workers);
+    return 0;
+}
@@ -0,0 +1,290 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_simd.c
+ * \brief Vectorised placement-scan kernels with runtime CPU dispatch.
+ *
+ * For an anchor row gy, the anchor columns where shape m does NOT fit are
+ *
+ *     blocked(gy) = OR over filled cells (sx, sy) of rows[gy + sy] >> sx
+ *
+ * so the legal anchors are ~blocked(gy) masked to the columns that keep the
+ * shape inside the grid.  Every kernel computes that expression; the vector
+ * kernels simply evaluate several consecutive anchor rows per instruction
+ * (one anchor row per 32-bit lane).  Shapes are stored top-left aligned
+ * (see gen_shape_masks.py), so only anchors with gx >= 0 and gy >= 0 exist.
+ */
+
+#include "blockblaster_simd.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) &&        \
+    !defined(__EMSCRIPTEN__)
+#define BLOCKBLASTER_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BLOCKBLASTER_SCAN_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Kernel signature: scan anchor rows 0..n-1 of rows, return the first one
+   with a legal anchor (bit set in limit & ~blocked) or -1. */
+typedef int (*scan_fn)(const uint32_t *rows, const ShapeMask *m, int n,
+                       uint32_t limit);
+
+/* ======================================================================== */
+/* Kernels                                                                   */
+/* ======================================================================== */
+
+/* Portable kernel: one anchor row per iteration. */
+static int scan_scalar(const uint32_t *rows, const ShapeMask *m, int n,
+                       uint32_t limit)
+{
+    for (int gy = 0; gy < n; gy++) {
+        uint32_t blocked = 0;
+        for (int i = 0; i < m->cell_count; i++)
+            blocked |= rows[gy + m->cells[i][1]] >> m->cells[i][0];
+        if (limit & ~blocked)
+            return gy;
+    }
+    return -1;
+}
+
+#ifdef BLOCKBLASTER_SCAN_X86
+/* SSE2 kernel: four anchor rows per iteration.  Lanes past the last anchor
+   row are masked off rather than relying on the padding contents. */
+static int scan_sse2(const uint32_t *rows, const ShapeMask *m, int n,
+                     uint32_t limit)
+{
+    const __m128i lim = _mm_set1_epi32((int) limit);
+    const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i nv = _mm_set1_epi32(n);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int gy = 0; gy < n; gy += 4) {
+        __m128i blocked = zero;
+        for (int i = 0; i < m->cell_count; i++) {
+            __m128i r = _mm_loadu_si128(
+                (const __m128i *) (rows + gy + m->cells[i][1]));
+            blocked = _mm_or_si128(
+                blocked, _mm_srl_epi32(r, _mm_cvtsi32_si128(m->cells[i][0])));
+        }
+        __m128i valid =
+            _mm_cmplt_epi32(_mm_add_epi32(_mm_set1_epi32(gy), lanes), nv);
+        __m128i fits = _mm_and_si128(_mm_andnot_si128(blocked, lim), valid);
+        int empty =
+            _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(fits, zero)));
+        if (empty != 0xF)
+            return gy + __builtin_ctz(~empty & 0xF);
+    }
+    return -1;
+}
+
+/* AVX2 kernel: eight anchor rows per iteration.  Compiled with a function
+   target attribute so the rest of the build needs no -mavx2; only called
+   after the CPU reports AVX2 support. */
+__attribute__((target("avx2"))) static int
+scan_avx2(const uint32_t *rows, const ShapeMask *m, int n, uint32_t limit)
+{
+    const __m256i lim = _mm256_set1_epi32((int) limit);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i nv = _mm256_set1_epi32(n);
+    const __m256i zero = _mm256_setzero_si256();
+
+    for (int gy = 0; gy < n; gy += 8) {
+        __m256i blocked = zero;
+        for (int i = 0; i < m->cell_count; i++) {
+            __m256i r = _mm256_loadu_si256(
+                (const __m256i *) (rows + gy + m->cells[i][1]));
+            blocked = _mm256_or_si256(
+                blocked,
+                _mm256_srl_epi32(r, _mm_cvtsi32_si128(m->cells[i][0])));
+        }
+        __m256i row = _mm256_add_epi32(_mm256_set1_epi32(gy), lanes);
+        __m256i valid = _mm256_cmpgt_epi32(nv, row);
+        __m256i fits =
+            _mm256_and_si256(_mm256_andnot_si256(blocked, lim), valid);
+        int empty = _mm256_movemask_ps(
+            _mm256_castsi256_ps(_mm256_cmpeq_epi32(fits, zero)));
+        if (empty != 0xFF)
+            return gy + __builtin_ctz(~empty & 0xFF);
+    }
+    return -1;
+}
+#endif /* BLOCKBLASTER_SCAN_X86 */
+
+#ifdef BLOCKBLASTER_SCAN_NEON
+/* NEON kernel: four anchor rows per iteration (armeabi-v7a and arm64-v8a).
+   A right shift by sx is a vshl by -sx. */
+static int scan_neon(const uint32_t *rows, const ShapeMask *m, int n,
+                     uint32_t limit)
+{
+    static const uint32_t lane_index[4] = {0, 1, 2, 3};
+    const uint32x4_t lim = vdupq_n_u32(limit);
+    const uint32x4_t lanes = vld1q_u32(lane_index);
+    const uint32x4_t nv = vdupq_n_u32((uint32_t) n);
+
+    for (int gy = 0; gy < n; gy += 4) {
+        uint32x4_t blocked = vdupq_n_u32(0);
+        for (int i = 0; i < m->cell_count; i++) {
+            uint32x4_t r = vld1q_u32(rows + gy + m->cells[i][1]);
+            blocked = vorrq_u32(blocked,
+                                vshlq_u32(r, vdupq_n_s32(-m->cells[i][0])));
+        }
+        uint32x4_t valid =
+            vcltq_u32(vaddq_u32(vdupq_n_u32((uint32_t) gy), lanes), nv);
+        uint32x4_t fits = vandq_u32(vbicq_u32(lim, blocked), valid);
+        uint32x2_t any = vorr_u32(vget_low_u32(fits), vget_high_u32(fits));
+        if (vget_lane_u32(any, 0) | vget_lane_u32(any, 1)) {
+            uint32_t out[4];
+            vst1q_u32(out, fits);
+            for (int l = 0; l < 4; l++)
+                if (out[l])
+                    return gy + l;
+        }
+    }
+    return -1;
+}
+#endif /* BLOCKBLASTER_SCAN_NEON */
+
+/* ======================================================================== */
+/* Dispatch                                                                  */
+/* ======================================================================== */
+
+static const scan_fn scan_kernels[SCAN_PATH_COUNT] = {
+    scan_scalar,
+#ifdef BLOCKBLASTER_SCAN_X86
+    scan_sse2,
+    scan_avx2,
+#else
+    NULL,
+    NULL,
+#endif
+#ifdef BLOCKBLASTER_SCAN_NEON
+    scan_neon,
+#else
+    NULL,
+#endif
+};
+
+static const char *scan_path_names[SCAN_PATH_COUNT] = {"scalar", "sse2",
+                                                       "avx2", "neon"};
+
+/* Path used by blockblaster_scan_any(); -1 until blockblaster_scan_init()
+   has run. */
+static int scan_active = -1;
+
+#ifdef BLOCKBLASTER_SCAN_X86
+/* Cached AVX2 CPU check: -1 not queried yet, 0 unsupported, 1 supported. */
+static int scan_has_avx2 = -1;
+#endif
+
+/**
+ * \brief Test whether a scan path is compiled in and supported by the CPU.
+ *
+ * \param path  Path to query.
+ * \return      true if blockblaster_scan_first_row() can run it.
+ */
+bool blockblaster_scan_path_available(SCAN_PATHS path)
+{
+    if ((int) path < 0 || path >= SCAN_PATH_COUNT || !scan_kernels[path])
+        return false;
+#ifdef BLOCKBLASTER_SCAN_X86
+    if (path == SCAN_PATH_AVX2) {
+        if (scan_has_avx2 < 0) {
+            __builtin_cpu_init();
+            scan_has_avx2 = __builtin_cpu_supports("avx2") != 0;
+        }
+        return scan_has_avx2 != 0;
+    }
+#endif
+    return true;
+}
+
+/**
+ * \brief Pick the fastest available scan path.
+ *
+ * Called once at startup; blockblaster_scan_any() also calls it lazily.
+ */
+void blockblaster_scan_init(void)
+{
+    static const SCAN_PATHS preference[] = {SCAN_PATH_AVX2, SCAN_PATH_NEON,
+                                            SCAN_PATH_SSE2, SCAN_PATH_SCALAR};
+    for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+        if (blockblaster_scan_path_available(preference[i])) {
+            scan_active = preference[i];
+            return;
+        }
+    }
+    scan_active = SCAN_PATH_SCALAR;
+}
+
+/**
+ * \brief Return the path selected by blockblaster_scan_init().
+ * \return  Active scan path.
+ */
+SCAN_PATHS blockblaster_scan_active_path(void)
+{
+    if (scan_active < 0)
+        blockblaster_scan_init();
+    return (SCAN_PATHS) scan_active;
+}
+
+/**
+ * \brief Return a short printable name for a scan path.
+ *
+ * \param path  Path to name.
+ * \return      Static string such as "avx2", or "?" for an invalid path.
+ */
+const char *blockblaster_scan_path_name(SCAN_PATHS path)
+{
+    if ((int) path < 0 || path >= SCAN_PATH_COUNT)
+        return "?";
+    return scan_path_names[path];
+}
+
+/**
+ * \brief Find the first anchor row where shape m fits on a grid.
+ *
+ * The vector kernels load whole lanes past the last anchor row (the extra
+ * lanes are masked off), so rows must be readable for h + 7 entries, as
+ * Grid.rows is thanks to GRID_ROW_PAD.  An unavailable path falls back to
+ * the scalar kernel.
+ *
+ * \param path  Kernel to use.
+ * \param rows  Grid row bitboards (bit x of rows[y] = cell (x, y)), padded
+ *              as described above.
+ * \param w     Grid width in cells (at most 32).
+ * \param h     Grid height in cells (at most GRID_H_MAX).
+ * \param m     Shape to place.
+ * \return      Smallest anchor row gy with at least one legal anchor, or -1
+ *              if the shape fits nowhere.
+ */
+int blockblaster_scan_first_row(SCAN_PATHS path, const uint32_t *rows, int w,
+                                int h, const ShapeMask *m)
+{
+    int n = h - m->max_y; /* anchor rows keeping the shape inside the grid */
+    if (n <= 0 || m->max_x >= w)
+        return -1;
+    if (!blockblaster_scan_path_available(path))
+        path = SCAN_PATH_SCALAR;
+    return scan_kernels[path](rows, m, n, GRID_BITS(w - m->max_x));
+}
+
+/**
+ * \brief Test whether shape m fits anywhere on a grid, using the active
+ *        scan path.
+ *
+ * \param rows  Grid row bitboards.
+ * \param w     Grid width in cells.
+ * \param h     Grid height in cells.
+ * \param m     Shape to place.
+ * \return      true if at least one anchor is legal.
+ */
+bool blockblaster_scan_any(const uint32_t *rows, int w, int h,
+                           const ShapeMask *m)
+{
+    return blockblaster_scan_first_row(blockblaster_scan_active_path(), rows,
+                                       w, h, m) >= 0;
+}
@@ -0,0 +1,49 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_simd.h
+ * \brief Vectorised placement-scan kernels with runtime CPU dispatch.
+ *
+ * A scan answers "does this shape fit anywhere on the grid?".  Each kernel
+ * evaluates every horizontal anchor of a band of anchor rows at once: one
+ * 32-bit lane per anchor row, one bit per anchor column.  The scalar path
+ * handles one anchor row per step, SSE2 and NEON four, AVX2 eight.
+ */
+
+#ifndef __BLOCKBLASTER_SIMD__
+#define __BLOCKBLASTER_SIMD__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "blockblaster_core.h"
+
+/**
+ * \brief Implementations of the placement-scan kernel.
+ *
+ * The particle update kernels (blockblaster_particles.h) follow the same
+ * paths, four particles per step on SSE2 and NEON and eight on AVX2.
+ */
+typedef enum {
+    SCAN_PATH_SCALAR = 0, /* Portable C, one anchor row per step. */
+    SCAN_PATH_SSE2 = 1,   /* x86 SSE2, four anchor rows per step. */
+    SCAN_PATH_AVX2 = 2,   /* x86 AVX2, eight anchor rows per step. */
+    SCAN_PATH_NEON = 3,   /* ARM NEON, four anchor rows per step. */
+    SCAN_PATH_COUNT = 4   /* Number of paths (not a valid path). */
+} SCAN_PATHS;
+
+void blockblaster_scan_init(void);
+SCAN_PATHS blockblaster_scan_active_path(void);
+bool blockblaster_scan_path_available(SCAN_PATHS path);
+const char *blockblaster_scan_path_name(SCAN_PATHS path);
+int blockblaster_scan_first_row(SCAN_PATHS path, const uint32_t *rows, int w,
+                                int h, const ShapeMask *m);
+bool blockblaster_scan_any(const uint32_t *rows, int w, int h,
+                           const ShapeMask *m);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLOCKBLASTER_SIMD__ */
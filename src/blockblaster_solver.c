@@ -0,0 +1,435 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_solver.c
+ * \brief Beam search over tray orderings with a Zobrist transposition table.
+ *
+ * The search works on a bare row/column bitboard copy of the grid (no
+ * themes or fill counters), which is all the rules need to test anchors,
+ * detect full lines and clear them.  A node is a board, the set of tray
+ * slots still to place and the combo state; its value is the best
+ * "score gained from here + evaluation of the board left once the tray is
+ * empty" over the children kept by the beam.
+ */
+
+#include "blockblaster_solver.h"
+#include "blockblaster_features.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Default beam width per depth (children expanded when 0, 1, 2, 3 pieces
+   have been placed).  Wider at the top, where ordering mistakes cost the
+   most, and narrow at the bottom where the tree is widest. */
+static const int solver_beam_default[PIECES_PER_SET_MAX] = {12, 6, 4, 2};
+
+/* Move ordering: a completed line outranks any amount of crowding. */
+#define ORDER_LINE_WEIGHT 4096
+
+/* Value of a position where some piece can no longer be placed, per piece
+   left over.  Far below any reachable gain, so completing the tray always
+   wins. */
+#define SOLVER_DEAD_PENALTY 1000000000000LL
+
+/* Board evaluation weights, in score points. */
+#define EVAL_EMPTY_CELL 4   /* per empty cell */
+#define EVAL_HOLE 30        /* per empty cell boxed in on all four sides */
+#define EVAL_TRANSITION 6   /* per occupied/empty edge between two cells */
+#define EVAL_NO_SQUARE 150  /* when no 3x3 square is empty */
+#define EVAL_SQUARE_SIDE 3
+
+/* Bitboard view of the grid.  rows[] keeps the GRID_ROW_PAD zero rows the
+   placement-scan kernels read past the last row. */
+typedef struct {
+    uint32_t rows[GRID_H_MAX + GRID_ROW_PAD];
+    uint32_t cols[GRID_W_MAX];
+} Board;
+
+/* One search position. */
+typedef struct {
+    Board b;
+    int w;
+    int h;
+    unsigned remaining; /* Bit i set while tray slot i is unplaced. */
+    int combo;
+    int combo_miss;
+    float last_move_mult;
+    uint64_t hash;
+} Node;
+
+/* A ranked child move. */
+typedef struct {
+    int slot;
+    int gx;
+    int gy;
+    int key;
+} Cand;
+
+/* Principal variation below a node. */
+typedef struct {
+    int count;
+    PolicyMove moves[PIECES_PER_SET_MAX];
+} Line;
+
+/* SplitMix64 step, used to fill the Zobrist tables. */
+static uint64_t splitmix64(uint64_t *x)
+{
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static int combo_index(int combo, int combo_miss)
+{
+    if (combo > SOLVER_COMBO_CAP)
+        combo = SOLVER_COMBO_CAP;
+    return combo * 4 + (combo_miss & 3);
+}
+
+/* ======================================================================== */
+/* Board                                                                     */
+/* ======================================================================== */
+
+/* Legal anchor columns of m on anchor row gy (shapes are stored top-left
+   aligned, so anchors start at 0). */
+static uint32_t board_anchor_row(const Node *n, const ShapeMask *m, int gy)
+{
+    uint32_t blocked = 0;
+    for (int i = 0; i < m->cell_count; i++)
+        blocked |= n->b.rows[gy + m->cells[i][1]] >> m->cells[i][0];
+    return GRID_BITS(n->w - m->max_x) & ~blocked;
+}
+
+/* Ordering key of placing m at (gx, gy): lines it completes, then how full
+   the rows and columns it lands on already are. */
+static int board_order_key(const Node *n, const ShapeMask *m, int gx, int gy)
+{
+    int lines = 0;
+    for (int sy = 0; sy <= m->max_y; sy++)
+        if ((n->b.rows[gy + sy] | (m->rows[sy] << gx)) == GRID_BITS(n->w))
+            lines++;
+    for (int sx = 0; sx <= m->max_x; sx++)
+        if ((n->b.cols[gx + sx] | (m->cols[sx] << gy)) == GRID_BITS(n->h))
+            lines++;
+
+    int crowd = 0;
+    for (int i = 0; i < m->cell_count; i++)
+        crowd += GRID_POPCOUNT(n->b.rows[gy + m->cells[i][1]]) +
+                 GRID_POPCOUNT(n->b.cols[gx + m->cells[i][0]]);
+    return lines * ORDER_LINE_WEIGHT + crowd;
+}
+
+/* Static evaluation of a board: empty space is good; cells boxed in on
+   all sides, ragged occupied/empty edges and having no room for a 3x3
+   block are bad. */
+static int64_t board_evaluate(const Node *n)
+{
+    const uint32_t *rows = n->b.rows;
+    int64_t v =
+        (int64_t) blockblaster_board_empty(rows, n->w, n->h) *
+            EVAL_EMPTY_CELL -
+        (int64_t) blockblaster_board_holes(rows, n->w, n->h) * EVAL_HOLE -
+        (int64_t) blockblaster_board_transitions(rows, n->w, n->h) *
+            EVAL_TRANSITION;
+    if (blockblaster_board_square(rows, n->w, n->h, EVAL_SQUARE_SIDE, NULL,
+                                  NULL) < EVAL_SQUARE_SIDE)
+        v -= EVAL_NO_SQUARE;
+    return v;
+}
+
+/* Play tray slot `slot` of c at (gx, gy) from position n into *child:
+   stamp the shape, clear the lines it completes (all at once, as
+   blockblaster_core_drop() does) and score the move.  The Zobrist hash is
+   updated incrementally.  Returns the score gained. */
+static int board_play(Solver *s, const CoreGame *c, const Node *n, int slot,
+                      int gx, int gy, Node *child)
+{
+    const ShapeMask *m = &SHAPE_MASKS[c->tray[slot].shape_id];
+    *child = *n;
+    Board *b = &child->b;
+
+    for (int sy = 0; sy <= m->max_y; sy++)
+        b->rows[gy + sy] |= m->rows[sy] << gx;
+    for (int sx = 0; sx <= m->max_x; sx++)
+        b->cols[gx + sx] |= m->cols[sx] << gy;
+    for (int i = 0; i < m->cell_count; i++)
+        child->hash ^=
+            s->zobrist_cell[gy + m->cells[i][1]][gx + m->cells[i][0]];
+
+    /* Only lines crossing the placed shape can have been completed. */
+    uint32_t full_rows = 0;
+    uint32_t full_cols = 0;
+    for (int sy = 0; sy <= m->max_y; sy++)
+        if (b->rows[gy + sy] == GRID_BITS(n->w))
+            full_rows |= 1u << (gy + sy);
+    for (int sx = 0; sx <= m->max_x; sx++)
+        if (b->cols[gx + sx] == GRID_BITS(n->h))
+            full_cols |= 1u << (gx + sx);
+
+    int nr = GRID_POPCOUNT(full_rows);
+    int nc = GRID_POPCOUNT(full_cols);
+    int cleared = nr * n->w + nc * n->h - nr * nc;
+    if (nr || nc) {
+        for (int y = 0; y < n->h; y++) {
+            uint32_t clear =
+                ((full_rows >> y) & 1u) ? GRID_BITS(n->w) : full_cols;
+            b->rows[y] &= ~clear;
+            for (; clear; clear &= clear - 1)
+                child->hash ^= s->zobrist_cell[y][__builtin_ctz(clear)];
+        }
+        for (int x = 0; x < n->w; x++)
+            b->cols[x] &= ((full_cols >> x) & 1u) ? 0u : ~full_rows;
+    }
+
+    child->remaining &= ~(1u << slot);
+    child->hash ^= s->zobrist_slot[slot];
+
+    CoreGame *sc = &s->score;
+    sc->score = 0;
+    sc->combo = n->combo;
+    sc->highest_combo = n->combo;
+    sc->combo_miss = n->combo_miss;
+    sc->last_move_mult = n->last_move_mult;
+    int gain = blockblaster_score_move(sc, m->cell_count, nr + nc, cleared,
+                                       NULL, NULL);
+    child->combo = sc->combo;
+    child->combo_miss = sc->combo_miss;
+    child->last_move_mult = sc->last_move_mult;
+    child->hash ^= s->zobrist_combo[combo_index(n->combo, n->combo_miss)] ^
+                   s->zobrist_combo[combo_index(child->combo,
+                                                child->combo_miss)];
+    return gain;
+}
+
+/* ======================================================================== */
+/* Search                                                                    */
+/* ======================================================================== */
+
+/* Collect the `width` best children of n that place one of `slots` by
+   ordering key into out[] (best first).  Slots holding the same shape as an
+   earlier slot in `slots` are skipped: they lead to the same positions. */
+static int collect_children(const CoreGame *c, const Node *n,
+                            uint32_t slots, int width, Cand *out)
+{
+    int count = 0;
+    for (int i = 0; i < c->tray_count; i++) {
+        if (!((slots >> i) & 1u))
+            continue;
+        bool dup = false;
+        for (int j = 0; j < i; j++)
+            if (((slots >> j) & 1u) &&
+                c->tray[j].shape_id == c->tray[i].shape_id)
+                dup = true;
+        if (dup)
+            continue;
+
+        const ShapeMask *m = &SHAPE_MASKS[c->tray[i].shape_id];
+        if (m->max_x >= n->w)
+            continue;
+        for (int gy = 0; gy + m->max_y < n->h; gy++) {
+            for (uint32_t bits = board_anchor_row(n, m, gy); bits;
+                 bits &= bits - 1) {
+                int gx = __builtin_ctz(bits);
+                int key = board_order_key(n, m, gx, gy);
+                if (count == width && key <= out[count - 1].key)
+                    continue;
+                /* Insertion into the sorted top-`width` list. */
+                int k = (count < width) ? count++ : count - 1;
+                while (k > 0 && out[k - 1].key < key) {
+                    out[k] = out[k - 1];
+                    k--;
+                }
+                out[k].slot = i;
+                out[k].gx = gx;
+                out[k].gy = gy;
+                out[k].key = key;
+            }
+        }
+    }
+    return count;
+}
+
+/* Best value reachable from n, with the moves achieving it in *pv. */
+static int64_t search(Solver *s, const CoreGame *c, const Node *n, int depth,
+                      Line *pv)
+{
+    pv->count = 0;
+    if (!n->remaining)
+        return board_evaluate(n);
+
+    SolverEntry *e = &s->table[n->hash & s->tt_mask];
+    if (e->gen == s->gen && e->key == n->hash) {
+        s->tt_hits++;
+        pv->count = e->count;
+        for (int i = 0; i < e->count; i++) {
+            pv->moves[i].slot = e->moves[i][0];
+            pv->moves[i].gx = e->moves[i][1];
+            pv->moves[i].gy = e->moves[i][2];
+        }
+        return e->value;
+    }
+    if (s->cancel && __atomic_load_n(s->cancel, __ATOMIC_RELAXED)) {
+        s->aborted = true;
+        return 0;
+    }
+    s->nodes++;
+
+    uint32_t slots = n->remaining;
+    if (depth == 0 && s->root_slot >= 0)
+        slots &= 1u << s->root_slot;
+
+    Cand cand[SOLVER_BEAM_MAX];
+    int width = s->beam[depth];
+    if (width < 1)
+        width = 1;
+    if (width > SOLVER_BEAM_MAX)
+        width = SOLVER_BEAM_MAX;
+    int ncand = collect_children(c, n, slots, width, cand);
+    int64_t best = -SOLVER_DEAD_PENALTY * GRID_POPCOUNT(n->remaining);
+    for (int k = 0; k < ncand; k++) {
+        Node child;
+        Line sub;
+        int gain = board_play(s, c, n, cand[k].slot, cand[k].gx, cand[k].gy,
+                              &child);
+        int64_t v = gain + search(s, c, &child, depth + 1, &sub);
+        if (k == 0 || v > best) {
+            best = v;
+            pv->moves[0].slot = cand[k].slot;
+            pv->moves[0].gx = cand[k].gx;
+            pv->moves[0].gy = cand[k].gy;
+            memcpy(&pv->moves[1], sub.moves, sizeof(sub.moves[0]) * sub.count);
+            pv->count = sub.count + 1;
+        }
+    }
+    if (s->aborted)
+        return best;
+
+    e->key = n->hash;
+    e->value = best;
+    e->gen = s->gen;
+    e->count = (uint8_t) pv->count;
+    /* pv->count never exceeds the tray size; the second bound tells the
+       compiler so, as it cannot prove moves[] stays in range. */
+    for (int i = 0; i < pv->count && i < PIECES_PER_SET_MAX; i++) {
+        e->moves[i][0] = (uint8_t) pv->moves[i].slot;
+        e->moves[i][1] = (uint8_t) pv->moves[i].gx;
+        e->moves[i][2] = (uint8_t) pv->moves[i].gy;
+    }
+    return best;
+}
+
+/* ======================================================================== */
+/* API                                                                       */
+/* ======================================================================== */
+
+/**
+ * \brief Initialise a solver: allocate its transposition table and set the
+ *        default beam widths.
+ *
+ * \param s        Solver to initialise.
+ * \param tt_bits  log2 of the table size (e.g. SOLVER_TT_BITS_DEFAULT).
+ * \return         false if the table could not be allocated.
+ */
+bool blockblaster_solver_init(Solver *s, int tt_bits)
+{
+    memset(s, 0, sizeof(*s));
+    if (tt_bits < 1 || tt_bits > 30)
+        return false;
+    s->table = calloc((size_t) 1 << tt_bits, sizeof(*s->table));
+    if (!s->table)
+        return false;
+    s->tt_mask = ((uint64_t) 1 << tt_bits) - 1;
+    memcpy(s->beam, solver_beam_default, sizeof(s->beam));
+
+    uint64_t x = 0x5eed5eed5eed5eedull;
+    for (int y = 0; y < GRID_H_MAX; y++)
+        for (int gx = 0; gx < GRID_W_MAX; gx++)
+            s->zobrist_cell[y][gx] = splitmix64(&x);
+    for (int i = 0; i < PIECES_PER_SET_MAX; i++)
+        s->zobrist_slot[i] = splitmix64(&x);
+    for (size_t i = 0;
+         i < sizeof(s->zobrist_combo) / sizeof(s->zobrist_combo[0]); i++)
+        s->zobrist_combo[i] = splitmix64(&x);
+
+    s->root_slot = -1;
+    return true;
+}
+
+/**
+ * \brief Release the transposition table of a solver.
+ *
+ * \param s  Solver initialised with blockblaster_solver_init().
+ */
+void blockblaster_solver_free(Solver *s)
+{
+    free(s->table);
+    s->table = NULL;
+}
+
+/**
+ * \brief Find the best placement sequence for the unused pieces of c.
+ *
+ * Searches orderings and anchors of the unused tray slots, playing each
+ * move as blockblaster_core_drop() would (clears between placements,
+ * combo scoring).  c itself is not modified.  When s->root_slot is set
+ * only sequences starting with that slot are considered.
+ *
+ * \param s    Solver.
+ * \param c    Game to solve; its grid, tray and combo state are read.
+ * \param out  Receives the best sequence.  When no unused piece fits,
+ *             count is 0.  When only some pieces can be placed, the
+ *             longest such sequence is returned with complete = false.
+ * \return     true if at least one move was found; false as well when
+ *             the solve was cancelled through s->cancel.
+ */
+bool blockblaster_solver_solve(Solver *s, const CoreGame *c,
+                               SolverResult *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (++s->gen == 0)
+        s->gen = 1;
+    s->nodes = 0;
+    s->tt_hits = 0;
+    s->aborted = false;
+
+    Node root;
+    memset(&root, 0, sizeof(root));
+    root.w = c->grid.w;
+    root.h = c->grid.h;
+    memcpy(root.b.rows, c->grid.rows, sizeof(uint32_t) * (size_t) root.h);
+    memcpy(root.b.cols, c->grid.cols, sizeof(uint32_t) * (size_t) root.w);
+    root.combo = c->combo;
+    root.combo_miss = c->combo_miss;
+    root.last_move_mult = c->last_move_mult;
+    for (int y = 0; y < root.h; y++)
+        for (uint32_t r = root.b.rows[y]; r; r &= r - 1)
+            root.hash ^= s->zobrist_cell[y][__builtin_ctz(r)];
+    for (int i = 0; i < c->tray_count; i++) {
+        if (!c->tray[i].used) {
+            root.remaining |= 1u << i;
+            root.hash ^= s->zobrist_slot[i];
+        }
+    }
+    root.hash ^= s->zobrist_combo[combo_index(root.combo, root.combo_miss)];
+
+    Line pv;
+    out->value = search(s, c, &root, 0, &pv);
+    out->nodes = s->nodes;
+    out->tt_hits = s->tt_hits;
+    if (s->aborted || pv.count == 0)
+        return false;
+
+    /* Replay the sequence for its score gain. */
+    Node n = root;
+    for (int i = 0; i < pv.count; i++) {
+        Node next;
+        out->gain += board_play(s, c, &n, pv.moves[i].slot, pv.moves[i].gx,
+                                pv.moves[i].gy, &next);
+        n = next;
+        out->moves[i] = pv.moves[i];
+    }
+    out->count = pv.count;
+    out->complete = (n.remaining == 0);
+    return true;
+}
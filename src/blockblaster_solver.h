@@ -0,0 +1,103 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_solver.h
+ * \brief Tray-ordering search: best placement sequence for the current tray.
+ *
+ * The solver searches the orderings and anchors of the unused tray pieces
+ * against the current grid, clearing completed lines between placements
+ * exactly as blockblaster_core_drop() does and scoring every move with
+ * blockblaster_score_move(), so combos carry over from one placement to the
+ * next.  The sequence with the best score gain plus final-board evaluation
+ * is returned.
+ *
+ * An exhaustive search is out of reach on large grids (a 20x20 board has
+ * several hundred anchors per piece, so 4 pieces give about 4! * 300^4,
+ * roughly 2e11 sequences).  Each node therefore ranks its children with a
+ * cheap move-ordering key and expands only the best few (a beam whose
+ * width shrinks with depth).  Positions reached through different orders
+ * are recognised by a Zobrist hash and evaluated once via a transposition
+ * table.
+ */
+
+#ifndef __BLOCKBLASTER_SOLVER__
+#define __BLOCKBLASTER_SOLVER__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "blockblaster_policy.h"
+
+/** \brief Default transposition table size, as a power of two. */
+#define SOLVER_TT_BITS_DEFAULT 16
+
+/** \brief Widest beam accepted at any depth. */
+#define SOLVER_BEAM_MAX 64
+
+/** \brief Combo values at or above this give the same future gains (the
+ * multiplier is capped at MAX_MULTIPLIER), so they share a hash key. */
+#define SOLVER_COMBO_CAP 19
+
+/**
+ * \brief One transposition table slot.
+ */
+typedef struct {
+    uint64_t key;   /* Zobrist hash of grid, remaining slots and combo. */
+    int64_t value;  /* Best value reachable from this position. */
+    uint32_t gen;   /* Solve generation that wrote the entry (0 = empty). */
+    uint8_t count;  /* Moves in the stored continuation. */
+    uint8_t moves[PIECES_PER_SET_MAX][3]; /* Continuation: slot, gx, gy. */
+} SolverEntry;
+
+/**
+ * \brief Best sequence found by blockblaster_solver_solve().
+ */
+typedef struct {
+    int count;                            /* Moves in the sequence. */
+    PolicyMove moves[PIECES_PER_SET_MAX]; /* Moves in play order. */
+    long gain;     /* Score gained by the sequence. */
+    int64_t value; /* gain plus the evaluation of the final board. */
+    bool complete; /* True if every unused piece gets placed. */
+    long nodes;    /* Positions expanded. */
+    long tt_hits;  /* Positions answered by the transposition table. */
+} SolverResult;
+
+/**
+ * \brief Solver state: transposition table, beam widths and scratch space.
+ *
+ * Initialise with blockblaster_solver_init() and reuse it for every solve;
+ * no memory is allocated after initialisation.  Each Solver owns its
+ * Zobrist keys and table, so threads simply use one Solver each.
+ *
+ * root_slot and cancel may be set between solves: root_slot asks for the
+ * best sequence that starts with a given tray slot, and cancel lets another
+ * thread stop a running solve (set it with an atomic store).
+ */
+typedef struct {
+    SolverEntry *table; /* 2^tt_bits entries. */
+    uint64_t tt_mask;   /* Table size - 1. */
+    uint32_t gen;       /* Current solve generation. */
+    int beam[PIECES_PER_SET_MAX]; /* Children expanded at each depth. */
+    CoreGame score;     /* Scratch game used to score moves. */
+    long nodes;         /* Statistics of the current solve. */
+    long tt_hits;
+    int root_slot;      /* Slot the first move must use, or -1 for any. */
+    const int *cancel;  /* Polled during the search; when it reads non-zero
+                           the solve stops and fails.  NULL = never. */
+    bool aborted;       /* True once the current solve was cancelled. */
+    uint64_t zobrist_cell[GRID_H_MAX][GRID_W_MAX]; /* Occupied cell keys. */
+    uint64_t zobrist_slot[PIECES_PER_SET_MAX];     /* Unplaced slot keys. */
+    uint64_t zobrist_combo[(SOLVER_COMBO_CAP + 1) * 4]; /* combo, miss. */
+} Solver;
+
+bool blockblaster_solver_init(Solver *s, int tt_bits);
+void blockblaster_solver_free(Solver *s);
+bool blockblaster_solver_solve(Solver *s, const CoreGame *c,
+                               SolverResult *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLOCKBLASTER_SOLVER__ */
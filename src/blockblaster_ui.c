@@ -18,9 +18,10 @@
  * \brief UI drawing and interaction functions.
  *
  * All button positions and sizes are derived from the virtual-canvas
- * dimensions WIN_W / WIN_H so that the layout scales correctly in both
- * windowed and fullscreen modes.  Corner radii and line widths are scaled
- * by UI_SCALE so they look correct on high-DPI and fullscreen displays.
+ * dimensions gm->win_w / gm->win_h so that the layout scales correctly in
+ * both windowed and fullscreen modes.  Corner radii and line widths are
+ * scaled by UI_SCALE(gm) so they look correct on high-DPI and fullscreen
+ * displays.
  *
  * \author Castagnier Mickael aka Gull Ra Driel
  * \version 2.0
@@ -42,76 +43,91 @@
 /* Menu button layout macros                                                 */
 /* ======================================================================== */
 
-#define MENU_BUTTON_W ((float) WIN_W * (2.0f / 3.0f))
-#define MENU_BUTTON_H ((float) WIN_H * 0.065f)
-#define MENU_BUTTON_X (((float) WIN_W - MENU_BUTTON_W) * 0.5f)
-#define MENU_ROW5_Y ((float) WIN_H * 0.200f)
-#define MENU_BTN_START_EMPTY_Y ((float) WIN_H * 0.285f)
-#define MENU_BTN_START_PARTIALFILL_Y ((float) WIN_H * 0.370f)
-#define MENU_BTN_SOUND_Y ((float) WIN_H * 0.455f)
-#define MENU_BTN_EXIT_Y ((float) WIN_H * 0.540f)
+#define MENU_BUTTON_W(gm) ((float) (gm)->win_w * (2.0f / 3.0f))
+#define MENU_BUTTON_H(gm) ((float) (gm)->win_h * 0.065f)
+#define MENU_BUTTON_X(gm) (((float) (gm)->win_w - MENU_BUTTON_W(gm)) * 0.5f)
+#define MENU_ROW5_Y(gm) ((float) (gm)->win_h * 0.200f)
+#define MENU_BTN_START_EMPTY_Y(gm) ((float) (gm)->win_h * 0.285f)
+#define MENU_BTN_START_PARTIALFILL_Y(gm) ((float) (gm)->win_h * 0.370f)
+#define MENU_BTN_SOUND_Y(gm) ((float) (gm)->win_h * 0.455f)
+#define MENU_BTN_EXIT_Y(gm) ((float) (gm)->win_h * 0.540f)
 
 /* Row 5: two half-width buttons side by side */
-#define MENU_ROW5_GAP ((float) WIN_W * 0.02f)
-#define MENU_ROW5_BTN_W ((MENU_BUTTON_W - MENU_ROW5_GAP) * 0.5f)
-#define MENU_TRAY_BTN_X MENU_BUTTON_X
-#define MENU_GRID_BTN_X (MENU_BUTTON_X + MENU_ROW5_BTN_W + MENU_ROW5_GAP)
+#define MENU_ROW5_GAP(gm) ((float) (gm)->win_w * 0.02f)
+#define MENU_ROW5_BTN_W(gm) ((MENU_BUTTON_W(gm) - MENU_ROW5_GAP(gm)) * 0.5f)
+#define MENU_TRAY_BTN_X(gm) MENU_BUTTON_X(gm)
+#define MENU_GRID_BTN_X(gm)                                                    \
+    (MENU_BUTTON_X(gm) + MENU_ROW5_BTN_W(gm) + MENU_ROW5_GAP(gm))
+
+/* Sound row: Sound + Fair tray buttons, same split as row 5 */
+#define MENU_SOUND_BTN_X(gm) MENU_TRAY_BTN_X(gm)
+#define MENU_FAIR_BTN_X(gm) MENU_GRID_BTN_X(gm)
+
+/* Exit row: Undo + Exit buttons, same split as row 5 */
+#define MENU_UNDO_BTN_X(gm) MENU_TRAY_BTN_X(gm)
+#define MENU_EXIT_BTN_X(gm) MENU_GRID_BTN_X(gm)
 
 /* ======================================================================== */
 /* Game-over overlay button layout macros                                    */
 /* ======================================================================== */
 
-#define GAMEOVER_BUTTON_W ((float) WIN_W * 0.467f)
-#define GAMEOVER_BUTTON_H ((float) WIN_H * 0.058f)
-#define GAMEOVER_BUTTON_X (((float) WIN_W - GAMEOVER_BUTTON_W) * 0.5f)
-#define GAMEOVER_BUTTON_Y ((float) WIN_H * 0.72f)
+#define GAMEOVER_BUTTON_W(gm) ((float) (gm)->win_w * 0.467f)
+#define GAMEOVER_BUTTON_H(gm) ((float) (gm)->win_h * 0.058f)
+#define GAMEOVER_BUTTON_X(gm)                                                  \
+    (((float) (gm)->win_w - GAMEOVER_BUTTON_W(gm)) * 0.5f)
+#define GAMEOVER_BUTTON_Y(gm) ((float) (gm)->win_h * 0.72f)
+
+/* Watch replay: same size as Back to menu, just above it */
+#define GAMEOVER_REPLAY_Y(gm) ((float) (gm)->win_h * 0.64f)
 
-#define GAMEOVER_EXIT_W ((float) WIN_W * 0.333f)
-#define GAMEOVER_EXIT_H ((float) WIN_H * 0.058f)
-#define GAMEOVER_EXIT_X (((float) WIN_W - GAMEOVER_EXIT_W) * 0.5f)
-#define GAMEOVER_EXIT_Y ((float) WIN_H * 0.80f)
+#define GAMEOVER_EXIT_W(gm) ((float) (gm)->win_w * 0.333f)
+#define GAMEOVER_EXIT_H(gm) ((float) (gm)->win_h * 0.058f)
+#define GAMEOVER_EXIT_X(gm) (((float) (gm)->win_w - GAMEOVER_EXIT_W(gm)) * 0.5f)
+#define GAMEOVER_EXIT_Y(gm) ((float) (gm)->win_h * 0.80f)
 
 /* OK button for player name editing (same position as Back to menu) */
-#define GAMEOVER_OK_W ((float) WIN_W * 0.25f)
-#define GAMEOVER_OK_H ((float) WIN_H * 0.058f)
-#define GAMEOVER_OK_X (((float) WIN_W - GAMEOVER_OK_W) * 0.5f)
-#define GAMEOVER_OK_Y ((float) WIN_H * 0.55f)
+#define GAMEOVER_OK_W(gm) ((float) (gm)->win_w * 0.25f)
+#define GAMEOVER_OK_H(gm) ((float) (gm)->win_h * 0.058f)
+#define GAMEOVER_OK_X(gm) (((float) (gm)->win_w - GAMEOVER_OK_W(gm)) * 0.5f)
+#define GAMEOVER_OK_Y(gm) ((float) (gm)->win_h * 0.55f)
 
 /* ======================================================================== */
 /* In-game exit + sound button layout macros                                 */
 /* ======================================================================== */
 
-#define PLAY_BTN_W ((float) WIN_W * 0.267f)
-#define PLAY_BTN_H ((float) WIN_H * 0.062f)
-#define PLAY_BTN_GAP ((float) WIN_W * 0.02f)
-#define PLAY_PAIR_W (PLAY_BTN_W + PLAY_BTN_GAP + PLAY_BTN_W)
+#define PLAY_BTN_W(gm) ((float) (gm)->win_w * 0.267f)
+#define PLAY_BTN_H(gm) ((float) (gm)->win_h * 0.062f)
+#define PLAY_BTN_GAP(gm) ((float) (gm)->win_w * 0.02f)
+#define PLAY_PAIR_W(gm) (PLAY_BTN_W(gm) + PLAY_BTN_GAP(gm) + PLAY_BTN_W(gm))
 
-#define PLAY_EXIT_BUTTON_X (((float) WIN_W - PLAY_PAIR_W) * 0.5f)
-#define PLAY_EXIT_BUTTON_W PLAY_BTN_W
-#define PLAY_EXIT_BUTTON_H PLAY_BTN_H
+#define PLAY_EXIT_BUTTON_X(gm) (((float) (gm)->win_w - PLAY_PAIR_W(gm)) * 0.5f)
+#define PLAY_EXIT_BUTTON_W(gm) PLAY_BTN_W(gm)
+#define PLAY_EXIT_BUTTON_H(gm) PLAY_BTN_H(gm)
 
-#define PLAY_SOUND_BUTTON_X (PLAY_EXIT_BUTTON_X + PLAY_BTN_W + PLAY_BTN_GAP)
-#define PLAY_SOUND_BUTTON_W PLAY_BTN_W
-#define PLAY_SOUND_BUTTON_H PLAY_BTN_H
+#define PLAY_SOUND_BUTTON_X(gm)                                                \
+    (PLAY_EXIT_BUTTON_X(gm) + PLAY_BTN_W(gm) + PLAY_BTN_GAP(gm))
+#define PLAY_SOUND_BUTTON_W(gm) PLAY_BTN_W(gm)
+#define PLAY_SOUND_BUTTON_H(gm) PLAY_BTN_H(gm)
 
-#define PLAY_BUTTON_Y ((float) WIN_H - PLAY_BTN_H - 5.0f)
-#define PLAY_EXIT_BUTTON_Y PLAY_BUTTON_Y
+#define PLAY_BUTTON_Y(gm) ((float) (gm)->win_h - PLAY_BTN_H(gm) - 5.0f)
+#define PLAY_EXIT_BUTTON_Y(gm) PLAY_BUTTON_Y(gm)
 
 /* ======================================================================== */
 /* Exit-confirmation dialog layout macros                                    */
 /* ======================================================================== */
 
-#define CONFIRM_PANEL_W ((float) WIN_W * 0.5f)
-#define CONFIRM_PANEL_H ((float) WIN_H * 0.189f)
-#define CONFIRM_PANEL_X (((float) WIN_W - CONFIRM_PANEL_W) * 0.5f)
-#define CONFIRM_PANEL_Y (((float) WIN_H - CONFIRM_PANEL_H) * 0.5f)
+#define CONFIRM_PANEL_W(gm) ((float) (gm)->win_w * 0.5f)
+#define CONFIRM_PANEL_H(gm) ((float) (gm)->win_h * 0.189f)
+#define CONFIRM_PANEL_X(gm) (((float) (gm)->win_w - CONFIRM_PANEL_W(gm)) * 0.5f)
+#define CONFIRM_PANEL_Y(gm) (((float) (gm)->win_h - CONFIRM_PANEL_H(gm)) * 0.5f)
 
-#define CONFIRM_BTN_W ((float) WIN_W * 0.167f)
-#define CONFIRM_BTN_H ((float) WIN_H * 0.058f)
-#define CONFIRM_BTN_Y                                                          \
-    (CONFIRM_PANEL_Y + CONFIRM_PANEL_H - CONFIRM_BTN_H - 18.0f)
-#define CONFIRM_YES_X (((float) WIN_W * 0.5f) - CONFIRM_BTN_W - 10.0f)
-#define CONFIRM_NO_X (((float) WIN_W * 0.5f) + 10.0f)
+#define CONFIRM_BTN_W(gm) ((float) (gm)->win_w * 0.167f)
+#define CONFIRM_BTN_H(gm) ((float) (gm)->win_h * 0.058f)
+#define CONFIRM_BTN_Y(gm)                                                      \
+    (CONFIRM_PANEL_Y(gm) + CONFIRM_PANEL_H(gm) - CONFIRM_BTN_H(gm) - 18.0f)
+#define CONFIRM_YES_X(gm)                                                      \
+    (((float) (gm)->win_w * 0.5f) - CONFIRM_BTN_W(gm) - 10.0f)
+#define CONFIRM_NO_X(gm) (((float) (gm)->win_w * 0.5f) + 10.0f)
 
 /* ======================================================================== */
 /* Internal helpers                                                          */
@@ -137,16 +153,17 @@ bool blockblaster_point_in_rect(float px, float py, float x1, float y1,
 /**
  * \brief Draw a rounded-rectangle button with a centred text label.
  *
- * Corner radii and border width are scaled by UI_SCALE so they remain
+ * Corner radii and border width are scaled by UI_SCALE(gm) so they remain
  * proportional on high-DPI displays.
  */
-static void draw_button(float x, float y, float w, float h, const char *label,
-                        ALLEGRO_FONT *font, ALLEGRO_COLOR bg)
+static void draw_button(const GameContext *gm, float x, float y, float w,
+                        float h, const char *label, ALLEGRO_FONT *font,
+                        ALLEGRO_COLOR bg)
 {
-    float r = 10.0f * UI_SCALE;
+    float r = 10.0f * UI_SCALE(gm);
     al_draw_filled_rounded_rectangle(x, y, x + w, y + h, r, r, bg);
     al_draw_rounded_rectangle(x, y, x + w, y + h, r, r, GRID_LINE_COLOR,
-                              ROUNDED_LINE_WIDTH);
+                              ROUNDED_LINE_WIDTH(gm));
     float text_y = y + (h - al_get_font_line_height(font)) * 0.5f;
     al_draw_text(font, al_map_rgb(240, 240, 248), x + w * 0.5f, text_y,
                  ALLEGRO_ALIGN_CENTER, label);
@@ -159,38 +176,52 @@ static void draw_button(float x, float y, float w, float h, const char *label,
 /**
  * \brief Map a click position to a MenuAction enum.
  *
+ * \param gm  Game context (layout).
  * \param mx  Click X in virtual canvas coordinates.
  * \param my  Click Y in virtual canvas coordinates.
  * \return    The action corresponding to the button hit, or
  *            MENU_ACTION_NONE if no button was clicked.
  */
-MenuAction blockblaster_menu_action_from_click(float mx, float my)
+MenuAction blockblaster_menu_action_from_click(const GameContext *gm, float mx,
+                                               float my)
 {
-    if (blockblaster_point_in_rect(mx, my, MENU_BUTTON_X,
-                                   MENU_BTN_START_EMPTY_Y,
-                                   MENU_BUTTON_X + MENU_BUTTON_W,
-                                   MENU_BTN_START_EMPTY_Y + MENU_BUTTON_H))
+    if (blockblaster_point_in_rect(
+            mx, my, MENU_BUTTON_X(gm), MENU_BTN_START_EMPTY_Y(gm),
+            MENU_BUTTON_X(gm) + MENU_BUTTON_W(gm),
+            MENU_BTN_START_EMPTY_Y(gm) + MENU_BUTTON_H(gm)))
         return MENU_ACTION_START_EMPTY;
     if (blockblaster_point_in_rect(
-            mx, my, MENU_BUTTON_X, MENU_BTN_START_PARTIALFILL_Y,
-            MENU_BUTTON_X + MENU_BUTTON_W,
-            MENU_BTN_START_PARTIALFILL_Y + MENU_BUTTON_H))
+            mx, my, MENU_BUTTON_X(gm), MENU_BTN_START_PARTIALFILL_Y(gm),
+            MENU_BUTTON_X(gm) + MENU_BUTTON_W(gm),
+            MENU_BTN_START_PARTIALFILL_Y(gm) + MENU_BUTTON_H(gm)))
         return MENU_ACTION_START_PARTIAL;
-    if (blockblaster_point_in_rect(mx, my, MENU_BUTTON_X, MENU_BTN_EXIT_Y,
-                                   MENU_BUTTON_X + MENU_BUTTON_W,
-                                   MENU_BTN_EXIT_Y + MENU_BUTTON_H))
+    if (blockblaster_point_in_rect(mx, my, MENU_EXIT_BTN_X(gm),
+                                   MENU_BTN_EXIT_Y(gm),
+                                   MENU_EXIT_BTN_X(gm) + MENU_ROW5_BTN_W(gm),
+                                   MENU_BTN_EXIT_Y(gm) + MENU_BUTTON_H(gm)))
         return MENU_ACTION_EXIT;
-    if (blockblaster_point_in_rect(mx, my, MENU_BUTTON_X, MENU_BTN_SOUND_Y,
-                                   MENU_BUTTON_X + MENU_BUTTON_W,
-                                   MENU_BTN_SOUND_Y + MENU_BUTTON_H))
+    if (blockblaster_point_in_rect(mx, my, MENU_UNDO_BTN_X(gm),
+                                   MENU_BTN_EXIT_Y(gm),
+                                   MENU_UNDO_BTN_X(gm) + MENU_ROW5_BTN_W(gm),
+                                   MENU_BTN_EXIT_Y(gm) + MENU_BUTTON_H(gm)))
+        return MENU_ACTION_TOGGLE_UNDO;
+    if (blockblaster_point_in_rect(mx, my, MENU_SOUND_BTN_X(gm),
+                                   MENU_BTN_SOUND_Y(gm),
+                                   MENU_SOUND_BTN_X(gm) + MENU_ROW5_BTN_W(gm),
+                                   MENU_BTN_SOUND_Y(gm) + MENU_BUTTON_H(gm)))
         return MENU_ACTION_TOGGLE_SOUND;
-    if (blockblaster_point_in_rect(mx, my, MENU_TRAY_BTN_X, MENU_ROW5_Y,
-                                   MENU_TRAY_BTN_X + MENU_ROW5_BTN_W,
-                                   MENU_ROW5_Y + MENU_BUTTON_H))
+    if (blockblaster_point_in_rect(mx, my, MENU_FAIR_BTN_X(gm),
+                                   MENU_BTN_SOUND_Y(gm),
+                                   MENU_FAIR_BTN_X(gm) + MENU_ROW5_BTN_W(gm),
+                                   MENU_BTN_SOUND_Y(gm) + MENU_BUTTON_H(gm)))
+        return MENU_ACTION_TOGGLE_FAIR;
+    if (blockblaster_point_in_rect(mx, my, MENU_TRAY_BTN_X(gm), MENU_ROW5_Y(gm),
+                                   MENU_TRAY_BTN_X(gm) + MENU_ROW5_BTN_W(gm),
+                                   MENU_ROW5_Y(gm) + MENU_BUTTON_H(gm)))
         return MENU_ACTION_CYCLE_TRAY;
-    if (blockblaster_point_in_rect(mx, my, MENU_GRID_BTN_X, MENU_ROW5_Y,
-                                   MENU_GRID_BTN_X + MENU_ROW5_BTN_W,
-                                   MENU_ROW5_Y + MENU_BUTTON_H))
+    if (blockblaster_point_in_rect(mx, my, MENU_GRID_BTN_X(gm), MENU_ROW5_Y(gm),
+                                   MENU_GRID_BTN_X(gm) + MENU_ROW5_BTN_W(gm),
+                                   MENU_ROW5_Y(gm) + MENU_BUTTON_H(gm)))
         return MENU_ACTION_CYCLE_GRID;
     return MENU_ACTION_NONE;
 }
@@ -247,25 +278,38 @@ void blockblaster_draw_menu(const GameContext *gm, ALLEGRO_FONT *font)
 {
     al_clear_to_color(al_map_rgb(14, 14, 18));
 
-    float cx = (float) WIN_W * 0.5f;
+    float cx = (float) gm->win_w * 0.5f;
 
-    al_draw_text(font, al_map_rgb(250, 250, 250), cx, (float) WIN_H * 0.10f,
+    al_draw_text(font, al_map_rgb(250, 250, 250), cx, (float) gm->win_h * 0.10f,
                  ALLEGRO_ALIGN_CENTER, "BLOCK BLASTER");
-    al_draw_text(font, al_map_rgb(250, 250, 250), cx, (float) WIN_H * 0.13f,
+    al_draw_text(font, al_map_rgb(250, 250, 250), cx, (float) gm->win_h * 0.13f,
                  ALLEGRO_ALIGN_CENTER, "A Nilorea Studio Game");
-    al_draw_text(font, al_map_rgb(250, 250, 250), cx, (float) WIN_H * 0.16f,
+    al_draw_text(font, al_map_rgb(250, 250, 250), cx, (float) gm->win_h * 0.16f,
                  ALLEGRO_ALIGN_CENTER, "Made with Allegro 5");
 
-    draw_button(MENU_BUTTON_X, MENU_BTN_START_EMPTY_Y, MENU_BUTTON_W,
-                MENU_BUTTON_H, "Empty grid", font, al_map_rgb(35, 55, 95));
-    draw_button(MENU_BUTTON_X, MENU_BTN_START_PARTIALFILL_Y, MENU_BUTTON_W,
-                MENU_BUTTON_H, "Partially filled grid", font,
-                al_map_rgb(55, 65, 45));
-    draw_button(MENU_BUTTON_X, MENU_BTN_EXIT_Y, MENU_BUTTON_W, MENU_BUTTON_H,
-                "Exit", font, al_map_rgb(90, 30, 30));
-    draw_button(MENU_BUTTON_X, MENU_BTN_SOUND_Y, MENU_BUTTON_W, MENU_BUTTON_H,
+    draw_button(gm, MENU_BUTTON_X(gm), MENU_BTN_START_EMPTY_Y(gm),
+                MENU_BUTTON_W(gm), MENU_BUTTON_H(gm), "Empty grid", font,
+                al_map_rgb(35, 55, 95));
+    draw_button(gm, MENU_BUTTON_X(gm), MENU_BTN_START_PARTIALFILL_Y(gm),
+                MENU_BUTTON_W(gm), MENU_BUTTON_H(gm), "Partially filled grid",
+                font, al_map_rgb(55, 65, 45));
+    draw_button(gm, MENU_UNDO_BTN_X(gm), MENU_BTN_EXIT_Y(gm),
+                MENU_ROW5_BTN_W(gm), MENU_BUTTON_H(gm),
+                gm->setting_undo ? "Undo: ON" : "Undo: OFF", font,
+                gm->setting_undo ? al_map_rgb(30, 70, 50)
+                                 : al_map_rgb(60, 40, 20));
+    draw_button(gm, MENU_EXIT_BTN_X(gm), MENU_BTN_EXIT_Y(gm),
+                MENU_ROW5_BTN_W(gm), MENU_BUTTON_H(gm), "Exit", font,
+                al_map_rgb(90, 30, 30));
+    draw_button(gm, MENU_SOUND_BTN_X(gm), MENU_BTN_SOUND_Y(gm),
+                MENU_ROW5_BTN_W(gm), MENU_BUTTON_H(gm),
                 gm->sound_on ? "Sound: ON" : "Sound: OFF", font,
                 gm->sound_on ? al_map_rgb(30, 70, 50) : al_map_rgb(60, 40, 20));
+    draw_button(gm, MENU_FAIR_BTN_X(gm), MENU_BTN_SOUND_Y(gm),
+                MENU_ROW5_BTN_W(gm), MENU_BUTTON_H(gm),
+                gm->setting_fair_tray ? "Fair: ON" : "Fair: OFF", font,
+                gm->setting_fair_tray ? al_map_rgb(30, 70, 50)
+                                      : al_map_rgb(60, 40, 20));
 
     /* Row 5: Tray count + Grid size buttons */
     {
@@ -280,21 +324,22 @@ void blockblaster_draw_menu(const GameContext *gm, ALLEGRO_FONT *font)
             r_val = 20;
         if (g_val < 20)
             g_val = 20;
-        draw_button(MENU_TRAY_BTN_X, MENU_ROW5_Y, MENU_ROW5_BTN_W,
-                    MENU_BUTTON_H, tray_label, font,
+        draw_button(gm, MENU_TRAY_BTN_X(gm), MENU_ROW5_Y(gm),
+                    MENU_ROW5_BTN_W(gm), MENU_BUTTON_H(gm), tray_label, font,
                     al_map_rgb(r_val, g_val, 20));
 
         char grid_label[32];
         snprintf(grid_label, sizeof(grid_label), "Grid: %dx%d",
                  gm->setting_grid_size, gm->setting_grid_size);
-        draw_button(MENU_GRID_BTN_X, MENU_ROW5_Y, MENU_ROW5_BTN_W,
-                    MENU_BUTTON_H, grid_label, font, al_map_rgb(35, 50, 80));
+        draw_button(gm, MENU_GRID_BTN_X(gm), MENU_ROW5_Y(gm),
+                    MENU_ROW5_BTN_W(gm), MENU_BUTTON_H(gm), grid_label, font,
+                    al_map_rgb(35, 50, 80));
     }
 
-    al_draw_text(font, al_map_rgb(140, 140, 150), cx, (float) WIN_H * 0.63f,
+    al_draw_text(font, al_map_rgb(140, 140, 150), cx, (float) gm->win_h * 0.63f,
                  ALLEGRO_ALIGN_CENTER, "Try to clear the board !");
 
-    draw_high_score_table(gm, font, cx, (float) WIN_H * 0.68f);
+    draw_high_score_table(gm, font, cx, (float) gm->win_h * 0.68f);
 }
 
 /* ======================================================================== */
@@ -304,44 +349,47 @@ void blockblaster_draw_menu(const GameContext *gm, ALLEGRO_FONT *font)
 /**
  * \brief Test whether the in-game "Exit" button was clicked.
  *
+ * \param gm  Game context (layout).
  * \param mx  Click X in virtual canvas coordinates.
  * \param my  Click Y in virtual canvas coordinates.
  * \return    true if the click hit the exit button.
  */
-bool blockblaster_play_exit_clicked(float mx, float my)
+bool blockblaster_play_exit_clicked(const GameContext *gm, float mx, float my)
 {
-    return blockblaster_point_in_rect(mx, my, PLAY_EXIT_BUTTON_X, PLAY_BUTTON_Y,
-                                      PLAY_EXIT_BUTTON_X + PLAY_BTN_W,
-                                      PLAY_BUTTON_Y + PLAY_BTN_H);
+    return blockblaster_point_in_rect(mx, my, PLAY_EXIT_BUTTON_X(gm),
+                                      PLAY_BUTTON_Y(gm),
+                                      PLAY_EXIT_BUTTON_X(gm) + PLAY_BTN_W(gm),
+                                      PLAY_BUTTON_Y(gm) + PLAY_BTN_H(gm));
 }
 
 /**
  * \brief Draw the in-game "Exit" button.
  *
- * \param gm    Game context (unused, reserved for future use).
+ * \param gm    Game context (layout).
  * \param font  Font used for the button label.
  */
 void blockblaster_draw_play_exit_button(const GameContext *gm,
                                         ALLEGRO_FONT *font)
 {
-    (void) gm;
-    draw_button(PLAY_EXIT_BUTTON_X, PLAY_BUTTON_Y, PLAY_BTN_W, PLAY_BTN_H,
-                "Exit", font, al_map_rgb(80, 28, 28));
+    draw_button(gm, PLAY_EXIT_BUTTON_X(gm), PLAY_BUTTON_Y(gm), PLAY_BTN_W(gm),
+                PLAY_BTN_H(gm), "Exit", font, al_map_rgb(80, 28, 28));
 }
 
 /**
  * \brief Test whether the in-game "Sound" toggle button was clicked.
  *
+ * \param gm  Game context (layout).
  * \param mx  Click X.
  * \param my  Click Y.
  * \return    true if the click hit the sound button.
  */
-bool blockblaster_play_sound_clicked(float mx, float my)
+bool blockblaster_play_sound_clicked(const GameContext *gm, float mx,
+                                     float my)
 {
-    return blockblaster_point_in_rect(mx, my, PLAY_SOUND_BUTTON_X,
-                                      PLAY_BUTTON_Y,
-                                      PLAY_SOUND_BUTTON_X + PLAY_SOUND_BUTTON_W,
-                                      PLAY_BUTTON_Y + PLAY_SOUND_BUTTON_H);
+    return blockblaster_point_in_rect(
+        mx, my, PLAY_SOUND_BUTTON_X(gm), PLAY_BUTTON_Y(gm),
+        PLAY_SOUND_BUTTON_X(gm) + PLAY_SOUND_BUTTON_W(gm),
+        PLAY_BUTTON_Y(gm) + PLAY_SOUND_BUTTON_H(gm));
 }
 
 /**
@@ -353,9 +401,9 @@ bool blockblaster_play_sound_clicked(float mx, float my)
 void blockblaster_draw_play_sound_button(const GameContext *gm,
                                          ALLEGRO_FONT *font)
 {
-    draw_button(PLAY_SOUND_BUTTON_X, PLAY_BUTTON_Y, PLAY_SOUND_BUTTON_W,
-                PLAY_SOUND_BUTTON_H, gm->sound_on ? "Sound: ON" : "Sound: OFF",
-                font,
+    draw_button(gm, PLAY_SOUND_BUTTON_X(gm), PLAY_BUTTON_Y(gm),
+                PLAY_SOUND_BUTTON_W(gm), PLAY_SOUND_BUTTON_H(gm),
+                gm->sound_on ? "Sound: ON" : "Sound: OFF", font,
                 gm->sound_on ? al_map_rgb(30, 70, 50) : al_map_rgb(60, 40, 20));
 }
 
@@ -366,29 +414,35 @@ void blockblaster_draw_play_sound_button(const GameContext *gm,
 /**
  * \brief Test whether the "Yes" button in the exit-confirm dialog was clicked.
  *
+ * \param gm  Game context (layout).
  * \param mx  Click X.
  * \param my  Click Y.
  * \return    true if the click hit "Yes".
  */
-bool blockblaster_exit_confirm_yes_clicked(float mx, float my)
+bool blockblaster_exit_confirm_yes_clicked(const GameContext *gm, float mx,
+                                           float my)
 {
-    return blockblaster_point_in_rect(mx, my, CONFIRM_YES_X, CONFIRM_BTN_Y,
-                                      CONFIRM_YES_X + CONFIRM_BTN_W,
-                                      CONFIRM_BTN_Y + CONFIRM_BTN_H);
+    return blockblaster_point_in_rect(mx, my, CONFIRM_YES_X(gm),
+                                      CONFIRM_BTN_Y(gm),
+                                      CONFIRM_YES_X(gm) + CONFIRM_BTN_W(gm),
+                                      CONFIRM_BTN_Y(gm) + CONFIRM_BTN_H(gm));
 }
 
 /**
  * \brief Test whether the "No" button in the exit-confirm dialog was clicked.
  *
+ * \param gm  Game context (layout).
  * \param mx  Click X.
  * \param my  Click Y.
  * \return    true if the click hit "No".
  */
-bool blockblaster_exit_confirm_no_clicked(float mx, float my)
+bool blockblaster_exit_confirm_no_clicked(const GameContext *gm, float mx,
+                                          float my)
 {
-    return blockblaster_point_in_rect(mx, my, CONFIRM_NO_X, CONFIRM_BTN_Y,
-                                      CONFIRM_NO_X + CONFIRM_BTN_W,
-                                      CONFIRM_BTN_Y + CONFIRM_BTN_H);
+    return blockblaster_point_in_rect(mx, my, CONFIRM_NO_X(gm),
+                                      CONFIRM_BTN_Y(gm),
+                                      CONFIRM_NO_X(gm) + CONFIRM_BTN_W(gm),
+                                      CONFIRM_BTN_Y(gm) + CONFIRM_BTN_H(gm));
 }
 
 /**
@@ -397,31 +451,34 @@ bool blockblaster_exit_confirm_no_clicked(float mx, float my)
  * Dims the background, draws a panel with the question "Exit game?" and
  * two buttons ("Yes" / "No").
  *
+ * \param gm    Game context (layout).
  * \param font  Font used for text labels.
  */
-void blockblaster_draw_exit_confirm(ALLEGRO_FONT *font)
+void blockblaster_draw_exit_confirm(const GameContext *gm, ALLEGRO_FONT *font)
 {
-    float cx = (float) WIN_W * 0.5f;
-    float r = 14.0f * UI_SCALE;
+    float cx = (float) gm->win_w * 0.5f;
+    float r = 14.0f * UI_SCALE(gm);
 
-    al_draw_filled_rectangle(0, 0, (float) WIN_W, (float) WIN_H,
+    al_draw_filled_rectangle(0, 0, (float) gm->win_w, (float) gm->win_h,
                              al_map_rgba(0, 0, 0, 160));
 
-    al_draw_filled_rounded_rectangle(
-        CONFIRM_PANEL_X, CONFIRM_PANEL_Y, CONFIRM_PANEL_X + CONFIRM_PANEL_W,
-        CONFIRM_PANEL_Y + CONFIRM_PANEL_H, r, r, al_map_rgba(20, 20, 30, 220));
-    al_draw_rounded_rectangle(CONFIRM_PANEL_X, CONFIRM_PANEL_Y,
-                              CONFIRM_PANEL_X + CONFIRM_PANEL_W,
-                              CONFIRM_PANEL_Y + CONFIRM_PANEL_H, r, r,
-                              GRID_LINE_COLOR, ROUNDED_LINE_WIDTH);
-
-    al_draw_text(font, al_map_rgb(240, 240, 248), cx, CONFIRM_PANEL_Y + 30.0f,
-                 ALLEGRO_ALIGN_CENTER, "Exit game?");
-
-    draw_button(CONFIRM_YES_X, CONFIRM_BTN_Y, CONFIRM_BTN_W, CONFIRM_BTN_H,
-                "Yes", font, al_map_rgb(90, 30, 30));
-    draw_button(CONFIRM_NO_X, CONFIRM_BTN_Y, CONFIRM_BTN_W, CONFIRM_BTN_H, "No",
-                font, al_map_rgb(35, 55, 95));
+    al_draw_filled_rounded_rectangle(CONFIRM_PANEL_X(gm), CONFIRM_PANEL_Y(gm),
+                                     CONFIRM_PANEL_X(gm) + CONFIRM_PANEL_W(gm),
+                                     CONFIRM_PANEL_Y(gm) + CONFIRM_PANEL_H(gm),
+                                     r, r, al_map_rgba(20, 20, 30, 220));
+    al_draw_rounded_rectangle(CONFIRM_PANEL_X(gm), CONFIRM_PANEL_Y(gm),
+                              CONFIRM_PANEL_X(gm) + CONFIRM_PANEL_W(gm),
+                              CONFIRM_PANEL_Y(gm) + CONFIRM_PANEL_H(gm), r, r,
+                              GRID_LINE_COLOR, ROUNDED_LINE_WIDTH(gm));
+
+    al_draw_text(font, al_map_rgb(240, 240, 248), cx,
+                 CONFIRM_PANEL_Y(gm) + 30.0f, ALLEGRO_ALIGN_CENTER,
+                 "Exit game?");
+
+    draw_button(gm, CONFIRM_YES_X(gm), CONFIRM_BTN_Y(gm), CONFIRM_BTN_W(gm),
+                CONFIRM_BTN_H(gm), "Yes", font, al_map_rgb(90, 30, 30));
+    draw_button(gm, CONFIRM_NO_X(gm), CONFIRM_BTN_Y(gm), CONFIRM_BTN_W(gm),
+                CONFIRM_BTN_H(gm), "No", font, al_map_rgb(35, 55, 95));
 }
 
 /* ======================================================================== */
@@ -432,30 +489,58 @@ void blockblaster_draw_exit_confirm(ALLEGRO_FONT *font)
  * \brief Test whether the "Back to menu" button was clicked on the
  *        game-over overlay.
  *
+ * \param gm  Game context (layout).
  * \param mx  Click X.
  * \param my  Click Y.
  * \return    true if the click hit the button.
  */
-bool blockblaster_gameover_restart_clicked(float mx, float my)
+bool blockblaster_gameover_restart_clicked(const GameContext *gm, float mx,
+                                           float my)
 {
-    return blockblaster_point_in_rect(mx, my, GAMEOVER_BUTTON_X,
-                                      GAMEOVER_BUTTON_Y,
-                                      GAMEOVER_BUTTON_X + GAMEOVER_BUTTON_W,
-                                      GAMEOVER_BUTTON_Y + GAMEOVER_BUTTON_H);
+    return blockblaster_point_in_rect(
+        mx, my, GAMEOVER_BUTTON_X(gm), GAMEOVER_BUTTON_Y(gm),
+        GAMEOVER_BUTTON_X(gm) + GAMEOVER_BUTTON_W(gm),
+        GAMEOVER_BUTTON_Y(gm) + GAMEOVER_BUTTON_H(gm));
 }
 
 /**
  * \brief Test whether the "Exit" button was clicked on the game-over overlay.
  *
+ * \param gm  Game context (layout).
+ * \param mx  Click X.
+ * \param my  Click Y.
+ * \return    true if the click hit the button.
+ */
+bool blockblaster_gameover_exit_clicked(const GameContext *gm, float mx,
+                                        float my)
+{
+    return blockblaster_point_in_rect(
+        mx, my, GAMEOVER_EXIT_X(gm), GAMEOVER_EXIT_Y(gm),
+        GAMEOVER_EXIT_X(gm) + GAMEOVER_EXIT_W(gm),
+        GAMEOVER_EXIT_Y(gm) + GAMEOVER_EXIT_H(gm));
+}
+
+/**
+ * \brief Test whether the "Watch replay" button was clicked on the
+ *        game-over overlay.
+ *
+ * The button is only shown once the name is confirmed and when the game
+ * can be replayed (gm->replay_indexed).
+ *
+ * \param gm  Game context (layout).
  * \param mx  Click X.
  * \param my  Click Y.
  * \return    true if the click hit the button.
  */
-bool blockblaster_gameover_exit_clicked(float mx, float my)
+bool blockblaster_gameover_replay_clicked(const GameContext *gm, float mx,
+                                          float my)
 {
-    return blockblaster_point_in_rect(mx, my, GAMEOVER_EXIT_X, GAMEOVER_EXIT_Y,
-                                      GAMEOVER_EXIT_X + GAMEOVER_EXIT_W,
-                                      GAMEOVER_EXIT_Y + GAMEOVER_EXIT_H);
+    if (gm->editing_name || !gm->replay_indexed)
+        return false;
+    return blockblaster_point_in_rect(
+        mx, my, GAMEOVER_BUTTON_X(gm), GAMEOVER_REPLAY_Y(gm),
+        GAMEOVER_BUTTON_X(gm) + GAMEOVER_BUTTON_W(gm),
+        GAMEOVER_REPLAY_Y(gm) + GAMEOVER_BUTTON_H(gm));
 }
 
 /**
@@ -472,9 +557,10 @@ bool blockblaster_gameover_ok_clicked(const GameContext *gm, float mx, float my)
 {
     if (!gm->editing_name)
         return false;
-    return blockblaster_point_in_rect(mx, my, GAMEOVER_OK_X, GAMEOVER_OK_Y,
-                                      GAMEOVER_OK_X + GAMEOVER_OK_W,
-                                      GAMEOVER_OK_Y + GAMEOVER_OK_H);
+    return blockblaster_point_in_rect(mx, my, GAMEOVER_OK_X(gm),
+                                      GAMEOVER_OK_Y(gm),
+                                      GAMEOVER_OK_X(gm) + GAMEOVER_OK_W(gm),
+                                      GAMEOVER_OK_Y(gm) + GAMEOVER_OK_H(gm));
 }
 
 /**
@@ -482,17 +568,19 @@ bool blockblaster_gameover_ok_clicked(const GameContext *gm, float mx, float my)
  *
  * Used on Android to re-open the soft keyboard when tapping the field.
  *
+ * \param gm  Game context (layout).
  * \param mx  Click X.
  * \param my  Click Y.
  * \return    true if the click hit the name input field.
  */
-bool blockblaster_gameover_name_field_clicked(float mx, float my)
+bool blockblaster_gameover_name_field_clicked(const GameContext *gm, float mx,
+                                              float my)
 {
-    float cx = (float) WIN_W * 0.5f;
-    float field_w = (float) WIN_W * 0.35f;
-    float field_h = (float) WIN_H * 0.06f;
+    float cx = (float) gm->win_w * 0.5f;
+    float field_w = (float) gm->win_w * 0.35f;
+    float field_h = (float) gm->win_h * 0.06f;
     float field_x = cx - field_w * 0.5f;
-    float field_y = (float) WIN_H * 0.32f;
+    float field_y = (float) gm->win_h * 0.32f;
     return blockblaster_point_in_rect(mx, my, field_x, field_y,
                                       field_x + field_w, field_y + field_h);
 }
@@ -502,7 +590,7 @@ bool blockblaster_gameover_name_field_clicked(float mx, float my)
  *
  * Two sub-modes: when gm->editing_name is true, shows the name editor
  * with an OK button; otherwise displays the final score, the high-score
- * table, and "Back to menu" / "Exit" buttons.
+ * table, and "Watch replay" / "Back to menu" / "Exit" buttons.
  *
  * \param gm    Game context.
  * \param font  Font used for all text and buttons.
@@ -510,43 +598,45 @@ bool blockblaster_gameover_name_field_clicked(float mx, float my)
 void blockblaster_draw_gameover_overlay(const GameContext *gm,
                                         ALLEGRO_FONT *font)
 {
-    float cx = (float) WIN_W * 0.5f;
-    float pmx = (float) WIN_W * 0.10f;
-    float panel_top = (float) WIN_H * 0.10f;
-    float panel_bot = (float) WIN_H * 0.90f;
-    float r = 14.0f * UI_SCALE;
+    float cx = (float) gm->win_w * 0.5f;
+    float pmx = (float) gm->win_w * 0.10f;
+    float panel_top = (float) gm->win_h * 0.10f;
+    float panel_bot = (float) gm->win_h * 0.90f;
+    float r = 14.0f * UI_SCALE(gm);
 
     /* Dim background */
-    al_draw_filled_rectangle(0, 0, (float) WIN_W, (float) WIN_H,
+    al_draw_filled_rectangle(0, 0, (float) gm->win_w, (float) gm->win_h,
                              al_map_rgba(8, 8, 12, 150));
 
     /* Panel */
-    al_draw_filled_rounded_rectangle(pmx, panel_top, (float) WIN_W - pmx,
+    al_draw_filled_rounded_rectangle(pmx, panel_top, (float) gm->win_w - pmx,
                                      panel_bot, r, r,
                                      al_map_rgba(20, 20, 30, 210));
-    al_draw_rounded_rectangle(pmx, panel_top, (float) WIN_W - pmx, panel_bot, r,
-                              r, GRID_LINE_COLOR, ROUNDED_LINE_WIDTH);
+    al_draw_rounded_rectangle(pmx, panel_top, (float) gm->win_w - pmx,
+                              panel_bot, r, r, GRID_LINE_COLOR,
+                              ROUNDED_LINE_WIDTH(gm));
 
-    al_draw_text(font, al_map_rgb(255, 120, 120), cx, (float) WIN_H * 0.14f,
+    al_draw_text(font, al_map_rgb(255, 120, 120), cx, (float) gm->win_h * 0.14f,
                  ALLEGRO_ALIGN_CENTER, "GAME OVER");
 
     if (gm->editing_name) {
         /* Player name editing mode */
-        al_draw_text(font, al_map_rgb(240, 240, 240), cx, (float) WIN_H * 0.25f,
-                     ALLEGRO_ALIGN_CENTER, "Enter your name:");
+        al_draw_text(font, al_map_rgb(240, 240, 240), cx,
+                     (float) gm->win_h * 0.25f, ALLEGRO_ALIGN_CENTER,
+                     "Enter your name:");
 
         /* Name display field */
-        float field_w = (float) WIN_W * 0.35f;
-        float field_h = (float) WIN_H * 0.06f;
+        float field_w = (float) gm->win_w * 0.35f;
+        float field_h = (float) gm->win_h * 0.06f;
         float field_x = cx - field_w * 0.5f;
-        float field_y = (float) WIN_H * 0.32f;
+        float field_y = (float) gm->win_h * 0.32f;
 
         al_draw_filled_rounded_rectangle(field_x, field_y, field_x + field_w,
                                          field_y + field_h, r * 0.5f, r * 0.5f,
                                          al_map_rgb(30, 30, 40));
         al_draw_rounded_rectangle(
             field_x, field_y, field_x + field_w, field_y + field_h, r * 0.5f,
-            r * 0.5f, al_map_rgb(120, 190, 255), ROUNDED_LINE_WIDTH);
+            r * 0.5f, al_map_rgb(120, 190, 255), ROUNDED_LINE_WIDTH(gm));
 
         /* Show name with blinking cursor */
         char display_name[MAX_PLAYER_NAME_LEN + 2];
@@ -557,34 +647,121 @@ void blockblaster_draw_gameover_overlay(const GameContext *gm,
                      ALLEGRO_ALIGN_CENTER, display_name);
 
         al_draw_textf(font, al_map_rgb(140, 140, 150), cx,
-                      (float) WIN_H * 0.42f, ALLEGRO_ALIGN_CENTER,
+                      (float) gm->win_h * 0.42f, ALLEGRO_ALIGN_CENTER,
                       "(%d/%d characters)", gm->name_cursor,
                       MAX_PLAYER_NAME_LEN);
 
         al_draw_textf(font, al_map_rgb(240, 240, 240), cx,
-                      (float) WIN_H * 0.47f, ALLEGRO_ALIGN_CENTER,
-                      "Final score: %ld", gm->score);
+                      (float) gm->win_h * 0.47f, ALLEGRO_ALIGN_CENTER,
+                      "Final score: %ld", gm->core.score);
 
         /* OK button only */
-        draw_button(GAMEOVER_OK_X, GAMEOVER_OK_Y, GAMEOVER_OK_W, GAMEOVER_OK_H,
-                    "OK", font, al_map_rgb(35, 55, 95));
+        draw_button(gm, GAMEOVER_OK_X(gm), GAMEOVER_OK_Y(gm), GAMEOVER_OK_W(gm),
+                    GAMEOVER_OK_H(gm), "OK", font, al_map_rgb(35, 55, 95));
     } else {
         /* Normal game-over display with scores */
         al_draw_textf(font, al_map_rgb(240, 240, 240), cx,
-                      (float) WIN_H * 0.22f, ALLEGRO_ALIGN_CENTER,
-                      "Final score: %ld  (Player: %s)", gm->score,
+                      (float) gm->win_h * 0.22f, ALLEGRO_ALIGN_CENTER,
+                      "Final score: %ld  (Player: %s)", gm->core.score,
                       gm->player_name);
 
         /* Top-5 high score table */
-        draw_high_score_table(gm, font, cx, (float) WIN_H * 0.30f);
+        draw_high_score_table(gm, font, cx, (float) gm->win_h * 0.30f);
 
         /* Buttons */
-        draw_button(GAMEOVER_BUTTON_X, GAMEOVER_BUTTON_Y, GAMEOVER_BUTTON_W,
-                    GAMEOVER_BUTTON_H, "Back to menu", font,
-                    al_map_rgb(90, 90, 60));
-        draw_button(GAMEOVER_EXIT_X, GAMEOVER_EXIT_Y, GAMEOVER_EXIT_W,
-                    GAMEOVER_EXIT_H, "Exit", font, al_map_rgb(60, 24, 24));
+        if (gm->replay_indexed)
+            draw_button(gm, GAMEOVER_BUTTON_X(gm), GAMEOVER_REPLAY_Y(gm),
+                        GAMEOVER_BUTTON_W(gm), GAMEOVER_BUTTON_H(gm),
+                        "Watch replay", font, al_map_rgb(35, 55, 95));
+        draw_button(gm, GAMEOVER_BUTTON_X(gm), GAMEOVER_BUTTON_Y(gm),
+                    GAMEOVER_BUTTON_W(gm), GAMEOVER_BUTTON_H(gm),
+                    "Back to menu", font, al_map_rgb(90, 90, 60));
+        draw_button(gm, GAMEOVER_EXIT_X(gm), GAMEOVER_EXIT_Y(gm),
+                    GAMEOVER_EXIT_W(gm), GAMEOVER_EXIT_H(gm), "Exit", font,
+                    al_map_rgb(60, 24, 24));
+    }
+}
+
+/* ======================================================================== */
+/* Replay view                                                               */
+/* ======================================================================== */
+
+/**
+ * \brief Test whether a click hit the replay scrub bar.
+ *
+ * The hit area is a little taller than the bar to make it easy to grab.
+ *
+ * \param gm  Game context (layout).
+ * \param mx  Click X.
+ * \param my  Click Y.
+ * \return    true if the click hit the bar.
+ */
+bool blockblaster_replay_bar_clicked(const GameContext *gm, float mx, float my)
+{
+    float x1 = GRID_X(gm);
+    float x2 = x1 + (float) gm->grid_w * CELL(gm);
+    return blockblaster_point_in_rect(mx, my, x1, REPLAY_BAR_Y(gm) - 8.0f, x2,
+                                      REPLAY_BAR_Y(gm) + REPLAY_BAR_H + 8.0f);
+}
+
+/**
+ * \brief Map a horizontal position on the scrub bar to a drop count.
+ *
+ * \param gm  Game context (layout and replay).
+ * \param mx  Pointer X; positions past either end are clamped.
+ * \return    Number of drops, 0 - gm->replay.count.
+ */
+int blockblaster_replay_bar_move(const GameContext *gm, float mx)
+{
+    float w = (float) gm->grid_w * CELL(gm);
+    float t = (mx - GRID_X(gm)) / w;
+    if (t < 0.0f)
+        t = 0.0f;
+    if (t > 1.0f)
+        t = 1.0f;
+    return (int) (t * (float) gm->replay.count + 0.5f);
+}
+
+/**
+ * \brief Draw the replay scrub bar and the position / key help line.
+ *
+ * The bar spans the grid width in the gap above the tray, with a tick at
+ * every keyframe and a knob at the shown position.
+ *
+ * \param gm    Game context.
+ * \param font  Font used for the labels.
+ */
+void blockblaster_draw_replay_bar(const GameContext *gm, ALLEGRO_FONT *font)
+{
+    float x1 = GRID_X(gm);
+    float w = (float) gm->grid_w * CELL(gm);
+    float y1 = REPLAY_BAR_Y(gm);
+    float y2 = y1 + REPLAY_BAR_H;
+    float r = REPLAY_BAR_H * 0.5f;
+    int count = gm->replay.count;
+    float t = count > 0 ? (float) gm->replay_move / (float) count : 1.0f;
+
+    al_draw_filled_rounded_rectangle(x1, y1, x1 + w, y2, r, r,
+                                     al_map_rgb(30, 30, 40));
+    if (t > 0.0f)
+        al_draw_filled_rounded_rectangle(x1, y1, x1 + w * t, y2, r, r,
+                                         al_map_rgb(60, 110, 170));
+    for (int k = gm->replay.key_interval; k > 0 && k < count;
+         k += gm->replay.key_interval) {
+        float kx = x1 + w * (float) k / (float) count;
+        al_draw_line(kx, y1 + 4.0f, kx, y2 - 4.0f, al_map_rgba(0, 0, 0, 120),
+                     1.0f);
     }
+    al_draw_rounded_rectangle(x1, y1, x1 + w, y2, r, r, GRID_LINE_COLOR,
+                              ROUNDED_LINE_WIDTH(gm));
+    al_draw_filled_circle(x1 + w * t, y1 + r, r + 2.0f,
+                          al_map_rgb(240, 240, 248));
+
+    al_draw_textf(font, al_map_rgb(240, 240, 240), (float) gm->win_w * 0.5f,
+                  y2 + 4.0f, ALLEGRO_ALIGN_CENTER,
+                  "%s %d / %d   Space  Arrows  Esc",
+                  gm->replay_playing ? "Playing" : "Paused", gm->replay_move,
+                  count);
 }
 
 /* ======================================================================== */
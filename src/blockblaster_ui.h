@@ -48,23 +48,36 @@ typedef enum {
     MENU_ACTION_EXIT,          /**< Exit the application. */
     MENU_ACTION_TOGGLE_SOUND,  /**< Toggle audio on or off. */
     MENU_ACTION_CYCLE_TRAY,    /**< Cycle tray pieces count (1-4). */
-    MENU_ACTION_CYCLE_GRID     /**< Cycle grid size (10/15/20). */
+    MENU_ACTION_CYCLE_GRID,    /**< Cycle grid size (10/15/20). */
+    MENU_ACTION_TOGGLE_FAIR,   /**< Toggle fair tray dealing. */
+    MENU_ACTION_TOGGLE_UNDO    /**< Toggle undo / redo in new games. */
 } MenuAction;
 
 bool blockblaster_point_in_rect(float px, float py, float x1, float y1,
                                 float x2, float y2);
 
-MenuAction blockblaster_menu_action_from_click(float mx, float my);
+MenuAction blockblaster_menu_action_from_click(const GameContext *gm, float mx,
+                                               float my);
 
-bool blockblaster_gameover_restart_clicked(float mx, float my);
-bool blockblaster_gameover_exit_clicked(float mx, float my);
+bool blockblaster_gameover_restart_clicked(const GameContext *gm, float mx,
+                                           float my);
+bool blockblaster_gameover_exit_clicked(const GameContext *gm, float mx,
+                                        float my);
+bool blockblaster_gameover_replay_clicked(const GameContext *gm, float mx,
+                                          float my);
 bool blockblaster_gameover_ok_clicked(const GameContext *gm, float mx,
                                       float my);
-bool blockblaster_gameover_name_field_clicked(float mx, float my);
-bool blockblaster_play_exit_clicked(float mx, float my);
-bool blockblaster_play_sound_clicked(float mx, float my);
-bool blockblaster_exit_confirm_yes_clicked(float mx, float my);
-bool blockblaster_exit_confirm_no_clicked(float mx, float my);
+bool blockblaster_gameover_name_field_clicked(const GameContext *gm, float mx,
+                                              float my);
+bool blockblaster_play_exit_clicked(const GameContext *gm, float mx, float my);
+bool blockblaster_play_sound_clicked(const GameContext *gm, float mx,
+                                     float my);
+bool blockblaster_exit_confirm_yes_clicked(const GameContext *gm, float mx,
+                                           float my);
+bool blockblaster_exit_confirm_no_clicked(const GameContext *gm, float mx,
+                                          float my);
+bool blockblaster_replay_bar_clicked(const GameContext *gm, float mx, float my);
+int blockblaster_replay_bar_move(const GameContext *gm, float mx);
 
 void blockblaster_draw_menu(const GameContext *gm, ALLEGRO_FONT *font);
 void blockblaster_draw_gameover_overlay(const GameContext *gm,
@@ -73,7 +86,8 @@ void blockblaster_draw_play_exit_button(const GameContext *gm,
                                         ALLEGRO_FONT *font);
 void blockblaster_draw_play_sound_button(const GameContext *gm,
                                          ALLEGRO_FONT *font);
-void blockblaster_draw_exit_confirm(ALLEGRO_FONT *font);
+void blockblaster_draw_exit_confirm(const GameContext *gm, ALLEGRO_FONT *font);
+void blockblaster_draw_replay_bar(const GameContext *gm, ALLEGRO_FONT *font);
 void blockblaster_toggle_fullscreen(GameContext *gm);
 
 #ifdef __cplusplus
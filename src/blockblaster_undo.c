@@ -0,0 +1,374 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_undo.c
+ * \brief Undo / redo history implementation.
+ *
+ * The ring holds `len` snapshots from `head`; the first `cur` of them are
+ * the states before the drops that can be undone.  When cur < len the
+ * current state is snapshot cur and the ones after it can be redone; when
+ * cur == len the current state is not stored, and blockblaster_undo()
+ * stores it first so that it can be redone.
+ */
+
+#include "blockblaster_undo.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Theme byte of a cell without a theme. */
+#define UNDO_NO_THEME 0xFF
+
+/* Bits of UndoSnapshot.flags above the tray used flags. */
+#define UNDO_GAME_OVER (1u << PIECES_PER_SET_MAX)
+
+/* One grid row of the row pool. */
+typedef struct {
+    uint32_t bits;             /* Row bitboard. */
+    uint16_t refs;             /* Snapshots using the row (0 = free). */
+    uint8_t theme[GRID_W_MAX]; /* Cell themes, UNDO_NO_THEME when none. */
+} UndoRow;
+
+/* One bag of the bag pool. */
+typedef struct {
+    uint16_t refs;           /* Snapshots using the bag (0 = free). */
+    uint8_t len;             /* Entries in shape. */
+    uint8_t shape[BAG_SIZE]; /* Shape indices. */
+} UndoBag;
+
+/* Rules state before one drop. */
+typedef struct {
+    uint64_t rng;                      /* Stream state. */
+    int64_t score;                     /* Score. */
+    int32_t combo;                     /* Combo. */
+    int32_t highest_combo;             /* Highest combo. */
+    int32_t combo_miss;                /* Moves since the last clear. */
+    float last_move_mult;              /* Multiplier of the last move. */
+    uint16_t row[GRID_H_MAX];          /* Pool row of each grid row. */
+    uint16_t bag;                      /* Pool bag. */
+    uint16_t move;                     /* Drop made from this state. */
+    uint8_t shape[PIECES_PER_SET_MAX]; /* Tray shape indices. */
+    uint8_t theme[PIECES_PER_SET_MAX]; /* Tray themes. */
+    uint8_t flags;                     /* Bit i: slot i used; game over. */
+    uint8_t bag_pos;                   /* Next draw in the bag. */
+    uint8_t set_theme;                 /* Shared theme of the set. */
+} UndoSnapshot;
+
+/** \brief Undo history state (see blockblaster_undo.h). */
+struct UndoHistory {
+    UndoSnapshot snap[UNDO_DEPTH]; /* Snapshot ring. */
+    int head;                      /* Ring index of the oldest snapshot. */
+    int len;                       /* Snapshots held. */
+    int cur;                       /* Snapshots that can be undone to. */
+
+    UndoRow rows[UNDO_ROWS];      /* Row pool. */
+    uint16_t row_free[UNDO_ROWS]; /* Free rows (stack). */
+    int row_free_count;           /* Entries in row_free. */
+    UndoBag bags[UNDO_BAGS];      /* Bag pool. */
+    uint16_t bag_free[UNDO_BAGS]; /* Free bags (stack). */
+    int bag_free_count;           /* Entries in bag_free. */
+};
+
+/* Snapshot i of the ring, 0 = oldest. */
+static UndoSnapshot *undo_at(UndoHistory *h, int i)
+{
+    return &h->snap[(h->head + i) % UNDO_DEPTH];
+}
+
+/* Release the pool rows and bag of snapshot s. */
+static void undo_release(UndoHistory *h, const UndoSnapshot *s, int rows)
+{
+    for (int y = 0; y < rows; y++)
+        if (--h->rows[s->row[y]].refs == 0)
+            h->row_free[h->row_free_count++] = s->row[y];
+    if (--h->bags[s->bag].refs == 0)
+        h->bag_free[h->bag_free_count++] = s->bag;
+}
+
+/* Drop the oldest snapshot. */
+static void undo_drop_oldest(UndoHistory *h, int rows)
+{
+    undo_release(h, undo_at(h, 0), rows);
+    h->head = (h->head + 1) % UNDO_DEPTH;
+    h->len--;
+    if (h->cur > 0)
+        h->cur--;
+}
+
+/* Drop the snapshots after the first keep ones. */
+static void undo_truncate(UndoHistory *h, int keep, int rows)
+{
+    while (h->len > keep)
+        undo_release(h, undo_at(h, --h->len), rows);
+}
+
+/* Drop the oldest snapshots until count more fit in the ring and the pools
+   (even if none of their rows is shared). */
+static void undo_make_room(UndoHistory *h, int count, int rows)
+{
+    while (h->len > 0 && (h->len + count > UNDO_DEPTH ||
+                          h->row_free_count < count * rows ||
+                          h->bag_free_count < count))
+        undo_drop_oldest(h, rows);
+}
+
+/* Append a snapshot of c, which must fit (see undo_make_room()).  Rows and
+   the bag equal to those of the newest snapshot are shared with it. */
+static void undo_push(UndoHistory *h, const CoreGame *c, uint16_t move)
+{
+    const Grid *g = &c->grid;
+    const UndoSnapshot *prev = h->len > 0 ? undo_at(h, h->len - 1) : NULL;
+    UndoSnapshot *s = undo_at(h, h->len);
+
+    for (int y = 0; y < g->h; y++) {
+        UndoRow row;
+        row.bits = g->rows[y];
+        memset(row.theme, UNDO_NO_THEME, sizeof(row.theme));
+        for (int x = 0; x < g->w; x++)
+            if (g->has_theme[y][x])
+                row.theme[x] = g->cell_theme[y][x];
+        if (prev) {
+            UndoRow *p = &h->rows[prev->row[y]];
+            if (p->bits == row.bits &&
+                memcmp(p->theme, row.theme, sizeof(row.theme)) == 0) {
+                p->refs++;
+                s->row[y] = prev->row[y];
+                continue;
+            }
+        }
+        uint16_t i = h->row_free[--h->row_free_count];
+        row.refs = 1;
+        h->rows[i] = row;
+        s->row[y] = i;
+    }
+
+    UndoBag *pb = prev ? &h->bags[prev->bag] : NULL;
+    bool same_bag = pb && pb->len == c->bag_len;
+    for (int i = 0; same_bag && i < c->bag_len; i++)
+        same_bag = pb->shape[i] == c->bag[i];
+    if (same_bag) {
+        pb->refs++;
+        s->bag = prev->bag;
+    } else {
+        uint16_t i = h->bag_free[--h->bag_free_count];
+        UndoBag *b = &h->bags[i];
+        b->refs = 1;
+        b->len = (uint8_t) c->bag_len;
+        for (int j = 0; j < c->bag_len; j++)
+            b->shape[j] = (uint8_t) c->bag[j];
+        s->bag = i;
+    }
+
+    s->flags = c->game_over ? UNDO_GAME_OVER : 0;
+    for (int i = 0; i < c->tray_count; i++) {
+        s->shape[i] = (uint8_t) c->tray[i].shape_id;
+        s->theme[i] = (uint8_t) c->tray[i].theme;
+        if (c->tray[i].used)
+            s->flags |= (uint8_t) (1u << i);
+    }
+    s->bag_pos = (uint8_t) c->bag_pos;
+    s->set_theme = (uint8_t) c->set_theme;
+    s->rng = c->rng.state;
+    s->score = c->score;
+    s->combo = c->combo;
+    s->highest_combo = c->highest_combo;
+    s->combo_miss = c->combo_miss;
+    s->last_move_mult = c->last_move_mult;
+    s->move = move;
+    h->len++;
+}
+
+/* Put the state of snapshot s back into c (same grid and tray size). */
+static void undo_restore(const UndoHistory *h, const UndoSnapshot *s,
+                         CoreGame *c)
+{
+    Grid *g = &c->grid;
+    memset(g->cols, 0, sizeof(g->cols));
+    memset(g->col_fill, 0, sizeof(g->col_fill));
+    for (int y = 0; y < g->h; y++) {
+        const UndoRow *row = &h->rows[s->row[y]];
+        uint32_t bits = row->bits;
+        g->rows[y] = bits;
+        g->row_fill[y] = (uint8_t) GRID_POPCOUNT(bits);
+        for (; bits; bits &= bits - 1) {
+            int x = __builtin_ctz(bits);
+            g->cols[x] |= 1u << y;
+            g->col_fill[x]++;
+        }
+        for (int x = 0; x < g->w; x++) {
+            g->has_theme[y][x] = row->theme[x] != UNDO_NO_THEME;
+            g->cell_theme[y][x] = g->has_theme[y][x] ? row->theme[x] : 0;
+        }
+    }
+
+    for (int i = 0; i < c->tray_count; i++) {
+        c->tray[i].shape_id = s->shape[i];
+        c->tray[i].shape = SHAPES[s->shape[i]];
+        c->tray[i].theme = s->theme[i];
+        c->tray[i].used = (s->flags >> i) & 1u;
+        blockblaster_placement_map_rebuild(c, i);
+    }
+
+    const UndoBag *b = &h->bags[s->bag];
+    c->bag_len = b->len;
+    for (int i = 0; i < b->len; i++)
+        c->bag[i] = b->shape[i];
+    c->bag_pos = s->bag_pos;
+    c->set_theme = s->set_theme;
+    c->rng.state = s->rng;
+    c->score = (long) s->score;
+    c->combo = s->combo;
+    c->highest_combo = s->highest_combo;
+    c->combo_miss = s->combo_miss;
+    c->last_move_mult = s->last_move_mult;
+    c->game_over = (s->flags & UNDO_GAME_OVER) != 0;
+}
+
+/**
+ * \brief Allocate an empty history.
+ *
+ * This is the only allocation: the snapshot ring and the row and bag pools
+ * are part of the history.
+ *
+ * \return  The history, or NULL when out of memory.
+ */
+UndoHistory *blockblaster_undo_create(void)
+{
+    UndoHistory *h = malloc(sizeof(*h));
+    if (h)
+        blockblaster_undo_reset(h);
+    return h;
+}
+
+/**
+ * \brief Free a history.
+ *
+ * \param h  History (NULL is ignored).
+ */
+void blockblaster_undo_destroy(UndoHistory *h)
+{
+    free(h);
+}
+
+/**
+ * \brief Forget every snapshot, e.g. when a new game starts.
+ *
+ * \param h  History.
+ */
+void blockblaster_undo_reset(UndoHistory *h)
+{
+    h->head = 0;
+    h->len = 0;
+    h->cur = 0;
+    for (int i = 0; i < UNDO_ROWS; i++) {
+        h->rows[i].refs = 0;
+        h->row_free[i] = (uint16_t) (UNDO_ROWS - 1 - i);
+    }
+    h->row_free_count = UNDO_ROWS;
+    for (int i = 0; i < UNDO_BAGS; i++) {
+        h->bags[i].refs = 0;
+        h->bag_free[i] = (uint16_t) (UNDO_BAGS - 1 - i);
+    }
+    h->bag_free_count = UNDO_BAGS;
+}
+
+/**
+ * \brief Record the state before a drop.
+ *
+ * Call with the game as it is just before move is applied (and with any
+ * pending line clear already done).  Drops the states that could be
+ * redone.  Every game recorded into a history must keep its grid size and
+ * tray count until blockblaster_undo_reset().
+ *
+ * \param h     History.
+ * \param c     Game, started with blockblaster_core_start().
+ * \param move  The drop about to be made, encoded by the caller (returned
+ *              by blockblaster_redo()).
+ */
+void blockblaster_undo_record(UndoHistory *h, const CoreGame *c,
+                              uint16_t move)
+{
+    undo_truncate(h, h->cur, c->grid.h);
+    /* Keep room for the snapshot of the current state taken by the first
+       blockblaster_undo(), so an undo never drops a level. */
+    undo_make_room(h, 2, c->grid.h);
+    undo_push(h, c, move);
+    h->cur = h->len;
+}
+
+/**
+ * \brief Go back to the state before the last drop.
+ *
+ * The first undo after a drop stores the current state so that it can be
+ * redone.
+ *
+ * \param h  History.
+ * \param c  Game (updated in place).
+ * \return   false when there is nothing to undo; c is then unchanged.
+ */
+bool blockblaster_undo(UndoHistory *h, CoreGame *c)
+{
+    if (h->cur == 0)
+        return false;
+    if (h->cur == h->len)
+        undo_push(h, c, UNDO_NO_MOVE);
+    h->cur--;
+    undo_restore(h, undo_at(h, h->cur), c);
+    return true;
+}
+
+/**
+ * \brief Make again the drop undone last.
+ *
+ * \param h     History.
+ * \param c     Game (updated in place).
+ * \param move  Receives the drop redone, as given to
+ *              blockblaster_undo_record() (may be NULL).
+ * \return      false when there is nothing to redo; c is then unchanged.
+ */
+bool blockblaster_redo(UndoHistory *h, CoreGame *c, uint16_t *move)
+{
+    if (h->cur + 1 >= h->len)
+        return false;
+    if (move)
+        *move = undo_at(h, h->cur)->move;
+    h->cur++;
+    undo_restore(h, undo_at(h, h->cur), c);
+    return true;
+}
+
+/**
+ * \brief Number of drops that can be undone.
+ *
+ * \param h  History.
+ * \return   Undo levels held.
+ */
+int blockblaster_undo_levels(const UndoHistory *h)
+{
+    return h->cur;
+}
+
+/**
+ * \brief Number of undone drops that can be redone.
+ *
+ * \param h  History.
+ * \return   Redo levels held.
+ */
+int blockblaster_redo_levels(const UndoHistory *h)
+{
+    return h->len > h->cur ? h->len - h->cur - 1 : 0;
+}
+
+/**
+ * \brief Memory taken by the snapshots held, with their shared rows and
+ *        bags counted once.
+ *
+ * \param h  History.
+ * \return   Bytes in use (the history itself is sizeof(UndoHistory)).
+ */
+size_t blockblaster_undo_bytes_used(const UndoHistory *h)
+{
+    return (size_t) h->len * sizeof(UndoSnapshot) +
+           (size_t) (UNDO_ROWS - h->row_free_count) * sizeof(UndoRow) +
+           (size_t) (UNDO_BAGS - h->bag_free_count) * sizeof(UndoBag);
+}
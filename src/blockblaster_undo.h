@@ -0,0 +1,62 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_undo.h
+ * \brief Undo / redo history of the rules state, with shared grid rows.
+ *
+ * Each history entry is a compact snapshot of what a drop changes: grid
+ * rows and cell themes, tray shapes, themes and used flags, bag and bag
+ * position, random stream, score, combo, combo_miss and last_move_mult.
+ * Grid rows and bags live in reference-counted pools and a snapshot only
+ * holds their indices, so a row or a bag left unchanged by a drop is
+ * shared with the previous snapshot instead of being copied; a drop
+ * usually adds a few rows.
+ *
+ * Snapshots are kept in a ring: when it is full, or when a pool runs out
+ * of free rows or bags, recording drops the oldest snapshots.  All storage
+ * is allocated by blockblaster_undo_create(), so recording, undoing and
+ * redoing never allocate.
+ */
+
+#ifndef __BLOCKBLASTER_UNDO__
+#define __BLOCKBLASTER_UNDO__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "blockblaster_core.h"
+
+#include <stddef.h>
+
+/** \brief Snapshots in the ring: up to UNDO_DEPTH - 1 drops can be undone. */
+#define UNDO_DEPTH 256
+
+/** \brief Grid rows in the shared row pool. */
+#define UNDO_ROWS 1536
+
+/** \brief Bags in the shared bag pool. */
+#define UNDO_BAGS 32
+
+/** \brief No drop recorded for a snapshot. */
+#define UNDO_NO_MOVE 0xFFFFu
+
+/** \brief Undo / redo history (snapshot ring and shared pools). */
+typedef struct UndoHistory UndoHistory;
+
+UndoHistory *blockblaster_undo_create(void);
+void blockblaster_undo_destroy(UndoHistory *h);
+void blockblaster_undo_reset(UndoHistory *h);
+void blockblaster_undo_record(UndoHistory *h, const CoreGame *c,
+                              uint16_t move);
+bool blockblaster_undo(UndoHistory *h, CoreGame *c);
+bool blockblaster_redo(UndoHistory *h, CoreGame *c, uint16_t *move);
+int blockblaster_undo_levels(const UndoHistory *h);
+int blockblaster_redo_levels(const UndoHistory *h);
+size_t blockblaster_undo_bytes_used(const UndoHistory *h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLOCKBLASTER_UNDO__ */
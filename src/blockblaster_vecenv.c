@@ -0,0 +1,260 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_vecenv.c
+ * \brief Batched training environment implementation.
+ *
+ * A step only touches the rows under the placed shape, one AND over the
+ * grid rows for the full columns and, when lines are completed, one pass
+ * rewriting the rows; the scoring uses blockblaster_clear_gain() like the
+ * CoreGame rules.  Episodes start from blockblaster_core_start() on a
+ * scratch CoreGame, whose state is then copied into the arrays, so the
+ * opening deal and partial fill can never drift from the game's.
+ */
+
+#include "blockblaster_vecenv.h"
+#include "blockblaster_simd.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Theme draws only advance the stream here; the batch keeps no colours. */
+static void skip_theme(Rng *r)
+{
+    (void) blockblaster_irand(r, 0, THEMES_COUNT - 1);
+}
+
+/* Deal a new set to game i, drawing from its bag exactly like a CoreGame
+   after its opening set (one shared theme, then one bag draw per slot). */
+static void vecenv_deal(VecEnv *v, int i)
+{
+    Rng *r = &v->rng[i];
+    uint8_t *bag = v->bag + (size_t) i * BAG_SIZE;
+    uint8_t *shape = v->tray_shape + (size_t) i * PIECES_PER_SET_MAX;
+
+    skip_theme(r);
+    for (int k = 0; k < v->tray; k++) {
+        if (v->bag_pos[i] >= BAG_SIZE) {
+            int fresh[BAG_SIZE];
+            for (int j = 0; j < BAG_SIZE; j++)
+                fresh[j] = blockblaster_shape_draw(r, (long) v->score[i]);
+            blockblaster_shuffle_ints(r, fresh, BAG_SIZE);
+            for (int j = 0; j < BAG_SIZE; j++)
+                bag[j] = (uint8_t) fresh[j];
+            v->bag_pos[i] = 0;
+        }
+        shape[k] = bag[v->bag_pos[i]++];
+    }
+}
+
+/* True when no unused slot of game i fits anywhere. */
+static bool vecenv_stuck(const VecEnv *v, int i)
+{
+    const uint32_t *rows = v->rows + (size_t) i * VECENV_ROW_STRIDE;
+    const uint8_t *shape = v->tray_shape + (size_t) i * PIECES_PER_SET_MAX;
+    for (int k = 0; k < v->tray; k++)
+        if (shape[k] != VECENV_SLOT_USED &&
+            blockblaster_scan_any(rows, v->grid, v->grid,
+                                  &SHAPE_MASKS[shape[k]]))
+            return false;
+    return true;
+}
+
+/**
+ * \brief Allocate n games and start the first episode of each.
+ *
+ * \param v     VecEnv to initialise.
+ * \param n     Number of games (> 0).
+ * \param grid  Grid side length (1 - GRID_W_MAX).
+ * \param tray  Pieces per set (1 - PIECES_PER_SET_MAX).
+ * \param mode  0 = empty grid, 1 = partially filled grid.
+ * \param seed  Base seed of every episode stream.
+ * \return      false (nothing allocated) on bad parameters or out of
+ *              memory.
+ */
+bool blockblaster_vecenv_init(VecEnv *v, int n, int grid, int tray, int mode,
+                              uint64_t seed)
+{
+    memset(v, 0, sizeof(*v));
+    if (n <= 0 || grid < 1 || grid > GRID_W_MAX || grid > GRID_H_MAX ||
+        tray < 1 || tray > PIECES_PER_SET_MAX || (mode != 0 && mode != 1))
+        return false;
+    v->n = n;
+    v->grid = grid;
+    v->tray = tray;
+    v->mode = mode;
+    v->seed = seed;
+
+    size_t un = (size_t) n;
+    v->rows = calloc(un * VECENV_ROW_STRIDE, sizeof(*v->rows));
+    v->tray_shape = calloc(un * PIECES_PER_SET_MAX, sizeof(*v->tray_shape));
+    v->bag = calloc(un * BAG_SIZE, sizeof(*v->bag));
+    v->bag_pos = calloc(un, sizeof(*v->bag_pos));
+    v->rng = calloc(un, sizeof(*v->rng));
+    v->score = calloc(un, sizeof(*v->score));
+    v->combo = calloc(un, sizeof(*v->combo));
+    v->combo_miss = calloc(un, sizeof(*v->combo_miss));
+    v->steps = calloc(un, sizeof(*v->steps));
+    v->episode = calloc(un, sizeof(*v->episode));
+    v->act_slot = calloc(un, sizeof(*v->act_slot));
+    v->act_gx = calloc(un, sizeof(*v->act_gx));
+    v->act_gy = calloc(un, sizeof(*v->act_gy));
+    v->reward = calloc(un, sizeof(*v->reward));
+    v->placed = calloc(un, sizeof(*v->placed));
+    v->done = calloc(un, sizeof(*v->done));
+    v->final_score = calloc(un, sizeof(*v->final_score));
+    if (!v->rows || !v->tray_shape || !v->bag || !v->bag_pos || !v->rng ||
+        !v->score || !v->combo || !v->combo_miss || !v->steps ||
+        !v->episode || !v->act_slot || !v->act_gx || !v->act_gy ||
+        !v->reward || !v->placed || !v->done || !v->final_score) {
+        blockblaster_vecenv_free(v);
+        return false;
+    }
+
+    for (int i = 0; i < n; i++)
+        blockblaster_vecenv_reset(v, i);
+    return true;
+}
+
+/**
+ * \brief Release the arrays of a VecEnv.
+ *
+ * \param v  VecEnv from blockblaster_vecenv_init() (may have failed).
+ */
+void blockblaster_vecenv_free(VecEnv *v)
+{
+    free(v->rows);
+    free(v->tray_shape);
+    free(v->bag);
+    free(v->bag_pos);
+    free(v->rng);
+    free(v->score);
+    free(v->combo);
+    free(v->combo_miss);
+    free(v->steps);
+    free(v->episode);
+    free(v->act_slot);
+    free(v->act_gx);
+    free(v->act_gy);
+    free(v->reward);
+    free(v->placed);
+    free(v->done);
+    free(v->final_score);
+    memset(v, 0, sizeof(*v));
+}
+
+/**
+ * \brief Start the next episode of game i.
+ *
+ * Episodes that are over on their first deal (possible on a partially
+ * filled grid) are skipped.
+ *
+ * \param v  VecEnv.
+ * \param i  Game index.
+ */
+void blockblaster_vecenv_reset(VecEnv *v, int i)
+{
+    static const CoreGame blank = {0};
+    CoreGame c;
+    do {
+        c = blank;
+        blockblaster_rng_seed(&c.rng, v->seed,
+                              (uint64_t) i << 32 | v->episode[i]++);
+        blockblaster_core_start(&c, v->grid, v->grid, v->tray, v->mode);
+    } while (c.game_over);
+
+    uint32_t *rows = v->rows + (size_t) i * VECENV_ROW_STRIDE;
+    memset(rows, 0, VECENV_ROW_STRIDE * sizeof(*rows));
+    memcpy(rows, c.grid.rows, (size_t) v->grid * sizeof(*rows));
+
+    uint8_t *shape = v->tray_shape + (size_t) i * PIECES_PER_SET_MAX;
+    memset(shape, VECENV_SLOT_USED, PIECES_PER_SET_MAX);
+    for (int k = 0; k < v->tray; k++)
+        shape[k] = (uint8_t) c.tray[k].shape_id;
+    for (int j = 0; j < c.bag_len; j++)
+        v->bag[(size_t) i * BAG_SIZE + (size_t) j] = (uint8_t) c.bag[j];
+    v->bag_pos[i] = (uint8_t) (c.bag_len == BAG_SIZE ? c.bag_pos : BAG_SIZE);
+
+    v->rng[i] = c.rng;
+    v->score[i] = 0;
+    v->combo[i] = 0;
+    v->combo_miss[i] = 0;
+    v->steps[i] = 0;
+}
+
+/**
+ * \brief Apply the action of every game in [i0, i1) and fill the outputs.
+ *
+ * \param v   VecEnv with act_slot, act_gx and act_gy set for the range.
+ * \param i0  First game.
+ * \param i1  One past the last game.
+ */
+void blockblaster_vecenv_step(VecEnv *v, int i0, int i1)
+{
+    const int w = v->grid, h = v->grid;
+    const uint32_t full_row = GRID_BITS(w);
+
+    for (int i = i0; i < i1; i++) {
+        uint32_t *rows = v->rows + (size_t) i * VECENV_ROW_STRIDE;
+        uint8_t *shape = v->tray_shape + (size_t) i * PIECES_PER_SET_MAX;
+        int slot = v->act_slot[i], gx = v->act_gx[i], gy = v->act_gy[i];
+
+        v->reward[i] = 0;
+        v->placed[i] = 0;
+        v->done[i] = 0;
+        if (slot >= v->tray || shape[slot] == VECENV_SLOT_USED)
+            continue;
+        const ShapeMask *m = &SHAPE_MASKS[shape[slot]];
+        if (gx + m->max_x >= w || gy + m->max_y >= h)
+            continue;
+        uint32_t hit = 0;
+        for (int sy = m->min_y; sy <= m->max_y; sy++)
+            hit |= (m->rows[sy] << gx) & rows[gy + sy];
+        if (hit)
+            continue;
+
+        /* Place, then look for lines: only rows and columns crossing the
+           shape can have been completed. */
+        uint32_t full_rows = 0;
+        for (int sy = m->min_y; sy <= m->max_y; sy++) {
+            rows[gy + sy] |= m->rows[sy] << gx;
+            if (rows[gy + sy] == full_row)
+                full_rows |= 1u << (gy + sy);
+        }
+        uint32_t full_cols = full_row;
+        for (int y = 0; y < h; y++)
+            full_cols &= rows[y];
+
+        int nr = GRID_POPCOUNT(full_rows), nc = GRID_POPCOUNT(full_cols);
+        int lines = nr + nc;
+        int gain = m->cell_count * SCORE_PER_PLACED_CELL;
+        if (lines > 0) {
+            v->combo[i] += lines;
+            v->combo_miss[i] = 0;
+            gain += blockblaster_clear_gain(v->combo[i], lines,
+                                            nr * w + nc * h - nr * nc, NULL);
+            for (int y = 0; y < h; y++)
+                rows[y] = ((full_rows >> y) & 1u) ? 0 : rows[y] & ~full_cols;
+        } else if (v->combo[i] > 0 && ++v->combo_miss[i] > 3) {
+            v->combo[i] = 0;
+            v->combo_miss[i] = 0;
+        }
+        v->score[i] += gain;
+        v->steps[i]++;
+        v->reward[i] = gain;
+        v->placed[i] = 1;
+
+        shape[slot] = VECENV_SLOT_USED;
+        bool empty = true;
+        for (int k = 0; k < v->tray; k++)
+            empty = empty && shape[k] == VECENV_SLOT_USED;
+        if (empty)
+            vecenv_deal(v, i);
+
+        if (vecenv_stuck(v, i)) {
+            v->done[i] = 1;
+            v->final_score[i] = v->score[i];
+            blockblaster_vecenv_reset(v, i);
+        }
+    }
+}
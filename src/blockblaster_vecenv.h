@@ -0,0 +1,94 @@
+/* Copyright (C) 2026 Nilorea Studio — GPL-3.0-or-later (see COPYING). */
+
+/**
+ * \file blockblaster_vecenv.h
+ * \brief Batched training environment: N games stepped per call.
+ *
+ * A VecEnv holds N independent games of one grid size, tray count and
+ * start mode in structure-of-arrays form: one array per field (bitboards,
+ * tray shapes, bag, random stream, score and combo counters), so a step
+ * over a range of games streams through each array in order.  Each game's
+ * row bitboards fill a padded block of VECENV_ROW_STRIDE words, which the
+ * placement-scan kernels read directly for the game-over test.
+ *
+ * The caller writes one action per game into act_slot / act_gx / act_gy
+ * and calls blockblaster_vecenv_step() on a range of games; disjoint
+ * ranges may be stepped from different threads.  Each step has the rules
+ * of blockblaster_core_drop() and BlockBlasterEnv: an illegal action
+ * leaves its game unchanged (placed = 0, reward = 0).  A game that ends is
+ * reset at once (done = 1, final_score holds its score), so the state
+ * seen after the step is the first position of the next episode.
+ *
+ * Episode e of game i is seeded on stream (i << 32 | e) of the VecEnv
+ * seed and plays exactly like a CoreGame seeded the same way.  Fair trays
+ * are not supported.
+ */
+
+#ifndef __BLOCKBLASTER_VECENV__
+#define __BLOCKBLASTER_VECENV__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "blockblaster_core.h"
+
+/** \brief Row bitboard words per game: GRID_H_MAX rows plus the scan
+ * padding, rounded up to two cache lines. */
+#define VECENV_ROW_STRIDE 32
+
+/** \brief tray_shape value of a used slot. */
+#define VECENV_SLOT_USED 0xFF
+
+/**
+ * \brief N games in structure-of-arrays form, with their action and step
+ *        output buffers.
+ *
+ * Initialise with blockblaster_vecenv_init(); every array has n entries
+ * (times the per-game width noted).  Fields are read-only to the caller
+ * except the act_* arrays.
+ */
+typedef struct {
+    int n;         /* Number of games. */
+    int grid;      /* Grid side length. */
+    int tray;      /* Pieces per set. */
+    int mode;      /* Start mode: 0 = empty, 1 = partially filled. */
+    uint64_t seed; /* Base seed of every episode stream. */
+
+    /* Game state. */
+    uint32_t *rows;       /* VECENV_ROW_STRIDE per game; bit x = cell (x, y). */
+    uint8_t *tray_shape;  /* PIECES_PER_SET_MAX per game: shape id or
+                             VECENV_SLOT_USED. */
+    uint8_t *bag;         /* BAG_SIZE per game: shape ids of the bag. */
+    uint8_t *bag_pos;     /* Next bag draw (BAG_SIZE = refill). */
+    Rng *rng;             /* Gameplay stream. */
+    int64_t *score;       /* Score of the current episode. */
+    int32_t *combo;       /* Combo counter (see blockblaster_score_move()). */
+    int32_t *combo_miss;  /* Non-clearing moves since the last clear. */
+    int32_t *steps;       /* Moves placed in the current episode. */
+    uint32_t *episode;    /* Episodes started (the current one is
+                             episode - 1). */
+
+    /* Actions, written by the caller before each step. */
+    uint8_t *act_slot; /* Tray slot. */
+    uint8_t *act_gx;   /* Grid column of the shape's top-left corner. */
+    uint8_t *act_gy;   /* Grid row of the shape's top-left corner. */
+
+    /* Outputs of the last step. */
+    int32_t *reward;      /* Score gained. */
+    uint8_t *placed;      /* 1 if the action was legal. */
+    uint8_t *done;        /* 1 if the episode ended (game reset since). */
+    int64_t *final_score; /* Score of the episode that ended, when done. */
+} VecEnv;
+
+bool blockblaster_vecenv_init(VecEnv *v, int n, int grid, int tray, int mode,
+                              uint64_t seed);
+void blockblaster_vecenv_free(VecEnv *v);
+void blockblaster_vecenv_reset(VecEnv *v, int i);
+void blockblaster_vecenv_step(VecEnv *v, int i0, int i1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLOCKBLASTER_VECENV__ */